@@ -69,6 +69,10 @@ extern "C" {
  * - free the IK_Solver
  * - get basis and translation changes from segments
  * - free all segments
+ *
+ * When the same problem is solved repeatedly (e.g. on every frame), the segments and
+ * the solver can be kept instead: update the segment transforms, call
+ * IK_SolverClearGoals, set the new goals and call IK_Solve again.
  */
 
 /**
@@ -125,6 +129,10 @@ extern void IK_SetStiffness(IK_Segment *seg, IK_SegmentAxis axis, float stiffnes
 extern void IK_GetBasisChange(IK_Segment *seg, float basis_change[][3]);
 extern void IK_GetTranslationChange(IK_Segment *seg, float *translation_change);
 
+/* Start solving from basis * basis_change instead of basis, call after IK_SetTransform.
+ * Used to warm-start the solver from a previous solution. */
+extern void IK_SetBasisChange(IK_Segment *seg, float basis_change[][3]);
+
 /**
  * An IK_Solver must be created to be able to execute the solver.
  *
@@ -136,6 +144,11 @@ extern void IK_GetTranslationChange(IK_Segment *seg, float *translation_change);
  * IK_Solve will execute the solver, that will run until either the
  * system converges, or a maximum number of iterations is reached.
  * It returns 1 if the system converged, 0 otherwise.
+ *
+ * With IK_SolverSetTwoBoneAnalytic enabled, chains of two segments with free
+ * spherical joints and a single position goal are solved in closed form. The
+ * end effector reaches the goal like with the iterative solver, but the bend
+ * plane of the chain is kept, so the resulting rotations can differ.
  */
 
 typedef void IK_Solver;
@@ -155,6 +168,8 @@ void IK_SolverSetPoleVectorConstraint(IK_Solver *solver,
                                       float poleangle,
                                       int getangle);
 float IK_SolverGetPoleAngle(IK_Solver *solver);
+void IK_SolverSetTwoBoneAnalytic(IK_Solver *solver, int enable);
+void IK_SolverClearGoals(IK_Solver *solver);
 
 int IK_Solve(IK_Solver *solver, float tolerance, int max_iterations);
 
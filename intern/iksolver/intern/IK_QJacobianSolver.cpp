@@ -30,6 +30,7 @@ IK_QJacobianSolver::IK_QJacobianSolver()
 {
   m_poleconstraint = false;
   m_getpoleangle = false;
+  m_twobone_analytic = false;
   m_rootmatrix.setIdentity();
 }
 
@@ -160,6 +161,14 @@ void IK_QJacobianSolver::SetPoleVectorConstraint(
   m_getpoleangle = getangle;
 }
 
+void IK_QJacobianSolver::ClearPoleVectorConstraint()
+{
+  m_poleconstraint = false;
+  m_getpoleangle = false;
+  m_twobone_analytic = false;
+  m_rootmatrix.setIdentity();
+}
+
 void IK_QJacobianSolver::ConstrainPoleVector(IK_QSegment *root, std::list<IK_QTask *> &tasks)
 {
   // this function will be called before and after solving. calling it before
@@ -290,11 +299,95 @@ bool IK_QJacobianSolver::UpdateAngles(double &norm)
   return locked;
 }
 
+bool IK_QJacobianSolver::TwoBoneChain(std::list<IK_QTask *> &tasks)
+{
+  // two segments with unconstrained spherical joints, no stretch, locks, limits or stiffness
+  if (m_segments.size() != 2)
+    return false;
+
+  std::vector<IK_QSegment *>::iterator seg;
+
+  for (seg = m_segments.begin(); seg != m_segments.end(); seg++) {
+    IK_QSegment *qseg = *seg;
+
+    if (qseg->Translational() || qseg->NumberOfDoF() != 3 || qseg->HasLimits())
+      return false;
+
+    for (int i = 0; i < 3; i++)
+      if (qseg->Weight(i) != 1.0)
+        return false;
+  }
+
+  // and a single position goal on the tip
+  if (tasks.size() != 1)
+    return false;
+
+  IK_QTask *task = tasks.front();
+
+  return task->PositionTask() && task->Segment() == m_segments[1];
+}
+
+bool IK_QJacobianSolver::SolveTwoBone(IK_QSegment *root, std::list<IK_QTask *> &tasks)
+{
+  IK_QSegment *tip = m_segments[1];
+  const Vector3d &goal = static_cast<IK_QPositionTask *>(tasks.front())->Goal();
+
+  root->UpdateTransform(m_rootmatrix);
+
+  const Vector3d rootpos = root->GlobalStart();
+  const Vector3d upper = tip->GlobalStart() - rootpos;
+  const Vector3d lower = tip->GlobalEnd() - tip->GlobalStart();
+  const double upper_len = upper.norm();
+  const double lower_len = lower.norm();
+  const double dist = (goal - rootpos).norm();
+
+  if (FuzzyZero(upper_len) || FuzzyZero(lower_len) || FuzzyZero(dist))
+    return false;
+
+  // bend the tip in the plane of the chain, so that the distance between root and end
+  // matches the distance to the goal (law of cosines). out of reach goals are clamped to a
+  // fully stretched or folded chain.
+  double cos_bend = (dist * dist - upper_len * upper_len - lower_len * lower_len) /
+                    (2.0 * upper_len * lower_len);
+  double bend = safe_acos(cos_bend) - angle(upper / upper_len, lower / lower_len);
+
+  // a straight chain has no plane, bend around the X axis of the tip then
+  Vector3d axis = upper.cross(lower);
+  if (axis.norm() < 1e-8 * upper_len * lower_len)
+    axis = tip->GlobalTransform().linear().col(0);
+
+  const Matrix3d &parent_basis = root->GlobalTransform().linear();
+  const Matrix3d bend_mat = Eigen::AngleAxisd(bend, axis.normalized()).toRotationMatrix();
+  tip->PrependBasis(parent_basis.transpose() * bend_mat * parent_basis);
+
+  root->UpdateTransform(m_rootmatrix);
+
+  if (m_poleconstraint) {
+    // rotate the chain around the root to point to the goal, in the plane of the pole
+    ConstrainPoleVector(root, tasks);
+    root->PrependBasis(m_rootmatrix.linear());
+  }
+  else {
+    // rotate the chain around the root to point to the goal, along the shortest arc
+    const Matrix3d rot = Eigen::Quaterniond::FromTwoVectors(tip->GlobalEnd() - rootpos,
+                                                            goal - rootpos)
+                             .toRotationMatrix();
+    const Matrix3d &rootbasis = m_rootmatrix.linear();
+    root->PrependBasis(rootbasis.transpose() * rot * rootbasis);
+  }
+
+  return true;
+}
+
 bool IK_QJacobianSolver::Solve(IK_QSegment *root,
                                std::list<IK_QTask *> tasks,
                                const double,
                                const int max_iterations)
 {
+  // plain two bone chains (arms, legs) have a closed form solution
+  if (m_twobone_analytic && TwoBoneChain(tasks) && SolveTwoBone(root, tasks))
+    return true;
+
   float scale = ComputeScale();
   bool solved = false;
   // double dt = analyze_time();
@@ -46,11 +46,20 @@ class IK_QJacobianSolver {
   // setup pole vector constraint
   void SetPoleVectorConstraint(
       IK_QSegment *tip, Vector3d &goal, Vector3d &polegoal, float poleangle, bool getangle);
+  // remove pole vector constraint, for reusing the solver with new tasks
+  void ClearPoleVectorConstraint();
   float GetPoleAngle()
   {
     return m_poleangle;
   }
 
+  // solve plain two bone chains in closed form instead of iterating, off by default
+  // because the result differs from the iterative one (it stays in the bend plane)
+  void SetTwoBoneAnalytic(bool enable)
+  {
+    m_twobone_analytic = enable;
+  }
+
   // call setup once before solving, if it fails don't solve
   bool Setup(IK_QSegment *root, std::list<IK_QTask *> &tasks);
 
@@ -62,6 +71,8 @@ class IK_QJacobianSolver {
 
  private:
   void AddSegmentList(IK_QSegment *seg);
+  bool TwoBoneChain(std::list<IK_QTask *> &tasks);
+  bool SolveTwoBone(IK_QSegment *root, std::list<IK_QTask *> &tasks);
   bool UpdateAngles(double &norm);
   void ConstrainPoleVector(IK_QSegment *root, std::list<IK_QTask *> &tasks);
 
@@ -73,6 +84,7 @@ class IK_QJacobianSolver {
   IK_QJacobian m_jacobian_sub;
 
   bool m_secondary_enabled;
+  bool m_twobone_analytic;
 
   std::vector<IK_QSegment *> m_segments;
 
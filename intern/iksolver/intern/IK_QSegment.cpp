@@ -81,6 +81,11 @@ Matrix3d IK_QSegment::BasisChange() const
   return m_orig_basis.transpose() * m_basis;
 }
 
+void IK_QSegment::SetBasisChange(const Matrix3d &change)
+{
+  SetBasis(m_orig_basis * change);
+}
+
 Vector3d IK_QSegment::TranslationChange() const
 {
   return m_translation - m_orig_translation;
@@ -117,6 +117,9 @@ class IK_QSegment {
   Matrix3d BasisChange() const;
   Vector3d TranslationChange() const;
 
+  // start from the given change in rotation w.r.t. the rest pose
+  void SetBasisChange(const Matrix3d &change);
+
   // the start and end of the segment
   const Vector3d GlobalStart() const
   {
@@ -181,6 +184,12 @@ class IK_QSegment {
   {
   }
 
+  // true if any joint limit was set
+  virtual bool HasLimits() const
+  {
+    return false;
+  }
+
   // set joint weights (per axis)
   virtual void SetWeight(int, double)
   {
@@ -252,6 +261,11 @@ class IK_QSphericalSegment : public IK_QSegment {
   void SetLimit(int axis, double lmin, double lmax);
   void SetWeight(int axis, double weight);
 
+  bool HasLimits() const
+  {
+    return m_limit_x || m_limit_y || m_limit_z;
+  }
+
  private:
   Matrix3d m_new_basis;
   bool m_limit_x, m_limit_y, m_limit_z;
@@ -297,6 +311,11 @@ class IK_QRevoluteSegment : public IK_QSegment {
   void SetWeight(int axis, double weight);
   void SetBasis(const Matrix3d &basis);
 
+  bool HasLimits() const
+  {
+    return m_limit;
+  }
+
  private:
   int m_axis;
   double m_angle, m_new_angle;
@@ -319,6 +338,11 @@ class IK_QSwingSegment : public IK_QSegment {
   void SetWeight(int axis, double weight);
   void SetBasis(const Matrix3d &basis);
 
+  bool HasLimits() const
+  {
+    return m_limit_x || m_limit_z;
+  }
+
  private:
   Matrix3d m_new_basis;
   bool m_limit_x, m_limit_z;
@@ -342,6 +366,11 @@ class IK_QElbowSegment : public IK_QSegment {
   void SetWeight(int axis, double weight);
   void SetBasis(const Matrix3d &basis);
 
+  bool HasLimits() const
+  {
+    return m_limit || m_limit_twist;
+  }
+
  private:
   int m_axis;
 
@@ -368,6 +397,11 @@ class IK_QTranslateSegment : public IK_QSegment {
   void SetWeight(int axis, double weight);
   void SetLimit(int axis, double lmin, double lmax);
 
+  bool HasLimits() const
+  {
+    return m_limit[0] || m_limit[1] || m_limit[2];
+  }
+
   void Scale(double scale);
 
  private:
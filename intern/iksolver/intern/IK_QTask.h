@@ -60,6 +60,11 @@ class IK_QTask {
     return m_active;
   }
 
+  const IK_QSegment *Segment() const
+  {
+    return m_segment;
+  }
+
   double Weight() const
   {
     return m_weight * m_weight;
@@ -110,6 +115,11 @@ class IK_QPositionTask : public IK_QTask {
     m_clamp_length *= scale;
   }
 
+  const Vector3d &Goal() const
+  {
+    return m_goal;
+  }
+
  private:
   Vector3d m_goal;
   double m_clamp_length;
@@ -272,6 +272,27 @@ void IK_GetTranslationChange(IK_Segment *seg, float *translation_change)
   translation_change[2] = (float)change[2];
 }
 
+void IK_SetBasisChange(IK_Segment *seg, float basis_change[][3])
+{
+  IK_QSegment *qseg = (IK_QSegment *)seg;
+
+  if (qseg->Translational() && qseg->Composite())
+    qseg = qseg->Composite();
+
+  // convert from blender column major
+  Matrix3d change = CreateMatrix(basis_change[0][0],
+                                 basis_change[1][0],
+                                 basis_change[2][0],
+                                 basis_change[0][1],
+                                 basis_change[1][1],
+                                 basis_change[2][1],
+                                 basis_change[0][2],
+                                 basis_change[1][2],
+                                 basis_change[2][2]);
+
+  qseg->SetBasisChange(change);
+}
+
 IK_Solver *IK_CreateSolver(IK_Segment *root)
 {
   if (root == NULL)
@@ -298,6 +319,22 @@ void IK_FreeSolver(IK_Solver *solver)
   delete qsolver;
 }
 
+void IK_SolverClearGoals(IK_Solver *solver)
+{
+  if (solver == NULL)
+    return;
+
+  IK_QSolver *qsolver = (IK_QSolver *)solver;
+  std::list<IK_QTask *> &tasks = qsolver->tasks;
+  std::list<IK_QTask *>::iterator task;
+
+  for (task = tasks.begin(); task != tasks.end(); task++)
+    delete (*task);
+
+  tasks.clear();
+  qsolver->solver.ClearPoleVectorConstraint();
+}
+
 void IK_SolverAddGoal(IK_Solver *solver, IK_Segment *tip, float goal[3], float weight)
 {
   if (solver == NULL || tip == NULL)
@@ -368,6 +405,16 @@ void IK_SolverSetPoleVectorConstraint(IK_Solver *solver,
   qsolver->solver.SetPoleVectorConstraint(qtip, qgoal, qpolegoal, poleangle, getangle);
 }
 
+void IK_SolverSetTwoBoneAnalytic(IK_Solver *solver, int enable)
+{
+  if (solver == NULL)
+    return;
+
+  IK_QSolver *qsolver = (IK_QSolver *)solver;
+
+  qsolver->solver.SetTwoBoneAnalytic(enable != 0);
+}
+
 float IK_SolverGetPoleAngle(IK_Solver *solver)
 {
   if (solver == NULL)
@@ -122,6 +122,31 @@ void evaluateFaceVarying(OpenSubdiv_Evaluator *evaluator,
       face_varying_channel, ptex_face_index, face_u, face_v, face_varying);
 }
 
+bool createLimitStencils(OpenSubdiv_Evaluator *evaluator,
+                         OpenSubdiv_TopologyRefiner *topology_refiner,
+                         const int num_points,
+                         const int *ptex_face_indices,
+                         const float *face_u,
+                         const float *face_v)
+{
+  return openSubdiv_createEvaluatorLimitStencilsInternal(
+      evaluator->internal, topology_refiner, num_points, ptex_face_indices, face_u, face_v);
+}
+
+void evaluateLimitStencils(OpenSubdiv_Evaluator *evaluator,
+                           const void *buffer,
+                           const int start_offset,
+                           const int stride,
+                           const int start_point,
+                           const int num_points,
+                           float (*P)[3],
+                           float (*dPdu)[3],
+                           float (*dPdv)[3])
+{
+  openSubdiv_evaluateLimitStencilsInternal(
+      evaluator->internal, buffer, start_offset, stride, start_point, num_points, P, dPdu, dPdv);
+}
+
 void assignFunctionPointers(OpenSubdiv_Evaluator *evaluator)
 {
   evaluator->setCoarsePositions = setCoarsePositions;
@@ -137,6 +162,9 @@ void assignFunctionPointers(OpenSubdiv_Evaluator *evaluator)
   evaluator->evaluateLimit = evaluateLimit;
   evaluator->evaluateVarying = evaluateVarying;
   evaluator->evaluateFaceVarying = evaluateFaceVarying;
+
+  evaluator->createLimitStencils = createLimitStencils;
+  evaluator->evaluateLimitStencils = evaluateLimitStencils;
 }
 
 }  // namespace
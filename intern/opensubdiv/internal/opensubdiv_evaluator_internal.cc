@@ -20,6 +20,7 @@
 
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 
 #ifdef _MSC_VER
 #  include <iso646.h>
@@ -28,6 +29,8 @@
 #include <opensubdiv/far/patchMap.h>
 #include <opensubdiv/far/patchTable.h>
 #include <opensubdiv/far/patchTableFactory.h>
+#include <opensubdiv/far/stencilTable.h>
+#include <opensubdiv/far/stencilTableFactory.h>
 #include <opensubdiv/osd/cpuEvaluator.h>
 #include <opensubdiv/osd/cpuPatchTable.h>
 #include <opensubdiv/osd/cpuVertexBuffer.h>
@@ -42,6 +45,8 @@
 #include "internal/opensubdiv_util.h"
 #include "opensubdiv_topology_refiner_capi.h"
 
+using OpenSubdiv::Far::LimitStencilTable;
+using OpenSubdiv::Far::LimitStencilTableFactory;
 using OpenSubdiv::Far::PatchMap;
 using OpenSubdiv::Far::PatchTable;
 using OpenSubdiv::Far::PatchTableFactory;
@@ -692,7 +697,7 @@ void CpuEvalOutputAPI::evaluateFaceVarying(const int face_varying_channel,
 }  // namespace opensubdiv_capi
 
 OpenSubdiv_EvaluatorInternal::OpenSubdiv_EvaluatorInternal()
-    : eval_output(NULL), patch_map(NULL), patch_table(NULL)
+    : eval_output(NULL), patch_map(NULL), patch_table(NULL), limit_stencils(NULL)
 {
 }
 
@@ -701,6 +706,7 @@ OpenSubdiv_EvaluatorInternal::~OpenSubdiv_EvaluatorInternal()
   delete eval_output;
   delete patch_map;
   delete patch_table;
+  delete limit_stencils;
 }
 
 OpenSubdiv_EvaluatorInternal *openSubdiv_createEvaluatorInternal(
@@ -838,3 +844,118 @@ void openSubdiv_deleteEvaluatorInternal(OpenSubdiv_EvaluatorInternal *evaluator)
 {
   OBJECT_GUARDED_DELETE(evaluator, OpenSubdiv_EvaluatorInternal);
 }
+
+bool openSubdiv_createEvaluatorLimitStencilsInternal(
+    OpenSubdiv_EvaluatorInternal *evaluator,
+    OpenSubdiv_TopologyRefiner *topology_refiner,
+    const int num_points,
+    const int *ptex_face_indices,
+    const float *face_u,
+    const float *face_v)
+{
+  delete evaluator->limit_stencils;
+  evaluator->limit_stencils = NULL;
+  if (num_points == 0) {
+    return false;
+  }
+  TopologyRefiner *refiner = topology_refiner->internal->osd_topology_refiner;
+  // Limit stencils are factorized through the patch table, which is only
+  // compatible with the stencils of an adaptively refined topology.
+  if (refiner == NULL || !topology_refiner->getIsAdaptive(topology_refiner)) {
+    return false;
+  }
+  // Stencils of all refined vertices, including the coarse ones. This way
+  // the limit stencils are expressed in coarse vertices only.
+  StencilTableFactory::Options vertex_stencil_options;
+  vertex_stencil_options.generateOffsets = true;
+  vertex_stencil_options.generateIntermediateLevels = true;
+  vertex_stencil_options.generateControlVerts = true;
+  const StencilTable *vertex_stencils = StencilTableFactory::Create(*refiner,
+                                                                    vertex_stencil_options);
+  const PatchTable *patch_table = evaluator->patch_table;
+  const StencilTable *local_point_stencil_table = patch_table->GetLocalPointStencilTable();
+  if (local_point_stencil_table != NULL) {
+    const StencilTable *table = StencilTableFactory::AppendLocalPointStencilTable(
+        *refiner, vertex_stencils, local_point_stencil_table);
+    delete vertex_stencils;
+    vertex_stencils = table;
+  }
+  // Use location array per point, so stencils are stored in the order of
+  // points.
+  LimitStencilTableFactory::LocationArrayVec location_arrays(num_points);
+  for (int point_index = 0; point_index < num_points; ++point_index) {
+    LimitStencilTableFactory::LocationArray &location_array = location_arrays[point_index];
+    location_array.ptexIdx = ptex_face_indices[point_index];
+    location_array.numLocations = 1;
+    location_array.s = &face_u[point_index];
+    location_array.t = &face_v[point_index];
+  }
+  LimitStencilTableFactory::Options limit_stencil_options;
+  limit_stencil_options.generate1stDerivatives = true;
+  const LimitStencilTable *limit_stencils = LimitStencilTableFactory::Create(
+      *refiner, location_arrays, vertex_stencils, patch_table, limit_stencil_options);
+  delete vertex_stencils;
+  // Points for which there is no patch are skipped by the factory, which
+  // breaks the correspondence of stencils and points.
+  if (limit_stencils == NULL || limit_stencils->GetNumStencils() != num_points) {
+    delete limit_stencils;
+    return false;
+  }
+  evaluator->limit_stencils = limit_stencils;
+  return true;
+}
+
+void openSubdiv_evaluateLimitStencilsInternal(const OpenSubdiv_EvaluatorInternal *evaluator,
+                                              const void *buffer,
+                                              const int start_offset,
+                                              const int stride,
+                                              const int start_point,
+                                              const int num_points,
+                                              float (*P)[3],
+                                              float (*dPdu)[3],
+                                              float (*dPdv)[3])
+{
+  const LimitStencilTable *limit_stencils = evaluator->limit_stencils;
+  assert(limit_stencils != NULL);
+  assert(start_point + num_points <= limit_stencils->GetNumStencils());
+  if (num_points == 0) {
+    return;
+  }
+  const unsigned char *coarse_buffer = (const unsigned char *)buffer + start_offset;
+  const int *sizes = &limit_stencils->GetSizes()[0];
+  const OpenSubdiv::Far::Index *offsets = &limit_stencils->GetOffsets()[0];
+  const OpenSubdiv::Far::Index *indices = &limit_stencils->GetControlIndices()[0];
+  const float *weights = &limit_stencils->GetWeights()[0];
+  const float *du_weights = &limit_stencils->GetDuWeights()[0];
+  const float *dv_weights = &limit_stencils->GetDvWeights()[0];
+  const bool need_derivatives = (dPdu != NULL || dPdv != NULL);
+  for (int i = 0; i < num_points; ++i) {
+    const int stencil_index = start_point + i;
+    const int offset = offsets[stencil_index];
+    float point[3] = {0.0f, 0.0f, 0.0f};
+    float du[3] = {0.0f, 0.0f, 0.0f};
+    float dv[3] = {0.0f, 0.0f, 0.0f};
+    for (int j = offset; j < offset + sizes[stencil_index]; ++j) {
+      const float *co = reinterpret_cast<const float *>(coarse_buffer +
+                                                        (size_t)indices[j] * stride);
+      point[0] += weights[j] * co[0];
+      point[1] += weights[j] * co[1];
+      point[2] += weights[j] * co[2];
+      if (need_derivatives) {
+        du[0] += du_weights[j] * co[0];
+        du[1] += du_weights[j] * co[1];
+        du[2] += du_weights[j] * co[2];
+        dv[0] += dv_weights[j] * co[0];
+        dv[1] += dv_weights[j] * co[1];
+        dv[2] += dv_weights[j] * co[2];
+      }
+    }
+    memcpy(P[i], point, sizeof(point));
+    if (dPdu != NULL) {
+      memcpy(dPdu[i], du, sizeof(du));
+    }
+    if (dPdv != NULL) {
+      memcpy(dPdv[i], dv, sizeof(dv));
+    }
+  }
+}
@@ -25,6 +25,7 @@
 
 #include <opensubdiv/far/patchMap.h>
 #include <opensubdiv/far/patchTable.h>
+#include <opensubdiv/far/stencilTable.h>
 
 struct OpenSubdiv_TopologyRefiner;
 
@@ -129,11 +130,31 @@ struct OpenSubdiv_EvaluatorInternal {
   opensubdiv_capi::CpuEvalOutputAPI *eval_output;
   const OpenSubdiv::Far::PatchMap *patch_map;
   const OpenSubdiv::Far::PatchTable *patch_table;
+  // Optional limit stencils of points requested from Blender side.
+  const OpenSubdiv::Far::LimitStencilTable *limit_stencils;
 };
 
 OpenSubdiv_EvaluatorInternal *openSubdiv_createEvaluatorInternal(
     struct OpenSubdiv_TopologyRefiner *topology_refiner);
 
+bool openSubdiv_createEvaluatorLimitStencilsInternal(
+    OpenSubdiv_EvaluatorInternal *evaluator,
+    struct OpenSubdiv_TopologyRefiner *topology_refiner,
+    const int num_points,
+    const int *ptex_face_indices,
+    const float *face_u,
+    const float *face_v);
+
+void openSubdiv_evaluateLimitStencilsInternal(const OpenSubdiv_EvaluatorInternal *evaluator,
+                                              const void *buffer,
+                                              const int start_offset,
+                                              const int stride,
+                                              const int start_point,
+                                              const int num_points,
+                                              float (*P)[3],
+                                              float (*dPdu)[3],
+                                              float (*dPdv)[3]);
+
 void openSubdiv_deleteEvaluatorInternal(OpenSubdiv_EvaluatorInternal *evaluator);
 
 #endif  // OPENSUBDIV_EVALUATOR_INTERNAL_H_
@@ -19,6 +19,8 @@
 #ifndef OPENSUBDIV_EVALUATOR_CAPI_H_
 #define OPENSUBDIV_EVALUATOR_CAPI_H_
 
+#include <stdint.h>  // for bool
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -108,6 +110,41 @@ typedef struct OpenSubdiv_Evaluator {
                               float face_v,
                               float face_varying[2]);
 
+  // Create limit stencils of the given points, replacing previously created
+  // ones. Every point is given by a ptex face index and (u, v) coordinate
+  // within that face.
+  //
+  // Stencils express limit position and derivatives of a point as a weighted
+  // sum of coarse vertex positions, so evaluating them does not require the
+  // evaluator to be refined for the new coarse positions.
+  //
+  // Returns false if stencils could not be created for all of the points, or
+  // there are no points.
+  bool (*createLimitStencils)(struct OpenSubdiv_Evaluator *evaluator,
+                              struct OpenSubdiv_TopologyRefiner *topology_refiner,
+                              const int num_points,
+                              const int *ptex_face_indices,
+                              const float *face_u,
+                              const float *face_v);
+
+  // Evaluate limit stencils of points [start_point, start_point + num_points)
+  // for coarse vertex positions stored in a continuous memory buffer, where
+  // first coordinate starts at offset of `start_offset` and there is `stride`
+  // bytes between adjacent vertex coordinates.
+  //
+  // If derivatives are NULL, they will not be evaluated.
+  //
+  // NOTE: Is safe to be called from multiple threads at once.
+  void (*evaluateLimitStencils)(struct OpenSubdiv_Evaluator *evaluator,
+                                const void *buffer,
+                                const int start_offset,
+                                const int stride,
+                                const int start_point,
+                                const int num_points,
+                                float (*P)[3],
+                                float (*dPdu)[3],
+                                float (*dPdv)[3]);
+
   // Internal storage for the use in this module only.
   //
   // This is where actual OpenSubdiv's evaluator is living.
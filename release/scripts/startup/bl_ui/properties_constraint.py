@@ -167,6 +167,7 @@ class ConstraintButtonsPanel:
             col = split.column()
             col.prop(con, "use_tail")
             col.prop(con, "use_stretch")
+            col.prop(con, "use_two_bone_analytic")
 
             layout.label(text="Weight:")
 
@@ -1054,6 +1054,10 @@ class DATA_PT_modifiers(ModifierButtonsPanel, Panel):
 
         col.prop(md, "show_only_control_edges")
         col.prop(md, "use_creases")
+        col.prop(md, "use_topology_cache")
+        sub = col.column()
+        sub.active = md.use_topology_cache
+        sub.prop(md, "use_limit_stencils")
 
         if show_adaptive_options and ob.cycles.use_adaptive_subdivision:
             col = layout.column(align=True)
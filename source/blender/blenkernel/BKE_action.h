@@ -209,6 +209,9 @@ void what_does_obaction(struct Object *ob,
                         struct bAction *act,
                         char groupname[],
                         float cframe);
+bool BKE_action_pose_channel_evaluate(struct bAction *act,
+                                      struct bPoseChannel *pchan,
+                                      float cframe);
 
 /* for proxy */
 void BKE_pose_copyesult_pchan_result(struct bPoseChannel *pchanto,
@@ -55,6 +55,12 @@ typedef struct PoseTree {
   float (*basis_change)[3][3]; /* basis change result from solver */
   int iterations;              /* iterations from the constraint */
   int stretch;                 /* disable stretching */
+  int two_bone_analytic;       /* closed form solution for two bone chains */
+
+  /* Solver state kept between evaluations, owned by the IK solver plugin. */
+  void **segments;   /* solver segments of the pose channels */
+  int *segment_flag; /* DoF and limits the segments were created with */
+  void *solver;      /* solver, only rebuilt together with the segments */
 } PoseTree;
 
 /*  Core armature functionality */
@@ -118,6 +124,12 @@ void BKE_pose_where_is_bone(struct Depsgraph *depsgraph,
                             float ctime,
                             bool do_extra);
 void BKE_pose_where_is_bone_tail(struct bPoseChannel *pchan);
+void BKE_pose_where_is_levels(struct Depsgraph *depsgraph,
+                              struct Scene *scene,
+                              struct Object *ob,
+                              float ctime);
+void BKE_pose_eval_levels_ensure(struct Object *ob);
+void BKE_pose_eval_levels_free(struct bPose *pose);
 
 /* get_objectspace_bone_matrix has to be removed still */
 void get_objectspace_bone_matrix(struct Bone *bone,
@@ -330,6 +342,10 @@ void BKE_pose_splineik_evaluate(struct Depsgraph *depsgraph,
                                 struct Object *object,
                                 int rootchan_index);
 
+void BKE_pose_eval_batched(struct Depsgraph *depsgraph,
+                           struct Scene *scene,
+                           struct Object *object);
+
 void BKE_pose_eval_done(struct Depsgraph *depsgraph, struct Object *object);
 
 void BKE_pose_eval_cleanup(struct Depsgraph *depsgraph,
@@ -34,6 +34,7 @@ struct BMEditMesh;
 struct MFace;
 struct MVert;
 struct Mesh;
+struct Object;
 
 typedef struct LinkNode BVHCache;
 
@@ -198,6 +199,15 @@ BVHTree *BKE_bvhtree_from_editmesh_get(BVHTreeFromEditMesh *data,
                                        const int bvh_cache_type,
                                        BVHCache **bvh_cache);
 
+BVHTree *BKE_bvhtree_from_object_mesh_get(struct BVHTreeFromMesh *data,
+                                          struct Object *ob_eval,
+                                          struct Mesh *mesh,
+                                          const int bvh_cache_type,
+                                          const int tree_type);
+
+void BKE_bvhtree_object_persistent_invalidate(struct Object *ob);
+void BKE_bvhtree_object_persistent_free(struct Object *ob);
+
 /**
  * Frees data allocated by a call to bvhtree_from_mesh_*.
  */
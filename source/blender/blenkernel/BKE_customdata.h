@@ -69,10 +69,17 @@ typedef enum eCDAllocType {
   CD_CALLOC = 1,
   /** Allocate and set to default. */
   CD_DEFAULT = 2,
-  /** Use data pointers, set layer flag NOFREE. */
+  /** Use data pointers, set layer flag NOFREE (shared source data gets shared, see #CD_SHARE). */
   CD_REFERENCE = 3,
   /** Do a full copy of all layers, only allowed if source has same number of elements. */
   CD_DUPLICATE = 4,
+  /**
+   * Share data pointers with the source layers, counting users instead of copying.
+   * The data is freed with its last user, layers are only duplicated once written to
+   * (see #CustomData_duplicate_referenced_layer), only allowed if source has same number
+   * of elements.
+   */
+  CD_SHARE = 5,
 } eCDAllocType;
 
 #define CD_TYPE_AS_MASK(_type) (CustomDataMask)((CustomDataMask)1 << (CustomDataMask)(_type))
@@ -231,6 +238,7 @@ void *CustomData_duplicate_referenced_layer_named(struct CustomData *data,
                                                   const char *name,
                                                   const int totelem);
 bool CustomData_is_referenced_layer(struct CustomData *data, int type);
+void CustomData_unshare_layers(struct CustomData *data, CustomDataMask mask);
 
 /* set the CD_FLAG_NOCOPY flag in custom data layers where the mask is
  * zero for the layer type, so only layer types specified by the mask
@@ -108,10 +108,18 @@ void BKE_driver_invalidate_expression(struct ChannelDriver *driver,
                                       bool expr_changed,
                                       bool varname_changed);
 
+int BKE_driver_resolve_variable_targets(struct ChannelDriver *driver,
+                                        struct PathResolvedRNA *r_var_targets);
+
 float evaluate_driver(struct PathResolvedRNA *anim_rna,
                       struct ChannelDriver *driver,
                       struct ChannelDriver *driver_orig,
                       const float evaltime);
+float evaluate_driver_ex(struct PathResolvedRNA *anim_rna,
+                         struct ChannelDriver *driver,
+                         struct ChannelDriver *driver_orig,
+                         struct PathResolvedRNA *var_targets,
+                         const float evaltime);
 
 /* ************** F-Curve Modifiers *************** */
 
@@ -335,14 +343,24 @@ void correct_bezpart(float v1[2], float v2[2], float v3[2], float v4[2]);
 
 /* evaluate fcurve */
 float evaluate_fcurve(struct FCurve *fcu, float evaltime);
+float evaluate_fcurve_sequential(struct FCurve *fcu, float evaltime, int *segment_hint);
 float evaluate_fcurve_only_curve(struct FCurve *fcu, float evaltime);
 float evaluate_fcurve_driver(struct PathResolvedRNA *anim_rna,
                              struct FCurve *fcu,
                              struct ChannelDriver *driver_orig,
                              float evaltime);
+float evaluate_fcurve_driver_ex(struct PathResolvedRNA *anim_rna,
+                                struct FCurve *fcu,
+                                struct ChannelDriver *driver_orig,
+                                struct PathResolvedRNA *var_targets,
+                                float evaltime);
 bool BKE_fcurve_is_empty(struct FCurve *fcu);
 /* evaluate fcurve and store value */
 float calculate_fcurve(struct PathResolvedRNA *anim_rna, struct FCurve *fcu, float evaltime);
+float calculate_fcurve_ex(struct PathResolvedRNA *anim_rna,
+                          struct FCurve *fcu,
+                          float evaltime,
+                          int *segment_hint);
 
 /* ************* F-Curve Samples API ******************** */
 
@@ -26,6 +26,7 @@
 
 #include "BLI_compiler_attrs.h"
 
+struct ArmatureSkinCache;
 struct BPoint;
 struct Depsgraph;
 struct Lattice;
@@ -87,6 +88,18 @@ void armature_deform_verts(struct Object *armOb,
                            float (*prevCos)[3],
                            const char *defgrp_name,
                            struct bGPDstroke *gps);
+void armature_deform_verts_ex(struct Object *armOb,
+                              struct Object *target,
+                              const struct Mesh *mesh,
+                              float (*vert_coords)[3],
+                              float (*defMats)[3][3],
+                              int numVerts,
+                              int deformflag,
+                              float (*prevCos)[3],
+                              const char *defgrp_name,
+                              struct bGPDstroke *gps,
+                              struct ArmatureSkinCache **r_skin_cache);
+void BKE_armature_skin_cache_free(struct ArmatureSkinCache *cache);
 
 float (*BKE_lattice_vert_coords_alloc(const struct Lattice *lt, int *r_vert_len))[3];
 void BKE_lattice_vert_coords_get(const struct Lattice *lt, float (*vert_coords)[3]);
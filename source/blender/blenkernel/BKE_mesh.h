@@ -56,6 +56,7 @@ struct MVert;
 struct Main;
 struct MemArena;
 struct Mesh;
+struct MeshElemMap;
 struct ModifierData;
 struct Object;
 struct Scene;
@@ -111,6 +112,7 @@ void BKE_mesh_copy_data(struct Main *bmain,
                         const int flag);
 struct Mesh *BKE_mesh_copy(struct Main *bmain, const struct Mesh *me);
 void BKE_mesh_update_customdata_pointers(struct Mesh *me, const bool do_ensure_tess_cd);
+void BKE_mesh_unshare_layers(struct Mesh *me, const struct CustomData_MeshMasks *mask);
 void BKE_mesh_ensure_skin_customdata(struct Mesh *me);
 
 struct Mesh *BKE_mesh_new_nomain(
@@ -296,6 +298,48 @@ void BKE_mesh_calc_normals_mapping_ex(struct MVert *mverts,
                                       const int *origIndexFace,
                                       float (*r_faceNors)[3],
                                       const bool only_face_normals);
+
+/**
+ * Vertex to loops mapping, used to gather vertex normals in parallel.
+ * Only depends on topology, so meshes which only get deformed can keep it around between
+ * evaluations, see #BKE_mesh_calc_normals_poly_ex.
+ */
+typedef struct MVertLoopMap {
+  /** Topology the map was built from, see #BKE_mesh_vert_loop_map_cache_matches. */
+  const struct MLoop *mloops;
+  const struct MPoly *mpolys;
+  int numVerts, numLoops, numPolys;
+
+  /** Number of meshes using this cache, see #BKE_mesh_runtime_vert_loop_map_share. */
+  int users;
+
+  struct MeshElemMap *map;
+  int *mem;
+} MVertLoopMap;
+
+MVertLoopMap *BKE_mesh_vert_loop_map_cache_create(const struct MLoop *mloops,
+                                                  const int numLoops,
+                                                  const struct MPoly *mpolys,
+                                                  const int numPolys,
+                                                  const int numVerts);
+bool BKE_mesh_vert_loop_map_cache_matches(const MVertLoopMap *vert_loop_map,
+                                          const struct MLoop *mloops,
+                                          const int numLoops,
+                                          const struct MPoly *mpolys,
+                                          const int numPolys,
+                                          const int numVerts);
+void BKE_mesh_vert_loop_map_cache_free(MVertLoopMap *vert_loop_map);
+
+void BKE_mesh_calc_normals_poly_ex(struct MVert *mverts,
+                                   float (*r_vertnors)[3],
+                                   int numVerts,
+                                   const struct MLoop *mloop,
+                                   const struct MPoly *mpolys,
+                                   int numLoops,
+                                   int numPolys,
+                                   float (*r_polyNors)[3],
+                                   const bool only_face_normals,
+                                   const struct MeshElemMap *vert_to_loop);
 void BKE_mesh_calc_normals_poly(struct MVert *mverts,
                                 float (*r_vertnors)[3],
                                 int numVerts,
@@ -409,7 +453,62 @@ void BKE_lnor_space_custom_normal_to_data(MLoopNorSpace *lnor_space,
                                           const float custom_lnor[3],
                                           short r_clnor_data[2]);
 
+/**
+ * Smooth fans of loops used to compute split normals, i.e. the loops around a vertex which share
+ * a same normal. Those only depend on topology and sharp edges/faces (not on the split angle),
+ * so meshes which only get deformed can keep them around between evaluations.
+ */
+typedef struct MLoopFans {
+  /** Topology the fans were built from, see #BKE_mesh_loop_fans_matches. */
+  const struct MEdge *medges;
+  const struct MLoop *mloops;
+  const struct MPoly *mpolys;
+  int numEdges, numLoops, numPolys;
+
+  /** Number of meshes using this cache, see #BKE_mesh_runtime_loop_fans_share. */
+  int users;
+
+  /** Edge to loops mapping, ignoring the split angle, see #BKE_mesh_normals_loop_split. */
+  int (*edge_to_loops)[2];
+  int *loop_to_poly;
+
+  /** First loop of each fan (or single sharp loop), in the order they are computed. */
+  int *fan_loops;
+  int totfan;
+} MLoopFans;
+
+MLoopFans *BKE_mesh_loop_fans_create(const struct MEdge *medges,
+                                     const int numEdges,
+                                     const struct MLoop *mloops,
+                                     const int numLoops,
+                                     const struct MPoly *mpolys,
+                                     const int numPolys);
+bool BKE_mesh_loop_fans_matches(const MLoopFans *fans,
+                                const struct MEdge *medges,
+                                const int numEdges,
+                                const struct MLoop *mloops,
+                                const int numLoops,
+                                const struct MPoly *mpolys,
+                                const int numPolys);
+void BKE_mesh_loop_fans_free(MLoopFans *fans);
+
 /* Medium-level custom normals functions. */
+void BKE_mesh_normals_loop_split_ex(const struct MVert *mverts,
+                                    const int numVerts,
+                                    struct MEdge *medges,
+                                    const int numEdges,
+                                    struct MLoop *mloops,
+                                    float (*r_loopnors)[3],
+                                    const int numLoops,
+                                    struct MPoly *mpolys,
+                                    const float (*polynors)[3],
+                                    const int numPolys,
+                                    const bool use_split_normals,
+                                    const float split_angle,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    short (*clnors_data)[2],
+                                    int *r_loop_to_poly,
+                                    const MLoopFans *loop_fans);
 void BKE_mesh_normals_loop_split(const struct MVert *mverts,
                                  const int numVerts,
                                  struct MEdge *medges,
@@ -47,6 +47,9 @@ bool BKE_mesh_runtime_ensure_edit_data(struct Mesh *mesh);
 bool BKE_mesh_runtime_clear_edit_data(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_geometry(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_cache(struct Mesh *mesh);
+void BKE_mesh_runtime_loop_fans_share(struct Mesh *mesh_src, struct Mesh *mesh_dst);
+void BKE_mesh_runtime_vert_loop_map_share(struct Mesh *mesh_src, struct Mesh *mesh_dst);
+const float (*BKE_mesh_runtime_vert_normals_get(const struct Mesh *mesh))[3];
 
 void BKE_mesh_runtime_verttri_from_looptri(struct MVertTri *r_verttri,
                                            const struct MLoop *mloop,
@@ -282,6 +282,7 @@ void BKE_pbvh_node_layer_disp_free(PBVHNode *node);
 float (*BKE_pbvh_vert_coords_alloc(struct PBVH *pbvh))[3];
 void BKE_pbvh_vert_coords_apply(struct PBVH *pbvh, const float (*vertCos)[3], const int totvert);
 bool BKE_pbvh_is_deformed(struct PBVH *pbvh);
+void BKE_pbvh_mesh_verts_update(struct PBVH *pbvh, struct MVert *verts);
 
 /* Vertex Iterator */
 
@@ -89,8 +89,10 @@ typedef struct ShrinkwrapTreeData {
 /* Checks if the modifier needs target normals with these settings. */
 bool BKE_shrinkwrap_needs_normals(int shrinkType, int shrinkMode);
 
-/* Initializes the mesh data structure from the given mesh and settings. */
+/* Initializes the mesh data structure from the given mesh and settings,
+ * the evaluated object of the mesh is optional. */
 bool BKE_shrinkwrap_init_tree(struct ShrinkwrapTreeData *data,
+                              struct Object *ob,
                               Mesh *mesh,
                               int shrinkType,
                               int shrinkMode,
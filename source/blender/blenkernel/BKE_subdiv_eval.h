@@ -87,6 +87,34 @@ void BKE_subdiv_eval_displacement(struct Subdiv *subdiv,
 void BKE_subdiv_eval_final_point(
     struct Subdiv *subdiv, const int ptex_face_index, const float u, const float v, float r_P[3]);
 
+/* Limit stencils.
+ *
+ * Stencils of a fixed set of points, which are weights of coarse vertices
+ * positions. They allow to evaluate those points for new coarse positions
+ * without refining the evaluator. */
+
+/* Create stencils for the given points, replacing the ones created before.
+ * Returns false if stencils could not be created, or there are no points. */
+bool BKE_subdiv_eval_limit_stencils_create(struct Subdiv *subdiv,
+                                           const int num_points,
+                                           const int *ptex_face_indices,
+                                           const float *u,
+                                           const float *v);
+
+/* Evaluate stencils of points [start_point, start_point + num_points) for
+ * coordinates of the mesh vertices. Derivatives are not evaluated when NULL.
+ *
+ * NOTE: Vertices of the mesh are expected to match vertices of the subdiv
+ * topology, meaning there are no vertices which are not used by faces.
+ * NOTE: Is safe to be called from threads. */
+void BKE_subdiv_eval_limit_stencils(struct Subdiv *subdiv,
+                                    const struct Mesh *mesh,
+                                    const int start_point,
+                                    const int num_points,
+                                    float (*r_P)[3],
+                                    float (*r_dPdu)[3],
+                                    float (*r_dPdv)[3]);
+
 /* Patch queries at given resolution.
  *
  * Will evaluate patch at uniformly distributed (u, v) coordinates on a grid
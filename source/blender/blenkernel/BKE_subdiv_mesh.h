@@ -28,6 +28,7 @@
 
 struct Mesh;
 struct Subdiv;
+struct SubdivMeshCache;
 
 typedef struct SubdivToMeshSettings {
   /* Resolution at which regular ptex (created for quad polygon) are being
@@ -46,4 +47,33 @@ struct Mesh *BKE_subdiv_to_mesh(struct Subdiv *subdiv,
                                 const SubdivToMeshSettings *settings,
                                 const struct Mesh *coarse_mesh);
 
+/* Same as above, but keeps the result in a cache, so that subdividing a
+ * coarse mesh which only differs in vertex positions only evaluates vertex
+ * coordinates and normals: edges, loops, polygons and all interpolated custom
+ * data are shared with the previous result, without traversing subdivision
+ * topology again.
+ *
+ * The base mesh is the mesh coarse one is deformed from: custom data of the
+ * coarse mesh other than vertices is to be referenced from it (which is the
+ * case after deform-only modifiers), and it is to be a copy-on-write mesh, so
+ * that changes to it are detected. The cache is not created when that is not
+ * the case, or for coarse meshes with loose geometry or displacement.
+ *
+ * With use_limit_stencils vertices are evaluated from limit stencils, which
+ * also avoids refining the evaluator for new coarse positions.
+ *
+ * The result is only kept once a coarse mesh which only differs in vertex
+ * positions from the previous one is subdivided, before that the cache only
+ * remembers what was subdivided. When settings, the coarse or the base mesh
+ * changed in anything else than vertex positions the kept result is freed.
+ * The cache is only valid for the subdiv it was created with. */
+struct Mesh *BKE_subdiv_to_mesh_cached(struct Subdiv *subdiv,
+                                       const SubdivToMeshSettings *settings,
+                                       const struct Mesh *coarse_mesh,
+                                       const struct Mesh *base_mesh,
+                                       const bool use_limit_stencils,
+                                       struct SubdivMeshCache **cache);
+
+void BKE_subdiv_mesh_cache_free(struct SubdivMeshCache *cache);
+
 #endif /* __BKE_SUBDIV)MESH_H__ */
@@ -805,7 +805,7 @@ static void mesh_copy_autosmooth(Mesh *me, Mesh *me_orig)
   }
 }
 
-static void mesh_calc_modifier_final_normals(const Mesh *mesh_input,
+static void mesh_calc_modifier_final_normals(Mesh *mesh_input,
                                              const CustomData_MeshMasks *final_datamask,
                                              const bool sculpt_dyntopo,
                                              Mesh *mesh_final)
@@ -838,6 +838,9 @@ static void mesh_calc_modifier_final_normals(const Mesh *mesh_input,
   }
 
   if (do_loop_normals) {
+    /* Smooth fans only depend on topology, reuse them from the input mesh when the modifiers
+     * kept it (e.g. only deformed it), they are then not searched again on each evaluation. */
+    BKE_mesh_runtime_loop_fans_share(mesh_input, mesh_final);
     /* Compute loop normals (note: will compute poly and vert normals as well, if needed!) */
     BKE_mesh_calc_normals_split(mesh_final);
     BKE_mesh_tessface_clear(mesh_final);
@@ -859,6 +862,10 @@ static void mesh_calc_modifier_final_normals(const Mesh *mesh_input,
      * If using loop normals, poly nors have already been computed.
      */
     if (!do_loop_normals) {
+      if (mesh_final->runtime.cd_dirty_vert & CD_MASK_NORMAL) {
+        /* Vertex to loops mapping only depends on topology, like smooth fans above. */
+        BKE_mesh_runtime_vert_loop_map_share(mesh_input, mesh_final);
+      }
       BKE_mesh_ensure_normals_for_display(mesh_final);
     }
   }
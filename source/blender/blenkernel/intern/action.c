@@ -62,6 +62,8 @@
 
 #include "CLG_log.h"
 
+#include "atomic_ops.h"
+
 static CLG_LogRef LOG = {"bke.action"};
 
 /* *********************** NOTE ON POSE AND ACTION **********************
@@ -79,6 +81,8 @@ static CLG_LogRef LOG = {"bke.action"};
 
 /* ***************** Library data level operations on action ************** */
 
+static void action_channel_cache_free(struct ActionChannelCache *cache);
+
 bAction *BKE_action_add(Main *bmain, const char name[])
 {
   bAction *act;
@@ -111,6 +115,12 @@ void BKE_action_free(bAction *act)
 
   /* Free pose-references (aka local markers) */
   BLI_freelistN(&act->markers);
+
+  /* Free evaluation cache */
+  if (act->channel_cache) {
+    action_channel_cache_free(act->channel_cache);
+    act->channel_cache = NULL;
+  }
 }
 
 /* .................................. */
@@ -133,6 +143,9 @@ void BKE_action_copy_data(Main *UNUSED(bmain),
   bActionGroup *grp_dst, *grp_src;
   FCurve *fcu_dst, *fcu_src;
 
+  /* F-Curves are re-allocated, the cache is built again on evaluation */
+  act_dst->channel_cache = NULL;
+
   /* duplicate the lists of groups and markers */
   BLI_duplicatelist(&act_dst->groups, &act_src->groups);
   BLI_duplicatelist(&act_dst->markers, &act_src->markers);
@@ -414,6 +427,38 @@ void action_groups_clear_tempflags(bAction *act)
 
 /* *************** Pose channels *************** */
 
+static GHash *pose_channels_hash_create(const bPose *pose)
+{
+  GHash *chanhash = BLI_ghash_str_new_ex("make_pose_chan gh",
+                                         BLI_listbase_count(&pose->chanbase));
+  LISTBASE_FOREACH (bPoseChannel *, pchan, &pose->chanbase) {
+    BLI_ghash_insert(chanhash, pchan->name, pchan);
+  }
+  return chanhash;
+}
+
+/**
+ * Build the name hash on first use, so copies of the pose (copy-on-write most notably)
+ * do not pay for it unless something looks channels up by name.
+ *
+ * \note Lookups happen from threaded pose evaluation, the first hash stored wins.
+ */
+static GHash *pose_channels_hash_ensure(const bPose *pose)
+{
+  GHash *chanhash = pose->chanhash;
+
+  if (chanhash == NULL) {
+    chanhash = pose_channels_hash_create(pose);
+    GHash *chanhash_prev = atomic_cas_ptr((void **)&((bPose *)pose)->chanhash, NULL, chanhash);
+    if (chanhash_prev != NULL) {
+      BLI_ghash_free(chanhash, NULL, NULL);
+      chanhash = chanhash_prev;
+    }
+  }
+
+  return chanhash;
+}
+
 /**
  * Return a pointer to the pose channel of the given name
  * from this pose.
@@ -424,8 +469,9 @@ bPoseChannel *BKE_pose_channel_find_name(const bPose *pose, const char *name)
     return NULL;
   }
 
-  if (pose->chanhash) {
-    return BLI_ghash_lookup(pose->chanhash, (const void *)name);
+  /* Not worth hashing a single channel (temporary poses of action constraints). */
+  if (pose->chanhash || (pose->chanbase.first != pose->chanbase.last)) {
+    return BLI_ghash_lookup(pose_channels_hash_ensure(pose), (const void *)name);
   }
 
   return BLI_findstring(&((const bPose *)pose)->chanbase, name, offsetof(bPoseChannel, name));
@@ -586,6 +632,52 @@ const char *BKE_pose_ikparam_get_name(bPose *pose)
   return NULL;
 }
 
+static bool pose_channel_has_links(const bPoseChannel *pchan)
+{
+  return (pchan->custom_tx || pchan->bbone_prev || pchan->bbone_next);
+}
+
+/**
+ * Point the links between channels of a freshly duplicated pose to its own channels.
+ * Both channel lists are in the same order, so this maps channels by position
+ * instead of looking each target up by name.
+ */
+static void pose_channels_remap_links(bPose *dst, const bPose *src)
+{
+  bPoseChannel *pchan, *pchan_src;
+  bool has_links = false;
+
+  for (pchan = dst->chanbase.first; pchan; pchan = pchan->next) {
+    if (pose_channel_has_links(pchan)) {
+      has_links = true;
+      break;
+    }
+  }
+  if (!has_links) {
+    return;
+  }
+
+  GHash *pchan_map = BLI_ghash_ptr_new_ex(__func__, BLI_listbase_count(&src->chanbase));
+  for (pchan = dst->chanbase.first, pchan_src = src->chanbase.first; pchan && pchan_src;
+       pchan = pchan->next, pchan_src = pchan_src->next) {
+    BLI_ghash_insert(pchan_map, pchan_src, pchan);
+  }
+
+  for (pchan = dst->chanbase.first; pchan; pchan = pchan->next) {
+    if (pchan->custom_tx) {
+      pchan->custom_tx = BLI_ghash_lookup(pchan_map, pchan->custom_tx);
+    }
+    if (pchan->bbone_prev) {
+      pchan->bbone_prev = BLI_ghash_lookup(pchan_map, pchan->bbone_prev);
+    }
+    if (pchan->bbone_next) {
+      pchan->bbone_next = BLI_ghash_lookup(pchan_map, pchan->bbone_next);
+    }
+  }
+
+  BLI_ghash_free(pchan_map, NULL, NULL);
+}
+
 /**
  * Allocate a new pose on the heap, and copy the src pose and it's channels
  * into the new pose. *dst is set to the newly allocated structure, and assumed to be NULL.
@@ -610,14 +702,9 @@ void BKE_pose_copy_data_ex(bPose **dst,
 
   BLI_duplicatelist(&outPose->chanbase, &src->chanbase);
 
-  /* Rebuild ghash here too, so that name lookups below won't be too bad...
-   * BUT this will have the penalty that the ghash will be built twice
-   * if BKE_pose_rebuild() gets called after this...
-   */
-  if (outPose->chanbase.first != outPose->chanbase.last) {
-    outPose->chanhash = NULL;
-    BKE_pose_channels_hash_make(outPose);
-  }
+  /* The name hash is built lazily on first lookup, see #pose_channels_hash_ensure. */
+  outPose->chanhash = NULL;
+  pose_channels_remap_links(outPose, src);
 
   outPose->iksolver = src->iksolver;
   outPose->ikdata = NULL;
@@ -629,17 +716,6 @@ void BKE_pose_copy_data_ex(bPose **dst,
       id_us_plus((ID *)pchan->custom);
     }
 
-    /* warning, O(n2) here, if done without the hash, but these are rarely used features. */
-    if (pchan->custom_tx) {
-      pchan->custom_tx = BKE_pose_channel_find_name(outPose, pchan->custom_tx->name);
-    }
-    if (pchan->bbone_prev) {
-      pchan->bbone_prev = BKE_pose_channel_find_name(outPose, pchan->bbone_prev->name);
-    }
-    if (pchan->bbone_next) {
-      pchan->bbone_next = BKE_pose_channel_find_name(outPose, pchan->bbone_next->name);
-    }
-
     if (copy_constraints) {
       BKE_constraints_copy_ex(
           &listb, &pchan->constraints, flag, true);  // BKE_constraints_copy NULLs listb
@@ -656,6 +732,10 @@ void BKE_pose_copy_data_ex(bPose **dst,
 
     pchan->draw_data = NULL; /* Drawing cache, no need to copy. */
 
+    /* IK trees are runtime data of the IK solvers, rebuilt on evaluation. */
+    BLI_listbase_clear(&pchan->iktree);
+    BLI_listbase_clear(&pchan->siktree);
+
     /* Runtime data, no need to copy. */
     memset(&pchan->runtime, 0, sizeof(pchan->runtime));
   }
@@ -744,14 +824,7 @@ bool BKE_pose_channel_in_IK_chain(Object *ob, bPoseChannel *pchan)
  */
 void BKE_pose_channels_hash_make(bPose *pose)
 {
-  if (!pose->chanhash) {
-    bPoseChannel *pchan;
-
-    pose->chanhash = BLI_ghash_str_new("make_pose_chan gh");
-    for (pchan = pose->chanbase.first; pchan; pchan = pchan->next) {
-      BLI_ghash_insert(pose->chanhash, pchan->name, pchan);
-    }
-  }
+  pose_channels_hash_ensure(pose);
 }
 
 void BKE_pose_channels_hash_free(bPose *pose)
@@ -846,6 +919,8 @@ void BKE_pose_channels_remove(Object *ob,
         }
       }
     }
+
+    BKE_pose_eval_levels_free(ob->pose);
   }
 }
 
@@ -900,6 +975,7 @@ void BKE_pose_channel_free_bbone_cache(bPoseChannel_Runtime *runtime)
   MEM_SAFE_FREE(runtime->bbone_pose_mats);
   MEM_SAFE_FREE(runtime->bbone_deform_mats);
   MEM_SAFE_FREE(runtime->bbone_dual_quats);
+  MEM_SAFE_FREE(runtime->bbone_segments_key);
 }
 
 void BKE_pose_channel_free(bPoseChannel *pchan)
@@ -926,6 +1002,8 @@ void BKE_pose_channels_free_ex(bPose *pose, bool do_id_user)
   BKE_pose_channels_hash_free(pose);
 
   MEM_SAFE_FREE(pose->chan_array);
+  pose->totchan = 0;
+  BKE_pose_eval_levels_free(pose);
 }
 
 void BKE_pose_channels_free(bPose *pose)
@@ -935,6 +1013,9 @@ void BKE_pose_channels_free(bPose *pose)
 
 void BKE_pose_free_data_ex(bPose *pose, bool do_id_user)
 {
+  /* free IK solver state, before the pose-channels which own the IK trees */
+  BIK_clear_data(pose);
+
   /* free pose-channels */
   BKE_pose_channels_free_ex(pose, do_id_user);
 
@@ -943,9 +1024,6 @@ void BKE_pose_free_data_ex(bPose *pose, bool do_id_user)
     BLI_freelistN(&pose->agroups);
   }
 
-  /* free IK solver state */
-  BIK_clear_data(pose);
-
   /* free IK solver param */
   if (pose->ikparam) {
     MEM_freeN(pose->ikparam);
@@ -1043,6 +1121,9 @@ void BKE_pose_update_constraint_flags(bPose *pose)
   }
   pose->flag &= ~POSE_CONSTRAINTS_TIMEDEPEND;
 
+  /* constraint targets define the evaluation levels */
+  BKE_pose_eval_levels_free(pose);
+
   /* detect */
   for (pchan = pose->chanbase.first; pchan; pchan = pchan->next) {
     for (con = pchan->constraints.first; con; con = con->next) {
@@ -1613,3 +1694,260 @@ void what_does_obaction(
     BKE_animsys_evaluate_animdata(NULL, &workob->id, &adt, cframe, ADT_RECALC_ANIM, false);
   }
 }
+
+/* Pose Channel Evaluation ----------------- */
+
+/* Evaluated actions keep the F-Curves animating the transform of each pose channel, so that the
+ * Action Constraint can evaluate a single channel without resolving any RNA paths. The cache is
+ * built on first use, and freed together with the F-Curves when the evaluated action is copied
+ * again from the original. */
+
+typedef enum eActionChannelProperty {
+  ACTION_CHANNEL_LOCATION = 0,
+  ACTION_CHANNEL_ROTATION_EULER,
+  ACTION_CHANNEL_ROTATION_QUATERNION,
+  ACTION_CHANNEL_ROTATION_AXIS_ANGLE,
+  ACTION_CHANNEL_SCALE,
+} eActionChannelProperty;
+
+typedef struct ActionChannelCurve {
+  FCurve *fcu;
+  short property;
+  short array_index;
+} ActionChannelCurve;
+
+typedef struct ActionChannelCurves {
+  /* Group named after the channel, only its curves are used when it exists. */
+  bActionGroup *agrp;
+  ActionChannelCurve *curves;
+  int totcurve;
+  /* Curves which can't be written directly (rotation mode changes), evaluate through RNA. */
+  bool use_rna;
+} ActionChannelCurves;
+
+typedef struct ActionChannelCache {
+  /* Pose channel name -> ActionChannelCurves. */
+  GHash *channels;
+  /* Some channel names could not be matched to their curves, evaluate through RNA. */
+  bool use_rna;
+} ActionChannelCache;
+
+static void action_channel_curves_free(void *channel_v)
+{
+  ActionChannelCurves *channel = channel_v;
+
+  MEM_SAFE_FREE(channel->curves);
+  MEM_freeN(channel);
+}
+
+static void action_channel_cache_free(ActionChannelCache *cache)
+{
+  BLI_ghash_free(cache->channels, MEM_freeN, action_channel_curves_free);
+  MEM_freeN(cache);
+}
+
+/* Returns false for paths that can't affect the transform of the channel. */
+static bool action_channel_property_get(const char *property,
+                                        int array_index,
+                                        short *r_property,
+                                        bool *r_use_rna)
+{
+  int array_len;
+
+  *r_use_rna = false;
+
+  if (STREQ(property, "location")) {
+    *r_property = ACTION_CHANNEL_LOCATION;
+    array_len = 3;
+  }
+  else if (STREQ(property, "rotation_euler")) {
+    *r_property = ACTION_CHANNEL_ROTATION_EULER;
+    array_len = 3;
+  }
+  else if (STREQ(property, "rotation_quaternion")) {
+    *r_property = ACTION_CHANNEL_ROTATION_QUATERNION;
+    array_len = 4;
+  }
+  else if (STREQ(property, "rotation_axis_angle")) {
+    *r_property = ACTION_CHANNEL_ROTATION_AXIS_ANGLE;
+    array_len = 4;
+  }
+  else if (STREQ(property, "scale")) {
+    *r_property = ACTION_CHANNEL_SCALE;
+    array_len = 3;
+  }
+  else if (STREQ(property, "rotation_mode")) {
+    /* Setting the rotation mode converts the existing rotation values. */
+    *r_use_rna = true;
+    return false;
+  }
+  else {
+    return false;
+  }
+
+  return (array_index >= 0 && array_index < array_len);
+}
+
+static ActionChannelCache *action_channel_cache_build(bAction *act)
+{
+  const char *prefix = "pose.bones[";
+  const size_t prefix_len = strlen(prefix);
+  ActionChannelCache *cache = MEM_callocN(sizeof(ActionChannelCache), __func__);
+  FCurve *fcu;
+
+  cache->channels = BLI_ghash_str_new(__func__);
+
+  for (fcu = act->curves.first; fcu; fcu = fcu->next) {
+    ActionChannelCurves *channel;
+    const char *property;
+    char *name;
+    void **val_p;
+    short channel_property;
+    bool use_rna;
+
+    if (fcu->rna_path == NULL || !STREQLEN(fcu->rna_path, prefix, prefix_len)) {
+      continue;
+    }
+
+    name = BLI_str_quoted_substrN(fcu->rna_path, prefix);
+    if (strchr(name, '\\')) {
+      /* Escaped characters, the name doesn't match the pose channel name. */
+      cache->use_rna = true;
+      MEM_freeN(name);
+      continue;
+    }
+
+    /* Skip `"name"]`, custom properties and nested data don't affect the transform. */
+    property = fcu->rna_path + prefix_len + strlen(name) + 2;
+    if (!STREQLEN(property, "].", 2)) {
+      MEM_freeN(name);
+      continue;
+    }
+    property += 2;
+
+    if (!action_channel_property_get(property, fcu->array_index, &channel_property, &use_rna) &&
+        !use_rna) {
+      MEM_freeN(name);
+      continue;
+    }
+
+    if (BLI_ghash_ensure_p(cache->channels, name, &val_p)) {
+      MEM_freeN(name);
+    }
+    else {
+      channel = MEM_callocN(sizeof(ActionChannelCurves), __func__);
+      channel->agrp = BKE_action_group_find_name(act, name);
+      *val_p = channel;
+    }
+    channel = *val_p;
+
+    /* When there is a group for the channel, only its curves are evaluated
+     * (see what_does_obaction). */
+    if (channel->agrp && fcu->grp != channel->agrp) {
+      continue;
+    }
+
+    if (use_rna || fcu->driver) {
+      channel->use_rna = true;
+      continue;
+    }
+
+    channel->curves = MEM_reallocN(channel->curves,
+                                   sizeof(ActionChannelCurve) * (channel->totcurve + 1));
+    channel->curves[channel->totcurve].fcu = fcu;
+    channel->curves[channel->totcurve].property = channel_property;
+    channel->curves[channel->totcurve].array_index = (short)fcu->array_index;
+    channel->totcurve++;
+  }
+
+  return cache;
+}
+
+static ActionChannelCache *action_channel_cache_ensure(bAction *act)
+{
+  ActionChannelCache *cache = act->channel_cache;
+
+  if (cache == NULL) {
+    /* Bones are evaluated in parallel, the first cache to be stored wins. */
+    cache = action_channel_cache_build(act);
+    if (atomic_cas_ptr((void **)&act->channel_cache, NULL, cache) != NULL) {
+      action_channel_cache_free(cache);
+      cache = act->channel_cache;
+    }
+  }
+
+  return cache;
+}
+
+/**
+ * Evaluate the F-Curves of the action animating the transform of the given pose channel,
+ * with the same result as what_does_obaction() on a pose only containing that channel.
+ *
+ * Only done for evaluated actions, using the cache of the action.
+ *
+ * \return false when the channel has to be evaluated with what_does_obaction() instead.
+ */
+bool BKE_action_pose_channel_evaluate(bAction *act, bPoseChannel *pchan, float cframe)
+{
+  ActionChannelCache *cache;
+  ActionChannelCurves *channel;
+
+  /* Original actions can be edited at any time. */
+  if ((act->id.tag & LIB_TAG_COPIED_ON_WRITE) == 0) {
+    return false;
+  }
+
+  cache = action_channel_cache_ensure(act);
+  if (cache->use_rna) {
+    return false;
+  }
+
+  channel = BLI_ghash_lookup(cache->channels, pchan->name);
+  if (channel == NULL) {
+    return true;
+  }
+  if (channel->use_rna) {
+    return false;
+  }
+
+  for (int i = 0; i < channel->totcurve; i++) {
+    const ActionChannelCurve *curve = &channel->curves[i];
+    FCurve *fcu = curve->fcu;
+    float value;
+
+    if ((fcu->grp != NULL) && (fcu->grp->flag & AGRP_MUTED)) {
+      continue;
+    }
+    if ((fcu->flag & (FCURVE_MUTED | FCURVE_DISABLED)) || BKE_fcurve_is_empty(fcu)) {
+      continue;
+    }
+
+    value = evaluate_fcurve(fcu, cframe);
+
+    switch (curve->property) {
+      case ACTION_CHANNEL_LOCATION:
+        pchan->loc[curve->array_index] = value;
+        break;
+      case ACTION_CHANNEL_ROTATION_EULER:
+        pchan->eul[curve->array_index] = value;
+        break;
+      case ACTION_CHANNEL_ROTATION_QUATERNION:
+        pchan->quat[curve->array_index] = value;
+        break;
+      case ACTION_CHANNEL_ROTATION_AXIS_ANGLE:
+        /* Stored as angle followed by the axis. */
+        if (curve->array_index == 0) {
+          pchan->rotAngle = value;
+        }
+        else {
+          pchan->rotAxis[curve->array_index - 1] = value;
+        }
+        break;
+      case ACTION_CHANNEL_SCALE:
+        pchan->size[curve->array_index] = value;
+        break;
+    }
+  }
+
+  return true;
+}
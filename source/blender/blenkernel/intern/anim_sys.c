@@ -34,6 +34,7 @@
 #include "BLI_alloca.h"
 #include "BLI_dynstr.h"
 #include "BLI_listbase.h"
+#include "BLI_task.h"
 #include "BLI_string_utils.h"
 #include "BLI_math_rotation.h"
 #include "BLI_math_vector.h"
@@ -237,6 +238,100 @@ bool BKE_animdata_set_action(ReportList *reports, ID *id, bAction *act)
   return ok;
 }
 
+/* Evaluation Bindings -------------------------------- */
+
+/* Resolved RNA paths of the F-Curves of the active action, stored in the AnimData of evaluated
+ * (copy-on-write) data-blocks so that playback doesn't parse the same paths on every frame.
+ *
+ * The resolved pointers point into the evaluated data-block, which only gets re-allocated when it
+ * is copied again from the original. That also frees its AnimData, so the bindings only have to
+ * be checked against the action being replaced or copied again. Paths resolving into another
+ * data-block are not kept, see animsys_fcurve_binding_get(). Original data-blocks can be
+ * edited at any time and never use bindings. */
+
+typedef enum eAnimFCurveBindingFlag {
+  /* rna has been resolved, and is valid if ANIM_BINDING_VALID is set. */
+  ANIM_BINDING_RESOLVED = (1 << 0),
+  ANIM_BINDING_VALID = (1 << 1),
+  /* Same for rna_orig, used for flushing the values to the original data-block. */
+  ANIM_BINDING_ORIG_RESOLVED = (1 << 2),
+  ANIM_BINDING_ORIG_VALID = (1 << 3),
+} eAnimFCurveBindingFlag;
+
+typedef struct AnimFCurveBinding {
+  /* F-Curve the paths were resolved for, guards against stale bindings. */
+  const FCurve *fcu;
+  PathResolvedRNA rna;
+  PathResolvedRNA rna_orig;
+  int flag;
+  /* Keyframe segment of the last evaluation, see evaluate_fcurve_sequential(). */
+  int segment_hint;
+} AnimFCurveBinding;
+
+typedef struct AnimActionBindings {
+  /* Action the bindings were created for, one binding per F-Curve in act->curves. */
+  const bAction *action;
+  AnimFCurveBinding *bindings;
+  int totcurve;
+} AnimActionBindings;
+
+static void animsys_action_bindings_free(AnimData *adt)
+{
+  if (adt->action_bindings != NULL) {
+    MEM_freeN(adt->action_bindings->bindings);
+    MEM_freeN(adt->action_bindings);
+    adt->action_bindings = NULL;
+  }
+}
+
+/* Drivers of evaluated data-blocks are bound the same way, created together with the driver
+ * array after copying. Each driver is evaluated by its own depsgraph operation, which only
+ * touches its own binding, so the bindings can be filled in lazily from multiple threads.
+ *
+ * The targets of 'single property' variables are resolved too. Those point into other evaluated
+ * data-blocks, which can be copied again on their own. That tags all their dependencies for
+ * evaluation, including the driver, which then resolves its targets again. Targets are also
+ * resolved again when the variables of the driver no longer match the ones they were resolved
+ * for, in case those were edited or remapped without copying the driver again. */
+
+/* Variable the target was resolved for. */
+typedef struct AnimDriverVarKey {
+  const DriverVar *dvar;
+  const ID *id;
+  const char *rna_path;
+  int type;
+} AnimDriverVarKey;
+
+typedef struct AnimDriverBinding {
+  /* Driven property. */
+  AnimFCurveBinding fcurve;
+  /* One item per driver variable, see BKE_driver_resolve_variable_targets(). */
+  PathResolvedRNA *var_targets;
+  AnimDriverVarKey *var_keys;
+  int totvar;
+  /* Number of variables with resolved targets. */
+  int totresolved;
+} AnimDriverBinding;
+
+typedef struct AnimDriverBindings {
+  /* One binding per F-Curve in adt->drivers. */
+  AnimDriverBinding *bindings;
+  int totdriver;
+} AnimDriverBindings;
+
+static void animsys_driver_bindings_free(AnimData *adt)
+{
+  if (adt->driver_bindings != NULL) {
+    for (int i = 0; i < adt->driver_bindings->totdriver; i++) {
+      MEM_SAFE_FREE(adt->driver_bindings->bindings[i].var_targets);
+      MEM_SAFE_FREE(adt->driver_bindings->bindings[i].var_keys);
+    }
+    MEM_freeN(adt->driver_bindings->bindings);
+    MEM_freeN(adt->driver_bindings);
+    adt->driver_bindings = NULL;
+  }
+}
+
 /* Freeing -------------------------------------------- */
 
 /* Free AnimData used by the nominated ID-block, and clear ID-block's AnimData pointer */
@@ -270,6 +365,10 @@ void BKE_animdata_free(ID *id, const bool do_id_user)
 
       /* free driver array cache */
       MEM_SAFE_FREE(adt->driver_array);
+      animsys_driver_bindings_free(adt);
+
+      /* free resolved paths cache */
+      animsys_action_bindings_free(adt);
 
       /* free overrides */
       /* TODO... */
@@ -319,6 +418,8 @@ AnimData *BKE_animdata_copy(Main *bmain, AnimData *adt, const int flag)
   /* duplicate drivers (F-Curves) */
   copy_fcurves(&dadt->drivers, &adt->drivers);
   dadt->driver_array = NULL;
+  dadt->driver_bindings = NULL;
+  dadt->action_bindings = NULL;
 
   /* don't copy overrides */
   BLI_listbase_clear(&dadt->overrides);
@@ -1861,44 +1962,258 @@ static bool animsys_construct_orig_pointer_rna(const PointerRNA *ptr, PointerRNA
   return true;
 }
 
+static bool animsys_store_orig_rna_setting(PointerRNA *ptr,
+                                           const char *rna_path,
+                                           int array_index,
+                                           PathResolvedRNA *r_result)
+{
+  PointerRNA ptr_orig;
+  if (!animsys_construct_orig_pointer_rna(ptr, &ptr_orig)) {
+    return false;
+  }
+  return animsys_store_rna_setting(&ptr_orig, rna_path, array_index, r_result);
+}
+
 static void animsys_write_orig_anim_rna(PointerRNA *ptr,
                                         const char *rna_path,
                                         int array_index,
                                         float value)
 {
-  PointerRNA ptr_orig;
-  if (!animsys_construct_orig_pointer_rna(ptr, &ptr_orig)) {
-    return;
-  }
   PathResolvedRNA orig_anim_rna;
-  /* TODO(sergey): Should be possible to cache resolved path in dependency graph somehow. */
-  if (animsys_store_rna_setting(&ptr_orig, rna_path, array_index, &orig_anim_rna)) {
+  /* NOTE: Bound F-Curves of the active action use animsys_fcurve_binding_get_orig() instead. */
+  if (animsys_store_orig_rna_setting(ptr, rna_path, array_index, &orig_anim_rna)) {
     animsys_write_rna_setting(&orig_anim_rna, value);
   }
 }
 
+/* Get the bindings for evaluating the given action on ptr, NULL when paths have to be resolved
+ * every time. */
+static AnimActionBindings *animsys_action_bindings_ensure(PointerRNA *ptr, bAction *act)
+{
+  ID *id = ptr->owner_id;
+
+  if (id == NULL || (id->tag & LIB_TAG_COPIED_ON_WRITE) == 0) {
+    return NULL;
+  }
+  AnimData *adt = BKE_animdata_from_id(id);
+  /* Only the active action, NLA strips have their own channel lookup. */
+  if (adt == NULL || adt->action != act || ptr->data != id) {
+    return NULL;
+  }
+
+  const int totcurve = BLI_listbase_count(&act->curves);
+
+  /* The action got copied again from the original, its F-Curves have been re-allocated.
+   * F-Curves can also be added or removed without that, every curve needs a binding. */
+  if (adt->action_bindings != NULL && (adt->action_bindings->action != act ||
+                                       (act->id.recalc & ID_RECALC_COPY_ON_WRITE) ||
+                                       adt->action_bindings->totcurve != totcurve)) {
+    animsys_action_bindings_free(adt);
+  }
+
+  if (adt->action_bindings == NULL) {
+    AnimActionBindings *bindings = MEM_callocN(sizeof(*bindings), __func__);
+    bindings->action = act;
+    bindings->totcurve = totcurve;
+    bindings->bindings = MEM_calloc_arrayN(
+        max_ii(bindings->totcurve, 1), sizeof(*bindings->bindings), __func__);
+    adt->action_bindings = bindings;
+  }
+
+  return adt->action_bindings;
+}
+
+/* Resolved path of the bound F-Curve, NULL if it's invalid. */
+static PathResolvedRNA *animsys_fcurve_binding_get(PointerRNA *ptr,
+                                                   AnimFCurveBinding *binding,
+                                                   FCurve *fcu)
+{
+  if (binding->fcu != fcu) {
+    binding->fcu = fcu;
+    binding->flag = 0;
+    binding->segment_hint = 0;
+  }
+  if ((binding->flag & ANIM_BINDING_RESOLVED) == 0) {
+    if (!animsys_store_rna_setting(ptr, fcu->rna_path, fcu->array_index, &binding->rna)) {
+      binding->flag |= ANIM_BINDING_RESOLVED;
+      return NULL;
+    }
+    /* Paths going through ID pointers resolve into another data-block, which can be copied again
+     * without this one knowing about it. Those are resolved again on every evaluation. */
+    if (binding->rna.ptr.owner_id != ptr->owner_id) {
+      return &binding->rna;
+    }
+    binding->flag |= ANIM_BINDING_RESOLVED | ANIM_BINDING_VALID;
+  }
+
+  return (binding->flag & ANIM_BINDING_VALID) ? &binding->rna : NULL;
+}
+
+static PathResolvedRNA *animsys_fcurve_binding_get_orig(PointerRNA *ptr,
+                                                        AnimFCurveBinding *binding)
+{
+  const FCurve *fcu = binding->fcu;
+
+  if ((binding->flag & ANIM_BINDING_ORIG_RESOLVED) == 0) {
+    if (!animsys_store_orig_rna_setting(
+            ptr, fcu->rna_path, fcu->array_index, &binding->rna_orig)) {
+      binding->flag |= ANIM_BINDING_ORIG_RESOLVED;
+      return NULL;
+    }
+    /* Same as for the evaluated data-block, other original data-blocks can be freed. */
+    if (binding->rna_orig.ptr.owner_id != ptr->owner_id->orig_id) {
+      return &binding->rna_orig;
+    }
+    binding->flag |= ANIM_BINDING_ORIG_RESOLVED | ANIM_BINDING_ORIG_VALID;
+  }
+
+  return (binding->flag & ANIM_BINDING_ORIG_VALID) ? &binding->rna_orig : NULL;
+}
+
+/* Check if the F-Curve doesn't contribute to the evaluated result. */
+static bool animsys_fcurve_is_skipped(FCurve *fcu)
+{
+  /* Check if this F-Curve doesn't belong to a muted group. */
+  if ((fcu->grp != NULL) && (fcu->grp->flag & AGRP_MUTED)) {
+    return true;
+  }
+  /* Check if this curve should be skipped. */
+  if ((fcu->flag & (FCURVE_MUTED | FCURVE_DISABLED))) {
+    return true;
+  }
+  /* Skip empty curves, as if muted. */
+  if (BKE_fcurve_is_empty(fcu)) {
+    return true;
+  }
+  return false;
+}
+
+/* Minimum number of F-Curves in a bound action to evaluate them in parallel,
+ * below this the threading overhead is larger than the evaluation itself. */
+#define ANIM_PARALLEL_FCURVES_MIN 256
+
+typedef struct AnimFCurvesEvalData {
+  FCurve **fcurves;
+  AnimActionBindings *bindings;
+  /* Value of each F-Curve, indexed like the bindings. */
+  float *values;
+  float ctime;
+} AnimFCurvesEvalData;
+
+static void animsys_evaluate_fcurves_task(void *__restrict userdata,
+                                          const int index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  AnimFCurvesEvalData *data = userdata;
+  FCurve *fcu = data->fcurves[index];
+
+  /* Drivers may run Python, they're evaluated when writing the values. */
+  if (fcu->driver != NULL || animsys_fcurve_is_skipped(fcu)) {
+    return;
+  }
+  data->values[index] = calculate_fcurve_ex(
+      NULL, fcu, data->ctime, &data->bindings->bindings[index].segment_hint);
+}
+
+/**
+ * Evaluate the F-Curves of a bound action in parallel, then write the values in a second pass.
+ * The writes happen in the order of the curves, so when several curves animate the same
+ * property the result is the same as when evaluating them one by one.
+ */
+static void animsys_evaluate_fcurves_parallel(PointerRNA *ptr,
+                                              ListBase *list,
+                                              AnimActionBindings *bindings,
+                                              float ctime,
+                                              bool flush_to_original)
+{
+  const int totcurve = bindings->totcurve;
+  FCurve **fcurves = MEM_malloc_arrayN(totcurve, sizeof(*fcurves), __func__);
+  float *values = MEM_malloc_arrayN(totcurve, sizeof(*values), __func__);
+  int index = 0;
+
+  for (FCurve *fcu = list->first; fcu && index < totcurve; fcu = fcu->next, index++) {
+    fcurves[index] = fcu;
+  }
+
+  AnimFCurvesEvalData data = {
+      .fcurves = fcurves,
+      .bindings = bindings,
+      .values = values,
+      .ctime = ctime,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 64;
+  BLI_task_parallel_range(0, index, &data, animsys_evaluate_fcurves_task, &settings);
+
+  for (int i = 0; i < index; i++) {
+    FCurve *fcu = fcurves[i];
+    if (animsys_fcurve_is_skipped(fcu)) {
+      continue;
+    }
+    PathResolvedRNA *anim_rna = animsys_fcurve_binding_get(ptr, &bindings->bindings[i], fcu);
+    if (anim_rna == NULL) {
+      continue;
+    }
+    const float curval = (fcu->driver != NULL) ?
+                             calculate_fcurve_ex(
+                                 anim_rna, fcu, ctime, &bindings->bindings[i].segment_hint) :
+                             values[i];
+    animsys_write_rna_setting(anim_rna, curval);
+    if (flush_to_original) {
+      PathResolvedRNA *orig_anim_rna = animsys_fcurve_binding_get_orig(ptr,
+                                                                       &bindings->bindings[i]);
+      if (orig_anim_rna != NULL) {
+        animsys_write_rna_setting(orig_anim_rna, curval);
+      }
+    }
+  }
+
+  MEM_freeN(fcurves);
+  MEM_freeN(values);
+}
+
 /**
  * Evaluate all the F-Curves in the given list
  * This performs a set of standard checks. If extra checks are required,
  * separate code should be used.
+ *
+ * \param bindings: Cached resolved paths for the curves of list, can be NULL.
  */
 static void animsys_evaluate_fcurves(PointerRNA *ptr,
                                      ListBase *list,
+                                     AnimActionBindings *bindings,
                                      float ctime,
                                      bool flush_to_original)
 {
+  if (bindings != NULL && bindings->totcurve >= ANIM_PARALLEL_FCURVES_MIN) {
+    animsys_evaluate_fcurves_parallel(ptr, list, bindings, ctime, flush_to_original);
+    return;
+  }
+
+  int index = -1;
+
   /* Calculate then execute each curve. */
   for (FCurve *fcu = list->first; fcu; fcu = fcu->next) {
-    /* Check if this F-Curve doesn't belong to a muted group. */
-    if ((fcu->grp != NULL) && (fcu->grp->flag & AGRP_MUTED)) {
-      continue;
-    }
-    /* Check if this curve should be skipped. */
-    if ((fcu->flag & (FCURVE_MUTED | FCURVE_DISABLED))) {
+    index++;
+    if (animsys_fcurve_is_skipped(fcu)) {
       continue;
     }
-    /* Skip empty curves, as if muted. */
-    if (BKE_fcurve_is_empty(fcu)) {
+    if (bindings != NULL && index < bindings->totcurve) {
+      PathResolvedRNA *anim_rna = animsys_fcurve_binding_get(
+          ptr, &bindings->bindings[index], fcu);
+      if (anim_rna != NULL) {
+        const float curval = calculate_fcurve_ex(
+            anim_rna, fcu, ctime, &bindings->bindings[index].segment_hint);
+        animsys_write_rna_setting(anim_rna, curval);
+        if (flush_to_original) {
+          PathResolvedRNA *orig_anim_rna = animsys_fcurve_binding_get_orig(
+              ptr, &bindings->bindings[index]);
+          if (orig_anim_rna != NULL) {
+            animsys_write_rna_setting(orig_anim_rna, curval);
+          }
+        }
+      }
       continue;
     }
     PathResolvedRNA anim_rna;
@@ -2037,7 +2352,8 @@ static void animsys_evaluate_action_ex(PointerRNA *ptr,
   action_idcode_patch_check(ptr->owner_id, act);
 
   /* calculate then execute each curve */
-  animsys_evaluate_fcurves(ptr, &act->curves, ctime, flush_to_original);
+  AnimActionBindings *bindings = animsys_action_bindings_ensure(ptr, act);
+  animsys_evaluate_fcurves(ptr, &act->curves, bindings, ctime, flush_to_original);
 }
 
 void animsys_evaluate_action(PointerRNA *ptr,
@@ -2084,7 +2400,7 @@ static void nlastrip_evaluate_controls(NlaStrip *strip, float ctime, const bool
     RNA_pointer_create(NULL, &RNA_NlaStrip, strip, &strip_ptr);
 
     /* execute these settings as per normal */
-    animsys_evaluate_fcurves(&strip_ptr, &strip->fcurves, ctime, flush_to_original);
+    animsys_evaluate_fcurves(&strip_ptr, &strip->fcurves, NULL, ctime, flush_to_original);
   }
 
   /* analytically generate values for influence and time (if applicable)
@@ -4078,7 +4394,78 @@ void BKE_animsys_update_driver_array(ID *id)
     for (FCurve *fcu = adt->drivers.first; fcu; fcu = fcu->next) {
       adt->driver_array[driver_index++] = fcu;
     }
+
+    /* Paths are resolved on the first evaluation of each driver. */
+    BLI_assert(!adt->driver_bindings);
+    AnimDriverBindings *bindings = MEM_callocN(sizeof(*bindings), __func__);
+    bindings->totdriver = num_drivers;
+    bindings->bindings = MEM_calloc_arrayN(num_drivers, sizeof(*bindings->bindings), __func__);
+    adt->driver_bindings = bindings;
+  }
+}
+
+static void animsys_driver_var_key_init(AnimDriverVarKey *key, const DriverVar *dvar)
+{
+  key->dvar = dvar;
+  key->id = dvar->targets[0].id;
+  key->rna_path = dvar->targets[0].rna_path;
+  key->type = dvar->type;
+}
+
+static bool animsys_driver_var_key_matches(const AnimDriverVarKey *key, const DriverVar *dvar)
+{
+  return key->dvar == dvar && key->id == dvar->targets[0].id &&
+         key->rna_path == dvar->targets[0].rna_path && key->type == dvar->type;
+}
+
+/* Check if the variable targets of the driver have to be resolved again. */
+static bool animsys_driver_binding_targets_outdated(AnimDriverBinding *binding,
+                                                    ChannelDriver *driver)
+{
+  if (binding->var_targets == NULL) {
+    return true;
+  }
+  int i = 0;
+  for (DriverVar *dvar = driver->variables.first; dvar; dvar = dvar->next, i++) {
+    if (!animsys_driver_var_key_matches(&binding->var_keys[i], dvar)) {
+      return true;
+    }
+    /* Only dereferenced once the target ID is known to be the one of the variable. */
+    const PathResolvedRNA *var_target = &binding->var_targets[i];
+    if (var_target->prop && (var_target->ptr.owner_id->recalc & ID_RECALC_COPY_ON_WRITE)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Resolved variable targets of the driver, NULL if it has to use the regular evaluation. */
+static PathResolvedRNA *animsys_driver_binding_var_targets(AnimDriverBinding *binding,
+                                                           ChannelDriver *driver)
+{
+  const int totvar = BLI_listbase_count(&driver->variables);
+
+  if (totvar == 0) {
+    return NULL;
+  }
+  if (binding->totvar != totvar) {
+    MEM_SAFE_FREE(binding->var_targets);
+    MEM_SAFE_FREE(binding->var_keys);
+    binding->totvar = totvar;
+  }
+  if (animsys_driver_binding_targets_outdated(binding, driver)) {
+    if (binding->var_targets == NULL) {
+      binding->var_targets = MEM_malloc_arrayN(totvar, sizeof(*binding->var_targets), __func__);
+      binding->var_keys = MEM_malloc_arrayN(totvar, sizeof(*binding->var_keys), __func__);
+    }
+    binding->totresolved = BKE_driver_resolve_variable_targets(driver, binding->var_targets);
+    int i = 0;
+    for (DriverVar *dvar = driver->variables.first; dvar; dvar = dvar->next, i++) {
+      animsys_driver_var_key_init(&binding->var_keys[i], dvar);
+    }
   }
+
+  return (binding->totresolved != 0) ? binding->var_targets : NULL;
 }
 
 void BKE_animsys_eval_driver(Depsgraph *depsgraph,
@@ -4091,7 +4478,7 @@ void BKE_animsys_eval_driver(Depsgraph *depsgraph,
   bool ok = false;
 
   /* Lookup driver, accelerated with driver array map. */
-  const AnimData *adt = BKE_animdata_from_id(id);
+  AnimData *adt = BKE_animdata_from_id(id);
   FCurve *fcu;
 
   if (adt->driver_array) {
@@ -4116,16 +4503,42 @@ void BKE_animsys_eval_driver(Depsgraph *depsgraph,
        * adding new to only be done when drivers only changed */
       // printf("\told val = %f\n", fcu->curval);
 
-      PathResolvedRNA anim_rna;
-      if (animsys_store_rna_setting(&id_ptr, fcu->rna_path, fcu->array_index, &anim_rna)) {
+      AnimDriverBinding *binding = NULL;
+      if (adt->driver_bindings && driver_index < adt->driver_bindings->totdriver) {
+        binding = &adt->driver_bindings->bindings[driver_index];
+      }
+
+      PathResolvedRNA anim_rna_local;
+      PathResolvedRNA *anim_rna = NULL;
+      PathResolvedRNA *var_targets = NULL;
+      if (binding) {
+        anim_rna = animsys_fcurve_binding_get(&id_ptr, &binding->fcurve, fcu);
+        var_targets = animsys_driver_binding_var_targets(binding, fcu->driver);
+      }
+      else if (animsys_store_rna_setting(
+                   &id_ptr, fcu->rna_path, fcu->array_index, &anim_rna_local)) {
+        anim_rna = &anim_rna_local;
+      }
+
+      if (anim_rna != NULL) {
         /* Evaluate driver, and write results to COW-domain destination */
         const float ctime = DEG_get_ctime(depsgraph);
-        const float curval = evaluate_fcurve_driver(&anim_rna, fcu, driver_orig, ctime);
-        ok = animsys_write_rna_setting(&anim_rna, curval);
+        const float curval = evaluate_fcurve_driver_ex(
+            anim_rna, fcu, driver_orig, var_targets, ctime);
+        ok = animsys_write_rna_setting(anim_rna, curval);
 
         /* Flush results & status codes to original data for UI (T59984) */
         if (ok && DEG_is_active(depsgraph)) {
-          animsys_write_orig_anim_rna(&id_ptr, fcu->rna_path, fcu->array_index, curval);
+          if (binding) {
+            PathResolvedRNA *orig_anim_rna = animsys_fcurve_binding_get_orig(&id_ptr,
+                                                                             &binding->fcurve);
+            if (orig_anim_rna != NULL) {
+              animsys_write_rna_setting(orig_anim_rna, curval);
+            }
+          }
+          else {
+            animsys_write_orig_anim_rna(&id_ptr, fcu->rna_path, fcu->array_index, curval);
+          }
 
           /* curval is displayed in the UI, and flag contains error-status codes */
           driver_orig->curval = fcu->driver->curval;
@@ -28,12 +28,18 @@
 #include <stdio.h>
 #include <float.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_math.h"
 #include "BLI_listbase.h"
 #include "BLI_string.h"
 #include "BLI_ghash.h"
+#include "BLI_linklist.h"
+#include "BLI_memarena.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
 #include "BLI_alloca.h"
@@ -661,6 +667,56 @@ static void evaluate_cubic_bezier(const float control[4][3],
   madd_v3_v3v3fl(r_pos, layer2[0], r_tangent, t);
 }
 
+/* Same as evaluate_cubic_bezier() for an array of parameter values,
+ * evaluating four of them at once when SSE2 is available. */
+static void evaluate_cubic_bezier_array(const float control[4][3],
+                                        const float *t_points,
+                                        int num,
+                                        float (*r_pos)[3],
+                                        float (*r_tangent)[3])
+{
+  int i = 0;
+
+#ifdef __SSE2__
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  for (; i + 4 <= num; i += 4) {
+    const __m128 t = _mm_loadu_ps(&t_points[i]);
+    const __m128 s = _mm_sub_ps(one, t);
+    float pos[3][4], tangent[3][4];
+
+    /* Same operations in the same order as interp_v3_v3v3 and madd_v3_v3v3fl. */
+    for (int axis = 0; axis < 3; axis++) {
+      const __m128 c0 = _mm_set1_ps(control[0][axis]);
+      const __m128 c1 = _mm_set1_ps(control[1][axis]);
+      const __m128 c2 = _mm_set1_ps(control[2][axis]);
+      const __m128 c3 = _mm_set1_ps(control[3][axis]);
+
+      const __m128 layer1_0 = _mm_add_ps(_mm_mul_ps(s, c0), _mm_mul_ps(t, c1));
+      const __m128 layer1_1 = _mm_add_ps(_mm_mul_ps(s, c1), _mm_mul_ps(t, c2));
+      const __m128 layer1_2 = _mm_add_ps(_mm_mul_ps(s, c2), _mm_mul_ps(t, c3));
+
+      const __m128 layer2_0 = _mm_add_ps(_mm_mul_ps(s, layer1_0), _mm_mul_ps(t, layer1_1));
+      const __m128 layer2_1 = _mm_add_ps(_mm_mul_ps(s, layer1_1), _mm_mul_ps(t, layer1_2));
+
+      const __m128 tan = _mm_sub_ps(layer2_1, layer2_0);
+
+      _mm_storeu_ps(tangent[axis], tan);
+      _mm_storeu_ps(pos[axis], _mm_add_ps(layer2_0, _mm_mul_ps(tan, t)));
+    }
+
+    for (int j = 0; j < 4; j++) {
+      copy_v3_fl3(r_pos[i + j], pos[0][j], pos[1][j], pos[2][j]);
+      copy_v3_fl3(r_tangent[i + j], tangent[0][j], tangent[1][j], tangent[2][j]);
+    }
+  }
+#endif
+
+  for (; i < num; i++) {
+    evaluate_cubic_bezier(control, t_points[i], r_pos[i], r_tangent[i]);
+  }
+}
+
 /* Get "next" and "prev" bones - these are used for handle calculations. */
 void BKE_pchan_bbone_handles_get(bPoseChannel *pchan, bPoseChannel **r_prev, bPoseChannel **r_next)
 {
@@ -1074,6 +1130,7 @@ int BKE_pchan_bbone_spline_compute(BBoneSplineParameters *param,
   zero_v3(bezt_controls[0]);
 
   float bezt_points[MAX_BBONE_SUBDIV + 1];
+  float bezt_pos[MAX_BBONE_SUBDIV + 1][3], bezt_tangent[MAX_BBONE_SUBDIV + 1][3];
 
   equalize_cubic_bezier(bezt_controls, MAX_BBONE_SUBDIV, param->segments, bezt_points);
 
@@ -1100,16 +1157,23 @@ int BKE_pchan_bbone_spline_compute(BBoneSplineParameters *param,
                              param->scale_in_y,
                              result_array[0].mat);
 
-    for (int a = 1; a < param->segments; a++) {
-      evaluate_cubic_bezier(bezt_controls, bezt_points[a], cur, axis);
+    evaluate_cubic_bezier_array(
+        bezt_controls, &bezt_points[1], param->segments - 1, &bezt_pos[1], &bezt_tangent[1]);
 
+    for (int a = 1; a < param->segments; a++) {
       float fac = ((float)a) / param->segments;
       float roll = interpf(roll2, roll1, fac);
       float scalex = interpf(param->scale_out_x, param->scale_in_x, fac);
       float scaley = interpf(param->scale_out_y, param->scale_in_y, fac);
 
-      make_bbone_spline_matrix(
-          param, scalemats, cur, axis, roll, scalex, scaley, result_array[a].mat);
+      make_bbone_spline_matrix(param,
+                               scalemats,
+                               bezt_pos[a],
+                               bezt_tangent[a],
+                               roll,
+                               scalex,
+                               scaley,
+                               result_array[a].mat);
     }
 
     negate_v3(bezt_deriv2[1]);
@@ -1127,8 +1191,11 @@ int BKE_pchan_bbone_spline_compute(BBoneSplineParameters *param,
   else {
     zero_v3(prev);
 
+    evaluate_cubic_bezier_array(
+        bezt_controls, &bezt_points[1], param->segments, &bezt_pos[1], &bezt_tangent[1]);
+
     for (int a = 0; a < param->segments; a++) {
-      evaluate_cubic_bezier(bezt_controls, bezt_points[a + 1], cur, axis);
+      copy_v3_v3(cur, bezt_pos[a + 1]);
 
       sub_v3_v3v3(axis, cur, prev);
 
@@ -1167,6 +1234,15 @@ static void allocate_bbone_cache(bPoseChannel *pchan, int segments)
   }
 }
 
+/* Everything the cached segments depend on. The spline parameters are cleared before being
+ * filled in, so they can be compared as memory. */
+typedef struct BBoneSegmentsKey {
+  BBoneSplineParameters pose_param;
+  BBoneSplineParameters rest_param;
+  float chan_mat[4][4];
+  float arm_mat[4][4];
+} BBoneSegmentsKey;
+
 /** Compute and cache the B-Bone shape in the channel runtime struct. */
 void BKE_pchan_bbone_segments_cache_compute(bPoseChannel *pchan)
 {
@@ -1176,7 +1252,7 @@ void BKE_pchan_bbone_segments_cache_compute(bPoseChannel *pchan)
 
   BLI_assert(segments > 1);
 
-  /* Allocate the cache if needed. */
+  /* Allocate the cache if needed, this clears the key when the segment count changes. */
   allocate_bbone_cache(pchan, segments);
 
   /* Compute the shape. */
@@ -1184,10 +1260,39 @@ void BKE_pchan_bbone_segments_cache_compute(bPoseChannel *pchan)
   Mat4 *b_bone_rest = runtime->bbone_rest_mats;
   Mat4 *b_bone_mats = runtime->bbone_deform_mats;
   DualQuat *b_bone_dual_quats = runtime->bbone_dual_quats;
+  BBoneSegmentsKey *key = runtime->bbone_segments_key;
+  BBoneSplineParameters pose_param, rest_param;
+  bool is_changed = false;
   int a;
 
-  BKE_pchan_bbone_spline_setup(pchan, false, true, b_bone);
-  BKE_pchan_bbone_spline_setup(pchan, true, true, b_bone_rest);
+  if (key == NULL) {
+    key = runtime->bbone_segments_key = MEM_callocN(sizeof(*key), "BBoneSegmentsKey");
+    is_changed = true;
+  }
+
+  /* Only compute the splines whose parameters changed since the last evaluation,
+   * the rest shape usually never changes. */
+  BKE_pchan_bbone_spline_params_get(pchan, false, &pose_param);
+  BKE_pchan_bbone_spline_params_get(pchan, true, &rest_param);
+
+  if (is_changed || memcmp(&key->pose_param, &pose_param, sizeof(pose_param)) != 0) {
+    key->pose_param = pose_param;
+    bone->segments = BKE_pchan_bbone_spline_compute(&pose_param, true, b_bone);
+    is_changed = true;
+  }
+  if (is_changed || memcmp(&key->rest_param, &rest_param, sizeof(rest_param)) != 0) {
+    key->rest_param = rest_param;
+    bone->segments = BKE_pchan_bbone_spline_compute(&rest_param, true, b_bone_rest);
+    is_changed = true;
+  }
+
+  if (!is_changed && equals_m4m4(key->chan_mat, pchan->chan_mat) &&
+      equals_m4m4(key->arm_mat, bone->arm_mat)) {
+    return;
+  }
+
+  copy_m4_m4(key->chan_mat, pchan->chan_mat);
+  copy_m4_m4(key->arm_mat, bone->arm_mat);
 
   /* Compute deform matrices. */
   /* first matrix is the inverse arm_mat, to bring points in local bone space
@@ -1228,6 +1333,9 @@ void BKE_pchan_bbone_segments_cache_copy(bPoseChannel *pchan, bPoseChannel *pcha
   else {
     allocate_bbone_cache(pchan, segments);
 
+    /* The copied segments don't match the inputs of the previous ones. */
+    MEM_SAFE_FREE(runtime->bbone_segments_key);
+
     memcpy(runtime->bbone_rest_mats, runtime_from->bbone_rest_mats, sizeof(Mat4) * (1 + segments));
     memcpy(runtime->bbone_pose_mats, runtime_from->bbone_pose_mats, sizeof(Mat4) * (1 + segments));
     memcpy(runtime->bbone_deform_mats,
@@ -1646,26 +1754,804 @@ static void armature_vert_task(void *__restrict userdata,
   }
 }
 
-void armature_deform_verts(Object *armOb,
-                           Object *target,
-                           const Mesh *mesh,
-                           float (*vertexCos)[3],
-                           float (*defMats)[3][3],
-                           int numVerts,
-                           int deformflag,
-                           float (*prevCos)[3],
-                           const char *defgrp_name,
-                           bGPDstroke *gps)
+/* ************ Packed Skinning ******************* */
+
+/* Vertices which are only influenced by plain (non B-Bone, non envelope) vertex group weights
+ * are deformed from a dense influence table instead of walking MDeformVert and defnrToPC per
+ * vertex. The table stores fixed-width bone slot indices and weights, laid out so that one
+ * batch of ARM_SKIN_BATCH vertices can be loaded directly into SIMD registers. Bone transforms
+ * are stored as structure-of-arrays. Vertices which don't fit (B-Bones, envelopes, too many
+ * influences) are collected in a separate list and deformed by armature_vert_task(). */
+
+#ifdef __SSE2__
+#  define WITH_ARMATURE_PACKED_SKINNING
+#endif
+
+/* Evaluation data of the Armature modifier which is kept between evaluations,
+ * see armature_deform_verts_ex(). */
+typedef struct ArmatureSkinCache {
+  /* Index in pose->chan_array of the pose channel of every vertex group, -1 when the group has
+   * no matching bone (those are looked up by name on every evaluation). */
+  int *defnr_pchan_index;
+  int defnr_pchan_tot;
+
+  /* Key of the influence table. */
+  const MDeformVert *dverts;
+  uint64_t dverts_copy_stamp;
+  int totvert;
+  int defbase_tot;
+  int armature_def_nr;
+  bool use_envelope;
+  bool invert_vgroup;
+  /* Packing state of every vertex group the table was built with. */
+  char *defnr_state;
+
+  struct ArmatureSkinTable *table;
+
+  /* Statistics, reported by the "bke.armature" log. */
+  int hits;
+  int misses;
+} ArmatureSkinCache;
+
+/**
+ * Fill in defnrToPC, using the pose channel indices found by the previous evaluation
+ * instead of name lookups whenever the names still match.
+ */
+static void armature_defnr_to_pchan_resolve(ArmatureSkinCache *cache,
+                                            bPose *pose,
+                                            const ListBase *defbase,
+                                            const int defbase_tot,
+                                            bPoseChannel **defnrToPC)
+{
+  const int totchan = pose->chan_array ? pose->totchan : 0;
+  bDeformGroup *dg;
+  int i;
+
+  if (cache && cache->defnr_pchan_tot != defbase_tot) {
+    MEM_SAFE_FREE(cache->defnr_pchan_index);
+    cache->defnr_pchan_tot = 0;
+  }
+  if (cache && cache->defnr_pchan_index == NULL && defbase_tot != 0) {
+    cache->defnr_pchan_index = MEM_malloc_arrayN(defbase_tot, sizeof(int), __func__);
+    copy_vn_i(cache->defnr_pchan_index, defbase_tot, -1);
+    cache->defnr_pchan_tot = defbase_tot;
+  }
+
+  for (i = 0, dg = defbase->first; dg; i++, dg = dg->next) {
+    bPoseChannel *pchan = NULL;
+
+    if (cache) {
+      const int index = cache->defnr_pchan_index[i];
+      if (index >= 0 && index < totchan && STREQ(pose->chan_array[index]->name, dg->name)) {
+        pchan = pose->chan_array[index];
+      }
+    }
+
+    if (pchan == NULL) {
+      pchan = BKE_pose_channel_find_name(pose, dg->name);
+      if (cache) {
+        cache->defnr_pchan_index[i] = -1;
+        if (pchan && pose->chan_array) {
+          for (int index = 0; index < totchan; index++) {
+            if (pose->chan_array[index] == pchan) {
+              cache->defnr_pchan_index[i] = index;
+              break;
+            }
+          }
+        }
+      }
+    }
+
+    /* exclude non-deforming bones */
+    if (pchan && (pchan->bone->flag & BONE_NO_DEFORM)) {
+      pchan = NULL;
+    }
+    defnrToPC[i] = pchan;
+  }
+}
+
+#ifdef WITH_ARMATURE_PACKED_SKINNING
+
+/* Number of vertices deformed together by the SIMD kernels. */
+#  define ARM_SKIN_BATCH 4
+/* Vertices with more influences than this are deformed by the scalar path. */
+#  define ARM_SKIN_MAX_INFLUENCES 8
+
+/* Components of the structure-of-arrays bone storage, each is an array of totbone floats. */
+enum {
+  /* chan_mat[col][row], rows 0..2 of columns 0..3. */
+  SKIN_MAT = 0,
+  SKIN_DQ_QUAT = 12,
+  SKIN_DQ_TRANS = 16,
+  SKIN_DQ_SCALE = 20,
+  SKIN_DQ_SCALE_WEIGHT = 36,
+  SKIN_TOT_COMPONENTS = 37,
+};
+
+typedef struct ArmatureSkinTable {
+  /* Number of influence slots stored for each vertex. */
+  int width;
+
+  /* Vertices deformed by the SIMD kernels. */
+  int totpacked;
+  int *packed_verts;
+  /* Laid out as [batch][slot][lane], padded with zero weights pointing to slot 0. */
+  int *bone_slots;
+  float *weights;
+  /* Weight of the overall armature vertex group, laid out as [batch][lane]. */
+  float *armature_weights;
+
+  /* Vertices which need armature_vert_task(). */
+  int totscalar;
+  int *scalar_verts;
+
+  /* Bone slot 0 is an identity transform used for padding,
+   * slot (def_nr + 1) is the pose channel of vertex group def_nr. Only indices are stored,
+   * the channels are resolved on every evaluation since the pose can be rebuilt or copied. */
+  int totbone;
+} ArmatureSkinTable;
+
+typedef struct ArmatureSkinBones {
+  int totbone;
+  /* Does any deforming bone have scale in its dual quaternion? */
+  bool use_dq_scale;
+  /* SKIN_TOT_COMPONENTS arrays of totbone floats. */
+  float *soa;
+} ArmatureSkinBones;
+
+static bool armature_skin_pchan_is_bbone(const bPoseChannel *pchan)
+{
+  const Bone *bone = pchan->bone;
+  return (bone->segments > 1 && pchan->runtime.bbone_segments == bone->segments);
+}
+
+/**
+ * Sort vertices into packed and scalar ones, and fill in the influence table for packed ones.
+ * Mirrors the vertex group handling of armature_vert_task().
+ */
+static ArmatureSkinTable *armature_skin_table_create(const ArmatureUserdata *data, int numVerts)
+{
+  const MDeformVert *dverts_base = NULL;
+  int totvert_dverts = 0;
+
+  if (data->mesh) {
+    dverts_base = data->mesh->dvert;
+    totvert_dverts = data->mesh->totvert;
+  }
+  else {
+    dverts_base = data->dverts;
+    totvert_dverts = data->target_totvert;
+  }
+
+  ArmatureSkinTable *table = MEM_callocN(sizeof(*table), __func__);
+  /* Number of influences of every vertex, negative for vertices which need no deformation,
+   * ARM_SKIN_MAX_INFLUENCES + 1 for vertices which need the scalar path. */
+  int *vert_influences = MEM_mallocN(sizeof(*vert_influences) * numVerts, __func__);
+  const int influences_scalar = ARM_SKIN_MAX_INFLUENCES + 1;
+
+  table->width = 1;
+
+  for (int i = 0; i < numVerts; i++) {
+    const MDeformVert *dvert = (dverts_base && i < totvert_dverts) ? &dverts_base[i] : NULL;
+    float armature_weight = 1.0f;
+
+    if (data->armature_def_nr != -1 && dvert) {
+      armature_weight = defvert_find_weight(dvert, data->armature_def_nr);
+      if (data->invert_vgroup) {
+        armature_weight = 1.0f - armature_weight;
+      }
+    }
+
+    if (armature_weight == 0.0f) {
+      vert_influences[i] = -1;
+      continue;
+    }
+
+    bool deformed = false;
+    int influences = 0;
+
+    if (dvert) {
+      const MDeformWeight *dw = dvert->dw;
+      for (int j = 0; j < dvert->totweight; j++, dw++) {
+        const int index = dw->def_nr;
+        const bPoseChannel *pchan;
+        if (index >= 0 && index < data->defbase_tot && (pchan = data->defnrToPC[index])) {
+          deformed = true;
+          if ((pchan->bone->flag & BONE_MULT_VG_ENV) || armature_skin_pchan_is_bbone(pchan)) {
+            influences = influences_scalar;
+            break;
+          }
+          if (dw->weight != 0.0f) {
+            influences++;
+          }
+        }
+      }
+    }
+
+    if (!deformed) {
+      /* Envelopes are used as a fallback for vertices without bone weights. */
+      vert_influences[i] = data->use_envelope ? influences_scalar : -1;
+    }
+    else if (influences > ARM_SKIN_MAX_INFLUENCES) {
+      vert_influences[i] = influences_scalar;
+    }
+    else {
+      vert_influences[i] = influences;
+    }
+
+    if (vert_influences[i] == influences_scalar) {
+      table->totscalar++;
+    }
+    else if (vert_influences[i] >= 0) {
+      table->totpacked++;
+      table->width = max_ii(table->width, influences);
+    }
+  }
+
+  const int totbatch = (table->totpacked + ARM_SKIN_BATCH - 1) / ARM_SKIN_BATCH;
+  const int totlanes = totbatch * ARM_SKIN_BATCH;
+  const int totslots = totlanes * table->width;
+
+  table->packed_verts = MEM_mallocN(sizeof(int) * max_ii(totlanes, 1), "skin packed_verts");
+  table->scalar_verts = MEM_mallocN(sizeof(int) * max_ii(table->totscalar, 1),
+                                    "skin scalar_verts");
+  /* Padding uses slot 0 with a zero weight, calloc takes care of that. */
+  table->bone_slots = MEM_callocN(sizeof(int) * max_ii(totslots, 1), "skin bone_slots");
+  table->weights = MEM_callocN(sizeof(float) * max_ii(totslots, 1), "skin weights");
+  table->armature_weights = MEM_callocN(sizeof(float) * max_ii(totlanes, 1),
+                                        "skin armature_weights");
+
+  int packed_index = 0, scalar_index = 0;
+  for (int i = 0; i < numVerts; i++) {
+    if (vert_influences[i] < 0) {
+      continue;
+    }
+    if (vert_influences[i] == influences_scalar) {
+      table->scalar_verts[scalar_index++] = i;
+      continue;
+    }
+
+    const MDeformVert *dvert = (dverts_base && i < totvert_dverts) ? &dverts_base[i] : NULL;
+    const int batch = packed_index / ARM_SKIN_BATCH;
+    const int lane = packed_index % ARM_SKIN_BATCH;
+    int *slots = &table->bone_slots[batch * table->width * ARM_SKIN_BATCH + lane];
+    float *weights = &table->weights[batch * table->width * ARM_SKIN_BATCH + lane];
+    float armature_weight = 1.0f;
+
+    if (data->armature_def_nr != -1 && dvert) {
+      armature_weight = defvert_find_weight(dvert, data->armature_def_nr);
+      if (data->invert_vgroup) {
+        armature_weight = 1.0f - armature_weight;
+      }
+    }
+
+    if (dvert) {
+      const MDeformWeight *dw = dvert->dw;
+      int k = 0;
+      for (int j = 0; j < dvert->totweight; j++, dw++) {
+        const int index = dw->def_nr;
+        if (index >= 0 && index < data->defbase_tot && data->defnrToPC[index] &&
+            dw->weight != 0.0f) {
+          slots[k * ARM_SKIN_BATCH] = index + 1;
+          weights[k * ARM_SKIN_BATCH] = dw->weight;
+          k++;
+        }
+      }
+    }
+
+    table->packed_verts[packed_index] = i;
+    table->armature_weights[packed_index] = armature_weight;
+    packed_index++;
+  }
+
+  /* Padding lanes repeat the last vertex, their results are never written back. */
+  for (; packed_index < totlanes; packed_index++) {
+    table->packed_verts[packed_index] = table->packed_verts[packed_index - 1];
+  }
+
+  table->totbone = data->defbase_tot + 1;
+
+  MEM_freeN(vert_influences);
+
+  return table;
+}
+
+static void armature_skin_table_free(ArmatureSkinTable *table)
+{
+  MEM_freeN(table->packed_verts);
+  MEM_freeN(table->scalar_verts);
+  MEM_freeN(table->bone_slots);
+  MEM_freeN(table->weights);
+  MEM_freeN(table->armature_weights);
+  MEM_freeN(table);
+}
+
+/* Packing state of one vertex group, a change of it invalidates the influence table. */
+enum {
+  SKIN_GROUP_NONE = 0,
+  SKIN_GROUP_PACKED = 1,
+  SKIN_GROUP_SCALAR = 2,
+};
+
+static char armature_skin_group_state(const bPoseChannel *pchan)
+{
+  if (pchan == NULL) {
+    return SKIN_GROUP_NONE;
+  }
+  if ((pchan->bone->flag & BONE_MULT_VG_ENV) || armature_skin_pchan_is_bbone(pchan)) {
+    return SKIN_GROUP_SCALAR;
+  }
+  return SKIN_GROUP_PACKED;
+}
+
+static void armature_skin_cache_clear(ArmatureSkinCache *cache)
+{
+  if (cache->table) {
+    armature_skin_table_free(cache->table);
+    cache->table = NULL;
+  }
+  MEM_SAFE_FREE(cache->defnr_state);
+  cache->dverts = NULL;
+  cache->dverts_copy_stamp = 0;
+}
+
+/* The cache is only valid for the vertex group layer of the deformed data-block itself,
+ * arrays created by preceding modifiers are new on every evaluation. Only copy-on-write meshes
+ * are used, they get a new copy stamp whenever their weights can have changed. */
+static const MDeformVert *armature_skin_cache_owned_dverts(Object *target,
+                                                           uint64_t *r_copy_stamp)
+{
+  if (target->type == OB_MESH) {
+    Mesh *me = BKE_object_get_pre_modified_mesh(target);
+    if ((me->id.tag & LIB_TAG_COPIED_ON_WRITE) && (me->runtime.copy_stamp != 0)) {
+      *r_copy_stamp = me->runtime.copy_stamp;
+      return me->dvert;
+    }
+  }
+  *r_copy_stamp = 0;
+  return NULL;
+}
+
+/**
+ * Get the influence table for this deformation, from the cache when its key still matches.
+ * Weights are considered unchanged as long as the mesh owning them was not copied again,
+ * every write to the original weights is followed by a copy-on-write update.
+ */
+static ArmatureSkinTable *armature_skin_cache_table_ensure(ArmatureSkinCache *cache,
+                                                           const ArmatureUserdata *data,
+                                                           const int numVerts)
+{
+  const MDeformVert *dverts = data->mesh ? data->mesh->dvert : data->dverts;
+  uint64_t copy_stamp;
+  bool is_valid = (cache->table != NULL);
+
+  if (dverts == NULL || dverts != armature_skin_cache_owned_dverts(data->target, &copy_stamp)) {
+    armature_skin_cache_clear(cache);
+    return armature_skin_table_create(data, numVerts);
+  }
+
+  if (is_valid) {
+    is_valid = (cache->dverts == dverts && cache->dverts_copy_stamp == copy_stamp &&
+                cache->totvert == numVerts &&
+                cache->defbase_tot == data->defbase_tot &&
+                cache->armature_def_nr == data->armature_def_nr &&
+                cache->use_envelope == data->use_envelope &&
+                cache->invert_vgroup == data->invert_vgroup);
+  }
+
+  /* Deform and B-Bone settings can be animated, so they are part of the key. */
+  if (is_valid) {
+    for (int i = 0; i < data->defbase_tot; i++) {
+      if (cache->defnr_state[i] != armature_skin_group_state(data->defnrToPC[i])) {
+        is_valid = false;
+        break;
+      }
+    }
+  }
+
+  if (is_valid) {
+    cache->hits++;
+    CLOG_INFO(&LOG,
+              2,
+              "skin table cache hit for '%s' (hits: %d, misses: %d)",
+              data->target->id.name + 2,
+              cache->hits,
+              cache->misses);
+    return cache->table;
+  }
+
+  armature_skin_cache_clear(cache);
+
+  cache->table = armature_skin_table_create(data, numVerts);
+  cache->dverts = dverts;
+  cache->dverts_copy_stamp = copy_stamp;
+  cache->totvert = numVerts;
+  cache->defbase_tot = data->defbase_tot;
+  cache->armature_def_nr = data->armature_def_nr;
+  cache->use_envelope = data->use_envelope;
+  cache->invert_vgroup = data->invert_vgroup;
+  cache->defnr_state = MEM_mallocN(sizeof(char) * max_ii(data->defbase_tot, 1), __func__);
+  for (int i = 0; i < data->defbase_tot; i++) {
+    cache->defnr_state[i] = armature_skin_group_state(data->defnrToPC[i]);
+  }
+
+  cache->misses++;
+  CLOG_INFO(&LOG,
+            1,
+            "skin table cache miss for '%s' (hits: %d, misses: %d)",
+            data->target->id.name + 2,
+            cache->hits,
+            cache->misses);
+
+  return cache->table;
+}
+
+/* Copy the current deform transforms of all bone slots into structure-of-arrays storage,
+ * the pose channels of the slots come from the defnrToPC of this evaluation. */
+static void armature_skin_bones_init(ArmatureSkinBones *bones,
+                                     const ArmatureSkinTable *table,
+                                     bPoseChannel **defnrToPC)
+{
+  const int totbone = table->totbone;
+
+  bones->totbone = totbone;
+  bones->use_dq_scale = false;
+  bones->soa = MEM_callocN(sizeof(float) * SKIN_TOT_COMPONENTS * totbone, "skin bones soa");
+
+  for (int b = 0; b < totbone; b++) {
+    const bPoseChannel *pchan = (b > 0) ? defnrToPC[b - 1] : NULL;
+    if (pchan == NULL) {
+      /* Identity, only referenced by zero weights. */
+      bones->soa[(SKIN_MAT + 0) * totbone + b] = 1.0f;
+      bones->soa[(SKIN_MAT + 4) * totbone + b] = 1.0f;
+      bones->soa[(SKIN_MAT + 8) * totbone + b] = 1.0f;
+      bones->soa[SKIN_DQ_QUAT * totbone + b] = 1.0f;
+      continue;
+    }
+
+    const DualQuat *dq = &pchan->runtime.deform_dual_quat;
+
+    for (int col = 0; col < 4; col++) {
+      for (int row = 0; row < 3; row++) {
+        bones->soa[(SKIN_MAT + col * 3 + row) * totbone + b] = pchan->chan_mat[col][row];
+      }
+    }
+    for (int c = 0; c < 4; c++) {
+      bones->soa[(SKIN_DQ_QUAT + c) * totbone + b] = dq->quat[c];
+      bones->soa[(SKIN_DQ_TRANS + c) * totbone + b] = dq->trans[c];
+    }
+    if (dq->scale_weight != 0.0f) {
+      for (int c = 0; c < 16; c++) {
+        bones->soa[(SKIN_DQ_SCALE + c) * totbone + b] = dq->scale[c / 4][c % 4];
+      }
+      bones->soa[SKIN_DQ_SCALE_WEIGHT * totbone + b] = dq->scale_weight;
+      bones->use_dq_scale = true;
+    }
+  }
+}
+
+typedef struct ArmatureSkinUserdata {
+  const ArmatureUserdata *data;
+  const ArmatureSkinTable *table;
+  const ArmatureSkinBones *bones;
+} ArmatureSkinUserdata;
+
+BLI_INLINE __m128 skin_gather_ps(const float *array, const int index[ARM_SKIN_BATCH])
+{
+  return _mm_set_ps(array[index[3]], array[index[2]], array[index[1]], array[index[0]]);
+}
+
+BLI_INLINE __m128 skin_madd_ps(__m128 a, __m128 b, __m128 c)
+{
+  return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+/* r = M * co for ARM_SKIN_BATCH points, M given as 12 SoA components. */
+BLI_INLINE void skin_transform_ps(__m128 r[3], const __m128 m[12], const __m128 co[3])
+{
+  for (int row = 0; row < 3; row++) {
+    r[row] = skin_madd_ps(
+        m[row],
+        co[0],
+        skin_madd_ps(m[3 + row], co[1], skin_madd_ps(m[6 + row], co[2], m[9 + row])));
+  }
+}
+
+static void skin_load_m4_ps(__m128 r[12], const float mat[4][4])
+{
+  for (int col = 0; col < 4; col++) {
+    for (int row = 0; row < 3; row++) {
+      r[col * 3 + row] = _mm_set1_ps(mat[col][row]);
+    }
+  }
+}
+
+/* Load the coordinates of one batch and bring them into armature space. */
+static void skin_load_coords_ps(__m128 r_co[3], const ArmatureUserdata *data, const int *verts)
+{
+  float(*const vertexCos)[3] = data->vertexCos;
+  __m128 premat[12], co[3];
+
+  for (int axis = 0; axis < 3; axis++) {
+    co[axis] = _mm_set_ps(vertexCos[verts[3]][axis],
+                          vertexCos[verts[2]][axis],
+                          vertexCos[verts[1]][axis],
+                          vertexCos[verts[0]][axis]);
+  }
+
+  skin_load_m4_ps(premat, data->premat);
+  skin_transform_ps(r_co, premat, co);
+}
+
+/* Bring the coordinates of one batch back into object space and write the valid lanes. */
+static void skin_store_coords(const ArmatureUserdata *data,
+                              const int *verts,
+                              const int totlanes,
+                              float co[3][ARM_SKIN_BATCH])
+{
+  float(*const vertexCos)[3] = data->vertexCos;
+
+  for (int lane = 0; lane < totlanes; lane++) {
+    float *r = vertexCos[verts[lane]];
+    r[0] = co[0][lane];
+    r[1] = co[1][lane];
+    r[2] = co[2][lane];
+    mul_m4_v3(data->postmat, r);
+  }
+}
+
+static void armature_skin_linear_task(void *__restrict userdata,
+                                      const int batch,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArmatureSkinUserdata *skin_data = userdata;
+  const ArmatureUserdata *data = skin_data->data;
+  const ArmatureSkinTable *table = skin_data->table;
+  const float *soa = skin_data->bones->soa;
+  const int totbone = skin_data->bones->totbone;
+  const int width = table->width;
+  const int *verts = &table->packed_verts[batch * ARM_SKIN_BATCH];
+  const int totlanes = min_ii(ARM_SKIN_BATCH, table->totpacked - batch * ARM_SKIN_BATCH);
+
+  __m128 co[3], vec[3], contrib = _mm_setzero_ps();
+
+  skin_load_coords_ps(co, data, verts);
+  vec[0] = vec[1] = vec[2] = _mm_setzero_ps();
+
+  for (int k = 0; k < width; k++) {
+    const int offset = (batch * width + k) * ARM_SKIN_BATCH;
+    const int *slots = &table->bone_slots[offset];
+    const __m128 weight = _mm_loadu_ps(&table->weights[offset]);
+    __m128 mat[12], tmp[3];
+
+    for (int c = 0; c < 12; c++) {
+      mat[c] = skin_gather_ps(&soa[(SKIN_MAT + c) * totbone], slots);
+    }
+    skin_transform_ps(tmp, mat, co);
+
+    for (int axis = 0; axis < 3; axis++) {
+      vec[axis] = skin_madd_ps(_mm_sub_ps(tmp[axis], co[axis]), weight, vec[axis]);
+    }
+    contrib = _mm_add_ps(contrib, weight);
+  }
+
+  /* Same threshold as armature_vert_task(), lanes below it are left untouched. */
+  const __m128 mask = _mm_cmpgt_ps(contrib, _mm_set1_ps(0.0001f));
+  const __m128 armature_weight = _mm_loadu_ps(&table->armature_weights[batch * ARM_SKIN_BATCH]);
+  const __m128 fac = _mm_and_ps(
+      mask, _mm_div_ps(armature_weight, _mm_max_ps(contrib, _mm_set1_ps(0.0001f))));
+
+  float result[3][ARM_SKIN_BATCH];
+  for (int axis = 0; axis < 3; axis++) {
+    _mm_storeu_ps(result[axis], skin_madd_ps(vec[axis], fac, co[axis]));
+  }
+
+  skin_store_coords(data, verts, totlanes, result);
+}
+
+static void armature_skin_dual_quat_task(void *__restrict userdata,
+                                         const int batch,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArmatureSkinUserdata *skin_data = userdata;
+  const ArmatureUserdata *data = skin_data->data;
+  const ArmatureSkinTable *table = skin_data->table;
+  const float *soa = skin_data->bones->soa;
+  const int totbone = skin_data->bones->totbone;
+  const bool use_dq_scale = skin_data->bones->use_dq_scale;
+  const int width = table->width;
+  const int *verts = &table->packed_verts[batch * ARM_SKIN_BATCH];
+  const int totlanes = min_ii(ARM_SKIN_BATCH, table->totpacked - batch * ARM_SKIN_BATCH);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 sign_bit = _mm_set1_ps(-0.0f);
+
+  __m128 co[3], quat[4], trans[4], scale[16], scale_weight = zero, contrib = zero;
+
+  skin_load_coords_ps(co, data, verts);
+  for (int c = 0; c < 4; c++) {
+    quat[c] = trans[c] = zero;
+  }
+  for (int c = 0; c < 16; c++) {
+    scale[c] = zero;
+  }
+
+  /* Vectorized add_weighted_dq_dq(). */
+  for (int k = 0; k < width; k++) {
+    const int offset = (batch * width + k) * ARM_SKIN_BATCH;
+    const int *slots = &table->bone_slots[offset];
+    const __m128 weight = _mm_loadu_ps(&table->weights[offset]);
+    __m128 bone_quat[4];
+
+    for (int c = 0; c < 4; c++) {
+      bone_quat[c] = skin_gather_ps(&soa[(SKIN_DQ_QUAT + c) * totbone], slots);
+    }
+
+    /* Make sure we interpolate quats in the right direction. */
+    __m128 dot = _mm_mul_ps(bone_quat[0], quat[0]);
+    for (int c = 1; c < 4; c++) {
+      dot = skin_madd_ps(bone_quat[c], quat[c], dot);
+    }
+    const __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, zero), sign_bit);
+    const __m128 weight_signed = _mm_xor_ps(weight, flip);
+
+    for (int c = 0; c < 4; c++) {
+      quat[c] = skin_madd_ps(bone_quat[c], weight_signed, quat[c]);
+      trans[c] = skin_madd_ps(
+          skin_gather_ps(&soa[(SKIN_DQ_TRANS + c) * totbone], slots), weight_signed, trans[c]);
+    }
+
+    if (use_dq_scale) {
+      /* Bones without scale store zeros, so they don't contribute. */
+      for (int c = 0; c < 16; c++) {
+        scale[c] = skin_madd_ps(
+            skin_gather_ps(&soa[(SKIN_DQ_SCALE + c) * totbone], slots), weight, scale[c]);
+      }
+      scale_weight = skin_madd_ps(
+          skin_gather_ps(&soa[SKIN_DQ_SCALE_WEIGHT * totbone], slots), weight, scale_weight);
+    }
+
+    contrib = _mm_add_ps(contrib, weight);
+  }
+
+  /* Normalization and the final transform are done per vertex. */
+  float lane_co[3][ARM_SKIN_BATCH], lane_quat[4][ARM_SKIN_BATCH], lane_trans[4][ARM_SKIN_BATCH];
+  float lane_scale[16][ARM_SKIN_BATCH], lane_scale_weight[ARM_SKIN_BATCH];
+  float lane_contrib[ARM_SKIN_BATCH];
+
+  for (int c = 0; c < 3; c++) {
+    _mm_storeu_ps(lane_co[c], co[c]);
+  }
+  for (int c = 0; c < 4; c++) {
+    _mm_storeu_ps(lane_quat[c], quat[c]);
+    _mm_storeu_ps(lane_trans[c], trans[c]);
+  }
+  for (int c = 0; c < 16; c++) {
+    _mm_storeu_ps(lane_scale[c], scale[c]);
+  }
+  _mm_storeu_ps(lane_scale_weight, scale_weight);
+  _mm_storeu_ps(lane_contrib, contrib);
+
+  for (int lane = 0; lane < totlanes; lane++) {
+    const float armature_weight = table->armature_weights[batch * ARM_SKIN_BATCH + lane];
+    float vco[3] = {lane_co[0][lane], lane_co[1][lane], lane_co[2][lane]};
+
+    if (lane_contrib[lane] > 0.0001f) {
+      DualQuat dq;
+      for (int c = 0; c < 4; c++) {
+        dq.quat[c] = lane_quat[c][lane];
+        dq.trans[c] = lane_trans[c][lane];
+      }
+      for (int c = 0; c < 16; c++) {
+        dq.scale[c / 4][c % 4] = lane_scale[c][lane];
+      }
+      dq.scale_weight = lane_scale_weight[lane];
+
+      normalize_dq(&dq, lane_contrib[lane]);
+
+      if (armature_weight != 1.0f) {
+        float dco[3];
+        copy_v3_v3(dco, vco);
+        mul_v3m3_dq(dco, NULL, &dq);
+        sub_v3_v3(dco, vco);
+        madd_v3_v3fl(vco, dco, armature_weight);
+      }
+      else {
+        mul_v3m3_dq(vco, NULL, &dq);
+      }
+    }
+
+    float *r = data->vertexCos[verts[lane]];
+    mul_v3_m4v3(r, data->postmat, vco);
+  }
+}
+
+static void armature_skin_scalar_task(void *__restrict userdata,
+                                      const int i,
+                                      const TaskParallelTLS *__restrict tls)
+{
+  const ArmatureSkinUserdata *skin_data = userdata;
+  armature_vert_task((void *)skin_data->data, skin_data->table->scalar_verts[i], tls);
+}
+
+/* Whether the packed kernels can handle this deformation at all. */
+static bool armature_skin_packed_supported(const ArmatureUserdata *data)
+{
+  return (data->use_dverts && data->defMats == NULL && data->prevCos == NULL &&
+          data->target->type != OB_GPENCIL);
+}
+
+static void armature_skin_deform_packed(const ArmatureUserdata *data,
+                                        const int numVerts,
+                                        ArmatureSkinCache *cache)
+{
+  ArmatureSkinTable *table = cache ? armature_skin_cache_table_ensure(cache, data, numVerts) :
+                                     armature_skin_table_create(data, numVerts);
+  ArmatureSkinBones bones;
+  armature_skin_bones_init(&bones, table, data->defnrToPC);
+
+  ArmatureSkinUserdata skin_data = {
+      .data = data,
+      .table = table,
+      .bones = &bones,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 32 / ARM_SKIN_BATCH;
+
+  const int totbatch = (table->totpacked + ARM_SKIN_BATCH - 1) / ARM_SKIN_BATCH;
+  BLI_task_parallel_range(0,
+                          totbatch,
+                          &skin_data,
+                          data->use_quaternion ? armature_skin_dual_quat_task :
+                                                 armature_skin_linear_task,
+                          &settings);
+
+  settings.min_iter_per_thread = 32;
+  BLI_task_parallel_range(0, table->totscalar, &skin_data, armature_skin_scalar_task, &settings);
+
+  MEM_freeN(bones.soa);
+  if (cache == NULL || table != cache->table) {
+    armature_skin_table_free(table);
+  }
+}
+
+#endif /* WITH_ARMATURE_PACKED_SKINNING */
+
+void BKE_armature_skin_cache_free(ArmatureSkinCache *cache)
+{
+#ifdef WITH_ARMATURE_PACKED_SKINNING
+  armature_skin_cache_clear(cache);
+#endif
+  MEM_SAFE_FREE(cache->defnr_pchan_index);
+  MEM_freeN(cache);
+}
+
+/**
+ * \param r_skin_cache: Optional storage for data which can be reused by the next evaluation,
+ * it is allocated when needed and freed with #BKE_armature_skin_cache_free.
+ */
+void armature_deform_verts_ex(Object *armOb,
+                              Object *target,
+                              const Mesh *mesh,
+                              float (*vertexCos)[3],
+                              float (*defMats)[3][3],
+                              int numVerts,
+                              int deformflag,
+                              float (*prevCos)[3],
+                              const char *defgrp_name,
+                              bGPDstroke *gps,
+                              ArmatureSkinCache **r_skin_cache)
 {
   bArmature *arm = armOb->data;
   bPoseChannel **defnrToPC = NULL;
+  ArmatureSkinCache *skin_cache = NULL;
   MDeformVert *dverts = NULL;
-  bDeformGroup *dg;
   const bool use_envelope = (deformflag & ARM_DEF_ENVELOPE) != 0;
   const bool use_quaternion = (deformflag & ARM_DEF_QUATERNION) != 0;
   const bool invert_vgroup = (deformflag & ARM_DEF_INVERT_VGROUP) != 0;
   int defbase_tot = 0;       /* safety for vertexgroup index overflow */
-  int i, target_totvert = 0; /* safety for vertexgroup overflow */
+  int target_totvert = 0;    /* safety for vertexgroup overflow */
   bool use_dverts = false;
   int armature_def_nr;
 
@@ -1721,20 +2607,15 @@ void armature_deform_verts(Object *armOb,
       }
 
       if (use_dverts) {
-        defnrToPC = MEM_callocN(sizeof(*defnrToPC) * defbase_tot, "defnrToBone");
-        /* TODO(sergey): Some considerations here:
-         *
-         * - Check whether keeping this consistent across frames gives speedup.
-         */
-        for (i = 0, dg = target->defbase.first; dg; i++, dg = dg->next) {
-          defnrToPC[i] = BKE_pose_channel_find_name(armOb->pose, dg->name);
-          /* exclude non-deforming bones */
-          if (defnrToPC[i]) {
-            if (defnrToPC[i]->bone->flag & BONE_NO_DEFORM) {
-              defnrToPC[i] = NULL;
-            }
+        if (r_skin_cache) {
+          if (*r_skin_cache == NULL) {
+            *r_skin_cache = MEM_callocN(sizeof(ArmatureSkinCache), "ArmatureSkinCache");
           }
+          skin_cache = *r_skin_cache;
         }
+        defnrToPC = MEM_callocN(sizeof(*defnrToPC) * defbase_tot, "defnrToBone");
+        armature_defnr_to_pchan_resolve(
+            skin_cache, armOb->pose, &target->defbase, defbase_tot, defnrToPC);
       }
     }
   }
@@ -1761,16 +2642,48 @@ void armature_deform_verts(Object *armOb,
   mul_m4_m4m4(data.postmat, obinv, armOb->obmat);
   invert_m4_m4(data.premat, data.postmat);
 
-  TaskParallelSettings settings;
-  BLI_parallel_range_settings_defaults(&settings);
-  settings.min_iter_per_thread = 32;
-  BLI_task_parallel_range(0, numVerts, &data, armature_vert_task, &settings);
+#ifdef WITH_ARMATURE_PACKED_SKINNING
+  if (armature_skin_packed_supported(&data)) {
+    armature_skin_deform_packed(&data, numVerts, skin_cache);
+  }
+  else
+#endif
+  {
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 32;
+    BLI_task_parallel_range(0, numVerts, &data, armature_vert_task, &settings);
+  }
 
   if (defnrToPC) {
     MEM_freeN(defnrToPC);
   }
 }
 
+void armature_deform_verts(Object *armOb,
+                           Object *target,
+                           const Mesh *mesh,
+                           float (*vertexCos)[3],
+                           float (*defMats)[3][3],
+                           int numVerts,
+                           int deformflag,
+                           float (*prevCos)[3],
+                           const char *defgrp_name,
+                           bGPDstroke *gps)
+{
+  armature_deform_verts_ex(armOb,
+                           target,
+                           mesh,
+                           vertexCos,
+                           defMats,
+                           numVerts,
+                           deformflag,
+                           prevCos,
+                           defgrp_name,
+                           gps,
+                           NULL);
+}
+
 /* ************ END Armature Deform ******************* */
 
 void get_objectspace_bone_matrix(struct Bone *bone,
@@ -2653,6 +3566,9 @@ void BKE_pose_rebuild(Main *bmain, Object *ob, bArmature *arm, const bool do_id_
   /* clear */
   BKE_pose_clear_pointers(pose);
 
+  /* IK trees may reference channels freed below, they are rebuilt on next evaluation anyway. */
+  BIK_clear_data(pose);
+
   /* first step, check if all channels are there */
   for (bone = arm->bonebase.first; bone; bone = bone->next) {
     counter = rebuild_pose_bone(pose, bone, NULL, counter);
@@ -2663,7 +3579,10 @@ void BKE_pose_rebuild(Main *bmain, Object *ob, bArmature *arm, const bool do_id_
     next = pchan->next;
     if (pchan->bone == NULL) {
       BKE_pose_channel_free_ex(pchan, do_id_user);
-      BKE_pose_channels_hash_free(pose);
+      /* Keep the name hash valid instead of re-hashing every channel afterwards. */
+      if (pose->chanhash) {
+        BLI_ghash_remove(pose->chanhash, pchan->name, NULL, NULL);
+      }
       BLI_freelinkN(&pose->chanbase, pchan);
     }
   }
@@ -2779,26 +3698,26 @@ void BKE_pose_where_is_bone(struct Depsgraph *depsgraph,
   if (do_extra) {
     /* Do constraints */
     if (pchan->constraints.first) {
-      bConstraintOb *cob;
+      bConstraintOb cob;
       float vec[3];
 
       /* make a copy of location of PoseChannel for later */
       copy_v3_v3(vec, pchan->pose_mat[3]);
 
       /* prepare PoseChannel for Constraint solving
-       * - makes a copy of matrix, and creates temporary struct to use
+       * - makes a copy of matrix, in a temporary struct on the stack
        */
-      cob = BKE_constraints_make_evalob(depsgraph, scene, ob, pchan, CONSTRAINT_OBTYPE_BONE);
+      BKE_constraints_init_evalob(&cob, depsgraph, scene, ob, pchan, CONSTRAINT_OBTYPE_BONE);
 
       /* Solve PoseChannel's Constraints */
 
       /* ctime doesn't alter objects. */
-      BKE_constraints_solve(depsgraph, &pchan->constraints, cob, ctime);
+      BKE_constraints_solve(depsgraph, &pchan->constraints, &cob, ctime);
 
       /* cleanup after Constraint Solving
-       * - applies matrix back to pchan, and frees temporary struct used
+       * - applies matrix back to pchan
        */
-      BKE_constraints_clear_evalob(cob);
+      BKE_constraints_apply_evalob(&cob);
 
       /* prevent constraints breaking a chain */
       if (pchan->bone->flag & BONE_CONNECTED) {
@@ -2868,18 +3787,23 @@ void BKE_pose_where_is(struct Depsgraph *depsgraph, Scene *scene, Object *ob)
     BKE_pose_splineik_init_tree(scene, ob, ctime);
 
     /* 3. the main loop, channels are already hierarchical sorted from root to children */
-    for (pchan = ob->pose->chanbase.first; pchan; pchan = pchan->next) {
-      /* 4a. if we find an IK root, we handle it separated */
-      if (pchan->flag & POSE_IKTREE) {
-        BIK_execute_tree(depsgraph, scene, ob, pchan, ctime);
-      }
-      /* 4b. if we find a Spline IK root, we handle it separated too */
-      else if (pchan->flag & POSE_IKSPLINE) {
-        BKE_splineik_execute_tree(depsgraph, scene, ob, pchan, ctime);
-      }
-      /* 5. otherwise just call the normal solver */
-      else if (!(pchan->flag & POSE_DONE)) {
-        BKE_pose_where_is_bone(depsgraph, scene, ob, pchan, ctime, 1);
+    if (arm->flag & ARM_POSE_EVAL_BATCHED) {
+      BKE_pose_where_is_levels(depsgraph, scene, ob, ctime);
+    }
+    else {
+      for (pchan = ob->pose->chanbase.first; pchan; pchan = pchan->next) {
+        /* 4a. if we find an IK root, we handle it separated */
+        if (pchan->flag & POSE_IKTREE) {
+          BIK_execute_tree(depsgraph, scene, ob, pchan, ctime);
+        }
+        /* 4b. if we find a Spline IK root, we handle it separated too */
+        else if (pchan->flag & POSE_IKSPLINE) {
+          BKE_splineik_execute_tree(depsgraph, scene, ob, pchan, ctime);
+        }
+        /* 5. otherwise just call the normal solver */
+        else if (!(pchan->flag & POSE_DONE)) {
+          BKE_pose_where_is_bone(depsgraph, scene, ob, pchan, ctime, 1);
+        }
       }
     }
     /* 6. release the IK tree */
@@ -2895,6 +3819,259 @@ void BKE_pose_where_is(struct Depsgraph *depsgraph, Scene *scene, Object *ob)
   }
 }
 
+/* ********************** Batched Pose Evaluation ******************* */
+
+/* The pose channels are sorted by levels, where every channel only depends on channels of lower
+ * levels: its parent and the bones of the same armature targeted by its constraints. IK and
+ * Spline IK trees are solved at their root channel, so the targets of the whole chain are
+ * dependencies of the root. The channels of one level can then be evaluated in parallel. */
+
+typedef struct PoseLevelsBuild {
+  bPose *pose;
+  Object *ob;
+  bPoseChannel **chans;
+  /* bPoseChannel -> index in chans. */
+  GHash *chan_index;
+  /* Dependencies of every channel besides its parent, as indices in chans. */
+  LinkNode **deps;
+  MemArena *arena;
+  /* Level of every channel, -1 when not computed yet, -2 while it is being computed. */
+  int *levels;
+} PoseLevelsBuild;
+
+static int pose_levels_chan_index(PoseLevelsBuild *build, bPoseChannel *pchan)
+{
+  return POINTER_AS_INT(BLI_ghash_lookup_default(build->chan_index, pchan, POINTER_FROM_INT(-1)));
+}
+
+static void pose_levels_add_constraint_deps(PoseLevelsBuild *build,
+                                            bPoseChannel *owner,
+                                            bConstraint *con)
+{
+  const bConstraintTypeInfo *cti = BKE_constraint_typeinfo_get(con);
+  ListBase targets = {NULL, NULL};
+  const int owner_index = pose_levels_chan_index(build, owner);
+
+  if (owner_index == -1 || cti == NULL || cti->get_constraint_targets == NULL) {
+    return;
+  }
+
+  cti->get_constraint_targets(con, &targets);
+
+  for (bConstraintTarget *ct = targets.first; ct; ct = ct->next) {
+    if (ct->tar == build->ob && ct->subtarget[0]) {
+      bPoseChannel *dep = BKE_pose_channel_find_name(build->pose, ct->subtarget);
+      const int dep_index = pose_levels_chan_index(build, dep);
+      if (dep_index != -1 && dep_index != owner_index) {
+        BLI_linklist_prepend_arena(
+            &build->deps[owner_index], POINTER_FROM_INT(dep_index), build->arena);
+      }
+    }
+  }
+
+  if (cti->flush_constraint_targets) {
+    cti->flush_constraint_targets(con, &targets, true);
+  }
+}
+
+/* Constraints of the channels in an IK chain are evaluated by the solver of the chain root. */
+static void pose_levels_add_chain_deps(PoseLevelsBuild *build,
+                                       bPoseChannel *rootchan,
+                                       bPoseChannel *tipchan)
+{
+  for (bPoseChannel *pchan = tipchan; pchan && pchan != rootchan; pchan = pchan->parent) {
+    for (bConstraint *con = pchan->constraints.first; con; con = con->next) {
+      if (!ELEM(con->type, CONSTRAINT_TYPE_KINEMATIC, CONSTRAINT_TYPE_SPLINEIK)) {
+        pose_levels_add_constraint_deps(build, rootchan, con);
+      }
+    }
+  }
+}
+
+static int pose_levels_compute(PoseLevelsBuild *build, int index)
+{
+  if (build->levels[index] >= 0) {
+    return build->levels[index];
+  }
+  if (build->levels[index] == -2) {
+    /* Dependency cycle, ignore the dependency closing it like the depsgraph would. */
+    return -1;
+  }
+
+  build->levels[index] = -2;
+
+  bPoseChannel *pchan = build->chans[index];
+  int level = 0;
+
+  if (pchan->parent) {
+    const int parent_index = pose_levels_chan_index(build, pchan->parent);
+    if (parent_index != -1) {
+      level = max_ii(level, pose_levels_compute(build, parent_index) + 1);
+    }
+  }
+  for (LinkNode *link = build->deps[index]; link; link = link->next) {
+    level = max_ii(level, pose_levels_compute(build, POINTER_AS_INT(link->link)) + 1);
+  }
+
+  build->levels[index] = level;
+  return level;
+}
+
+void BKE_pose_eval_levels_free(bPose *pose)
+{
+  MEM_SAFE_FREE(pose->level_chans);
+  MEM_SAFE_FREE(pose->level_offsets);
+  pose->totlevel = 0;
+}
+
+/**
+ * Sort the pose channels by dependency level into #bPose.level_chans, if not done yet.
+ * Gets invalidated when the channels or their constraints change.
+ */
+void BKE_pose_eval_levels_ensure(Object *ob)
+{
+  bPose *pose = ob->pose;
+
+  if (pose->level_offsets != NULL) {
+    return;
+  }
+
+  const int totchan = BLI_listbase_count(&pose->chanbase);
+  PoseLevelsBuild build = {
+      .pose = pose,
+      .ob = ob,
+      .chans = MEM_malloc_arrayN(totchan, sizeof(*build.chans), __func__),
+      .chan_index = BLI_ghash_ptr_new_ex(__func__, totchan),
+      .deps = MEM_calloc_arrayN(totchan, sizeof(*build.deps), __func__),
+      .arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__),
+      .levels = MEM_malloc_arrayN(totchan, sizeof(*build.levels), __func__),
+  };
+  int index = 0;
+
+  for (bPoseChannel *pchan = pose->chanbase.first; pchan; pchan = pchan->next, index++) {
+    build.chans[index] = pchan;
+    build.levels[index] = -1;
+    BLI_ghash_insert(build.chan_index, pchan, POINTER_FROM_INT(index));
+  }
+
+  for (index = 0; index < totchan; index++) {
+    bPoseChannel *pchan = build.chans[index];
+
+    for (bConstraint *con = pchan->constraints.first; con; con = con->next) {
+      bPoseChannel *rootchan = pchan;
+
+      if (con->type == CONSTRAINT_TYPE_KINEMATIC) {
+        rootchan = BKE_armature_ik_solver_find_root(pchan, con->data);
+      }
+      else if (con->type == CONSTRAINT_TYPE_SPLINEIK) {
+        rootchan = BKE_armature_splineik_solver_find_root(pchan, con->data);
+      }
+      if (rootchan == NULL) {
+        continue;
+      }
+
+      pose_levels_add_constraint_deps(&build, rootchan, con);
+      if (rootchan != pchan) {
+        pose_levels_add_chain_deps(&build, rootchan, pchan);
+      }
+    }
+  }
+
+  int totlevel = 0;
+  for (index = 0; index < totchan; index++) {
+    totlevel = max_ii(totlevel, pose_levels_compute(&build, index) + 1);
+  }
+
+  /* Counting sort, keeps the hierarchical order of chanbase within every level. */
+  pose->totlevel = totlevel;
+  pose->level_offsets = MEM_calloc_arrayN(totlevel + 1, sizeof(int), "pose->level_offsets");
+  pose->level_chans = MEM_malloc_arrayN(
+      max_ii(totchan, 1), sizeof(bPoseChannel *), "pose->level_chans");
+
+  for (index = 0; index < totchan; index++) {
+    pose->level_offsets[build.levels[index] + 1]++;
+  }
+  for (int level = 0; level < totlevel; level++) {
+    pose->level_offsets[level + 1] += pose->level_offsets[level];
+  }
+
+  int *fill = MEM_dupallocN(pose->level_offsets);
+  for (index = 0; index < totchan; index++) {
+    pose->level_chans[fill[build.levels[index]]++] = build.chans[index];
+  }
+  MEM_freeN(fill);
+
+  CLOG_INFO(&LOG, 1, "%s: %d pose channels in %d levels", ob->id.name + 2, totchan, totlevel);
+
+  BLI_memarena_free(build.arena);
+  BLI_ghash_free(build.chan_index, NULL, NULL);
+  MEM_freeN(build.chans);
+  MEM_freeN(build.deps);
+  MEM_freeN(build.levels);
+}
+
+typedef struct PoseLevelsEvalData {
+  struct Depsgraph *depsgraph;
+  Scene *scene;
+  Object *ob;
+  bPoseChannel **chans;
+  float ctime;
+} PoseLevelsEvalData;
+
+static void pose_levels_eval_task(void *__restrict userdata,
+                                  const int index,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PoseLevelsEvalData *data = userdata;
+  bPoseChannel *pchan = data->chans[index];
+
+  /* IK and Spline IK trees are solved once the whole level is done. */
+  if (pchan->flag & (POSE_IKTREE | POSE_IKSPLINE | POSE_DONE)) {
+    return;
+  }
+  BKE_pose_where_is_bone(data->depsgraph, data->scene, data->ob, pchan, data->ctime, true);
+}
+
+/**
+ * Equivalent of the main loop of #BKE_pose_where_is, evaluating the channels of every level
+ * in parallel. The IK trees are expected to be initialized already.
+ */
+void BKE_pose_where_is_levels(struct Depsgraph *depsgraph, Scene *scene, Object *ob, float ctime)
+{
+  bPose *pose = ob->pose;
+
+  BKE_pose_eval_levels_ensure(ob);
+
+  PoseLevelsEvalData data = {
+      .depsgraph = depsgraph,
+      .scene = scene,
+      .ob = ob,
+      .chans = pose->level_chans,
+      .ctime = ctime,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 8;
+
+  for (int level = 0; level < pose->totlevel; level++) {
+    const int start = pose->level_offsets[level];
+    const int end = pose->level_offsets[level + 1];
+
+    BLI_task_parallel_range(start, end, &data, pose_levels_eval_task, &settings);
+
+    /* Solve the IK trees rooted at this level before any of their children is evaluated. */
+    for (int index = start; index < end; index++) {
+      bPoseChannel *pchan = pose->level_chans[index];
+      if (pchan->flag & POSE_IKTREE) {
+        BIK_execute_tree(depsgraph, scene, ob, pchan, ctime);
+      }
+      else if (pchan->flag & POSE_IKSPLINE) {
+        BKE_splineik_execute_tree(depsgraph, scene, ob, pchan, ctime);
+      }
+    }
+  }
+}
+
 /************** Bounding box ********************/
 static int minmax_armature(Object *ob, float r_min[3], float r_max[3])
 {
@@ -28,6 +28,7 @@
 #include "BLI_utildefines.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "DNA_armature_types.h"
 #include "DNA_constraint_types.h"
@@ -600,6 +601,7 @@ void BKE_pose_pchan_index_rebuild(bPose *pose)
   MEM_SAFE_FREE(pose->chan_array);
   const int num_channels = BLI_listbase_count(&pose->chanbase);
   pose->chan_array = MEM_malloc_arrayN(num_channels, sizeof(bPoseChannel *), "pose->chan_array");
+  pose->totchan = num_channels;
   int pchan_index = 0;
   for (bPoseChannel *pchan = pose->chanbase.first; pchan != NULL; pchan = pchan->next) {
     pose->chan_array[pchan_index++] = pchan;
@@ -612,7 +614,7 @@ BLI_INLINE bPoseChannel *pose_pchan_get_indexed(Object *ob, int pchan_index)
   BLI_assert(pose != NULL);
   BLI_assert(pose->chan_array != NULL);
   BLI_assert(pchan_index >= 0);
-  BLI_assert(pchan_index < MEM_allocN_len(pose->chan_array) / sizeof(bPoseChannel *));
+  BLI_assert(pchan_index < pose->totchan);
   return pose->chan_array[pchan_index];
 }
 
@@ -814,6 +816,69 @@ void BKE_pose_splineik_evaluate(struct Depsgraph *depsgraph,
   BKE_splineik_execute_tree(depsgraph, scene, object, rootchan, ctime);
 }
 
+typedef struct PoseBatchedEvalData {
+  struct Depsgraph *depsgraph;
+  Object *object;
+} PoseBatchedEvalData;
+
+static void pose_eval_batched_bone_done_task(void *__restrict userdata,
+                                             const int pchan_index,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PoseBatchedEvalData *data = userdata;
+  BKE_pose_bone_done(data->depsgraph, data->object, pchan_index);
+}
+
+static void pose_eval_batched_bbone_segments_task(void *__restrict userdata,
+                                                  const int pchan_index,
+                                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PoseBatchedEvalData *data = userdata;
+  BKE_pose_eval_bbone_segments(data->depsgraph, data->object, pchan_index);
+}
+
+/* Evaluates the whole pose in one operation, used instead of the per-bone operations for
+ * armatures with ARM_POSE_EVAL_BATCHED. Runs between the IK initialization and cleanup. */
+void BKE_pose_eval_batched(struct Depsgraph *depsgraph, Scene *scene, Object *object)
+{
+  const bArmature *armature = (bArmature *)object->data;
+  if (armature->edbo != NULL) {
+    return;
+  }
+  bPose *pose = object->pose;
+  DEG_debug_print_eval(depsgraph, __func__, object->id.name, object);
+  BLI_assert(object->type == OB_ARMATURE);
+  BLI_assert(pose->chan_array != NULL || BLI_listbase_is_empty(&pose->chanbase));
+
+  if (armature->flag & ARM_RESTPOS) {
+    for (bPoseChannel *pchan = pose->chanbase.first; pchan != NULL; pchan = pchan->next) {
+      Bone *bone = pchan->bone;
+      if (bone) {
+        copy_m4_m4(pchan->pose_mat, bone->arm_mat);
+        copy_v3_v3(pchan->pose_head, bone->arm_head);
+        copy_v3_v3(pchan->pose_tail, bone->arm_tail);
+      }
+    }
+  }
+  else {
+    const float ctime = BKE_scene_frame_get(scene); /* not accurate... */
+    BKE_pose_where_is_levels(depsgraph, scene, object, ctime);
+  }
+
+  /* Deform matrices first, B-Bone segments read them from their handles. */
+  const int num_channels = BLI_listbase_count(&pose->chanbase);
+  PoseBatchedEvalData data = {
+      .depsgraph = depsgraph,
+      .object = object,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 32;
+  BLI_task_parallel_range(0, num_channels, &data, pose_eval_batched_bone_done_task, &settings);
+  BLI_task_parallel_range(
+      0, num_channels, &data, pose_eval_batched_bbone_segments_task, &settings);
+}
+
 /* Common part for both original and proxy armatrues. */
 static void pose_eval_done_common(struct Depsgraph *depsgraph, Object *object)
 {
@@ -28,10 +28,12 @@
 
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
 
 #include "BLI_utildefines.h"
 #include "BLI_linklist.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_bvhutils.h"
@@ -1579,6 +1581,293 @@ BVHTree *BKE_bvhtree_from_editmesh_get(BVHTreeFromEditMesh *data,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Persistent Object BVH
+ *
+ * The evaluated mesh of an object, and with it the #BVHCache, is created anew on every
+ * evaluation. Deforming objects keep their topology though, so their trees are kept in the
+ * evaluated object and refitted to the new coordinates instead of being built again.
+ * \{ */
+
+/* Rebuild a refitted tree once queries got this much more expensive than after building it. */
+#define BVH_PERSISTENT_REFIT_COST_MAX 1.5f
+
+typedef struct BVHPersistentItem {
+  int type;
+  int tree_type;
+  BVHTree *tree;
+  /* Result of #BLI_bvhtree_get_refit_cost() after building the tree. */
+  float cost_build;
+
+  /* Number of elements and vertices of every looptri the tree was built for. */
+  int totelem;
+  int (*tri_verts)[3];
+
+  /* Evaluated mesh the tree fits, cleared when the mesh is freed. */
+  const Mesh *mesh;
+} BVHPersistentItem;
+
+typedef struct BVHPersistentRefitData {
+  BVHTree *tree;
+  const MVert *vert;
+  const MLoop *mloop;
+  const MLoopTri *looptri;
+  const int (*tri_verts)[3];
+
+  bool topology_changed;
+} BVHPersistentRefitData;
+
+static ThreadRWMutex persistent_rwlock = BLI_RWLOCK_INITIALIZER;
+
+static BVHPersistentItem *bvhtree_persistent_find(LinkNode *items, int type, int tree_type)
+{
+  for (LinkNode *link = items; link; link = link->next) {
+    BVHPersistentItem *item = link->link;
+    if (item->type == type && item->tree_type == tree_type) {
+      return item;
+    }
+  }
+  return NULL;
+}
+
+static void bvhtree_persistent_refit_verts_cb(void *__restrict userdata,
+                                              const int i,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHPersistentRefitData *data = userdata;
+  BLI_bvhtree_update_node(data->tree, i, data->vert[i].co, NULL, 1);
+}
+
+static void bvhtree_persistent_refit_looptri_cb(void *__restrict userdata,
+                                                const int i,
+                                                const TaskParallelTLS *__restrict tls)
+{
+  BVHPersistentRefitData *data = userdata;
+  bool *topology_changed = tls->userdata_chunk;
+  float co[3][3];
+
+  for (int j = 0; j < 3; j++) {
+    const int v = (int)data->mloop[data->looptri[i].tri[j]].v;
+    if (v != data->tri_verts[i][j]) {
+      *topology_changed = true;
+      return;
+    }
+    copy_v3_v3(co[j], data->vert[v].co);
+  }
+
+  BLI_bvhtree_update_node(data->tree, i, co[0], NULL, 3);
+}
+
+static void bvhtree_persistent_refit_finalize(void *__restrict userdata,
+                                              void *__restrict userdata_chunk)
+{
+  BVHPersistentRefitData *data = userdata;
+  const bool *topology_changed = userdata_chunk;
+  data->topology_changed |= *topology_changed;
+}
+
+/* Refit the tree of the item to the coordinates of the mesh,
+ * returns false when the topology does not match the tree anymore. */
+static bool bvhtree_persistent_refit(BVHPersistentItem *item,
+                                     const Mesh *mesh,
+                                     const MLoopTri *looptri)
+{
+  BVHPersistentRefitData data = {
+      .tree = item->tree,
+      .vert = mesh->mvert,
+      .mloop = mesh->mloop,
+      .looptri = looptri,
+      .tri_verts = (const int(*)[3])item->tri_verts,
+      .topology_changed = false,
+  };
+  bool topology_changed = false;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  if (item->type == BVHTREE_FROM_VERTS) {
+    BLI_task_parallel_range(
+        0, item->totelem, &data, bvhtree_persistent_refit_verts_cb, &settings);
+  }
+  else {
+    settings.userdata_chunk = &topology_changed;
+    settings.userdata_chunk_size = sizeof(topology_changed);
+    settings.func_finalize = bvhtree_persistent_refit_finalize;
+    BLI_task_parallel_range(
+        0, item->totelem, &data, bvhtree_persistent_refit_looptri_cb, &settings);
+
+    if (data.topology_changed) {
+      return false;
+    }
+  }
+
+  BLI_bvhtree_update_tree(item->tree);
+  return true;
+}
+
+static void bvhtree_persistent_build(BVHPersistentItem *item,
+                                     const Mesh *mesh,
+                                     const MLoopTri *looptri,
+                                     const int looptri_len)
+{
+  BLI_bvhtree_free(item->tree);
+  MEM_SAFE_FREE(item->tri_verts);
+
+  if (item->type == BVHTREE_FROM_VERTS) {
+    item->totelem = mesh->totvert;
+    item->tree = bvhtree_from_mesh_verts_create_tree(
+        0.0f, item->tree_type, 6, mesh->mvert, mesh->totvert, NULL, -1);
+  }
+  else {
+    item->totelem = looptri_len;
+    item->tree = bvhtree_from_mesh_looptri_create_tree(0.0f,
+                                                       item->tree_type,
+                                                       6,
+                                                       mesh->mvert,
+                                                       mesh->mloop,
+                                                       looptri,
+                                                       looptri_len,
+                                                       NULL,
+                                                       -1);
+
+    item->tri_verts = MEM_malloc_arrayN(
+        (size_t)looptri_len, sizeof(*item->tri_verts), "BVHPersistentItem.tri_verts");
+    for (int i = 0; i < looptri_len; i++) {
+      for (int j = 0; j < 3; j++) {
+        item->tri_verts[i][j] = (int)mesh->mloop[looptri[i].tri[j]].v;
+      }
+    }
+  }
+
+  item->cost_build = item->tree ? BLI_bvhtree_get_refit_cost(item->tree) : 0.0f;
+}
+
+static void bvhtree_persistent_fit(BVHPersistentItem *item,
+                                   const Mesh *mesh,
+                                   const MLoopTri *looptri,
+                                   const int looptri_len)
+{
+  const int totelem = (item->type == BVHTREE_FROM_VERTS) ? mesh->totvert : looptri_len;
+
+  if (item->tree != NULL && item->totelem == totelem) {
+    if (bvhtree_persistent_refit(item, mesh, looptri) &&
+        BLI_bvhtree_get_refit_cost(item->tree) <=
+            item->cost_build * BVH_PERSISTENT_REFIT_COST_MAX) {
+      return;
+    }
+  }
+
+  bvhtree_persistent_build(item, mesh, looptri, looptri_len);
+}
+
+/**
+ * Same as #BKE_bvhtree_from_mesh_get(), for the evaluated mesh of an evaluated object.
+ *
+ * Vertex and looptri trees are kept in the object across evaluations and refitted while the
+ * topology does not change. Other types and meshes fall back to the #BVHCache of the mesh.
+ */
+BVHTree *BKE_bvhtree_from_object_mesh_get(struct BVHTreeFromMesh *data,
+                                          struct Object *ob_eval,
+                                          struct Mesh *mesh,
+                                          const int bvh_cache_type,
+                                          const int tree_type)
+{
+  if (!ELEM(bvh_cache_type, BVHTREE_FROM_VERTS, BVHTREE_FROM_LOOPTRI) || ob_eval == NULL ||
+      (ob_eval->id.tag & LIB_TAG_COPIED_ON_WRITE) == 0 || mesh == NULL ||
+      mesh != ob_eval->runtime.mesh_eval || !ob_eval->runtime.is_mesh_eval_owned) {
+    return BKE_bvhtree_from_mesh_get(data, mesh, bvh_cache_type, tree_type);
+  }
+
+  const MLoopTri *looptri = NULL;
+  int looptri_len = 0;
+  if (bvh_cache_type == BVHTREE_FROM_LOOPTRI) {
+    looptri = BKE_mesh_runtime_looptri_ensure(mesh);
+    looptri_len = BKE_mesh_runtime_looptri_len(mesh);
+  }
+
+  BLI_rw_mutex_lock(&persistent_rwlock, THREAD_LOCK_READ);
+  BVHPersistentItem *item = bvhtree_persistent_find(
+      ob_eval->runtime.bvh_persistent, bvh_cache_type, tree_type);
+  const bool is_fitted = (item != NULL && item->mesh == mesh);
+  BLI_rw_mutex_unlock(&persistent_rwlock);
+
+  if (!is_fitted) {
+    BLI_rw_mutex_lock(&persistent_rwlock, THREAD_LOCK_WRITE);
+    item = bvhtree_persistent_find(ob_eval->runtime.bvh_persistent, bvh_cache_type, tree_type);
+    if (item == NULL) {
+      item = MEM_callocN(sizeof(*item), "BVHPersistentItem");
+      item->type = bvh_cache_type;
+      item->tree_type = tree_type;
+      BLI_linklist_prepend(&ob_eval->runtime.bvh_persistent, item);
+    }
+    if (item->mesh != mesh) {
+      bvhtree_persistent_fit(item, mesh, looptri, looptri_len);
+      item->mesh = mesh;
+    }
+    BLI_rw_mutex_unlock(&persistent_rwlock);
+  }
+
+  if (item->tree == NULL) {
+    memset(data, 0, sizeof(*data));
+    return NULL;
+  }
+
+  /* The tree is owned by the object, so it is flagged as cached. */
+  if (bvh_cache_type == BVHTREE_FROM_VERTS) {
+    bvhtree_from_mesh_verts_setup_data(data, item->tree, true, mesh->mvert, false);
+  }
+  else {
+    bvhtree_from_mesh_looptri_setup_data(
+        data, item->tree, true, mesh->mvert, false, mesh->mloop, false, looptri, false);
+  }
+
+  return item->tree;
+}
+
+static void bvhtree_persistent_item_free(void *_item)
+{
+  BVHPersistentItem *item = _item;
+
+  BLI_bvhtree_free(item->tree);
+  MEM_SAFE_FREE(item->tri_verts);
+  MEM_freeN(item);
+}
+
+/**
+ * Called when the evaluated mesh of the object is freed,
+ * the trees get refitted to the next one.
+ *
+ * Trees which were not asked for with the freed mesh have no users left
+ * (the Shrinkwrap modifiers and constraints targeting the object were removed or retargeted),
+ * they are freed instead of being kept for the lifetime of the object.
+ */
+void BKE_bvhtree_object_persistent_invalidate(struct Object *ob)
+{
+  LinkNode **link_p = &ob->runtime.bvh_persistent;
+  while (*link_p != NULL) {
+    LinkNode *link = *link_p;
+    BVHPersistentItem *item = link->link;
+    if (item->mesh == NULL) {
+      *link_p = link->next;
+      bvhtree_persistent_item_free(item);
+      MEM_freeN(link);
+    }
+    else {
+      item->mesh = NULL;
+      link_p = &link->next;
+    }
+  }
+}
+
+void BKE_bvhtree_object_persistent_free(struct Object *ob)
+{
+  BLI_linklist_free(ob->runtime.bvh_persistent, bvhtree_persistent_item_free);
+  ob->runtime.bvh_persistent = NULL;
+}
+
+/** \} */
+
 /* Frees data allocated by a call to bvhtree_from_editmesh_*. */
 void free_bvhtree_from_editmesh(struct BVHTreeFromEditMesh *data)
 {
@@ -119,16 +119,16 @@ void BKE_constraint_unique_name(bConstraint *con, ListBase *list)
 
 /* ----------------- Evaluation Loop Preparation --------------- */
 
-/* package an object/bone for use in constraint evaluation */
-/* This function MEM_calloc's a bConstraintOb struct,
- * that will need to be freed after evaluation */
-bConstraintOb *BKE_constraints_make_evalob(
-    Depsgraph *depsgraph, Scene *scene, Object *ob, void *subdata, short datatype)
+/* package an object/bone for use in constraint evaluation, in a struct owned by the caller
+ * (usually on the stack), BKE_constraints_apply_evalob must be called after evaluation */
+void BKE_constraints_init_evalob(bConstraintOb *cob,
+                                 Depsgraph *depsgraph,
+                                 Scene *scene,
+                                 Object *ob,
+                                 void *subdata,
+                                 short datatype)
 {
-  bConstraintOb *cob;
-
-  /* create regardless of whether we have any data! */
-  cob = MEM_callocN(sizeof(bConstraintOb), "bConstraintOb");
+  memset(cob, 0, sizeof(*cob));
 
   /* for system time, part of deglobalization, code nicer later with local time (ton) */
   cob->scene = scene;
@@ -137,7 +137,7 @@ bConstraintOb *BKE_constraints_make_evalob(
   /* based on type of available data */
   switch (datatype) {
     case CONSTRAINT_OBTYPE_OBJECT: {
-      /* disregard subdata... calloc should set other values right */
+      /* disregard subdata... clearing above should set other values right */
       if (ob) {
         cob->ob = ob;
         cob->type = datatype;
@@ -195,20 +195,27 @@ bConstraintOb *BKE_constraints_make_evalob(
       unit_m4(cob->startmat);
       break;
   }
+}
+
+/* package an object/bone for use in constraint evaluation */
+/* This function MEM_calloc's a bConstraintOb struct,
+ * that will need to be freed after evaluation */
+bConstraintOb *BKE_constraints_make_evalob(
+    Depsgraph *depsgraph, Scene *scene, Object *ob, void *subdata, short datatype)
+{
+  /* create regardless of whether we have any data! */
+  bConstraintOb *cob = MEM_mallocN(sizeof(bConstraintOb), "bConstraintOb");
+
+  BKE_constraints_init_evalob(cob, depsgraph, scene, ob, subdata, datatype);
 
   return cob;
 }
 
-/* cleanup after constraint evaluation */
-void BKE_constraints_clear_evalob(bConstraintOb *cob)
+/* copy the result of constraint evaluation back to the owner */
+void BKE_constraints_apply_evalob(bConstraintOb *cob)
 {
   float delta[4][4], imat[4][4];
 
-  /* prevent crashes */
-  if (cob == NULL) {
-    return;
-  }
-
   /* calculate delta of constraints evaluation */
   invert_m4_m4(imat, cob->startmat);
   /* XXX This would seem to be in wrong order. However, it does not work in 'right' order -
@@ -242,6 +249,17 @@ void BKE_constraints_clear_evalob(bConstraintOb *cob)
       break;
     }
   }
+}
+
+/* cleanup after constraint evaluation */
+void BKE_constraints_clear_evalob(bConstraintOb *cob)
+{
+  /* prevent crashes */
+  if (cob == NULL) {
+    return;
+  }
+
+  BKE_constraints_apply_evalob(cob);
 
   /* free tempolary struct */
   MEM_freeN(cob);
@@ -738,6 +756,36 @@ static void default_get_tarmat_full_bbone(struct Depsgraph *UNUSED(depsgraph),
   }
 }
 
+/* Temporary targets are taken from the solver storage linked at the start of the list by
+ * BKE_constraints_solve(), and only allocated when there is none left (or when called outside
+ * of the solver). */
+static bConstraintTarget *constraint_target_temp_new(ListBase *list)
+{
+  bConstraintTarget *ct = list->first;
+
+  if (ct && ct->flag == CONSTRAINT_TAR_SOLVER_STORAGE) {
+    BLI_remlink(list, ct);
+    memset(ct, 0, sizeof(*ct));
+    ct->flag = CONSTRAINT_TAR_TEMP | CONSTRAINT_TAR_SOLVER_STORAGE;
+  }
+  else {
+    ct = MEM_callocN(sizeof(bConstraintTarget), "tempConstraintTarget");
+    ct->flag = CONSTRAINT_TAR_TEMP;
+  }
+
+  BLI_addtail(list, ct);
+  return ct;
+}
+
+static void constraint_target_temp_free(ListBase *list, bConstraintTarget *ct)
+{
+  BLI_remlink(list, ct);
+
+  if ((ct->flag & CONSTRAINT_TAR_SOLVER_STORAGE) == 0) {
+    MEM_freeN(ct);
+  }
+}
+
 /* This following macro should be used for all standard single-target *_get_tars functions
  * to save typing and reduce maintenance woes.
  * (Hopefully all compilers will be happy with the lines with just a space on them. Those are
@@ -746,12 +794,11 @@ static void default_get_tarmat_full_bbone(struct Depsgraph *UNUSED(depsgraph),
 // TODO: cope with getting rotation order...
 #define SINGLETARGET_GET_TARS(con, datatar, datasubtarget, ct, list) \
   { \
-    ct = MEM_callocN(sizeof(bConstraintTarget), "tempConstraintTarget"); \
+    ct = constraint_target_temp_new(list); \
 \
     ct->tar = datatar; \
     BLI_strncpy(ct->subtarget, datasubtarget, sizeof(ct->subtarget)); \
     ct->space = con->tarspace; \
-    ct->flag = CONSTRAINT_TAR_TEMP; \
 \
     if (ct->tar) { \
       if ((ct->tar->type == OB_ARMATURE) && (ct->subtarget[0])) { \
@@ -768,8 +815,6 @@ static void default_get_tarmat_full_bbone(struct Depsgraph *UNUSED(depsgraph),
         ct->rotOrder = ct->tar->rotmode; \
       } \
     } \
-\
-    BLI_addtail(list, ct); \
   } \
   (void)0
 
@@ -781,16 +826,13 @@ static void default_get_tarmat_full_bbone(struct Depsgraph *UNUSED(depsgraph),
 // TODO: cope with getting rotation order...
 #define SINGLETARGETNS_GET_TARS(con, datatar, ct, list) \
   { \
-    ct = MEM_callocN(sizeof(bConstraintTarget), "tempConstraintTarget"); \
+    ct = constraint_target_temp_new(list); \
 \
     ct->tar = datatar; \
     ct->space = con->tarspace; \
-    ct->flag = CONSTRAINT_TAR_TEMP; \
 \
     if (ct->tar) \
       ct->type = CONSTRAINT_OBTYPE_OBJECT; \
-\
-    BLI_addtail(list, ct); \
   } \
   (void)0
 
@@ -810,7 +852,7 @@ static void default_get_tarmat_full_bbone(struct Depsgraph *UNUSED(depsgraph),
         con->tarspace = (char)ct->space; \
       } \
 \
-      BLI_freelinkN(list, ct); \
+      constraint_target_temp_free(list, ct); \
       ct = ctn; \
     } \
   } \
@@ -831,7 +873,7 @@ static void default_get_tarmat_full_bbone(struct Depsgraph *UNUSED(depsgraph),
         con->tarspace = (char)ct->space; \
       } \
 \
-      BLI_freelinkN(list, ct); \
+      constraint_target_temp_free(list, ct); \
       ct = ctn; \
     } \
   } \
@@ -2621,27 +2663,41 @@ static void actcon_get_tarmat(struct Depsgraph *UNUSED(depsgraph),
       BKE_object_to_mat4(&workob, ct->matrix);
     }
     else if (cob->type == CONSTRAINT_OBTYPE_BONE) {
-      Object workob;
-      bPose pose = {{0}};
-      bPoseChannel *pchan, *tchan;
-
-      /* make a copy of the bone of interest in the temp pose before evaluating action,
-       * so that it can get set - we need to manually copy over a few settings,
-       * including rotation order, otherwise this fails. */
-      pchan = cob->pchan;
+      bPoseChannel *pchan = cob->pchan;
+      bPoseChannel tchan_eval = {NULL};
+
+      /* evaluated actions can evaluate the curves of the bone of interest directly,
+       * on a channel with the same defaults as BKE_pose_channel_verify() */
+      BLI_strncpy(tchan_eval.name, pchan->name, sizeof(tchan_eval.name));
+      tchan_eval.rotmode = pchan->rotmode;
+      unit_qt(tchan_eval.quat);
+      unit_axis_angle(tchan_eval.rotAxis, &tchan_eval.rotAngle);
+      copy_v3_fl(tchan_eval.size, 1.0f);
+
+      if (data->act == NULL || BKE_action_pose_channel_evaluate(data->act, &tchan_eval, t)) {
+        BKE_pchan_to_mat4(&tchan_eval, ct->matrix);
+      }
+      else {
+        Object workob;
+        bPose pose = {{0}};
+        bPoseChannel *tchan;
 
-      tchan = BKE_pose_channel_verify(&pose, pchan->name);
-      tchan->rotmode = pchan->rotmode;
+        /* make a copy of the bone of interest in the temp pose before evaluating action,
+         * so that it can get set - we need to manually copy over a few settings,
+         * including rotation order, otherwise this fails. */
+        tchan = BKE_pose_channel_verify(&pose, pchan->name);
+        tchan->rotmode = pchan->rotmode;
 
-      /* evaluate action using workob (it will only set the PoseChannel in question) */
-      what_does_obaction(cob->ob, &workob, &pose, data->act, pchan->name, t);
+        /* evaluate action using workob (it will only set the PoseChannel in question) */
+        what_does_obaction(cob->ob, &workob, &pose, data->act, pchan->name, t);
 
-      /* convert animation to matrices for use here */
-      BKE_pchan_calc_mat(tchan);
-      copy_m4_m4(ct->matrix, tchan->chan_mat);
+        /* convert animation to matrices for use here */
+        BKE_pchan_calc_mat(tchan);
+        copy_m4_m4(ct->matrix, tchan->chan_mat);
 
-      /* Clean up */
-      BKE_pose_free_data(&pose);
+        /* Clean up */
+        BKE_pose_free_data(&pose);
+      }
     }
     else {
       /* behavior undefined... */
@@ -3896,7 +3952,7 @@ static void shrinkwrap_get_tarmat(struct Depsgraph *UNUSED(depsgraph),
     ShrinkwrapTreeData tree;
 
     if (BKE_shrinkwrap_init_tree(
-            &tree, target_eval, scon->shrinkType, scon->shrinkMode, do_track_normal)) {
+            &tree, ct->tar, target_eval, scon->shrinkType, scon->shrinkMode, do_track_normal)) {
       BLI_space_transform_from_matrices(&transform, cob->matrix, ct->tar->obmat);
 
       switch (scon->shrinkType) {
@@ -5533,6 +5589,108 @@ bool BKE_constraints_proxylocked_owner(Object *ob, bPoseChannel *pchan)
   return false;
 }
 
+/* -------- Solver Target Storage ------- */
+
+/* Number of temporary targets the solver keeps on the stack, enough for all built-in
+ * single-target constraints, the rest fall back to allocation. */
+#define CONSTRAINT_SOLVER_TARGETS 4
+/* Number of target matrices remembered while solving the constraints of one owner. */
+#define CONSTRAINT_SOLVER_CACHED_MATRICES 4
+
+/* Target matrix only depending on the target and space, as computed by
+ * default_get_tarmat() and default_get_tarmat_full_bbone(). */
+typedef struct ConstraintTargetMatrixCache {
+  void (*get_target_matrix)(struct Depsgraph *depsgraph,
+                            struct bConstraint *con,
+                            struct bConstraintOb *cob,
+                            struct bConstraintTarget *ct,
+                            float ctime);
+  struct Object *tar;
+  char subtarget[64];
+  short space;
+  short flag;
+  float headtail;
+  float matrix[4][4];
+} ConstraintTargetMatrixCache;
+
+typedef struct ConstraintSolverStorage {
+  bConstraintTarget targets[CONSTRAINT_SOLVER_TARGETS];
+
+  ConstraintTargetMatrixCache matrices[CONSTRAINT_SOLVER_CACHED_MATRICES];
+  int matrices_len;
+  int matrices_next;
+} ConstraintSolverStorage;
+
+/* Link the unused storage targets into the list, so that get_tars callbacks can use them. */
+static void constraint_solver_storage_link(ConstraintSolverStorage *storage, ListBase *targets)
+{
+  BLI_listbase_clear(targets);
+
+  for (int i = 0; i < CONSTRAINT_SOLVER_TARGETS; i++) {
+    bConstraintTarget *ct = &storage->targets[i];
+    ct->flag = CONSTRAINT_TAR_SOLVER_STORAGE;
+    BLI_addtail(targets, ct);
+  }
+}
+
+/* Remove the storage targets which were not used by the get_tars callback. */
+static void constraint_solver_storage_unlink(ListBase *targets)
+{
+  bConstraintTarget *ct, *ct_next;
+
+  for (ct = targets->first; ct; ct = ct_next) {
+    ct_next = ct->next;
+    if (ct->flag == CONSTRAINT_TAR_SOLVER_STORAGE) {
+      BLI_remlink(targets, ct);
+    }
+  }
+}
+
+static void constraint_target_matrix_get_cached(ConstraintSolverStorage *storage,
+                                                struct Depsgraph *depsgraph,
+                                                const bConstraintTypeInfo *cti,
+                                                bConstraint *con,
+                                                bConstraintOb *cob,
+                                                bConstraintTarget *ct,
+                                                float ctime)
+{
+  /* Other callbacks depend on constraint settings, or on the owner. */
+  if (storage == NULL || !VALID_CONS_TARGET(ct) ||
+      !ELEM(cti->get_target_matrix, default_get_tarmat, default_get_tarmat_full_bbone)) {
+    cti->get_target_matrix(depsgraph, con, cob, ct, ctime);
+    return;
+  }
+
+  const short flag = con->flag & (CONSTRAINT_BBONE_SHAPE | CONSTRAINT_BBONE_SHAPE_FULL);
+  ConstraintTargetMatrixCache *cache;
+
+  for (int i = 0; i < storage->matrices_len; i++) {
+    cache = &storage->matrices[i];
+
+    if (cache->get_target_matrix == cti->get_target_matrix && cache->tar == ct->tar &&
+        cache->space == ct->space && cache->flag == flag && cache->headtail == con->headtail &&
+        STREQ(cache->subtarget, ct->subtarget)) {
+      copy_m4_m4(ct->matrix, cache->matrix);
+      return;
+    }
+  }
+
+  cti->get_target_matrix(depsgraph, con, cob, ct, ctime);
+
+  /* Store a copy, evaluate callbacks are free to modify ct->matrix. */
+  cache = &storage->matrices[storage->matrices_next];
+  cache->get_target_matrix = cti->get_target_matrix;
+  cache->tar = ct->tar;
+  STRNCPY(cache->subtarget, ct->subtarget);
+  cache->space = ct->space;
+  cache->flag = flag;
+  cache->headtail = con->headtail;
+  copy_m4_m4(cache->matrix, ct->matrix);
+
+  storage->matrices_len = max_ii(storage->matrices_len, storage->matrices_next + 1);
+  storage->matrices_next = (storage->matrices_next + 1) % CONSTRAINT_SOLVER_CACHED_MATRICES;
+}
+
 /* -------- Target-Matrix Stuff ------- */
 
 /* This function is a relic from the prior implementations of the constraints system, when all
@@ -5553,64 +5711,66 @@ void BKE_constraint_target_matrix_get(struct Depsgraph *depsgraph,
 {
   const bConstraintTypeInfo *cti = BKE_constraint_typeinfo_get(con);
   ListBase targets = {NULL, NULL};
-  bConstraintOb *cob;
+  bConstraintOb cob = {NULL};
   bConstraintTarget *ct;
 
   if (cti && cti->get_constraint_targets) {
+    ConstraintSolverStorage storage;
+
     /* make 'constraint-ob' */
-    cob = MEM_callocN(sizeof(bConstraintOb), "tempConstraintOb");
-    cob->type = ownertype;
-    cob->scene = scene;
-    cob->depsgraph = depsgraph;
+    cob.type = ownertype;
+    cob.scene = scene;
+    cob.depsgraph = depsgraph;
     switch (ownertype) {
       case CONSTRAINT_OBTYPE_OBJECT: /* it is usually this case */
       {
-        cob->ob = (Object *)ownerdata;
-        cob->pchan = NULL;
-        if (cob->ob) {
-          copy_m4_m4(cob->matrix, cob->ob->obmat);
-          copy_m4_m4(cob->startmat, cob->matrix);
+        cob.ob = (Object *)ownerdata;
+        cob.pchan = NULL;
+        if (cob.ob) {
+          copy_m4_m4(cob.matrix, cob.ob->obmat);
+          copy_m4_m4(cob.startmat, cob.matrix);
         }
         else {
-          unit_m4(cob->matrix);
-          unit_m4(cob->startmat);
+          unit_m4(cob.matrix);
+          unit_m4(cob.startmat);
         }
         break;
       }
       case CONSTRAINT_OBTYPE_BONE: /* this may occur in some cases */
       {
-        cob->ob = NULL; /* this might not work at all :/ */
-        cob->pchan = (bPoseChannel *)ownerdata;
-        if (cob->pchan) {
-          copy_m4_m4(cob->matrix, cob->pchan->pose_mat);
-          copy_m4_m4(cob->startmat, cob->matrix);
+        cob.ob = NULL; /* this might not work at all :/ */
+        cob.pchan = (bPoseChannel *)ownerdata;
+        if (cob.pchan) {
+          copy_m4_m4(cob.matrix, cob.pchan->pose_mat);
+          copy_m4_m4(cob.startmat, cob.matrix);
         }
         else {
-          unit_m4(cob->matrix);
-          unit_m4(cob->startmat);
+          unit_m4(cob.matrix);
+          unit_m4(cob.startmat);
         }
         break;
       }
     }
 
     /* get targets - we only need the first one though (and there should only be one) */
+    constraint_solver_storage_link(&storage, &targets);
     cti->get_constraint_targets(con, &targets);
+    constraint_solver_storage_unlink(&targets);
 
     /* only calculate the target matrix on the first target */
     ct = BLI_findlink(&targets, index);
 
     if (ct) {
       if (cti->get_target_matrix) {
-        cti->get_target_matrix(depsgraph, con, cob, ct, ctime);
+        cti->get_target_matrix(depsgraph, con, &cob, ct, ctime);
       }
       copy_m4_m4(mat, ct->matrix);
     }
 
-    /* free targets + 'constraint-ob' */
+    /* free targets */
     if (cti->flush_constraint_targets) {
       cti->flush_constraint_targets(con, &targets, 1);
     }
-    MEM_freeN(cob);
   }
   else {
     /* invalid constraint - perhaps... */
@@ -5618,12 +5778,12 @@ void BKE_constraint_target_matrix_get(struct Depsgraph *depsgraph,
   }
 }
 
-/* Get the list of targets required for solving a constraint */
-void BKE_constraint_targets_for_solving_get(struct Depsgraph *depsgraph,
-                                            bConstraint *con,
-                                            bConstraintOb *cob,
-                                            ListBase *targets,
-                                            float ctime)
+static void constraint_targets_for_solving_get(ConstraintSolverStorage *storage,
+                                               struct Depsgraph *depsgraph,
+                                               bConstraint *con,
+                                               bConstraintOb *cob,
+                                               ListBase *targets,
+                                               float ctime)
 {
   const bConstraintTypeInfo *cti = BKE_constraint_typeinfo_get(con);
 
@@ -5634,7 +5794,14 @@ void BKE_constraint_targets_for_solving_get(struct Depsgraph *depsgraph,
      * - constraints should use ct->matrix, not directly accessing values
      * - ct->matrix members have not yet been calculated here!
      */
-    cti->get_constraint_targets(con, targets);
+    if (storage) {
+      constraint_solver_storage_link(storage, targets);
+      cti->get_constraint_targets(con, targets);
+      constraint_solver_storage_unlink(targets);
+    }
+    else {
+      cti->get_constraint_targets(con, targets);
+    }
 
     /* The Armature constraint doesn't need ct->matrix for evaluate at all. */
     if (ELEM(cti->type, CONSTRAINT_TYPE_ARMATURE)) {
@@ -5646,7 +5813,7 @@ void BKE_constraint_targets_for_solving_get(struct Depsgraph *depsgraph,
      */
     if (cti->get_target_matrix) {
       for (ct = targets->first; ct; ct = ct->next) {
-        cti->get_target_matrix(depsgraph, con, cob, ct, ctime);
+        constraint_target_matrix_get_cached(storage, depsgraph, cti, con, cob, ct, ctime);
       }
     }
     else {
@@ -5657,19 +5824,34 @@ void BKE_constraint_targets_for_solving_get(struct Depsgraph *depsgraph,
   }
 }
 
+/* Get the list of targets required for solving a constraint */
+void BKE_constraint_targets_for_solving_get(struct Depsgraph *depsgraph,
+                                            bConstraint *con,
+                                            bConstraintOb *cob,
+                                            ListBase *targets,
+                                            float ctime)
+{
+  constraint_targets_for_solving_get(NULL, depsgraph, con, cob, targets, ctime);
+}
+
 /* ---------- Evaluation ----------- */
 
 /* This function is called whenever constraints need to be evaluated. Currently, all
  * constraints that can be evaluated are every time this gets run.
  *
- * BKE_constraints_make_evalob and BKE_constraints_clear_evalob should be called before and
- * after running this function, to sort out cob
+ * BKE_constraints_init_evalob and BKE_constraints_apply_evalob (or BKE_constraints_make_evalob
+ * and BKE_constraints_clear_evalob) should be called before and after running this function,
+ * to sort out cob.
+ *
+ * Temporary targets use storage on the stack of this function, and target matrices are shared
+ * between constraints of the owner using the same target, so that solving does not allocate.
  */
 void BKE_constraints_solve(struct Depsgraph *depsgraph,
                            ListBase *conlist,
                            bConstraintOb *cob,
                            float ctime)
 {
+  ConstraintSolverStorage storage;
   bConstraint *con;
   float oldmat[4][4];
   float enf;
@@ -5679,6 +5861,9 @@ void BKE_constraints_solve(struct Depsgraph *depsgraph,
     return;
   }
 
+  storage.matrices_len = 0;
+  storage.matrices_next = 0;
+
   /* loop over available constraints, solving and blending them */
   for (con = conlist->first; con; con = con->next) {
     const bConstraintTypeInfo *cti = BKE_constraint_typeinfo_get(con);
@@ -5713,7 +5898,7 @@ void BKE_constraints_solve(struct Depsgraph *depsgraph,
         cob->ob, cob->pchan, cob->matrix, CONSTRAINT_SPACE_WORLD, con->ownspace, false);
 
     /* prepare targets for constraint solving */
-    BKE_constraint_targets_for_solving_get(depsgraph, con, cob, &targets, ctime);
+    constraint_targets_for_solving_get(&storage, depsgraph, con, cob, &targets, ctime);
 
     /* Solve the constraint and put result in cob->matrix */
     cti->evaluate_constraint(con, cob, &targets);
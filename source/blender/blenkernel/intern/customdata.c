@@ -57,6 +57,8 @@
 /* only for customdata_data_transfer_interp_normal_normals */
 #include "data_transfer_intern.h"
 
+#include "atomic_ops.h"
+
 /* number of layers to add when growing a CustomData object */
 #define CUSTOMDATA_GROW 5
 
@@ -1848,6 +1850,132 @@ static bool customdata_typemap_is_valid(const CustomData *data)
 }
 #endif
 
+/* -------------------------------------------------------------------- */
+/** \name Shared Layer Data
+ *
+ * Layers copied with #CD_SHARE point to the same data as their source,
+ * the data is owned by all of them and freed along with its last user.
+ * \{ */
+
+static void customData_free_layer__internal(CustomDataLayer *layer, int totelem);
+
+typedef struct CustomDataLayerSharing {
+  int users;
+  /** Number of elements in the shared data, needed to duplicate it. */
+  int totelem;
+} CustomDataLayerSharing;
+
+/**
+ * Add a user to the data of \a layer, returns the sharing info for the new user.
+ *
+ * \note The layer is the source of a copy, its sharing info is created on first use and
+ * published atomically since the same original data may be copied from several threads.
+ */
+static CustomDataLayerSharing *customData_layer_sharing_add_user(CustomDataLayer *layer,
+                                                                 int totelem)
+{
+  CustomDataLayerSharing *sharing = layer->sharing;
+
+  if (sharing == NULL) {
+    sharing = MEM_mallocN(sizeof(*sharing), __func__);
+    sharing->users = 1;
+    sharing->totelem = totelem;
+    CustomDataLayerSharing *sharing_prev = atomic_cas_ptr((void **)&layer->sharing, NULL, sharing);
+    if (sharing_prev != NULL) {
+      MEM_freeN(sharing);
+      sharing = sharing_prev;
+    }
+  }
+
+  BLI_assert(sharing->totelem == totelem);
+  atomic_add_and_fetch_int32(&sharing->users, 1);
+  return sharing;
+}
+
+/**
+ * Remove \a layer from the users of its data.
+ * \return true when it was the last user, the caller is then responsible for freeing the data.
+ */
+static bool customData_layer_sharing_remove_user(CustomDataLayer *layer)
+{
+  CustomDataLayerSharing *sharing = layer->sharing;
+
+  layer->sharing = NULL;
+  if (atomic_sub_and_fetch_int32(&sharing->users, 1) != 0) {
+    return false;
+  }
+
+  MEM_freeN(sharing);
+  return true;
+}
+
+static bool customData_layer_is_shared(const CustomDataLayer *layer)
+{
+  return (layer->sharing != NULL) && (layer->sharing->users > 1);
+}
+
+static void *customData_layer_data_duplicate(const CustomDataLayer *layer, const int totelem)
+{
+  /* MEM_dupallocN won't work in case of complex layers, like e.g.
+   * CD_MDEFORMVERT, which has pointers to allocated data...
+   * So in case a custom copy function is defined, use it!
+   */
+  const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
+
+  if (typeInfo->copy) {
+    void *dst_data = MEM_malloc_arrayN((size_t)totelem, typeInfo->size, "CD duplicate ref layer");
+    typeInfo->copy(layer->data, dst_data, totelem);
+    return dst_data;
+  }
+
+  return MEM_dupallocN(layer->data);
+}
+
+/**
+ * Give the layer its own copy of the data if other layers use it, before modifying it.
+ */
+static void customData_layer_ensure_unshared(CustomDataLayer *layer)
+{
+  if (layer->sharing == NULL) {
+    return;
+  }
+
+  if (customData_layer_is_shared(layer)) {
+    const int totelem = layer->sharing->totelem;
+    void *data = customData_layer_data_duplicate(layer, totelem);
+    if (customData_layer_sharing_remove_user(layer)) {
+      /* Other users went away meanwhile. */
+      CustomDataLayer layer_old = *layer;
+      customData_free_layer__internal(&layer_old, totelem);
+    }
+    layer->data = data;
+  }
+  else {
+    MEM_freeN(layer->sharing);
+    layer->sharing = NULL;
+  }
+}
+
+/**
+ * Give the layers in \a mask their own copy of data they share with other layers, to be called
+ * before writing to the layers in place. Unlike #CustomData_duplicate_referenced_layer,
+ * layers referencing data they don't own (#CD_FLAG_NOFREE) are kept as they are.
+ *
+ * \note Layer data pointers may change, pointers to them have to be updated (like
+ * #BKE_mesh_update_customdata_pointers).
+ */
+void CustomData_unshare_layers(CustomData *data, CustomDataMask mask)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    CustomDataLayer *layer = &data->layers[i];
+    if (mask & CD_TYPE_AS_MASK(layer->type)) {
+      customData_layer_ensure_unshared(layer);
+    }
+  }
+}
+
+/** \} */
+
 bool CustomData_merge(const struct CustomData *source,
                       struct CustomData *dest,
                       CustomDataMask mask,
@@ -1899,6 +2027,7 @@ bool CustomData_merge(const struct CustomData *source,
       case CD_ASSIGN:
       case CD_REFERENCE:
       case CD_DUPLICATE:
+      case CD_SHARE:
         data = layer->data;
         break;
       default:
@@ -1906,15 +2035,34 @@ bool CustomData_merge(const struct CustomData *source,
         break;
     }
 
+    eCDAllocType layer_alloctype = alloctype;
     if ((alloctype == CD_ASSIGN) && (flag & CD_FLAG_NOFREE)) {
-      newlayer = customData_add_layer__internal(
-          dest, type, CD_REFERENCE, data, totelem, layer->name);
+      layer_alloctype = CD_REFERENCE;
     }
-    else {
-      newlayer = customData_add_layer__internal(dest, type, alloctype, data, totelem, layer->name);
+    else if ((alloctype == CD_SHARE) && ((flag & CD_FLAG_NOFREE) || (data == NULL))) {
+      /* The source does not own referenced data, it can't give it more users. */
+      layer_alloctype = CD_DUPLICATE;
+    }
+    else if ((alloctype == CD_REFERENCE) && customData_layer_is_shared(layer)) {
+      /* Other users may write to their copy of shared data, the reference would see it.
+       * Becoming one of the users gets its own copy on write instead. */
+      layer_alloctype = CD_SHARE;
     }
+    newlayer = customData_add_layer__internal(
+        dest, type, layer_alloctype, data, totelem, layer->name);
 
     if (newlayer) {
+      if (data && (newlayer->data == data)) {
+        if (layer_alloctype == CD_ASSIGN) {
+          /* Ownership of the data moves to the new layer, users included. */
+          newlayer->sharing = layer->sharing;
+        }
+        else if (layer_alloctype == CD_SHARE) {
+          newlayer->sharing = customData_layer_sharing_add_user((CustomDataLayer *)layer,
+                                                                totelem);
+        }
+      }
+
       newlayer->uid = layer->uid;
 
       newlayer->active = lastactive;
@@ -1940,6 +2088,7 @@ void CustomData_realloc(CustomData *data, int totelem)
     if (layer->flag & CD_FLAG_NOFREE) {
       continue;
     }
+    customData_layer_ensure_unshared(layer);
     typeInfo = layerType_getInfo(layer->type);
     layer->data = MEM_reallocN(layer->data, (size_t)totelem * typeInfo->size);
   }
@@ -1964,6 +2113,11 @@ static void customData_free_layer__internal(CustomDataLayer *layer, int totelem)
 {
   const LayerTypeInfo *typeInfo;
 
+  if (layer->sharing && !customData_layer_sharing_remove_user(layer)) {
+    /* Other layers still use the data. */
+    return;
+  }
+
   if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
     typeInfo = layerType_getInfo(layer->type);
 
@@ -2303,14 +2457,13 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
 
   /* Passing a layer-data to copy from with an alloctype that won't copy is
    * most likely a bug */
-  BLI_assert(!layerdata || (alloctype == CD_ASSIGN) || (alloctype == CD_DUPLICATE) ||
-             (alloctype == CD_REFERENCE));
+  BLI_assert(!layerdata || ELEM(alloctype, CD_ASSIGN, CD_DUPLICATE, CD_REFERENCE, CD_SHARE));
 
   if (!typeInfo->defaultname && CustomData_has_layer(data, type)) {
     return &data->layers[CustomData_get_layer_index(data, type)];
   }
 
-  if ((alloctype == CD_ASSIGN) || (alloctype == CD_REFERENCE)) {
+  if (ELEM(alloctype, CD_ASSIGN, CD_REFERENCE, CD_SHARE)) {
     newlayerdata = layerdata;
   }
   else if (totelem > 0 && typeInfo->size > 0) {
@@ -2362,6 +2515,7 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
   data->layers[index].type = type;
   data->layers[index].flag = flag;
   data->layers[index].data = newlayerdata;
+  data->layers[index].sharing = NULL;
 
   /* Set default name if none exists. Note we only call DATA_()  once
    * we know there is a default name, to avoid overhead of locale lookups
@@ -2548,24 +2702,12 @@ static void *customData_duplicate_referenced_layer_index(CustomData *data,
   layer = &data->layers[layer_index];
 
   if (layer->flag & CD_FLAG_NOFREE) {
-    /* MEM_dupallocN won't work in case of complex layers, like e.g.
-     * CD_MDEFORMVERT, which has pointers to allocated data...
-     * So in case a custom copy function is defined, use it!
-     */
-    const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
-
-    if (typeInfo->copy) {
-      void *dst_data = MEM_malloc_arrayN(
-          (size_t)totelem, typeInfo->size, "CD duplicate ref layer");
-      typeInfo->copy(layer->data, dst_data, totelem);
-      layer->data = dst_data;
-    }
-    else {
-      layer->data = MEM_dupallocN(layer->data);
-    }
-
+    layer->data = customData_layer_data_duplicate(layer, totelem);
     layer->flag &= ~CD_FLAG_NOFREE;
   }
+  else {
+    customData_layer_ensure_unshared(layer);
+  }
 
   return layer->data;
 }
@@ -2619,7 +2761,7 @@ bool CustomData_is_referenced_layer(struct CustomData *data, int type)
 
   layer = &data->layers[layer_index];
 
-  return (layer->flag & CD_FLAG_NOFREE) != 0;
+  return (layer->flag & CD_FLAG_NOFREE) || customData_layer_is_shared(layer);
 }
 
 void CustomData_free_temporary(CustomData *data, int totelem)
@@ -2807,6 +2949,8 @@ void CustomData_free_elem(CustomData *data, int index, int count)
       if (typeInfo->free) {
         size_t offset = (size_t)index * typeInfo->size;
 
+        customData_layer_ensure_unshared(&data->layers[i]);
+
         typeInfo->free(POINTER_OFFSET(data->layers[i].data, offset), count, typeInfo->size);
       }
     }
@@ -3653,7 +3797,7 @@ bool CustomData_has_referenced(const struct CustomData *data)
 {
   int i;
   for (i = 0; i < data->totlayer; ++i) {
-    if (data->layers[i].flag & CD_FLAG_NOFREE) {
+    if ((data->layers[i].flag & CD_FLAG_NOFREE) || customData_layer_is_shared(&data->layers[i])) {
       return true;
     }
   }
@@ -947,9 +947,19 @@ void fcurve_store_samples(FCurve *fcu, void *data, int start, int end, FcuSample
   fpt = new_fpt = MEM_callocN(sizeof(FPoint) * (end - start + 1), "FPoint Samples");
 
   /* use the sampling callback at 1-frame intervals from start to end frames */
-  for (cfra = start; cfra <= end; cfra++, fpt++) {
-    fpt->vec[0] = (float)cfra;
-    fpt->vec[1] = sample_cb(fcu, data, (float)cfra);
+  if (sample_cb == fcurve_samplingcb_evalcurve) {
+    /* Plain curve sampling, evaluate sequentially to skip searching the keyframes. */
+    int segment_hint = 0;
+    for (cfra = start; cfra <= end; cfra++, fpt++) {
+      fpt->vec[0] = (float)cfra;
+      fpt->vec[1] = evaluate_fcurve_sequential(fcu, (float)cfra, &segment_hint);
+    }
+  }
+  else {
+    for (cfra = start; cfra <= end; cfra++, fpt++) {
+      fpt->vec[0] = (float)cfra;
+      fpt->vec[1] = sample_cb(fcu, data, (float)cfra);
+    }
   }
 
   /* free any existing sample/keyframe data on curve  */
@@ -1249,6 +1259,74 @@ static ID *dtar_id_ensure_proxy_from(ID *id)
   return id;
 }
 
+/**
+ * Read the value of a driver target from its already resolved RNA property.
+ */
+static float dtar_get_resolved_prop_val(ChannelDriver *driver,
+                                        DriverTarget *dtar,
+                                        PointerRNA *ptr,
+                                        PropertyRNA *prop,
+                                        int index)
+{
+  float value = 0.0f;
+
+  if (RNA_property_array_check(prop)) {
+    /* array */
+    if ((index >= 0) && (index < RNA_property_array_length(ptr, prop))) {
+      switch (RNA_property_type(prop)) {
+        case PROP_BOOLEAN:
+          value = (float)RNA_property_boolean_get_index(ptr, prop, index);
+          break;
+        case PROP_INT:
+          value = (float)RNA_property_int_get_index(ptr, prop, index);
+          break;
+        case PROP_FLOAT:
+          value = RNA_property_float_get_index(ptr, prop, index);
+          break;
+        default:
+          break;
+      }
+    }
+    else {
+      /* out of bounds */
+      if (G.debug & G_DEBUG) {
+        CLOG_ERROR(&LOG,
+                   "Driver Evaluation Error: array index is out of bounds for %s -> %s (%d)",
+                   ptr->owner_id->name,
+                   dtar->rna_path,
+                   index);
+      }
+
+      driver->flag |= DRIVER_FLAG_INVALID;
+      dtar->flag |= DTAR_FLAG_INVALID;
+      return 0.0f;
+    }
+  }
+  else {
+    /* not an array */
+    switch (RNA_property_type(prop)) {
+      case PROP_BOOLEAN:
+        value = (float)RNA_property_boolean_get(ptr, prop);
+        break;
+      case PROP_INT:
+        value = (float)RNA_property_int_get(ptr, prop);
+        break;
+      case PROP_FLOAT:
+        value = RNA_property_float_get(ptr, prop);
+        break;
+      case PROP_ENUM:
+        value = (float)RNA_property_enum_get(ptr, prop);
+        break;
+      default:
+        break;
+    }
+  }
+
+  /* if we're still here, we should be ok... */
+  dtar->flag &= ~DTAR_FLAG_INVALID;
+  return value;
+}
+
 /**
  * Helper function to obtain a value using RNA from the specified source
  * (for evaluating drivers).
@@ -1259,7 +1337,6 @@ static float dtar_get_prop_val(ChannelDriver *driver, DriverTarget *dtar)
   PropertyRNA *prop;
   ID *id;
   int index = -1;
-  float value = 0.0f;
 
   /* sanity check */
   if (ELEM(NULL, driver, dtar)) {
@@ -1283,60 +1360,7 @@ static float dtar_get_prop_val(ChannelDriver *driver, DriverTarget *dtar)
   RNA_id_pointer_create(id, &id_ptr);
 
   /* get property to read from, and get value as appropriate */
-  if (RNA_path_resolve_property_full(&id_ptr, dtar->rna_path, &ptr, &prop, &index)) {
-    if (RNA_property_array_check(prop)) {
-      /* array */
-      if ((index >= 0) && (index < RNA_property_array_length(&ptr, prop))) {
-        switch (RNA_property_type(prop)) {
-          case PROP_BOOLEAN:
-            value = (float)RNA_property_boolean_get_index(&ptr, prop, index);
-            break;
-          case PROP_INT:
-            value = (float)RNA_property_int_get_index(&ptr, prop, index);
-            break;
-          case PROP_FLOAT:
-            value = RNA_property_float_get_index(&ptr, prop, index);
-            break;
-          default:
-            break;
-        }
-      }
-      else {
-        /* out of bounds */
-        if (G.debug & G_DEBUG) {
-          CLOG_ERROR(&LOG,
-                     "Driver Evaluation Error: array index is out of bounds for %s -> %s (%d)",
-                     id->name,
-                     dtar->rna_path,
-                     index);
-        }
-
-        driver->flag |= DRIVER_FLAG_INVALID;
-        dtar->flag |= DTAR_FLAG_INVALID;
-        return 0.0f;
-      }
-    }
-    else {
-      /* not an array */
-      switch (RNA_property_type(prop)) {
-        case PROP_BOOLEAN:
-          value = (float)RNA_property_boolean_get(&ptr, prop);
-          break;
-        case PROP_INT:
-          value = (float)RNA_property_int_get(&ptr, prop);
-          break;
-        case PROP_FLOAT:
-          value = RNA_property_float_get(&ptr, prop);
-          break;
-        case PROP_ENUM:
-          value = (float)RNA_property_enum_get(&ptr, prop);
-          break;
-        default:
-          break;
-      }
-    }
-  }
-  else {
+  if (!RNA_path_resolve_property_full(&id_ptr, dtar->rna_path, &ptr, &prop, &index)) {
     /* path couldn't be resolved */
     if (G.debug & G_DEBUG) {
       CLOG_ERROR(&LOG,
@@ -1350,9 +1374,7 @@ static float dtar_get_prop_val(ChannelDriver *driver, DriverTarget *dtar)
     return 0.0f;
   }
 
-  /* if we're still here, we should be ok... */
-  dtar->flag &= ~DTAR_FLAG_INVALID;
-  return value;
+  return dtar_get_resolved_prop_val(driver, dtar, &ptr, prop, index);
 }
 
 /**
@@ -2079,8 +2101,13 @@ static ExprPyLike_Parsed *driver_compile_simple_expr_impl(ChannelDriver *driver)
   return BLI_expr_pylike_parse(driver->expression, names, names_len + 1);
 }
 
+static float driver_get_variable_value_ex(ChannelDriver *driver,
+                                          DriverVar *dvar,
+                                          PathResolvedRNA *var_target);
+
 static bool driver_evaluate_simple_expr(ChannelDriver *driver,
                                         ExprPyLike_Parsed *expr,
+                                        PathResolvedRNA *var_targets,
                                         float *result,
                                         float time)
 {
@@ -2091,8 +2118,9 @@ static bool driver_evaluate_simple_expr(ChannelDriver *driver,
 
   vars[i++] = time;
 
-  for (DriverVar *dvar = driver->variables.first; dvar; dvar = dvar->next) {
-    vars[i++] = driver_get_variable_value(driver, dvar);
+  for (DriverVar *dvar = driver->variables.first; dvar; dvar = dvar->next, i++) {
+    vars[i] = driver_get_variable_value_ex(
+        driver, dvar, var_targets ? &var_targets[i - 1] : NULL);
   }
 
   /* Evaluate expression. */
@@ -2122,6 +2150,21 @@ static bool driver_evaluate_simple_expr(ChannelDriver *driver,
   }
 }
 
+/* Explain why the expression can't use the simple expression evaluator, for debugging rigs
+ * where Python drivers are a bottleneck. */
+static const char *driver_simple_expr_fallback_reason(ChannelDriver *driver)
+{
+  for (DriverVar *dvar = driver->variables.first; dvar; dvar = dvar->next) {
+    if (dvar->flag & DVAR_ALL_INVALID_FLAGS) {
+      return "a variable has an invalid name";
+    }
+  }
+  if ((driver->flag & DRIVER_FLAG_USE_SELF) && strstr(driver->expression, "self")) {
+    return "it uses 'self'";
+  }
+  return "it uses names, functions or syntax outside of the simple expression subset";
+}
+
 /* Compile and cache the driver expression if necessary, with thread safety. */
 static bool driver_compile_simple_expr(ChannelDriver *driver)
 {
@@ -2137,6 +2180,14 @@ static bool driver_compile_simple_expr(ChannelDriver *driver)
    * waste some effort, but in return avoids mutex contention. */
   ExprPyLike_Parsed *expr = driver_compile_simple_expr_impl(driver);
 
+  if (!BLI_expr_pylike_is_valid(expr) && driver->expression[0] != '\0') {
+    CLOG_INFO(&LOG,
+              1,
+              "driver expression '%s' is evaluated with Python: %s",
+              driver->expression,
+              driver_simple_expr_fallback_reason(driver));
+  }
+
   /* Store the result if the field is still NULL, or discard
    * it if another thread got here first. */
   if (atomic_cas_ptr((void **)&driver->expr_simple, NULL, expr) != NULL) {
@@ -2150,6 +2201,7 @@ static bool driver_compile_simple_expr(ChannelDriver *driver)
  * On success, stores the result and returns true; on failure result is set to 0. */
 static bool driver_try_evaluate_simple_expr(ChannelDriver *driver,
                                             ChannelDriver *driver_orig,
+                                            PathResolvedRNA *var_targets,
                                             float *result,
                                             float time)
 {
@@ -2157,7 +2209,8 @@ static bool driver_try_evaluate_simple_expr(ChannelDriver *driver,
 
   return driver_compile_simple_expr(driver_orig) &&
          BLI_expr_pylike_is_valid(driver_orig->expr_simple) &&
-         driver_evaluate_simple_expr(driver, driver_orig->expr_simple, result, time);
+         driver_evaluate_simple_expr(
+             driver, driver_orig->expr_simple, var_targets, result, time);
 }
 
 /* Check if the expression in the driver conforms to the simple subset. */
@@ -2215,6 +2268,63 @@ float driver_get_variable_value(ChannelDriver *driver, DriverVar *dvar)
   return dvar->curval;
 }
 
+/* Same as driver_get_variable_value(), reading the target of 'single property' variables
+ * directly when it has been resolved already. */
+static float driver_get_variable_value_ex(ChannelDriver *driver,
+                                          DriverVar *dvar,
+                                          PathResolvedRNA *var_target)
+{
+  if (var_target && var_target->prop && dvar->type == DVAR_TYPE_SINGLE_PROP) {
+    dvar->curval = dtar_get_resolved_prop_val(
+        driver, &dvar->targets[0], &var_target->ptr, var_target->prop, var_target->prop_index);
+    return dvar->curval;
+  }
+  return driver_get_variable_value(driver, dvar);
+}
+
+/**
+ * Resolve the RNA paths of the 'single property' variables of a driver ahead of evaluation,
+ * for evaluate_driver_ex(). Other variable types, paths which can't be resolved and paths going
+ * through ID pointers into another data-block are left empty, those are evaluated as usual
+ * (reporting errors).
+ *
+ * \param r_var_targets: One item per variable of the driver.
+ * \return The number of resolved variables.
+ */
+int BKE_driver_resolve_variable_targets(ChannelDriver *driver, PathResolvedRNA *r_var_targets)
+{
+  int i = 0;
+  int totresolved = 0;
+
+  for (DriverVar *dvar = driver->variables.first; dvar; dvar = dvar->next, i++) {
+    PathResolvedRNA *var_target = &r_var_targets[i];
+    DriverTarget *dtar = &dvar->targets[0];
+    ID *id = dtar_id_ensure_proxy_from(dtar->id);
+    PointerRNA id_ptr;
+
+    memset(var_target, 0, sizeof(*var_target));
+
+    if (dvar->type != DVAR_TYPE_SINGLE_PROP || id == NULL || dtar->rna_path == NULL) {
+      continue;
+    }
+
+    RNA_id_pointer_create(id, &id_ptr);
+    if (RNA_path_resolve_property_full(&id_ptr,
+                                       dtar->rna_path,
+                                       &var_target->ptr,
+                                       &var_target->prop,
+                                       &var_target->prop_index) &&
+        var_target->ptr.owner_id == id) {
+      totresolved++;
+    }
+    else {
+      var_target->prop = NULL;
+    }
+  }
+
+  return totresolved;
+}
+
 /* Evaluate an Channel-Driver to get a 'time' value to use instead of "evaltime"
  * - "evaltime" is the frame at which F-Curve is being evaluated
  * - has to return a float value
@@ -2224,8 +2334,23 @@ float evaluate_driver(PathResolvedRNA *anim_rna,
                       ChannelDriver *driver,
                       ChannelDriver *driver_orig,
                       const float evaltime)
+{
+  return evaluate_driver_ex(anim_rna, driver, driver_orig, NULL, evaltime);
+}
+
+/**
+ * Same as evaluate_driver(), with optional pre-resolved variable targets.
+ *
+ * \param var_targets: One item per variable, see BKE_driver_resolve_variable_targets().
+ */
+float evaluate_driver_ex(PathResolvedRNA *anim_rna,
+                         ChannelDriver *driver,
+                         ChannelDriver *driver_orig,
+                         PathResolvedRNA *var_targets,
+                         const float evaltime)
 {
   DriverVar *dvar;
+  int i;
 
   /* check if driver can be evaluated */
   if (driver_orig->flag & DRIVER_FLAG_INVALID) {
@@ -2240,7 +2365,8 @@ float evaluate_driver(PathResolvedRNA *anim_rna,
       if (BLI_listbase_is_single(&driver->variables)) {
         /* just one target, so just use that */
         dvar = driver->variables.first;
-        driver->curval = driver_get_variable_value(driver, dvar);
+        driver->curval = driver_get_variable_value_ex(
+            driver, dvar, var_targets ? &var_targets[0] : NULL);
       }
       else {
         /* more than one target, so average the values of the targets */
@@ -2248,8 +2374,9 @@ float evaluate_driver(PathResolvedRNA *anim_rna,
         int tot = 0;
 
         /* loop through targets, adding (hopefully we don't get any overflow!) */
-        for (dvar = driver->variables.first; dvar; dvar = dvar->next) {
-          value += driver_get_variable_value(driver, dvar);
+        for (dvar = driver->variables.first, i = 0; dvar; dvar = dvar->next, i++) {
+          value += driver_get_variable_value_ex(
+              driver, dvar, var_targets ? &var_targets[i] : NULL);
           tot++;
         }
 
@@ -2269,9 +2396,10 @@ float evaluate_driver(PathResolvedRNA *anim_rna,
       float value = 0.0f;
 
       /* loop through the variables, getting the values and comparing them to existing ones */
-      for (dvar = driver->variables.first; dvar; dvar = dvar->next) {
+      for (dvar = driver->variables.first, i = 0; dvar; dvar = dvar->next, i++) {
         /* get value */
-        float tmp_val = driver_get_variable_value(driver, dvar);
+        float tmp_val = driver_get_variable_value_ex(
+            driver, dvar, var_targets ? &var_targets[i] : NULL);
 
         /* store this value if appropriate */
         if (dvar->prev) {
@@ -2305,7 +2433,8 @@ float evaluate_driver(PathResolvedRNA *anim_rna,
       if ((driver_orig->expression[0] == '\0') || (driver_orig->flag & DRIVER_FLAG_INVALID)) {
         driver->curval = 0.0f;
       }
-      else if (!driver_try_evaluate_simple_expr(driver, driver_orig, &driver->curval, evaltime)) {
+      else if (!driver_try_evaluate_simple_expr(
+                   driver, driver_orig, var_targets, &driver->curval, evaltime)) {
 #ifdef WITH_PYTHON
         /* this evaluates the expression using Python, and returns its result:
          * - on errors it reports, then returns 0.0f
@@ -2524,8 +2653,35 @@ static void berekeny(float f1, float f2, float f3, float f4, float *o, int b)
 
 /* -------------------------- */
 
-/* Calculate F-Curve value for 'evaltime' using BezTriple keyframes */
-static float fcurve_eval_keyframes(FCurve *fcu, BezTriple *bezts, float evaltime)
+/* Find the keyframe segment containing evaltime using the one found by a previous evaluation,
+ * for curves evaluated at increasing (or repeated) times during playback and sampling.
+ * Only succeeds when evaltime is strictly inside the segment, giving the same index as the
+ * binary search would without an exact match. */
+static bool fcurve_keyframe_index_from_hint(
+    const BezTriple *bezts, int totvert, float evaltime, float threshold, int hint, int *r_index)
+{
+  /* The segment of the last evaluation, then the one after it. */
+  for (int a = hint; a <= hint + 1; a++) {
+    if (a < 1 || a >= totvert) {
+      continue;
+    }
+    const float prevframe = bezts[a - 1].vec[1][0];
+    const float frame = bezts[a].vec[1][0];
+    if ((prevframe < evaltime) && (evaltime < frame) && !IS_EQT(evaltime, prevframe, threshold) &&
+        !IS_EQT(evaltime, frame, threshold)) {
+      *r_index = a;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Calculate F-Curve value for 'evaltime' using BezTriple keyframes,
+ * segment_hint is optional, see evaluate_fcurve_sequential(). */
+static float fcurve_eval_keyframes(FCurve *fcu,
+                                   BezTriple *bezts,
+                                   float evaltime,
+                                   int *segment_hint)
 {
   const float eps = 1.e-8f;
   BezTriple *bezt, *prevbezt, *lastbezt;
@@ -2657,7 +2813,20 @@ static float fcurve_eval_keyframes(FCurve *fcu, BezTriple *bezts, float evaltime
      *   Weird errors, like selecting the wrong keyframe range (see T39207), occur.
      *   This lower bound was established in b888a32eee8147b028464336ad2404d8155c64dd.
      */
-    a = binarysearch_bezt_index_ex(bezts, evaltime, fcu->totvert, 0.0001, &exact);
+    const float threshold = 0.0001f;
+    int index;
+
+    if (segment_hint &&
+        fcurve_keyframe_index_from_hint(
+            bezts, fcu->totvert, evaltime, threshold, *segment_hint, &index)) {
+      a = index;
+    }
+    else {
+      a = binarysearch_bezt_index_ex(bezts, evaltime, fcu->totvert, threshold, &exact);
+    }
+    if (segment_hint) {
+      *segment_hint = a;
+    }
 
     if (exact) {
       /* index returned must be interpreted differently when it sits on top of an existing keyframe
@@ -3000,7 +3169,7 @@ static float fcurve_eval_samples(FCurve *fcu, FPoint *fpts, float evaltime)
 /* Evaluate and return the value of the given F-Curve at the specified frame ("evaltime")
  * Note: this is also used for drivers
  */
-static float evaluate_fcurve_ex(FCurve *fcu, float evaltime, float cvalue)
+static float evaluate_fcurve_ex(FCurve *fcu, float evaltime, float cvalue, int *segment_hint)
 {
   float devaltime;
 
@@ -3017,7 +3186,7 @@ static float evaluate_fcurve_ex(FCurve *fcu, float evaltime, float cvalue)
    *   F-Curve modifier on the stack requested the curve to be evaluated at
    */
   if (fcu->bezt) {
-    cvalue = fcurve_eval_keyframes(fcu, fcu->bezt, devaltime);
+    cvalue = fcurve_eval_keyframes(fcu, fcu->bezt, devaltime, segment_hint);
   }
   else if (fcu->fpt) {
     cvalue = fcurve_eval_samples(fcu, fcu->fpt, devaltime);
@@ -3041,7 +3210,21 @@ float evaluate_fcurve(FCurve *fcu, float evaltime)
 {
   BLI_assert(fcu->driver == NULL);
 
-  return evaluate_fcurve_ex(fcu, evaltime, 0.0);
+  return evaluate_fcurve_ex(fcu, evaltime, 0.0, NULL);
+}
+
+/**
+ * Same as evaluate_fcurve(), for evaluating the same curve many times at increasing times
+ * (playback, sampling, baking). The keyframe segment of the previous evaluation is kept in
+ * segment_hint, which makes finding the segment O(1) instead of a binary search.
+ *
+ * \param segment_hint: Owned by the caller, initialized to 0 and only used for this curve.
+ */
+float evaluate_fcurve_sequential(FCurve *fcu, float evaltime, int *segment_hint)
+{
+  BLI_assert(fcu->driver == NULL);
+
+  return evaluate_fcurve_ex(fcu, evaltime, 0.0, segment_hint);
 }
 
 float evaluate_fcurve_only_curve(FCurve *fcu, float evaltime)
@@ -3049,13 +3232,23 @@ float evaluate_fcurve_only_curve(FCurve *fcu, float evaltime)
   /* Can be used to evaluate the (keyframed) fcurve only.
    * Also works for driver-fcurves when the driver itself is not relevant.
    * E.g. when inserting a keyframe in a driver fcurve. */
-  return evaluate_fcurve_ex(fcu, evaltime, 0.0);
+  return evaluate_fcurve_ex(fcu, evaltime, 0.0, NULL);
 }
 
 float evaluate_fcurve_driver(PathResolvedRNA *anim_rna,
                              FCurve *fcu,
                              ChannelDriver *driver_orig,
                              float evaltime)
+{
+  return evaluate_fcurve_driver_ex(anim_rna, fcu, driver_orig, NULL, evaltime);
+}
+
+/* Same as evaluate_fcurve_driver(), see evaluate_driver_ex() for var_targets. */
+float evaluate_fcurve_driver_ex(PathResolvedRNA *anim_rna,
+                                FCurve *fcu,
+                                ChannelDriver *driver_orig,
+                                PathResolvedRNA *var_targets,
+                                float evaltime)
 {
   BLI_assert(fcu->driver != NULL);
   float cvalue = 0.0f;
@@ -3065,7 +3258,7 @@ float evaluate_fcurve_driver(PathResolvedRNA *anim_rna,
    * input (i.e. in place of 'time') for F-Curves. */
   if (fcu->driver) {
     /* evaltime now serves as input for the curve */
-    evaltime = evaluate_driver(anim_rna, fcu->driver, driver_orig, evaltime);
+    evaltime = evaluate_driver_ex(anim_rna, fcu->driver, driver_orig, var_targets, evaltime);
 
     /* only do a default 1-1 mapping if it's unlikely that anything else will set a value... */
     if (fcu->totvert == 0) {
@@ -3096,7 +3289,7 @@ float evaluate_fcurve_driver(PathResolvedRNA *anim_rna,
     }
   }
 
-  return evaluate_fcurve_ex(fcu, evaltime, cvalue);
+  return evaluate_fcurve_ex(fcu, evaltime, cvalue, NULL);
 }
 
 /* Checks if the curve has valid keys, drivers or modifiers that produce an actual curve. */
@@ -3106,8 +3299,12 @@ bool BKE_fcurve_is_empty(FCurve *fcu)
          !list_has_suitable_fmodifier(&fcu->modifiers, 0, FMI_TYPE_GENERATE_CURVE);
 }
 
-/* Calculate the value of the given F-Curve at the given frame, and set its curval */
-float calculate_fcurve(PathResolvedRNA *anim_rna, FCurve *fcu, float evaltime)
+/* Calculate the value of the given F-Curve at the given frame, and set its curval,
+ * segment_hint is optional, see evaluate_fcurve_sequential(). */
+float calculate_fcurve_ex(PathResolvedRNA *anim_rna,
+                          FCurve *fcu,
+                          float evaltime,
+                          int *segment_hint)
 {
   /* only calculate + set curval (overriding the existing value) if curve has
    * any data which warrants this...
@@ -3119,7 +3316,7 @@ float calculate_fcurve(PathResolvedRNA *anim_rna, FCurve *fcu, float evaltime)
       curval = evaluate_fcurve_driver(anim_rna, fcu, fcu->driver, evaltime);
     }
     else {
-      curval = evaluate_fcurve(fcu, evaltime);
+      curval = evaluate_fcurve_sequential(fcu, evaltime, segment_hint);
     }
     fcu->curval = curval; /* debug display only, not thread safe! */
     return curval;
@@ -3128,3 +3325,9 @@ float calculate_fcurve(PathResolvedRNA *anim_rna, FCurve *fcu, float evaltime)
     return 0.0f;
   }
 }
+
+/* Calculate the value of the given F-Curve at the given frame, and set its curval */
+float calculate_fcurve(PathResolvedRNA *anim_rna, FCurve *fcu, float evaltime)
+{
+  return calculate_fcurve_ex(anim_rna, fcu, evaltime, NULL);
+}
@@ -467,6 +467,21 @@ void BKE_mesh_update_customdata_pointers(Mesh *me, const bool do_ensure_tess_cd)
   me->mloopuv = CustomData_get_layer(&me->ldata, CD_MLOOPUV);
 }
 
+/**
+ * Give the mesh its own copy of the layers in \a mask it shares with other meshes, see
+ * #CustomData_unshare_layers. Original meshes share their layers with their copy-on-write
+ * copies, this has to be called before modifying their layers in place.
+ */
+void BKE_mesh_unshare_layers(Mesh *me, const CustomData_MeshMasks *mask)
+{
+  CustomData_unshare_layers(&me->vdata, mask->vmask);
+  CustomData_unshare_layers(&me->edata, mask->emask);
+  CustomData_unshare_layers(&me->fdata, mask->fmask);
+  CustomData_unshare_layers(&me->ldata, mask->lmask);
+  CustomData_unshare_layers(&me->pdata, mask->pmask);
+  BKE_mesh_update_customdata_pointers(me, false);
+}
+
 bool BKE_mesh_has_custom_loop_normals(Mesh *me)
 {
   if (me->edit_mesh) {
@@ -590,7 +605,13 @@ void BKE_mesh_copy_data(Main *bmain, Mesh *me_dst, const Mesh *me_src, const int
 
   me_dst->mat = MEM_dupallocN(me_src->mat);
 
-  const eCDAllocType alloc_type = (flag & LIB_ID_COPY_CD_REFERENCE) ? CD_REFERENCE : CD_DUPLICATE;
+  eCDAllocType alloc_type = CD_DUPLICATE;
+  if (flag & LIB_ID_COPY_CD_REFERENCE) {
+    alloc_type = CD_REFERENCE;
+  }
+  else if (flag & LIB_ID_COPY_CD_SHARE) {
+    alloc_type = CD_SHARE;
+  }
   CustomData_copy(&me_src->vdata, &me_dst->vdata, mask.vmask, alloc_type, me_dst->totvert);
   CustomData_copy(&me_src->edata, &me_dst->edata, mask.emask, alloc_type, me_dst->totedge);
   CustomData_copy(&me_src->ldata, &me_dst->ldata, mask.lmask, alloc_type, me_dst->totloop);
@@ -1596,6 +1617,7 @@ void BKE_mesh_vert_normals_apply(Mesh *mesh, const short (*vert_normals)[3])
   for (int i = 0; i < mesh->totvert; i++, mv++) {
     copy_v3_v3_short(mv->no, vert_normals[i]);
   }
+  MEM_SAFE_FREE(mesh->runtime.vert_normals);
   mesh->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
 }
 
@@ -1620,6 +1642,8 @@ void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spac
   const float split_angle = (mesh->flag & ME_AUTOSMOOTH) != 0 ? mesh->smoothresh : (float)M_PI;
 
   if (CustomData_has_layer(&mesh->ldata, CD_NORMAL)) {
+    /* Written in place, may be shared with other meshes. */
+    CustomData_unshare_layers(&mesh->ldata, CD_MASK_NORMAL);
     r_loopnors = CustomData_get_layer(&mesh->ldata, CD_NORMAL);
     memset(r_loopnors, 0, sizeof(float[3]) * mesh->totloop);
   }
@@ -1651,26 +1675,34 @@ void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spac
     free_polynors = true;
   }
 
-  BKE_mesh_normals_loop_split(mesh->mvert,
-                              mesh->totvert,
-                              mesh->medge,
-                              mesh->totedge,
-                              mesh->mloop,
-                              r_loopnors,
-                              mesh->totloop,
-                              mesh->mpoly,
-                              (const float(*)[3])polynors,
-                              mesh->totpoly,
-                              use_split_normals,
-                              split_angle,
-                              r_lnors_spacearr,
-                              clnors,
-                              NULL);
+  /* May be NULL, only used when it still matches the mesh topology. */
+  const MLoopFans *loop_fans = mesh->runtime.loop_fans;
+
+  BKE_mesh_normals_loop_split_ex(mesh->mvert,
+                                 mesh->totvert,
+                                 mesh->medge,
+                                 mesh->totedge,
+                                 mesh->mloop,
+                                 r_loopnors,
+                                 mesh->totloop,
+                                 mesh->mpoly,
+                                 (const float(*)[3])polynors,
+                                 mesh->totpoly,
+                                 use_split_normals,
+                                 split_angle,
+                                 r_lnors_spacearr,
+                                 clnors,
+                                 NULL,
+                                 loop_fans);
 
   if (free_polynors) {
     MEM_freeN(polynors);
   }
 
+  /* Vertex normals are not updated here, float ones would remain outdated. */
+  if (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) {
+    MEM_SAFE_FREE(mesh->runtime.vert_normals);
+  }
   mesh->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
 }
 
@@ -25,6 +25,10 @@
 
 #include <limits.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "CLG_log.h"
 
 #include "MEM_guardedalloc.h"
@@ -48,6 +52,8 @@
 #include "BKE_customdata.h"
 #include "BKE_global.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_multires.h"
 #include "BKE_report.h"
 
@@ -216,6 +222,8 @@ typedef struct MeshCalcNormalsData {
   float (*pnors)[3];
   float (*lnors_weighted)[3];
   float (*vnors)[3];
+  /* Optional, allows to gather weighted loop normals in parallel. */
+  const MeshElemMap *vert_to_loop;
 } MeshCalcNormalsData;
 
 static void mesh_calc_normals_poly_cb(void *__restrict userdata,
@@ -228,6 +236,85 @@ static void mesh_calc_normals_poly_cb(void *__restrict userdata,
   BKE_mesh_calc_poly_normal(mp, data->mloop + mp->loopstart, data->mverts, data->pnors[pidx]);
 }
 
+#ifdef __SSE2__
+/**
+ * Same as the generic code of #mesh_calc_normals_poly_prepare_cb for triangles and quads,
+ * handling all corners at once (one per lane): Newell's normal terms, normalized edge-vectors
+ * and angles between the two edges of each corner.
+ * Operations are done in the same order, so results are the same as the generic code.
+ */
+static void mesh_calc_normals_poly_corners_sse2(const MVert *mverts,
+                                                const MLoop *ml,
+                                                const int nverts,
+                                                float r_pnor[3],
+                                                float r_fac[4])
+{
+  float co_curr[3][4], co_prev[3][4];
+  float edge[3][4], edge_next[3][4];
+  float newell[3][4], dot[4];
+
+  BLI_assert(ELEM(nverts, 3, 4));
+
+  for (int i = 0; i < 4; i++) {
+    /* Unused fourth lane of triangles gets a null edge, its terms are all zero. */
+    const int i_curr = (i < nverts) ? i : nverts - 1;
+    const int i_prev = (i < nverts) ? ((i == 0) ? nverts - 1 : i - 1) : nverts - 1;
+    const float *v_curr = mverts[ml[i_curr].v].co;
+    const float *v_prev = mverts[ml[i_prev].v].co;
+    for (int axis = 0; axis < 3; axis++) {
+      co_curr[axis][i] = v_curr[axis];
+      co_prev[axis][i] = v_prev[axis];
+    }
+  }
+
+  const __m128 x_curr = _mm_loadu_ps(co_curr[0]), x_prev = _mm_loadu_ps(co_prev[0]);
+  const __m128 y_curr = _mm_loadu_ps(co_curr[1]), y_prev = _mm_loadu_ps(co_prev[1]);
+  const __m128 z_curr = _mm_loadu_ps(co_curr[2]), z_prev = _mm_loadu_ps(co_prev[2]);
+
+  /* Edge-vector from previous to current corner, stored in the lane of the current corner. */
+  const __m128 x_edge = _mm_sub_ps(x_prev, x_curr);
+  const __m128 y_edge = _mm_sub_ps(y_prev, y_curr);
+  const __m128 z_edge = _mm_sub_ps(z_prev, z_curr);
+
+  /* Same as add_newell_cross_v3_v3v3, terms are summed in corners order below. */
+  _mm_storeu_ps(newell[0], _mm_mul_ps(y_edge, _mm_add_ps(z_prev, z_curr)));
+  _mm_storeu_ps(newell[1], _mm_mul_ps(z_edge, _mm_add_ps(x_prev, x_curr)));
+  _mm_storeu_ps(newell[2], _mm_mul_ps(x_edge, _mm_add_ps(y_prev, y_curr)));
+
+  /* Same as normalize_v3. */
+  const __m128 len_sq = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(x_edge, x_edge), _mm_mul_ps(y_edge, y_edge)),
+      _mm_mul_ps(z_edge, z_edge));
+  const __m128 is_valid = _mm_cmpgt_ps(len_sq, _mm_set1_ps(1.0e-35f));
+  const __m128 fac = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(len_sq)), is_valid);
+  _mm_storeu_ps(edge[0], _mm_mul_ps(x_edge, fac));
+  _mm_storeu_ps(edge[1], _mm_mul_ps(y_edge, fac));
+  _mm_storeu_ps(edge[2], _mm_mul_ps(z_edge, fac));
+
+  /* Edge-vector from each corner to the next one. */
+  for (int i = 0; i < 4; i++) {
+    const int i_next = (i < nverts - 1) ? i + 1 : ((i == nverts - 1) ? 0 : i);
+    for (int axis = 0; axis < 3; axis++) {
+      edge_next[axis][i] = edge[axis][i_next];
+    }
+  }
+
+  _mm_storeu_ps(dot,
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(edge_next[0]), _mm_loadu_ps(edge[0])),
+                                      _mm_mul_ps(_mm_loadu_ps(edge_next[1]), _mm_loadu_ps(edge[1]))),
+                           _mm_mul_ps(_mm_loadu_ps(edge_next[2]), _mm_loadu_ps(edge[2]))));
+
+  zero_v3(r_pnor);
+  for (int i = 0; i < nverts; i++) {
+    r_pnor[0] += newell[0][i];
+    r_pnor[1] += newell[1][i];
+    r_pnor[2] += newell[2][i];
+
+    r_fac[i] = saacos(-dot[i]);
+  }
+}
+#endif
+
 static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
                                               const int pidx,
                                               const TaskParallelTLS *__restrict UNUSED(tls))
@@ -242,9 +329,26 @@ static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
   float(*lnors_weighted)[3] = data->lnors_weighted;
 
   const int nverts = mp->totloop;
-  float(*edgevecbuf)[3] = BLI_array_alloca(edgevecbuf, (size_t)nverts);
   int i;
 
+#ifdef __SSE2__
+  if (ELEM(nverts, 3, 4)) {
+    float fac[4];
+
+    mesh_calc_normals_poly_corners_sse2(mverts, ml, nverts, pnor, fac);
+    if (UNLIKELY(normalize_v3(pnor) == 0.0f)) {
+      pnor[2] = 1.0f; /* other axes set to 0.0 */
+    }
+
+    for (i = 0; i < nverts; i++) {
+      mul_v3_v3fl(lnors_weighted[mp->loopstart + i], pnor, fac[i]);
+    }
+    return;
+  }
+#endif
+
+  float(*edgevecbuf)[3] = BLI_array_alloca(edgevecbuf, (size_t)nverts);
+
   /* Polygon Normal and edge-vector */
   /* inline version of #BKE_mesh_calc_poly_normal, also does edge-vectors */
   {
@@ -301,6 +405,15 @@ static void mesh_calc_normals_poly_finalize_cb(void *__restrict userdata,
   MVert *mv = &data->mverts[vidx];
   float *no = data->vnors[vidx];
 
+  if (data->vert_to_loop) {
+    /* Gather weighted loop normals, in the same order they would be accumulated otherwise. */
+    const MeshElemMap *loops = &data->vert_to_loop[vidx];
+    zero_v3(no);
+    for (int i = 0; i < loops->count; i++) {
+      add_v3_v3(no, data->lnors_weighted[loops->indices[i]]);
+    }
+  }
+
   if (UNLIKELY(normalize_v3(no) == 0.0f)) {
     /* following Mesh convention; we use vertex coordinate itself for normal in this case */
     normalize_v3_v3(no, mv->co);
@@ -309,15 +422,88 @@ static void mesh_calc_normals_poly_finalize_cb(void *__restrict userdata,
   normal_float_to_short_v3(mv->no, no);
 }
 
-void BKE_mesh_calc_normals_poly(MVert *mverts,
-                                float (*r_vertnors)[3],
-                                int numVerts,
-                                const MLoop *mloop,
-                                const MPoly *mpolys,
-                                int numLoops,
-                                int numPolys,
-                                float (*r_polynors)[3],
-                                const bool only_face_normals)
+/**
+ * Build the vertex to loops mapping of given topology,
+ * for later use by #BKE_mesh_calc_normals_poly_ex.
+ */
+MVertLoopMap *BKE_mesh_vert_loop_map_cache_create(const MLoop *mloops,
+                                                  const int numLoops,
+                                                  const MPoly *mpolys,
+                                                  const int numPolys,
+                                                  const int numVerts)
+{
+  MVertLoopMap *vert_loop_map = MEM_callocN(sizeof(*vert_loop_map), __func__);
+
+  vert_loop_map->mloops = mloops;
+  vert_loop_map->mpolys = mpolys;
+  vert_loop_map->numVerts = numVerts;
+  vert_loop_map->numLoops = numLoops;
+  vert_loop_map->numPolys = numPolys;
+  vert_loop_map->users = 1;
+
+  BKE_mesh_vert_loop_map_create(&vert_loop_map->map,
+                                &vert_loop_map->mem,
+                                mpolys,
+                                mloops,
+                                numVerts,
+                                numPolys,
+                                numLoops);
+
+  return vert_loop_map;
+}
+
+/**
+ * Whether given map was built from that topology (same arrays and sizes).
+ */
+bool BKE_mesh_vert_loop_map_cache_matches(const MVertLoopMap *vert_loop_map,
+                                          const MLoop *mloops,
+                                          const int numLoops,
+                                          const MPoly *mpolys,
+                                          const int numPolys,
+                                          const int numVerts)
+{
+  return (vert_loop_map->mloops == mloops && vert_loop_map->mpolys == mpolys &&
+          vert_loop_map->numVerts == numVerts && vert_loop_map->numLoops == numLoops &&
+          vert_loop_map->numPolys == numPolys);
+}
+
+void BKE_mesh_vert_loop_map_cache_free(MVertLoopMap *vert_loop_map)
+{
+  MEM_freeN(vert_loop_map->map);
+  MEM_freeN(vert_loop_map->mem);
+  MEM_freeN(vert_loop_map);
+}
+
+/* Runtime vertex to loops mapping of the mesh, when it still matches its topology. */
+static const MeshElemMap *mesh_vert_to_loop_get(const Mesh *mesh)
+{
+  const MVertLoopMap *vert_loop_map = mesh->runtime.vert_loop_map;
+
+  if (vert_loop_map != NULL &&
+      BKE_mesh_vert_loop_map_cache_matches(
+          vert_loop_map, mesh->mloop, mesh->totloop, mesh->mpoly, mesh->totpoly, mesh->totvert)) {
+    return vert_loop_map->map;
+  }
+  return NULL;
+}
+
+/**
+ * Compute poly normals, and unless \a only_face_normals is set, vertex normals
+ * (stored in \a r_vertnors too when given).
+ *
+ * \param vert_to_loop: Optional vertex to loops mapping,
+ * allows to accumulate vertex normals in parallel.
+ */
+void BKE_mesh_calc_normals_poly_ex(MVert *mverts,
+                                   float (*r_vertnors)[3],
+                                   int numVerts,
+                                   const MLoop *mloop,
+                                   const MPoly *mpolys,
+                                   int numLoops,
+                                   int numPolys,
+                                   float (*r_polynors)[3],
+                                   const bool only_face_normals,
+                                   const MeshElemMap *vert_to_loop)
 {
   float(*pnors)[3] = r_polynors;
 
@@ -347,10 +533,11 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
 
   /* first go through and calculate normals for all the polys */
   if (vnors == NULL) {
-    vnors = MEM_calloc_arrayN((size_t)numVerts, sizeof(*vnors), __func__);
+    vnors = vert_to_loop ? MEM_malloc_arrayN((size_t)numVerts, sizeof(*vnors), __func__) :
+                           MEM_calloc_arrayN((size_t)numVerts, sizeof(*vnors), __func__);
     free_vnors = true;
   }
-  else {
+  else if (vert_to_loop == NULL) {
     memset(vnors, 0, sizeof(*vnors) * (size_t)numVerts);
   }
 
@@ -361,6 +548,7 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
       .pnors = pnors,
       .lnors_weighted = lnors_weighted,
       .vnors = vnors,
+      .vert_to_loop = vert_to_loop,
   };
 
   /* Compute poly normals, and prepare weighted loop normals. */
@@ -369,9 +557,12 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
   /* Actually accumulate weighted loop normals into vertex ones. */
   /* Unfortunately, not possible to thread that
    * (not in a reasonable, totally lock- and barrier-free fashion),
-   * since several loops will point to the same vertex... */
-  for (int lidx = 0; lidx < numLoops; lidx++) {
-    add_v3_v3(vnors[mloop[lidx].v], data.lnors_weighted[lidx]);
+   * since several loops will point to the same vertex...
+   * Unless we know the loops of each vertex, then they are gathered when finalizing. */
+  if (vert_to_loop == NULL) {
+    for (int lidx = 0; lidx < numLoops; lidx++) {
+      add_v3_v3(vnors[mloop[lidx].v], data.lnors_weighted[lidx]);
+    }
   }
 
   /* Normalize and validate computed vertex normals. */
@@ -383,6 +574,39 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
   MEM_freeN(lnors_weighted);
 }
 
+void BKE_mesh_calc_normals_poly(MVert *mverts,
+                                float (*r_vertnors)[3],
+                                int numVerts,
+                                const MLoop *mloop,
+                                const MPoly *mpolys,
+                                int numLoops,
+                                int numPolys,
+                                float (*r_polynors)[3],
+                                const bool only_face_normals)
+{
+  BKE_mesh_calc_normals_poly_ex(mverts,
+                                r_vertnors,
+                                numVerts,
+                                mloop,
+                                mpolys,
+                                numLoops,
+                                numPolys,
+                                r_polynors,
+                                only_face_normals,
+                                NULL);
+}
+
+/* Normals are written in place, layers shared with other meshes need their own copy first
+ * (the original mesh for copy-on-write meshes, see #CD_SHARE). */
+static void mesh_normals_layers_unshare(Mesh *mesh, const bool do_vert_normals)
+{
+  if (do_vert_normals) {
+    CustomData_unshare_layers(&mesh->vdata, CD_MASK_MVERT);
+    mesh->mvert = CustomData_get_layer(&mesh->vdata, CD_MVERT);
+  }
+  CustomData_unshare_layers(&mesh->pdata, CD_MASK_NORMAL);
+}
+
 void BKE_mesh_ensure_normals(Mesh *mesh)
 {
   if (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) {
@@ -401,21 +625,32 @@ void BKE_mesh_ensure_normals_for_display(Mesh *mesh)
   const bool do_poly_normals = (mesh->runtime.cd_dirty_poly & CD_MASK_NORMAL || poly_nors == NULL);
 
   if (do_vert_normals || do_poly_normals) {
+    mesh_normals_layers_unshare(mesh, do_vert_normals);
+    poly_nors = CustomData_get_layer(&mesh->pdata, CD_NORMAL);
+
     const bool do_add_poly_nors_cddata = (poly_nors == NULL);
     if (do_add_poly_nors_cddata) {
       poly_nors = MEM_malloc_arrayN((size_t)mesh->totpoly, sizeof(*poly_nors), __func__);
     }
 
+    /* Keep float vertex normals around, so that display code does not have to convert them
+     * back from #MVert.no, see #BKE_mesh_runtime_vert_normals_get. */
+    if (do_vert_normals && mesh->runtime.vert_normals == NULL) {
+      mesh->runtime.vert_normals = MEM_malloc_arrayN(
+          (size_t)mesh->totvert, sizeof(*mesh->runtime.vert_normals), __func__);
+    }
+
     /* calculate poly/vert normals */
-    BKE_mesh_calc_normals_poly(mesh->mvert,
-                               NULL,
-                               mesh->totvert,
-                               mesh->mloop,
-                               mesh->mpoly,
-                               mesh->totloop,
-                               mesh->totpoly,
-                               poly_nors,
-                               !do_vert_normals);
+    BKE_mesh_calc_normals_poly_ex(mesh->mvert,
+                                  do_vert_normals ? mesh->runtime.vert_normals : NULL,
+                                  mesh->totvert,
+                                  mesh->mloop,
+                                  mesh->mpoly,
+                                  mesh->totloop,
+                                  mesh->totpoly,
+                                  poly_nors,
+                                  !do_vert_normals,
+                                  mesh_vert_to_loop_get(mesh));
 
     if (do_add_poly_nors_cddata) {
       CustomData_add_layer(&mesh->pdata, CD_NORMAL, CD_ASSIGN, poly_nors, mesh->totpoly);
@@ -433,15 +668,18 @@ void BKE_mesh_calc_normals(Mesh *mesh)
 #ifdef DEBUG_TIME
   TIMEIT_START_AVERAGED(BKE_mesh_calc_normals);
 #endif
-  BKE_mesh_calc_normals_poly(mesh->mvert,
-                             NULL,
-                             mesh->totvert,
-                             mesh->mloop,
-                             mesh->mpoly,
-                             mesh->totloop,
-                             mesh->totpoly,
-                             NULL,
-                             false);
+  mesh_normals_layers_unshare(mesh, true);
+  /* Float vertex normals are only updated when the mesh already has them. */
+  BKE_mesh_calc_normals_poly_ex(mesh->mvert,
+                                mesh->runtime.vert_normals,
+                                mesh->totvert,
+                                mesh->mloop,
+                                mesh->mpoly,
+                                mesh->totloop,
+                                mesh->totpoly,
+                                NULL,
+                                false,
+                                mesh_vert_to_loop_get(mesh));
 #ifdef DEBUG_TIME
   TIMEIT_END_AVERAGED(BKE_mesh_calc_normals);
 #endif
@@ -801,8 +1039,17 @@ typedef struct LoopSplitTaskDataCommon {
   int numEdges;
   int numLoops;
   int numPolys;
+
+  /* First loop of each fan to compute, and their pre-allocated lnor spaces. */
+  const int *fan_loops;
+  MLoopNorSpace **fan_lnor_spaces;
 } LoopSplitTaskDataCommon;
 
+typedef struct LoopSplitTaskTLS {
+  /** Temp edge vectors stack, only used when computing lnor spacearr. */
+  BLI_Stack *edge_vectors;
+} LoopSplitTaskTLS;
+
 #define INDEX_UNSET INT_MIN
 #define INDEX_INVALID -1
 /* See comment about edge_to_loops below. */
@@ -915,6 +1162,30 @@ static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
   }
 }
 
+/**
+ * Same as the angle check of #mesh_edges_sharp_tag,
+ * for an edge to loops mapping which was computed without it.
+ */
+static void mesh_edges_sharp_tag_from_angle(int (*edge_to_loops)[2],
+                                            const int numEdges,
+                                            const int *loop_to_poly,
+                                            const float (*polynors)[3],
+                                            const float split_angle)
+{
+  const float split_angle_cos = cosf(split_angle);
+
+  for (int me_index = 0; me_index < numEdges; me_index++) {
+    int *e2l = edge_to_loops[me_index];
+
+    /* Only smooth edges can become sharp, their second loop is a valid (non-zero) index. */
+    if (e2l[1] > 0 &&
+        dot_v3v3(polynors[loop_to_poly[e2l[0]]], polynors[loop_to_poly[e2l[1]]]) <
+            split_angle_cos) {
+      e2l[1] = INDEX_INVALID;
+    }
+  }
+}
+
 /** Define sharp edges as needed to mimic 'autosmooth' from angle threshold.
  *
  * Used when defining an empty custom loop normals data layer,
@@ -1283,52 +1554,71 @@ static void split_loop_nor_fan_do(LoopSplitTaskDataCommon *common_data, LoopSpli
   }
 }
 
-static void loop_split_worker_do(LoopSplitTaskDataCommon *common_data,
-                                 LoopSplitTaskData *data,
-                                 BLI_Stack *edge_vectors)
+static void loop_split_task_data_init(const LoopSplitTaskDataCommon *common_data,
+                                      const int ml_curr_index,
+                                      LoopSplitTaskData *data)
 {
-  BLI_assert(data->ml_curr);
-  if (data->e2l_prev) {
-    BLI_assert((edge_vectors == NULL) || BLI_stack_is_empty(edge_vectors));
-    data->edge_vectors = edge_vectors;
-    split_loop_nor_fan_do(common_data, data);
+  const MLoop *mloops = common_data->mloops;
+  const int(*edge_to_loops)[2] = common_data->edge_to_loops;
+  const int mp_index = common_data->loop_to_poly[ml_curr_index];
+  const MPoly *mp = &common_data->mpolys[mp_index];
+  const int ml_prev_index = (ml_curr_index == mp->loopstart) ?
+                                (mp->loopstart + mp->totloop - 1) :
+                                (ml_curr_index - 1);
+  const int *e2l_curr = edge_to_loops[mloops[ml_curr_index].e];
+  const int *e2l_prev = edge_to_loops[mloops[ml_prev_index].e];
+
+  memset(data, 0, sizeof(*data));
+
+  data->ml_curr = &mloops[ml_curr_index];
+  data->ml_prev = &mloops[ml_prev_index];
+  data->ml_curr_index = ml_curr_index;
+  data->ml_prev_index = ml_prev_index;
+  data->mp_index = mp_index;
+
+  if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
+    data->lnor = &common_data->loopnors[ml_curr_index];
   }
   else {
-    /* No need for edge_vectors for 'single' case! */
-    split_loop_nor_single_do(common_data, data);
+    data->e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
   }
 }
 
-static void loop_split_worker(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+static void loop_split_fan_cb(void *__restrict userdata,
+                              const int fan_index,
+                              const TaskParallelTLS *__restrict tls)
 {
-  LoopSplitTaskDataCommon *common_data = BLI_task_pool_userdata(pool);
-  LoopSplitTaskData *data = taskdata;
+  LoopSplitTaskDataCommon *common_data = userdata;
+  LoopSplitTaskTLS *tls_data = tls->userdata_chunk;
+  LoopSplitTaskData data;
 
-  /* Temp edge vectors stack, only used when computing lnor spacearr. */
-  BLI_Stack *edge_vectors = common_data->lnors_spacearr ?
-                                BLI_stack_new(sizeof(float[3]), __func__) :
-                                NULL;
+  loop_split_task_data_init(common_data, common_data->fan_loops[fan_index], &data);
 
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_worker);
-#endif
+  if (common_data->lnors_spacearr) {
+    data.lnor_space = common_data->fan_lnor_spaces[fan_index];
+  }
 
-  for (int i = 0; i < LOOP_SPLIT_TASK_BLOCK_SIZE; i++, data++) {
-    /* A NULL ml_curr is used to tag ended data! */
-    if (data->ml_curr == NULL) {
-      break;
+  if (data.e2l_prev) {
+    if (common_data->lnors_spacearr && tls_data->edge_vectors == NULL) {
+      tls_data->edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
     }
-
-    loop_split_worker_do(common_data, data, edge_vectors);
+    BLI_assert((tls_data->edge_vectors == NULL) || BLI_stack_is_empty(tls_data->edge_vectors));
+    data.edge_vectors = tls_data->edge_vectors;
+    split_loop_nor_fan_do(common_data, &data);
   }
-
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
+  else {
+    /* No need for edge_vectors for 'single' case! */
+    split_loop_nor_single_do(common_data, &data);
   }
+}
 
-#ifdef DEBUG_TIME
-  TIMEIT_END_AVERAGED(loop_split_worker);
-#endif
+static void loop_split_fan_finalize(void *__restrict UNUSED(userdata), void *__restrict tls_v)
+{
+  LoopSplitTaskTLS *tls_data = tls_v;
+
+  if (tls_data->edge_vectors) {
+    BLI_stack_free(tls_data->edge_vectors);
+  }
 }
 
 /**
@@ -1407,11 +1697,12 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
   }
 }
 
-static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
+/**
+ * Find the first loop of each smooth fan (or single sharp loop) to compute,
+ * in \a r_fan_loops (which must be at least numLoops long), returns the number of fans.
+ */
+static int loop_split_generator(const LoopSplitTaskDataCommon *common_data, int *r_fan_loops)
 {
-  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
-  float(*loopnors)[3] = common_data->loopnors;
-
   const MLoop *mloops = common_data->mloops;
   const MPoly *mpolys = common_data->mpolys;
   const int *loop_to_poly = common_data->loop_to_poly;
@@ -1429,49 +1720,27 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 
   BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
 
-  LoopSplitTaskData *data_buff = NULL;
-  int data_idx = 0;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr
-   * (and we are not multi-threading). */
-  BLI_Stack *edge_vectors = NULL;
+  int totfan = 0;
 
 #ifdef DEBUG_TIME
   TIMEIT_START_AVERAGED(loop_split_generator);
 #endif
 
-  if (!pool) {
-    if (lnors_spacearr) {
-      edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
-    }
-  }
-
   /* We now know edges that can be smoothed (with their vector, and their two loops),
-   * and edges that will be hard! Now, time to generate the normals.
+   * and edges that will be hard! Now, time to find the fans to generate the normals from.
    */
   for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    float(*lnors)[3];
     const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
     ml_curr_index = mp->loopstart;
     ml_prev_index = ml_last_index;
 
     ml_curr = &mloops[ml_curr_index];
     ml_prev = &mloops[ml_prev_index];
-    lnors = &loopnors[ml_curr_index];
 
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
+    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
       const int *e2l_curr = edge_to_loops[ml_curr->e];
       const int *e2l_prev = edge_to_loops[ml_prev->e];
 
-#if 0
-      printf("Checking loop %d / edge %u / vert %u (sharp edge: %d, skiploop: %d)...",
-             ml_curr_index,
-             ml_curr->e,
-             ml_curr->v,
-             IS_EDGE_SHARP(e2l_curr),
-             BLI_BITMAP_TEST_BOOL(skip_loops, ml_curr_index));
-#endif
-
       /* A smooth edge, we have to check for cyclic smooth fan case.
        * If we find a new, never-processed cyclic smooth fan, we can do it now using that loop/edge
        * as 'entry point', otherwise we can skip it. */
@@ -1482,51 +1751,18 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
        * the code, add more memory usage, and despite its logical complexity,
        * loop_manifold_fan_around_vert_next() is quite cheap in term of CPU cycles,
        * so really think it's not worth it. */
-      if (!IS_EDGE_SHARP(e2l_curr) && (BLI_BITMAP_TEST(skip_loops, ml_curr_index) ||
-                                       !loop_split_generator_check_cyclic_smooth_fan(mloops,
-                                                                                     mpolys,
-                                                                                     edge_to_loops,
-                                                                                     loop_to_poly,
-                                                                                     e2l_prev,
-                                                                                     skip_loops,
-                                                                                     ml_curr,
-                                                                                     ml_prev,
-                                                                                     ml_curr_index,
-                                                                                     ml_prev_index,
-                                                                                     mp_index))) {
-        //              printf("SKIPPING!\n");
-      }
-      else {
-        LoopSplitTaskData *data, data_local;
-
-        //              printf("PROCESSING!\n");
-
-        if (pool) {
-          if (data_idx == 0) {
-            data_buff = MEM_calloc_arrayN(
-                LOOP_SPLIT_TASK_BLOCK_SIZE, sizeof(*data_buff), __func__);
-          }
-          data = &data_buff[data_idx];
-        }
-        else {
-          data = &data_local;
-          memset(data, 0, sizeof(*data));
-        }
-
-        if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
-          data->lnor = lnors;
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-#if 0 /* Not needed for 'single' loop. */
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = NULL; /* Tag as 'single' task. */
-#endif
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
+      if (IS_EDGE_SHARP(e2l_curr) || (!BLI_BITMAP_TEST(skip_loops, ml_curr_index) &&
+                                      loop_split_generator_check_cyclic_smooth_fan(mloops,
+                                                                                   mpolys,
+                                                                                   edge_to_loops,
+                                                                                   loop_to_poly,
+                                                                                   e2l_prev,
+                                                                                   skip_loops,
+                                                                                   ml_curr,
+                                                                                   ml_prev,
+                                                                                   ml_curr_index,
+                                                                                   ml_prev_index,
+                                                                                   mp_index))) {
         /* We *do not need* to check/tag loops as already computed!
          * Due to the fact a loop only links to one of its two edges,
          * a same fan *will never be walked more than once!*
@@ -1536,31 +1772,7 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
          * and not the alternative (smooth curr_edge, sharp prev_edge).
          * All this due/thanks to link between normals and loop ordering (i.e. winding).
          */
-        else {
-#if 0 /* Not needed for 'fan' loops. */
-          data->lnor = lnors;
-#endif
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
-
-        if (pool) {
-          data_idx++;
-          if (data_idx == LOOP_SPLIT_TASK_BLOCK_SIZE) {
-            BLI_task_pool_push(pool, loop_split_worker, data_buff, true, TASK_PRIORITY_LOW);
-            data_idx = 0;
-          }
-        }
-        else {
-          loop_split_worker_do(common_data, data, edge_vectors);
-        }
+        r_fan_loops[totfan++] = ml_curr_index;
       }
 
       ml_prev = ml_curr;
@@ -1568,42 +1780,110 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
     }
   }
 
-  /* Last block of data... Since it is calloc'ed and we use first NULL item as stopper,
-   * everything is fine. */
-  if (pool && data_idx) {
-    BLI_task_pool_push(pool, loop_split_worker, data_buff, true, TASK_PRIORITY_LOW);
-  }
-
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
-  }
   MEM_freeN(skip_loops);
 
 #ifdef DEBUG_TIME
   TIMEIT_END_AVERAGED(loop_split_generator);
 #endif
+
+  return totfan;
+}
+
+/**
+ * Build the smooth fans of given topology, ignoring any split angle,
+ * for later use by #BKE_mesh_normals_loop_split_ex.
+ */
+MLoopFans *BKE_mesh_loop_fans_create(const MEdge *medges,
+                                     const int numEdges,
+                                     const MLoop *mloops,
+                                     const int numLoops,
+                                     const MPoly *mpolys,
+                                     const int numPolys)
+{
+  MLoopFans *loop_fans = MEM_callocN(sizeof(*loop_fans), __func__);
+
+  loop_fans->medges = medges;
+  loop_fans->mloops = mloops;
+  loop_fans->mpolys = mpolys;
+  loop_fans->numEdges = numEdges;
+  loop_fans->numLoops = numLoops;
+  loop_fans->numPolys = numPolys;
+  loop_fans->users = 1;
+
+  loop_fans->edge_to_loops = MEM_calloc_arrayN(
+      (size_t)numEdges, sizeof(*loop_fans->edge_to_loops), __func__);
+  loop_fans->loop_to_poly = MEM_malloc_arrayN(
+      (size_t)numLoops, sizeof(*loop_fans->loop_to_poly), __func__);
+
+  LoopSplitTaskDataCommon common_data = {
+      .medges = medges,
+      .mloops = mloops,
+      .mpolys = mpolys,
+      .edge_to_loops = loop_fans->edge_to_loops,
+      .loop_to_poly = loop_fans->loop_to_poly,
+      .numEdges = numEdges,
+      .numLoops = numLoops,
+      .numPolys = numPolys,
+  };
+
+  mesh_edges_sharp_tag(&common_data, false, (float)M_PI, false);
+
+  int *fan_loops = MEM_malloc_arrayN((size_t)numLoops, sizeof(*fan_loops), __func__);
+  loop_fans->totfan = loop_split_generator(&common_data, fan_loops);
+  loop_fans->fan_loops = MEM_reallocN(fan_loops,
+                                      sizeof(*fan_loops) * (size_t)max_ii(loop_fans->totfan, 1));
+
+  return loop_fans;
+}
+
+/**
+ * Whether given fans were built from that topology (same arrays and sizes).
+ */
+bool BKE_mesh_loop_fans_matches(const MLoopFans *loop_fans,
+                                const MEdge *medges,
+                                const int numEdges,
+                                const MLoop *mloops,
+                                const int numLoops,
+                                const MPoly *mpolys,
+                                const int numPolys)
+{
+  return (loop_fans->medges == medges && loop_fans->mloops == mloops &&
+          loop_fans->mpolys == mpolys && loop_fans->numEdges == numEdges &&
+          loop_fans->numLoops == numLoops && loop_fans->numPolys == numPolys);
+}
+
+void BKE_mesh_loop_fans_free(MLoopFans *loop_fans)
+{
+  MEM_freeN(loop_fans->edge_to_loops);
+  MEM_freeN(loop_fans->loop_to_poly);
+  MEM_freeN(loop_fans->fan_loops);
+  MEM_freeN(loop_fans);
 }
 
 /**
  * Compute split normals, i.e. vertex normals associated with each poly (hence 'loop normals').
  * Useful to materialize sharp edges (or non-smooth faces) without actually modifying the geometry
  * (splitting edges).
+ *
+ * \param loop_fans: Optional smooth fans of that topology, see #BKE_mesh_loop_fans_create.
+ * Without split angle they are used as-is, otherwise only their edge to loops mapping is reused.
  */
-void BKE_mesh_normals_loop_split(const MVert *mverts,
-                                 const int UNUSED(numVerts),
-                                 MEdge *medges,
-                                 const int numEdges,
-                                 MLoop *mloops,
-                                 float (*r_loopnors)[3],
-                                 const int numLoops,
-                                 MPoly *mpolys,
-                                 const float (*polynors)[3],
-                                 const int numPolys,
-                                 const bool use_split_normals,
-                                 const float split_angle,
-                                 MLoopNorSpaceArray *r_lnors_spacearr,
-                                 short (*clnors_data)[2],
-                                 int *r_loop_to_poly)
+void BKE_mesh_normals_loop_split_ex(const MVert *mverts,
+                                    const int UNUSED(numVerts),
+                                    MEdge *medges,
+                                    const int numEdges,
+                                    MLoop *mloops,
+                                    float (*r_loopnors)[3],
+                                    const int numLoops,
+                                    MPoly *mpolys,
+                                    const float (*polynors)[3],
+                                    const int numPolys,
+                                    const bool use_split_normals,
+                                    const float split_angle,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    short (*clnors_data)[2],
+                                    int *r_loop_to_poly,
+                                    const MLoopFans *loop_fans)
 {
   /* For now this is not supported.
    * If we do not use split normals, we do not generate anything fancy! */
@@ -1640,6 +1920,15 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
     return;
   }
 
+  if (loop_fans != NULL &&
+      !BKE_mesh_loop_fans_matches(
+          loop_fans, medges, numEdges, mloops, numLoops, mpolys, numPolys)) {
+    loop_fans = NULL;
+  }
+
+  /* When using custom loop normals, disable the angle feature! */
+  const bool check_angle = (split_angle < (float)M_PI) && (clnors_data == NULL);
+
   /**
    * Mapping edge -> loops.
    * If that edge is used by more than two loops (polys),
@@ -1654,15 +1943,31 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
    * However, if needed, we can store the negated value of loop index instead of INDEX_INVALID
    * to retrieve the real value later in code).
    * Note also that lose edges always have both values set to 0! */
-  int(*edge_to_loops)[2] = MEM_calloc_arrayN((size_t)numEdges, sizeof(*edge_to_loops), __func__);
+  int(*edge_to_loops)[2];
 
   /* Simple mapping from a loop to its polygon index. */
-  int *loop_to_poly = r_loop_to_poly ?
-                          r_loop_to_poly :
-                          MEM_malloc_arrayN((size_t)numLoops, sizeof(*loop_to_poly), __func__);
+  int *loop_to_poly;
 
-  /* When using custom loop normals, disable the angle feature! */
-  const bool check_angle = (split_angle < (float)M_PI) && (clnors_data == NULL);
+  /* First loop of each smooth fan (or single sharp loop). */
+  const int *fan_loops;
+  int *fan_loops_local = NULL;
+  int totfan;
+
+  if (loop_fans == NULL) {
+    edge_to_loops = MEM_calloc_arrayN((size_t)numEdges, sizeof(*edge_to_loops), __func__);
+    loop_to_poly = r_loop_to_poly ?
+                       r_loop_to_poly :
+                       MEM_malloc_arrayN((size_t)numLoops, sizeof(*loop_to_poly), __func__);
+  }
+  else {
+    /* Cached mapping does not account for the split angle, we have to apply it on a copy. */
+    edge_to_loops = check_angle ? MEM_dupallocN(loop_fans->edge_to_loops) :
+                                  loop_fans->edge_to_loops;
+    loop_to_poly = loop_fans->loop_to_poly;
+    if (r_loop_to_poly) {
+      memcpy(r_loop_to_poly, loop_to_poly, sizeof(*r_loop_to_poly) * (size_t)numLoops);
+    }
+  }
 
   MLoopNorSpaceArray _lnors_spacearr = {NULL};
 
@@ -1695,31 +2000,66 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
       .numPolys = numPolys,
   };
 
-  /* This first loop check which edges are actually smooth, and compute edge vectors. */
-  mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
-
-  if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-    /* Not enough loops to be worth the whole threading overhead... */
-    loop_split_generator(NULL, &common_data);
+  if (loop_fans == NULL) {
+    /* This first loop check which edges are actually smooth, and compute edge vectors. */
+    mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
   }
   else {
-    TaskScheduler *task_scheduler;
-    TaskPool *task_pool;
+    /* Pre-populate all loop normals as if their verts were all-smooth,
+     * as done by mesh_edges_sharp_tag() otherwise. */
+    for (int ml_index = 0; ml_index < numLoops; ml_index++) {
+      normal_short_to_float_v3(r_loopnors[ml_index], mverts[mloops[ml_index].v].no);
+    }
+    if (check_angle) {
+      mesh_edges_sharp_tag_from_angle(
+          edge_to_loops, numEdges, loop_to_poly, polynors, split_angle);
+    }
+  }
 
-    task_scheduler = BLI_task_scheduler_get();
-    task_pool = BLI_task_pool_create(task_scheduler, &common_data);
+  if (loop_fans != NULL && !check_angle) {
+    /* Sharp edges are the same as when the fans were built, so are the fans. */
+    fan_loops = loop_fans->fan_loops;
+    totfan = loop_fans->totfan;
+  }
+  else {
+    fan_loops_local = MEM_malloc_arrayN((size_t)numLoops, sizeof(*fan_loops_local), __func__);
+    totfan = loop_split_generator(&common_data, fan_loops_local);
+    fan_loops = fan_loops_local;
+  }
+  common_data.fan_loops = fan_loops;
 
-    loop_split_generator(task_pool, &common_data);
+  if (r_lnors_spacearr) {
+    /* We have to create those outside of tasks, since memarena is not threadsafe. */
+    common_data.fan_lnor_spaces = MEM_malloc_arrayN(
+        (size_t)totfan, sizeof(*common_data.fan_lnor_spaces), __func__);
+    for (int fan_index = 0; fan_index < totfan; fan_index++) {
+      common_data.fan_lnor_spaces[fan_index] = BKE_lnor_space_create(r_lnors_spacearr);
+    }
+  }
 
-    BLI_task_pool_work_and_wait(task_pool);
+  LoopSplitTaskTLS tls_data = {NULL};
 
-    BLI_task_pool_free(task_pool);
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  /* Not enough loops to be worth the whole threading overhead otherwise... */
+  settings.use_threading = (numLoops >= LOOP_SPLIT_TASK_BLOCK_SIZE * 8);
+  settings.min_iter_per_thread = LOOP_SPLIT_TASK_BLOCK_SIZE;
+  settings.userdata_chunk = &tls_data;
+  settings.userdata_chunk_size = sizeof(tls_data);
+  settings.func_finalize = loop_split_fan_finalize;
+  BLI_task_parallel_range(0, totfan, &common_data, loop_split_fan_cb, &settings);
+
+  if (loop_fans == NULL) {
+    MEM_freeN(edge_to_loops);
+    if (!r_loop_to_poly) {
+      MEM_freeN(loop_to_poly);
+    }
   }
-
-  MEM_freeN(edge_to_loops);
-  if (!r_loop_to_poly) {
-    MEM_freeN(loop_to_poly);
+  else if (check_angle) {
+    MEM_freeN(edge_to_loops);
   }
+  MEM_SAFE_FREE(fan_loops_local);
+  MEM_SAFE_FREE(common_data.fan_lnor_spaces);
 
   if (r_lnors_spacearr) {
     if (r_lnors_spacearr == &_lnors_spacearr) {
@@ -1732,6 +2072,40 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
 #endif
 }
 
+void BKE_mesh_normals_loop_split(const MVert *mverts,
+                                 const int numVerts,
+                                 MEdge *medges,
+                                 const int numEdges,
+                                 MLoop *mloops,
+                                 float (*r_loopnors)[3],
+                                 const int numLoops,
+                                 MPoly *mpolys,
+                                 const float (*polynors)[3],
+                                 const int numPolys,
+                                 const bool use_split_normals,
+                                 const float split_angle,
+                                 MLoopNorSpaceArray *r_lnors_spacearr,
+                                 short (*clnors_data)[2],
+                                 int *r_loop_to_poly)
+{
+  BKE_mesh_normals_loop_split_ex(mverts,
+                                 numVerts,
+                                 medges,
+                                 numEdges,
+                                 mloops,
+                                 r_loopnors,
+                                 numLoops,
+                                 mpolys,
+                                 polynors,
+                                 numPolys,
+                                 use_split_normals,
+                                 split_angle,
+                                 r_lnors_spacearr,
+                                 clnors_data,
+                                 r_loop_to_poly,
+                                 NULL);
+}
+
 #undef INDEX_UNSET
 #undef INDEX_INVALID
 #undef IS_EDGE_SHARP
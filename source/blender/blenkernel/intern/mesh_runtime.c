@@ -45,6 +45,9 @@
 
 static ThreadRWMutex loops_cache_lock = PTHREAD_RWLOCK_INITIALIZER;
 
+/* Last #Mesh_Runtime.copy_stamp given out, zero is never used for a copy. */
+static uint64_t mesh_runtime_copy_stamp = 0;
+
 /**
  * Default values defined at read time.
  */
@@ -69,6 +72,10 @@ void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int UNUSED(flag))
   memset(&runtime->looptris, 0, sizeof(runtime->looptris));
   runtime->bvh_cache = NULL;
   runtime->shrinkwrap_data = NULL;
+  runtime->loop_fans = NULL;
+  runtime->vert_loop_map = NULL;
+  runtime->vert_normals = NULL;
+  runtime->copy_stamp = atomic_add_and_fetch_uint64(&mesh_runtime_copy_stamp, 1);
 
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
@@ -192,6 +199,122 @@ void BKE_mesh_runtime_verttri_from_looptri(MVertTri *r_verttri,
   }
 }
 
+/* Whether both meshes use the same faces and loops, e.g. when one was only deformed. */
+static bool mesh_runtime_topology_is_shared(const Mesh *mesh_src, const Mesh *mesh_dst)
+{
+  return (mesh_src != mesh_dst && mesh_src->mloop == mesh_dst->mloop &&
+          mesh_src->mpoly == mesh_dst->mpoly && mesh_src->totloop == mesh_dst->totloop &&
+          mesh_src->totpoly == mesh_dst->totpoly && mesh_src->totloop != 0);
+}
+
+static void mesh_runtime_loop_fans_release(Mesh *mesh)
+{
+  MLoopFans *loop_fans = mesh->runtime.loop_fans;
+  if (loop_fans == NULL) {
+    return;
+  }
+  mesh->runtime.loop_fans = NULL;
+  if (atomic_sub_and_fetch_int32(&loop_fans->users, 1) == 0) {
+    BKE_mesh_loop_fans_free(loop_fans);
+  }
+}
+
+/**
+ * Give \a mesh_dst the smooth fans of \a mesh_src (building them if needed),
+ * when both meshes use the same topology arrays, e.g. when \a mesh_dst was only deformed.
+ * Since they do not depend on vertex positions, they stay valid until \a mesh_src geometry
+ * gets cleared, so split normals of deformed meshes do not have to find them again.
+ */
+void BKE_mesh_runtime_loop_fans_share(Mesh *mesh_src, Mesh *mesh_dst)
+{
+  if (!mesh_runtime_topology_is_shared(mesh_src, mesh_dst) ||
+      mesh_src->medge != mesh_dst->medge || mesh_src->totedge != mesh_dst->totedge) {
+    return;
+  }
+
+  MLoopFans *loop_fans = mesh_src->runtime.loop_fans;
+  if (loop_fans == NULL) {
+    loop_fans = BKE_mesh_loop_fans_create(mesh_src->medge,
+                                          mesh_src->totedge,
+                                          mesh_src->mloop,
+                                          mesh_src->totloop,
+                                          mesh_src->mpoly,
+                                          mesh_src->totpoly);
+    /* Another evaluation of the same mesh may have been faster, keep the first one. */
+    MLoopFans *loop_fans_prev = atomic_cas_ptr(
+        (void **)&mesh_src->runtime.loop_fans, NULL, loop_fans);
+    if (loop_fans_prev != NULL) {
+      BKE_mesh_loop_fans_free(loop_fans);
+      loop_fans = loop_fans_prev;
+    }
+  }
+
+  if (mesh_dst->runtime.loop_fans == loop_fans) {
+    return;
+  }
+  mesh_runtime_loop_fans_release(mesh_dst);
+  atomic_add_and_fetch_int32(&loop_fans->users, 1);
+  mesh_dst->runtime.loop_fans = loop_fans;
+}
+
+static void mesh_runtime_vert_loop_map_release(Mesh *mesh)
+{
+  MVertLoopMap *vert_loop_map = mesh->runtime.vert_loop_map;
+  if (vert_loop_map == NULL) {
+    return;
+  }
+  mesh->runtime.vert_loop_map = NULL;
+  if (atomic_sub_and_fetch_int32(&vert_loop_map->users, 1) == 0) {
+    BKE_mesh_vert_loop_map_cache_free(vert_loop_map);
+  }
+}
+
+/**
+ * Same as #BKE_mesh_runtime_loop_fans_share, for the vertex to loops mapping
+ * used to compute vertex normals in parallel.
+ */
+void BKE_mesh_runtime_vert_loop_map_share(Mesh *mesh_src, Mesh *mesh_dst)
+{
+  if (!mesh_runtime_topology_is_shared(mesh_src, mesh_dst) ||
+      mesh_src->totvert != mesh_dst->totvert) {
+    return;
+  }
+
+  MVertLoopMap *vert_loop_map = mesh_src->runtime.vert_loop_map;
+  if (vert_loop_map == NULL) {
+    vert_loop_map = BKE_mesh_vert_loop_map_cache_create(mesh_src->mloop,
+                                                        mesh_src->totloop,
+                                                        mesh_src->mpoly,
+                                                        mesh_src->totpoly,
+                                                        mesh_src->totvert);
+    MVertLoopMap *vert_loop_map_prev = atomic_cas_ptr(
+        (void **)&mesh_src->runtime.vert_loop_map, NULL, vert_loop_map);
+    if (vert_loop_map_prev != NULL) {
+      BKE_mesh_vert_loop_map_cache_free(vert_loop_map);
+      vert_loop_map = vert_loop_map_prev;
+    }
+  }
+
+  if (mesh_dst->runtime.vert_loop_map == vert_loop_map) {
+    return;
+  }
+  mesh_runtime_vert_loop_map_release(mesh_dst);
+  atomic_add_and_fetch_int32(&vert_loop_map->users, 1);
+  mesh_dst->runtime.vert_loop_map = vert_loop_map;
+}
+
+/**
+ * Float vertex normals, when they were kept by the last computation of vertex normals
+ * and are still valid, NULL otherwise (#MVert.no has to be used then).
+ */
+const float (*BKE_mesh_runtime_vert_normals_get(const Mesh *mesh))[3]
+{
+  if (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) {
+    return NULL;
+  }
+  return (const float(*)[3])mesh->runtime.vert_normals;
+}
+
 bool BKE_mesh_runtime_ensure_edit_data(struct Mesh *mesh)
 {
   if (mesh->runtime.edit_data != NULL) {
@@ -235,6 +358,9 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
     mesh->runtime.subdiv_ccg = NULL;
   }
   BKE_shrinkwrap_discard_boundary_data(mesh);
+  mesh_runtime_loop_fans_release(mesh);
+  mesh_runtime_vert_loop_map_release(mesh);
+  MEM_SAFE_FREE(mesh->runtime.vert_normals);
 }
 
 /** \} */
@@ -66,6 +66,7 @@
 #include "BLT_translation.h"
 
 #include "BKE_pbvh.h"
+#include "BKE_bvhutils.h"
 #include "BKE_main.h"
 #include "BKE_global.h"
 #include "BKE_idprop.h"
@@ -445,6 +446,8 @@ void BKE_object_free_derived_caches(Object *ob)
       BKE_mesh_eval_delete(mesh_eval);
     }
     ob->runtime.mesh_eval = NULL;
+    /* Persistent trees are kept, to be refitted to the next evaluated mesh. */
+    BKE_bvhtree_object_persistent_invalidate(ob);
   }
   if (ob->runtime.mesh_deform_eval != NULL) {
     Mesh *mesh_deform_eval = ob->runtime.mesh_deform_eval;
@@ -573,6 +576,8 @@ void BKE_object_free(Object *ob)
     ob->runtime.curve_cache = NULL;
   }
 
+  BKE_bvhtree_object_persistent_free(ob);
+
   BKE_previewimg_free(&ob->preview);
 }
 
@@ -2544,10 +2549,10 @@ static void object_where_is_calc_ex(Depsgraph *depsgraph,
 
   /* solve constraints */
   if (ob->constraints.first && !(ob->transflag & OB_NO_CONSTRAINTS)) {
-    bConstraintOb *cob;
-    cob = BKE_constraints_make_evalob(depsgraph, scene, ob, NULL, CONSTRAINT_OBTYPE_OBJECT);
-    BKE_constraints_solve(depsgraph, &ob->constraints, cob, ctime);
-    BKE_constraints_clear_evalob(cob);
+    bConstraintOb cob;
+    BKE_constraints_init_evalob(&cob, depsgraph, scene, ob, NULL, CONSTRAINT_OBTYPE_OBJECT);
+    BKE_constraints_solve(depsgraph, &ob->constraints, &cob, ctime);
+    BKE_constraints_apply_evalob(&cob);
   }
 
   /* set negative scale flag in object */
@@ -3919,6 +3924,7 @@ void BKE_object_runtime_reset_on_copy(Object *object, const int UNUSED(flag))
   runtime->mesh_deform_eval = NULL;
   runtime->curve_cache = NULL;
   runtime->gpencil_cache = NULL;
+  runtime->bvh_persistent = NULL;
 }
 
 /*
@@ -118,23 +118,23 @@ void BKE_object_eval_parent(Depsgraph *depsgraph, Object *ob)
 
 void BKE_object_eval_constraints(Depsgraph *depsgraph, Scene *scene, Object *ob)
 {
-  bConstraintOb *cob;
+  bConstraintOb cob;
   float ctime = BKE_scene_frame_get(scene);
 
   DEG_debug_print_eval(depsgraph, __func__, ob->id.name, ob);
 
   /* evaluate constraints stack */
   /* TODO: split this into:
-   * - pre (i.e. BKE_constraints_make_evalob, per-constraint (i.e.
+   * - pre (i.e. BKE_constraints_init_evalob, per-constraint (i.e.
    * - inner body of BKE_constraints_solve),
-   * - post (i.e. BKE_constraints_clear_evalob)
+   * - post (i.e. BKE_constraints_apply_evalob)
    *
    * Not sure why, this is from Joshua - sergey
    *
    */
-  cob = BKE_constraints_make_evalob(depsgraph, scene, ob, NULL, CONSTRAINT_OBTYPE_OBJECT);
-  BKE_constraints_solve(depsgraph, &ob->constraints, cob, ctime);
-  BKE_constraints_clear_evalob(cob);
+  BKE_constraints_init_evalob(&cob, depsgraph, scene, ob, NULL, CONSTRAINT_OBTYPE_OBJECT);
+  BKE_constraints_solve(depsgraph, &ob->constraints, &cob, ctime);
+  BKE_constraints_apply_evalob(&cob);
 }
 
 void BKE_object_eval_transform_final(Depsgraph *depsgraph, Object *ob)
@@ -1146,6 +1146,34 @@ static bool sculpt_modifiers_active(Scene *scene, Sculpt *sd, Object *ob)
   return false;
 }
 
+/**
+ * Layers painted in the current mode are written in place,
+ * the original mesh must stop sharing them with its copy-on-write copies (see #CD_SHARE).
+ */
+static void sculpt_mesh_layers_unshare(Object *ob, Mesh *me)
+{
+  SculptSession *ss = ob->sculpt;
+  CustomData_MeshMasks mask = {0};
+
+  if (ob->mode & OB_MODE_SCULPT) {
+    mask.vmask |= CD_MASK_MVERT | CD_MASK_PAINT_MASK;
+    mask.lmask |= CD_MASK_MDISPS | CD_MASK_GRID_PAINT_MASK;
+  }
+  if (ob->mode & OB_MODE_VERTEX_PAINT) {
+    mask.lmask |= CD_MASK_MLOOPCOL;
+  }
+  if (ob->mode & OB_MODE_WEIGHT_PAINT) {
+    mask.vmask |= CD_MASK_MDEFORMVERT;
+  }
+
+  MVert *mvert = me->mvert;
+  BKE_mesh_unshare_layers(me, &mask);
+
+  if (ss->pbvh != NULL && me->mvert != mvert && BKE_pbvh_type(ss->pbvh) == PBVH_FACES) {
+    BKE_pbvh_mesh_verts_update(ss->pbvh, me->mvert);
+  }
+}
+
 /**
  * \param need_mask: So that the evaluated mesh that is returned has mask data.
  */
@@ -1163,6 +1191,8 @@ static void sculpt_update_object(
 
   ss->building_vp_handle = false;
 
+  sculpt_mesh_layers_unshare(ob, me);
+
   if (need_mask) {
     if (mmd == NULL) {
       if (!CustomData_has_layer(&me->vdata, CD_PAINT_MASK)) {
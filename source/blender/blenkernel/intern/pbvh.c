@@ -26,6 +26,7 @@
 #include "BLI_math.h"
 #include "BLI_ghash.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "DNA_meshdata_types.h"
 
@@ -54,6 +55,16 @@
 
 #define PBVH_THREADED_LIMIT 4
 
+/* Number of bins primitive centroids are sorted into along every axis, when
+ * looking for the best split of a node. */
+#define PBVH_BUILD_BINS 16
+/* Sub-trees with primitives for more than this many leaves are built by
+ * separate tasks. */
+#define PBVH_BUILD_TASK_LEAVES 4
+/* Primitives of nodes with primitives for more than this many leaves are
+ * sorted into bins by multiple threads. */
+#define PBVH_BUILD_THREADED_BINS_LEAVES 64
+
 typedef struct PBVHStack {
   PBVHNode *node;
   bool revisiting;
@@ -195,6 +206,49 @@ static int partition_indices(int *prim_indices, int lo, int hi, int axis, float
   }
 }
 
+/* Bin of a primitive centroid along an axis, see PBVHBuildBins. */
+BLI_INLINE int build_bin_index(const float bin_min, const float bin_scale, const float co)
+{
+  const int bin = (int)((co - bin_min) * bin_scale);
+  return CLAMPIS(bin, 0, PBVH_BUILD_BINS - 1);
+}
+
+/* Returns the index of the first element on the right of the partition,
+ * primitives in bins lower than split_bin are on the left. */
+static int partition_indices_bins(int *prim_indices,
+                                  int lo,
+                                  int hi,
+                                  int axis,
+                                  float bin_min,
+                                  float bin_scale,
+                                  int split_bin,
+                                  BBC *prim_bbc)
+{
+  int i = lo, j = hi;
+  for (;;) {
+    for (; i <= j && build_bin_index(bin_min,
+                                     bin_scale,
+                                     prim_bbc[prim_indices[i]].bcentroid[axis]) < split_bin;
+         i++) {
+      /* pass */
+    }
+    for (; i <= j && build_bin_index(bin_min,
+                                     bin_scale,
+                                     prim_bbc[prim_indices[j]].bcentroid[axis]) >= split_bin;
+         j--) {
+      /* pass */
+    }
+
+    if (!(i < j)) {
+      return i;
+    }
+
+    SWAP(int, prim_indices[i], prim_indices[j]);
+    i++;
+    j--;
+  }
+}
+
 /* Returns the index of the first element on the right of the partition */
 static int partition_indices_material(PBVH *bvh, int lo, int hi)
 {
@@ -252,53 +306,36 @@ void pbvh_grow_nodes(PBVH *bvh, int totnode)
   bvh->totnode = totnode;
 }
 
-/* Add a vertex to the map, with a positive value for unique vertices and
- * a negative value for additional vertices */
-static int map_insert_vert(
-    PBVH *bvh, GHash *map, unsigned int *face_verts, unsigned int *uniq_verts, int vertex)
-{
-  void *key, **value_p;
-
-  key = POINTER_FROM_INT(vertex);
-  if (!BLI_ghash_ensure_p(map, key, &value_p)) {
-    int value_i;
-    if (BLI_BITMAP_TEST(bvh->vert_bitmap, vertex) == 0) {
-      BLI_BITMAP_ENABLE(bvh->vert_bitmap, vertex);
-      value_i = *uniq_verts;
-      (*uniq_verts)++;
-    }
-    else {
-      value_i = ~(*face_verts);
-      (*face_verts)++;
-    }
-    *value_p = POINTER_FROM_INT(value_i);
-    return value_i;
-  }
-  else {
-    return POINTER_AS_INT(*value_p);
-  }
-}
-
-/* Find vertices used by the faces in this node and update the draw buffers */
+/* Find vertices used by the faces in this node, in the order of their first
+ * use, and update the draw buffers.
+ *
+ * Which of the vertices are unique to the node is decided afterwards, see
+ * build_mesh_leaf_node_claim_verts(). */
 static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node)
 {
   bool has_visible = false;
 
-  node->uniq_verts = node->face_verts = 0;
   const int totface = node->totprim;
 
   /* reserve size is rough guess */
   GHash *map = BLI_ghash_int_new_ex("build_mesh_leaf_node gh", 2 * totface);
 
   int(*face_vert_indices)[3] = MEM_mallocN(sizeof(int[3]) * totface, "bvh node face vert indices");
+  int *vert_indices = MEM_mallocN(sizeof(int) * 3 * totface, "bvh node vert indices");
+  int totvert = 0;
 
   node->face_vert_indices = (const int(*)[3])face_vert_indices;
 
   for (int i = 0; i < totface; ++i) {
     const MLoopTri *lt = &bvh->looptri[node->prim_indices[i]];
     for (int j = 0; j < 3; ++j) {
-      face_vert_indices[i][j] = map_insert_vert(
-          bvh, map, &node->face_verts, &node->uniq_verts, bvh->mloop[lt->tri[j]].v);
+      const int vertex = bvh->mloop[lt->tri[j]].v;
+      void **value_p;
+      if (!BLI_ghash_ensure_p(map, POINTER_FROM_INT(vertex), &value_p)) {
+        *value_p = POINTER_FROM_INT(totvert);
+        vert_indices[totvert++] = vertex;
+      }
+      face_vert_indices[i][j] = POINTER_AS_INT(*value_p);
     }
 
     if (!paint_is_face_hidden(lt, bvh->verts, bvh->mloop)) {
@@ -306,47 +343,73 @@ static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node)
     }
   }
 
-  int *vert_indices = MEM_callocN(sizeof(int) * (node->uniq_verts + node->face_verts),
-                                  "bvh node vert indices");
   node->vert_indices = vert_indices;
+  node->uniq_verts = totvert;
+  node->face_verts = 0;
 
-  /* Build the vertex list, unique verts first */
-  GHashIterator gh_iter;
-  GHASH_ITER (gh_iter, map) {
-    void *value = BLI_ghashIterator_getValue(&gh_iter);
-    int ndx = POINTER_AS_INT(value);
+  BKE_pbvh_node_mark_rebuild_draw(node);
 
-    if (ndx < 0) {
-      ndx = -ndx + node->uniq_verts - 1;
-    }
+  BKE_pbvh_node_fully_hidden_set(node, !has_visible);
 
-    vert_indices[ndx] = POINTER_AS_INT(BLI_ghashIterator_getKey(&gh_iter));
-  }
+  BLI_ghash_free(map, NULL, NULL);
+}
 
-  for (int i = 0; i < totface; ++i) {
-    const int sides = 3;
+/* Mark vertices of the node which are not used by any of the nodes before it
+ * as unique to it, other vertices are stored negated (bitwise). */
+static void build_mesh_leaf_node_claim_verts(PBVH *bvh, PBVHNode *node)
+{
+  int *vert_indices = (int *)node->vert_indices;
+  const int totvert = node->uniq_verts;
 
-    for (int j = 0; j < sides; ++j) {
-      if (face_vert_indices[i][j] < 0) {
-        face_vert_indices[i][j] = -face_vert_indices[i][j] + node->uniq_verts - 1;
-      }
+  node->uniq_verts = 0;
+  for (int i = 0; i < totvert; ++i) {
+    const int vertex = vert_indices[i];
+    if (BLI_BITMAP_TEST(bvh->vert_bitmap, vertex) == 0) {
+      BLI_BITMAP_ENABLE(bvh->vert_bitmap, vertex);
+      node->uniq_verts++;
+    }
+    else {
+      vert_indices[i] = ~vertex;
     }
   }
+  node->face_verts = totvert - node->uniq_verts;
+}
 
-  BKE_pbvh_node_mark_rebuild_draw(node);
+/* Build the vertex list of the node, unique verts first. */
+static void build_mesh_leaf_node_sort_verts(PBVHNode *node)
+{
+  const int totvert = node->uniq_verts + node->face_verts;
+  int *claimed_vert_indices = (int *)node->vert_indices;
+  int *vert_indices = MEM_mallocN(sizeof(int) * totvert, "bvh node vert indices");
+  int *vert_map = MEM_mallocN(sizeof(int) * totvert, __func__);
+  int uniq_vert = 0, face_vert = node->uniq_verts;
 
-  BKE_pbvh_node_fully_hidden_set(node, !has_visible);
+  for (int i = 0; i < totvert; ++i) {
+    const int vertex = claimed_vert_indices[i];
+    const int ndx = (vertex >= 0) ? uniq_vert++ : face_vert++;
+    vert_indices[ndx] = (vertex >= 0) ? vertex : ~vertex;
+    vert_map[i] = ndx;
+  }
 
-  BLI_ghash_free(map, NULL, NULL);
+  int(*face_vert_indices)[3] = (int(*)[3])node->face_vert_indices;
+  for (int i = 0; i < node->totprim; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      face_vert_indices[i][j] = vert_map[face_vert_indices[i][j]];
+    }
+  }
+
+  node->vert_indices = vert_indices;
+
+  MEM_freeN(vert_map);
+  MEM_freeN(claimed_vert_indices);
 }
 
-static void update_vb(PBVH *bvh, PBVHNode *node, BBC *prim_bbc, int offset, int count)
+static void update_vb(PBVH *bvh, BB *vb, BBC *prim_bbc, int offset, int count)
 {
-  BB_reset(&node->vb);
+  BB_reset(vb);
   for (int i = offset + count - 1; i >= offset; --i) {
-    BB_expand_with_bb(&node->vb, (BB *)(&prim_bbc[bvh->prim_indices[i]]));
+    BB_expand_with_bb(vb, (BB *)(&prim_bbc[bvh->prim_indices[i]]));
   }
-  node->orig_vb = node->vb;
 }
 
 /* Returns the number of visible quads in the nodes' grids. */
@@ -390,24 +453,6 @@ static void build_grid_leaf_node(PBVH *bvh, PBVHNode *node)
   BKE_pbvh_node_mark_rebuild_draw(node);
 }
 
-static void build_leaf(PBVH *bvh, int node_index, BBC *prim_bbc, int offset, int count)
-{
-  bvh->nodes[node_index].flag |= PBVH_Leaf;
-
-  bvh->nodes[node_index].prim_indices = bvh->prim_indices + offset;
-  bvh->nodes[node_index].totprim = count;
-
-  /* Still need vb for searches */
-  update_vb(bvh, &bvh->nodes[node_index], prim_bbc, offset, count);
-
-  if (bvh->looptri) {
-    build_mesh_leaf_node(bvh, bvh->nodes + node_index);
-  }
-  else {
-    build_grid_leaf_node(bvh, bvh->nodes + node_index);
-  }
-}
-
 /* Return zero if all primitives in the node can be drawn with the
  * same material (including flat/smooth shading), non-zero otherwise */
 static bool leaf_needs_material_split(PBVH *bvh, int offset, int count)
@@ -442,50 +487,268 @@ static bool leaf_needs_material_split(PBVH *bvh, int offset, int count)
   return false;
 }
 
+/* Node of the tree being built, the tree is built by tasks and stored in the
+ * PBVH nodes array once complete. A leaf has no children. */
+typedef struct PBVHBuildNode {
+  struct PBVHBuildNode *children[2];
+  /* Range in the array of primitive indices. */
+  int offset, count;
+  /* Voxel box around all of the primitives. */
+  BB vb;
+  /* Box around all centroids of the primitives, when known by the parent. */
+  BB cb;
+  bool has_cb;
+} PBVHBuildNode;
+
+typedef struct PBVHBuildContext {
+  PBVH *bvh;
+  BBC *prim_bbc;
+  /* NULL if the tree is small enough to be built by a single thread. */
+  TaskPool *task_pool;
+} PBVHBuildContext;
+
+/* Primitives of a node sorted into bins along every axis, by their centroids.
+ * Splits between bins are evaluated using surface area heuristic. */
+typedef struct PBVHBuildBin {
+  BB bb;
+  BB cb;
+  int count;
+} PBVHBuildBin;
+
+typedef struct PBVHBuildBins {
+  PBVHBuildBin bins[3][PBVH_BUILD_BINS];
+} PBVHBuildBins;
+
+typedef struct PBVHBuildBinsData {
+  PBVH *bvh;
+  BBC *prim_bbc;
+  int offset;
+  float bin_min[3];
+  float bin_scale[3];
+  /* Bins of all primitives and the initial bins of every chunk of them. */
+  PBVHBuildBins bins;
+  PBVHBuildBins bins_chunk;
+} PBVHBuildBinsData;
+
+static void build_bins_reset(PBVHBuildBins *bins)
+{
+  for (int axis = 0; axis < 3; axis++) {
+    for (int i = 0; i < PBVH_BUILD_BINS; i++) {
+      BB_reset(&bins->bins[axis][i].bb);
+      BB_reset(&bins->bins[axis][i].cb);
+      bins->bins[axis][i].count = 0;
+    }
+  }
+}
+
+static void build_bins_task_cb(void *__restrict userdata,
+                               const int n,
+                               const TaskParallelTLS *__restrict tls)
+{
+  PBVHBuildBinsData *data = userdata;
+  PBVHBuildBins *bins = tls->userdata_chunk;
+  BBC *bbc = &data->prim_bbc[data->bvh->prim_indices[data->offset + n]];
+
+  for (int axis = 0; axis < 3; axis++) {
+    PBVHBuildBin *bin = &bins->bins[axis][build_bin_index(
+        data->bin_min[axis], data->bin_scale[axis], bbc->bcentroid[axis])];
+    BB_expand_with_bb(&bin->bb, (BB *)bbc);
+    BB_expand(&bin->cb, bbc->bcentroid);
+    bin->count++;
+  }
+}
+
+static void build_bins_finalize(void *__restrict userdata, void *__restrict userdata_chunk)
+{
+  PBVHBuildBinsData *data = userdata;
+  PBVHBuildBins *bins = userdata_chunk;
+
+  for (int axis = 0; axis < 3; axis++) {
+    for (int i = 0; i < PBVH_BUILD_BINS; i++) {
+      PBVHBuildBin *bin = &data->bins.bins[axis][i];
+      BB_expand_with_bb(&bin->bb, &bins->bins[axis][i].bb);
+      BB_expand_with_bb(&bin->cb, &bins->bins[axis][i].cb);
+      bin->count += bins->bins[axis][i].count;
+    }
+  }
+}
+
+static float build_bb_half_area(const BB *bb)
+{
+  float dim[3];
+  sub_v3_v3v3(dim, bb->bmax, bb->bmin);
+  return dim[0] * dim[1] + dim[1] * dim[2] + dim[2] * dim[0];
+}
+
+/* Find the split between bins with the lowest surface area heuristic cost,
+ * returns false if all centroids are in a single bin along every axis. */
+static bool build_bins_best_split(const PBVHBuildBins *bins, int *r_axis, int *r_split_bin)
+{
+  float best_cost = FLT_MAX;
+  bool found = false;
+
+  for (int axis = 0; axis < 3; axis++) {
+    const PBVHBuildBin *axis_bins = bins->bins[axis];
+    float right_area[PBVH_BUILD_BINS];
+    int right_count[PBVH_BUILD_BINS];
+    BB bb;
+    int count = 0;
+
+    BB_reset(&bb);
+    for (int i = PBVH_BUILD_BINS - 1; i > 0; i--) {
+      BB_expand_with_bb(&bb, (BB *)&axis_bins[i].bb);
+      count += axis_bins[i].count;
+      right_area[i] = build_bb_half_area(&bb);
+      right_count[i] = count;
+    }
+
+    BB_reset(&bb);
+    count = 0;
+    for (int i = 1; i < PBVH_BUILD_BINS; i++) {
+      BB_expand_with_bb(&bb, (BB *)&axis_bins[i - 1].bb);
+      count += axis_bins[i - 1].count;
+      if (count == 0 || right_count[i] == 0) {
+        continue;
+      }
+      const float cost = build_bb_half_area(&bb) * count + right_area[i] * right_count[i];
+      if (cost < best_cost) {
+        best_cost = cost;
+        *r_axis = axis;
+        *r_split_bin = i;
+        found = true;
+      }
+    }
+  }
+
+  return found;
+}
+
+static void build_node(PBVHBuildContext *ctx, PBVHBuildNode *node, int threadid);
+
+static void build_node_task_cb(TaskPool *__restrict pool, void *taskdata, int threadid)
+{
+  build_node(BLI_task_pool_userdata(pool), taskdata, threadid);
+}
+
+static void build_child_node(PBVHBuildContext *ctx,
+                             PBVHBuildNode *node,
+                             int child,
+                             int offset,
+                             int count,
+                             const BB *cb,
+                             int threadid)
+{
+  PBVHBuildNode *child_node = MEM_callocN(sizeof(PBVHBuildNode), "PBVHBuildNode");
+  child_node->offset = offset;
+  child_node->count = count;
+  if (cb != NULL) {
+    child_node->cb = *cb;
+    child_node->has_cb = true;
+  }
+  node->children[child] = child_node;
+
+  /* Large sub-trees are built by separate tasks, all nodes write to their own
+   * range of primitive indices. */
+  if (ctx->task_pool != NULL && count > ctx->bvh->leaf_limit * PBVH_BUILD_TASK_LEAVES) {
+    BLI_task_pool_push_from_thread(
+        ctx->task_pool, build_node_task_cb, child_node, false, TASK_PRIORITY_HIGH, threadid);
+  }
+  else {
+    build_node(ctx, child_node, threadid);
+  }
+}
+
 /* Recursively build a node in the tree
  *
- * vb is the voxel box around all of the primitives contained in
- * this node.
- *
- * cb is the bounding box around all the centroids of the primitives
- * contained in this node
- *
- * offset and start indicate a range in the array of primitive indices
+ * Nodes above the leaf limit are split where the surface area heuristic
+ * cost is the lowest, nodes below it are only split by material.
  */
 
-static void build_sub(PBVH *bvh, int node_index, BB *cb, BBC *prim_bbc, int offset, int count)
+static void build_node(PBVHBuildContext *ctx, PBVHBuildNode *node, int threadid)
 {
+  PBVH *bvh = ctx->bvh;
+  BBC *prim_bbc = ctx->prim_bbc;
+  const int offset = node->offset;
+  const int count = node->count;
   int end;
-  BB cb_backing;
 
   /* Decide whether this is a leaf or not */
   const bool below_leaf_limit = count <= bvh->leaf_limit;
   if (below_leaf_limit) {
+    /* Still need vb for searches */
+    update_vb(bvh, &node->vb, prim_bbc, offset, count);
+
     if (!leaf_needs_material_split(bvh, offset, count)) {
-      build_leaf(bvh, node_index, prim_bbc, offset, count);
       return;
     }
-  }
 
-  /* Add two child nodes */
-  bvh->nodes[node_index].children_offset = bvh->totnode;
-  pbvh_grow_nodes(bvh, bvh->totnode + 2);
+    /* Partition primitives by material */
+    end = partition_indices_material(bvh, offset, offset + count - 1);
+    build_child_node(ctx, node, 0, offset, end - offset, NULL, threadid);
+    build_child_node(ctx, node, 1, end, offset + count - end, NULL, threadid);
+    return;
+  }
 
-  /* Update parent node bounding box */
-  update_vb(bvh, &bvh->nodes[node_index], prim_bbc, offset, count);
-
-  if (!below_leaf_limit) {
-    /* Find axis with widest range of primitive centroids */
-    if (!cb) {
-      cb = &cb_backing;
-      BB_reset(cb);
-      for (int i = offset + count - 1; i >= offset; --i) {
-        BB_expand(cb, prim_bbc[bvh->prim_indices[i]].bcentroid);
-      }
+  if (!node->has_cb) {
+    BB_reset(&node->cb);
+    for (int i = offset + count - 1; i >= offset; --i) {
+      BB_expand(&node->cb, prim_bbc[bvh->prim_indices[i]].bcentroid);
     }
-    const int axis = BB_widest_axis(cb);
+  }
+  const BB *cb = &node->cb;
+
+  /* Sort primitives into bins along every axis, bins are too large to be
+   * kept on the stack of recursive tasks. */
+  PBVHBuildBinsData *data = MEM_mallocN(sizeof(PBVHBuildBinsData), __func__);
+  data->bvh = bvh;
+  data->prim_bbc = prim_bbc;
+  data->offset = offset;
+  for (int axis = 0; axis < 3; axis++) {
+    const float extent = cb->bmax[axis] - cb->bmin[axis];
+    data->bin_min[axis] = cb->bmin[axis];
+    data->bin_scale[axis] = (extent > 0.0f) ? PBVH_BUILD_BINS / extent : 0.0f;
+  }
+  build_bins_reset(&data->bins);
+  build_bins_reset(&data->bins_chunk);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (count > bvh->leaf_limit * PBVH_BUILD_THREADED_BINS_LEAVES);
+  settings.userdata_chunk = &data->bins_chunk;
+  settings.userdata_chunk_size = sizeof(data->bins_chunk);
+  settings.func_finalize = build_bins_finalize;
+  BLI_task_parallel_range(0, count, data, build_bins_task_cb, &settings);
 
-    /* Partition primitives along that axis */
+  /* Update parent node bounding box */
+  BB_reset(&node->vb);
+  for (int i = 0; i < PBVH_BUILD_BINS; i++) {
+    BB_expand_with_bb(&node->vb, &data->bins.bins[0][i].bb);
+  }
+
+  int axis, split_bin;
+  BB children_cb[2];
+  const bool use_bins = build_bins_best_split(&data->bins, &axis, &split_bin);
+  if (use_bins) {
+    /* Partition primitives between bins, bounds of centroids of both sides
+     * are known from the bins. */
+    BB_reset(&children_cb[0]);
+    BB_reset(&children_cb[1]);
+    for (int i = 0; i < PBVH_BUILD_BINS; i++) {
+      BB_expand_with_bb(&children_cb[i >= split_bin], &data->bins.bins[axis][i].cb);
+    }
+
+    end = partition_indices_bins(bvh->prim_indices,
+                                 offset,
+                                 offset + count - 1,
+                                 axis,
+                                 data->bin_min[axis],
+                                 data->bin_scale[axis],
+                                 split_bin,
+                                 prim_bbc);
+  }
+  else {
+    /* All centroids coincide, partition primitives at the middle of them */
+    axis = BB_widest_axis(cb);
     end = partition_indices(bvh->prim_indices,
                             offset,
                             offset + count - 1,
@@ -493,15 +756,105 @@ static void build_sub(PBVH *bvh, int node_index, BB *cb, BBC *prim_bbc, int offs
                             (cb->bmax[axis] + cb->bmin[axis]) * 0.5f,
                             prim_bbc);
   }
+
+  MEM_freeN(data);
+
+  /* Build children */
+  build_child_node(
+      ctx, node, 0, offset, end - offset, use_bins ? &children_cb[0] : NULL, threadid);
+  build_child_node(
+      ctx, node, 1, end, offset + count - end, use_bins ? &children_cb[1] : NULL, threadid);
+}
+
+/* Store the built tree in PBVH nodes, in the same order as it would be built
+ * recursively by a single thread, and free it. */
+static void build_store_node(
+    PBVH *bvh, PBVHBuildNode *build_node, int node_index, int *r_leaves, int *r_totleaf)
+{
+  PBVHNode *node = &bvh->nodes[node_index];
+
+  node->vb = build_node->vb;
+  node->orig_vb = build_node->vb;
+
+  if (build_node->children[0] == NULL) {
+    node->flag |= PBVH_Leaf;
+    node->prim_indices = bvh->prim_indices + build_node->offset;
+    node->totprim = build_node->count;
+    r_leaves[(*r_totleaf)++] = node_index;
+  }
   else {
-    /* Partition primitives by material */
-    end = partition_indices_material(bvh, offset, offset + count - 1);
+    /* Add two child nodes */
+    const int children_offset = bvh->totnode;
+    node->children_offset = children_offset;
+    pbvh_grow_nodes(bvh, bvh->totnode + 2);
+
+    build_store_node(bvh, build_node->children[0], children_offset, r_leaves, r_totleaf);
+    build_store_node(bvh, build_node->children[1], children_offset + 1, r_leaves, r_totleaf);
   }
 
-  /* Build children */
-  build_sub(bvh, bvh->nodes[node_index].children_offset, NULL, prim_bbc, offset, end - offset);
-  build_sub(
-      bvh, bvh->nodes[node_index].children_offset + 1, NULL, prim_bbc, end, offset + count - end);
+  MEM_freeN(build_node);
+}
+
+static int build_count_nodes(const PBVHBuildNode *build_node)
+{
+  if (build_node->children[0] == NULL) {
+    return 1;
+  }
+  return 1 + build_count_nodes(build_node->children[0]) +
+         build_count_nodes(build_node->children[1]);
+}
+
+typedef struct PBVHBuildLeavesData {
+  PBVH *bvh;
+  const int *leaves;
+} PBVHBuildLeavesData;
+
+static void build_mesh_leaf_node_task_cb(void *__restrict userdata,
+                                         const int n,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  build_mesh_leaf_node(data->bvh, &data->bvh->nodes[data->leaves[n]]);
+}
+
+static void build_mesh_leaf_node_sort_verts_task_cb(void *__restrict userdata,
+                                                    const int n,
+                                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  build_mesh_leaf_node_sort_verts(&data->bvh->nodes[data->leaves[n]]);
+}
+
+static void build_grid_leaf_node_task_cb(void *__restrict userdata,
+                                         const int n,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  build_grid_leaf_node(data->bvh, &data->bvh->nodes[data->leaves[n]]);
+}
+
+static void build_leaves(PBVH *bvh, const int *leaves, int totleaf)
+{
+  PBVHBuildLeavesData data = {
+      .bvh = bvh,
+      .leaves = leaves,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (totleaf > PBVH_THREADED_LIMIT);
+
+  if (bvh->looptri) {
+    BLI_task_parallel_range(0, totleaf, &data, build_mesh_leaf_node_task_cb, &settings);
+    /* Vertices belong to the first node which uses them, in build order. */
+    for (int i = 0; i < totleaf; i++) {
+      build_mesh_leaf_node_claim_verts(bvh, &bvh->nodes[leaves[i]]);
+    }
+    BLI_task_parallel_range(0, totleaf, &data, build_mesh_leaf_node_sort_verts_task_cb, &settings);
+  }
+  else {
+    BLI_task_parallel_range(0, totleaf, &data, build_grid_leaf_node_task_cb, &settings);
+  }
 }
 
 static void pbvh_build(PBVH *bvh, BB *cb, BBC *prim_bbc, int totprim)
@@ -525,8 +878,111 @@ static void pbvh_build(PBVH *bvh, BB *cb, BBC *prim_bbc, int totprim)
     }
   }
 
+  PBVHBuildContext ctx = {
+      .bvh = bvh,
+      .prim_bbc = prim_bbc,
+  };
+  PBVHBuildNode *root = MEM_callocN(sizeof(PBVHBuildNode), "PBVHBuildNode");
+  root->offset = 0;
+  root->count = totprim;
+  if (cb) {
+    root->cb = *cb;
+    root->has_cb = true;
+  }
+
+  if (totprim > bvh->leaf_limit * PBVH_BUILD_TASK_LEAVES) {
+    TaskScheduler *scheduler = BLI_task_scheduler_get();
+    ctx.task_pool = BLI_task_pool_create(scheduler, &ctx);
+    BLI_task_pool_push(ctx.task_pool, build_node_task_cb, root, false, TASK_PRIORITY_HIGH);
+    BLI_task_pool_work_and_wait(ctx.task_pool);
+    BLI_task_pool_free(ctx.task_pool);
+  }
+  else {
+    build_node(&ctx, root, 0);
+  }
+
+  /* Nodes are only allocated once the tree is complete, so that they are not
+   * reallocated while tasks write to them. */
+  const int totnode = build_count_nodes(root);
+  int *leaves = MEM_mallocN(sizeof(int) * totnode, __func__);
+  int totleaf = 0;
+  pbvh_grow_nodes(bvh, totnode);
   bvh->totnode = 1;
-  build_sub(bvh, 0, cb, prim_bbc, 0, totprim);
+  build_store_node(bvh, root, 0, leaves, &totleaf);
+  BLI_assert(bvh->totnode == totnode);
+
+  build_leaves(bvh, leaves, totleaf);
+
+  MEM_freeN(leaves);
+}
+
+typedef struct PBVHPrimBBCData {
+  PBVH *bvh;
+  BBC *prim_bbc;
+  /* Box around all centroids of primitives. */
+  BB *cb;
+} PBVHPrimBBCData;
+
+static void pbvh_mesh_prim_bbc_task_cb(void *__restrict userdata,
+                                       const int n,
+                                       const TaskParallelTLS *__restrict tls)
+{
+  PBVHPrimBBCData *data = userdata;
+  PBVH *bvh = data->bvh;
+  const MLoopTri *lt = &bvh->looptri[n];
+  const int sides = 3;
+  BBC *bbc = data->prim_bbc + n;
+
+  BB_reset((BB *)bbc);
+
+  for (int j = 0; j < sides; ++j) {
+    BB_expand((BB *)bbc, bvh->verts[bvh->mloop[lt->tri[j]].v].co);
+  }
+
+  BBC_update_centroid(bbc);
+
+  BB_expand(tls->userdata_chunk, bbc->bcentroid);
+}
+
+static void pbvh_grid_prim_bbc_task_cb(void *__restrict userdata,
+                                       const int n,
+                                       const TaskParallelTLS *__restrict tls)
+{
+  PBVHPrimBBCData *data = userdata;
+  PBVH *bvh = data->bvh;
+  const CCGKey *key = &bvh->gridkey;
+  CCGElem *grid = bvh->grids[n];
+  BBC *bbc = data->prim_bbc + n;
+
+  BB_reset((BB *)bbc);
+
+  for (int j = 0; j < key->grid_size * key->grid_size; ++j) {
+    BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
+  }
+
+  BBC_update_centroid(bbc);
+
+  BB_expand(tls->userdata_chunk, bbc->bcentroid);
+}
+
+static void pbvh_prim_bbc_finalize(void *__restrict userdata, void *__restrict userdata_chunk)
+{
+  PBVHPrimBBCData *data = userdata;
+  BB_expand_with_bb(data->cb, userdata_chunk);
+}
+
+static void pbvh_prim_bbc_calc(PBVHPrimBBCData *data, int totprim, TaskParallelRangeFunc func)
+{
+  BB cb_chunk;
+  BB_reset(&cb_chunk);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (totprim > data->bvh->leaf_limit);
+  settings.userdata_chunk = &cb_chunk;
+  settings.userdata_chunk_size = sizeof(cb_chunk);
+  settings.func_finalize = pbvh_prim_bbc_finalize;
+  BLI_task_parallel_range(0, totprim, data, func, &settings);
 }
 
 /**
@@ -564,21 +1020,12 @@ void BKE_pbvh_build_mesh(PBVH *bvh,
   /* For each face, store the AABB and the AABB centroid */
   prim_bbc = MEM_mallocN(sizeof(BBC) * looptri_num, "prim_bbc");
 
-  for (int i = 0; i < looptri_num; ++i) {
-    const MLoopTri *lt = &looptri[i];
-    const int sides = 3;
-    BBC *bbc = prim_bbc + i;
-
-    BB_reset((BB *)bbc);
-
-    for (int j = 0; j < sides; ++j) {
-      BB_expand((BB *)bbc, verts[bvh->mloop[lt->tri[j]].v].co);
-    }
-
-    BBC_update_centroid(bbc);
-
-    BB_expand(&cb, bbc->bcentroid);
-  }
+  PBVHPrimBBCData data = {
+      .bvh = bvh,
+      .prim_bbc = prim_bbc,
+      .cb = &cb,
+  };
+  pbvh_prim_bbc_calc(&data, looptri_num, pbvh_mesh_prim_bbc_task_cb);
 
   if (looptri_num) {
     pbvh_build(bvh, &cb, prim_bbc, looptri_num);
@@ -614,20 +1061,12 @@ void BKE_pbvh_build_grids(PBVH *bvh,
   /* For each grid, store the AABB and the AABB centroid */
   BBC *prim_bbc = MEM_mallocN(sizeof(BBC) * totgrid, "prim_bbc");
 
-  for (int i = 0; i < totgrid; ++i) {
-    CCGElem *grid = grids[i];
-    BBC *bbc = prim_bbc + i;
-
-    BB_reset((BB *)bbc);
-
-    for (int j = 0; j < gridsize * gridsize; ++j) {
-      BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
-    }
-
-    BBC_update_centroid(bbc);
-
-    BB_expand(&cb, bbc->bcentroid);
-  }
+  PBVHPrimBBCData data = {
+      .bvh = bvh,
+      .prim_bbc = prim_bbc,
+      .cb = &cb,
+  };
+  pbvh_prim_bbc_calc(&data, totgrid, pbvh_grid_prim_bbc_task_cb);
 
   if (totgrid) {
     pbvh_build(bvh, &cb, prim_bbc, totgrid);
@@ -2414,6 +2853,18 @@ bool BKE_pbvh_is_deformed(PBVH *pbvh)
 {
   return pbvh->deformed;
 }
+
+/**
+ * Vertices of the mesh moved to another array (when they stopped being shared for example),
+ * only used when PBVH is not deformed, otherwise it has its own copy of them.
+ */
+void BKE_pbvh_mesh_verts_update(PBVH *pbvh, MVert *verts)
+{
+  BLI_assert(pbvh->type == PBVH_FACES);
+  if (!pbvh->deformed) {
+    pbvh->verts = verts;
+  }
+}
 /* Proxies */
 
 PBVHProxyNode *BKE_pbvh_node_add_proxy(PBVH *bvh, PBVHNode *node)
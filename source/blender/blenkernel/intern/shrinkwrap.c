@@ -109,8 +109,12 @@ bool BKE_shrinkwrap_needs_normals(int shrinkType, int shrinkMode)
 }
 
 /* Initializes the mesh data structure from the given mesh and settings. */
-bool BKE_shrinkwrap_init_tree(
-    ShrinkwrapTreeData *data, Mesh *mesh, int shrinkType, int shrinkMode, bool force_normals)
+bool BKE_shrinkwrap_init_tree(ShrinkwrapTreeData *data,
+                              Object *ob,
+                              Mesh *mesh,
+                              int shrinkType,
+                              int shrinkMode,
+                              bool force_normals)
 {
   memset(data, 0, sizeof(*data));
 
@@ -121,7 +125,8 @@ bool BKE_shrinkwrap_init_tree(
   data->mesh = mesh;
 
   if (shrinkType == MOD_SHRINKWRAP_NEAREST_VERTEX) {
-    data->bvh = BKE_bvhtree_from_mesh_get(&data->treeData, mesh, BVHTREE_FROM_VERTS, 2);
+    data->bvh = BKE_bvhtree_from_object_mesh_get(
+        &data->treeData, ob, mesh, BVHTREE_FROM_VERTS, 2);
 
     return data->bvh != NULL;
   }
@@ -130,7 +135,8 @@ bool BKE_shrinkwrap_init_tree(
       return false;
     }
 
-    data->bvh = BKE_bvhtree_from_mesh_get(&data->treeData, mesh, BVHTREE_FROM_LOOPTRI, 4);
+    data->bvh = BKE_bvhtree_from_object_mesh_get(
+        &data->treeData, ob, mesh, BVHTREE_FROM_LOOPTRI, 4);
 
     if (data->bvh == NULL) {
       return false;
@@ -690,8 +696,12 @@ static void shrinkwrap_calc_normal_projection(ShrinkwrapCalcData *calc)
     BLI_SPACE_TRANSFORM_SETUP(&local2aux, calc->ob, calc->aux_target);
   }
 
-  if (BKE_shrinkwrap_init_tree(
-          &aux_tree_stack, auxMesh, calc->smd->shrinkType, calc->smd->shrinkMode, false)) {
+  if (BKE_shrinkwrap_init_tree(&aux_tree_stack,
+                               calc->aux_target,
+                               auxMesh,
+                               calc->smd->shrinkType,
+                               calc->smd->shrinkMode,
+                               false)) {
     aux_tree = &aux_tree_stack;
   }
 
@@ -1404,8 +1414,9 @@ void shrinkwrapModifier_deform(ShrinkwrapModifierData *smd,
   calc.vgroup = defgrp_index;
   calc.invert_vgroup = (smd->shrinkOpts & MOD_SHRINKWRAP_INVERT_VGROUP) != 0;
 
+  Object *ob_target = NULL;
   if (smd->target != NULL) {
-    Object *ob_target = DEG_get_evaluated_object(ctx->depsgraph, smd->target);
+    ob_target = DEG_get_evaluated_object(ctx->depsgraph, smd->target);
     calc.target = BKE_modifier_get_evaluated_mesh_from_evaluated_object(ob_target, false);
 
     /* TODO there might be several "bugs" on non-uniform scales matrixs
@@ -1454,7 +1465,8 @@ void shrinkwrapModifier_deform(ShrinkwrapModifierData *smd,
   /* Projecting target defined - lets work! */
   ShrinkwrapTreeData tree;
 
-  if (BKE_shrinkwrap_init_tree(&tree, calc.target, smd->shrinkType, smd->shrinkMode, false)) {
+  if (BKE_shrinkwrap_init_tree(
+          &tree, ob_target, calc.target, smd->shrinkType, smd->shrinkMode, false)) {
     calc.tree = &tree;
 
     switch (smd->shrinkType) {
@@ -233,6 +233,40 @@ void BKE_subdiv_eval_final_point(
   }
 }
 
+/* ============================= Limit stencils ============================= */
+
+bool BKE_subdiv_eval_limit_stencils_create(Subdiv *subdiv,
+                                           const int num_points,
+                                           const int *ptex_face_indices,
+                                           const float *u,
+                                           const float *v)
+{
+  if (subdiv->evaluator == NULL) {
+    return false;
+  }
+  return subdiv->evaluator->createLimitStencils(
+      subdiv->evaluator, subdiv->topology_refiner, num_points, ptex_face_indices, u, v);
+}
+
+void BKE_subdiv_eval_limit_stencils(Subdiv *subdiv,
+                                    const Mesh *mesh,
+                                    const int start_point,
+                                    const int num_points,
+                                    float (*r_P)[3],
+                                    float (*r_dPdu)[3],
+                                    float (*r_dPdv)[3])
+{
+  subdiv->evaluator->evaluateLimitStencils(subdiv->evaluator,
+                                           mesh->mvert,
+                                           offsetof(MVert, co),
+                                           sizeof(MVert),
+                                           start_point,
+                                           num_points,
+                                           r_P,
+                                           r_dPdu,
+                                           r_dPdv);
+}
+
 /* ===================  Patch queries at given resolution =================== */
 
 /* Move buffer forward by a given number of bytes. */
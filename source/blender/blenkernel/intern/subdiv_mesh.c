@@ -31,8 +31,11 @@
 
 #include "BLI_alloca.h"
 #include "BLI_math_vector.h"
+#include "BLI_stack.h"
+#include "BLI_task.h"
 
 #include "BKE_customdata.h"
+#include "BKE_library.h"
 #include "BKE_mesh.h"
 #include "BKE_key.h"
 #include "BKE_subdiv.h"
@@ -76,8 +79,27 @@ typedef struct SubdivMeshContext {
    * when it's not possible is when displacement is used. */
   bool can_evaluate_normals;
   bool have_displacement;
+  /* Limit surface points, gathered when the result is to be cached.
+   *
+   * Every subdivided vertex has a point it is evaluated at. Vertices on coarse
+   * edges and corners also have points on every adjacent ptex face, their
+   * normals are averaged from (stored as SubdivLimitNormalPoint). */
+  bool gather_limit_points;
+  int *limit_point_ptex_face_index;
+  float *limit_point_u;
+  float *limit_point_v;
+  struct BLI_Stack *limit_normal_points;
+  /* Loose geometry is not evaluated from the limit surface, so it can not be
+   * re-evaluated from the gathered points. */
+  bool have_loose_geometry;
 } SubdivMeshContext;
 
+typedef struct SubdivLimitNormalPoint {
+  int subdiv_vertex_index;
+  int ptex_face_index;
+  float u, v;
+} SubdivLimitNormalPoint;
+
 static void subdiv_mesh_ctx_cache_uv_layers(SubdivMeshContext *ctx)
 {
   Mesh *subdiv_mesh = ctx->subdiv_mesh;
@@ -113,10 +135,30 @@ static void subdiv_mesh_prepare_accumulator(SubdivMeshContext *ctx, int num_vert
       sizeof(*ctx->accumulated_counters), num_vertices, "subdiv accumulated counters");
 }
 
+static void subdiv_mesh_prepare_limit_points(SubdivMeshContext *ctx, int num_vertices)
+{
+  if (!ctx->gather_limit_points) {
+    return;
+  }
+  ctx->limit_point_ptex_face_index = MEM_malloc_arrayN(
+      num_vertices, sizeof(*ctx->limit_point_ptex_face_index), "subdiv limit ptex faces");
+  ctx->limit_point_u = MEM_malloc_arrayN(
+      num_vertices, sizeof(*ctx->limit_point_u), "subdiv limit u");
+  ctx->limit_point_v = MEM_malloc_arrayN(
+      num_vertices, sizeof(*ctx->limit_point_v), "subdiv limit v");
+  ctx->limit_normal_points = BLI_stack_new(sizeof(SubdivLimitNormalPoint), __func__);
+}
+
 static void subdiv_mesh_context_free(SubdivMeshContext *ctx)
 {
   MEM_SAFE_FREE(ctx->accumulated_normals);
   MEM_SAFE_FREE(ctx->accumulated_counters);
+  MEM_SAFE_FREE(ctx->limit_point_ptex_face_index);
+  MEM_SAFE_FREE(ctx->limit_point_u);
+  MEM_SAFE_FREE(ctx->limit_point_v);
+  if (ctx->limit_normal_points != NULL) {
+    BLI_stack_free(ctx->limit_normal_points);
+  }
 }
 
 /* =============================================================================
@@ -486,6 +528,24 @@ static void subdiv_accumulate_vertex_normal_and_displacement(SubdivMeshContext *
     add_v3_v3(subdiv_vert->co, D);
   }
   ++ctx->accumulated_counters[subdiv_vertex_index];
+  /* NOTE: Every corner and edge vertices are traversed from a single thread. */
+  if (ctx->gather_limit_points) {
+    const SubdivLimitNormalPoint point = {subdiv_vertex_index, ptex_face_index, u, v};
+    BLI_stack_push(ctx->limit_normal_points, &point);
+  }
+}
+
+static void subdiv_mesh_limit_point_set(const SubdivMeshContext *ctx,
+                                        const int subdiv_vertex_index,
+                                        const int ptex_face_index,
+                                        const float u,
+                                        const float v)
+{
+  if (ctx->gather_limit_points) {
+    ctx->limit_point_ptex_face_index[subdiv_vertex_index] = ptex_face_index;
+    ctx->limit_point_u[subdiv_vertex_index] = u;
+    ctx->limit_point_v[subdiv_vertex_index] = v;
+  }
 }
 
 /* =============================================================================
@@ -508,6 +568,7 @@ static bool subdiv_mesh_topology_info(const SubdivForeachContext *foreach_contex
       subdiv_context->coarse_mesh, num_vertices, num_edges, 0, num_loops, num_polygons, mask);
   subdiv_mesh_ctx_cache_custom_data_layers(subdiv_context);
   subdiv_mesh_prepare_accumulator(subdiv_context, num_vertices);
+  subdiv_mesh_prepare_limit_points(subdiv_context, num_vertices);
   return true;
 }
 
@@ -673,6 +734,7 @@ static void subdiv_mesh_vertex_corner(const SubdivForeachContext *foreach_contex
   MVert *subdiv_vert = &subdiv_mvert[subdiv_vertex_index];
   evaluate_vertex_and_apply_displacement_copy(
       ctx, ptex_face_index, u, v, coarse_vert, subdiv_vert);
+  subdiv_mesh_limit_point_set(ctx, subdiv_vertex_index, ptex_face_index, u, v);
 }
 
 static void subdiv_mesh_ensure_vertex_interpolation(SubdivMeshContext *ctx,
@@ -724,6 +786,7 @@ static void subdiv_mesh_vertex_edge(const SubdivForeachContext *foreach_context,
   subdiv_mesh_ensure_vertex_interpolation(ctx, tls, coarse_poly, coarse_corner);
   evaluate_vertex_and_apply_displacement_interpolate(
       ctx, ptex_face_index, u, v, &tls->vertex_interpolation, subdiv_vert);
+  subdiv_mesh_limit_point_set(ctx, subdiv_vertex_index, ptex_face_index, u, v);
 }
 
 static bool subdiv_mesh_is_center_vertex(const MPoly *coarse_poly, const float u, const float v)
@@ -774,6 +837,7 @@ static void subdiv_mesh_vertex_inner(const SubdivForeachContext *foreach_context
   eval_final_point_and_vertex_normal(
       subdiv, ptex_face_index, u, v, subdiv_vert->co, subdiv_vert->no);
   subdiv_mesh_tag_center_vertex(coarse_poly, subdiv_vert, u, v);
+  subdiv_mesh_limit_point_set(ctx, subdiv_vertex_index, ptex_face_index, u, v);
 }
 
 /* =============================================================================
@@ -970,6 +1034,7 @@ static void subdiv_mesh_vertex_loose(const SubdivForeachContext *foreach_context
   MVert *subdiv_mvert = subdiv_mesh->mvert;
   MVert *subdiv_vertex = &subdiv_mvert[subdiv_vertex_index];
   subdiv_vertex_data_copy(ctx, coarse_vertex, subdiv_vertex);
+  ctx->have_loose_geometry = true;
 }
 
 /* Get neighbor edges of the given one.
@@ -1092,6 +1157,7 @@ static void subdiv_mesh_vertex_of_loose_edge(const struct SubdivForeachContext *
   Mesh *subdiv_mesh = ctx->subdiv_mesh;
   MVert *subdiv_mvert = subdiv_mesh->mvert;
   const bool is_simple = ctx->subdiv->settings.is_simple;
+  ctx->have_loose_geometry = true;
   /* Find neighbors of the current loose edge. */
   const MEdge *neighbors[2];
   find_edge_neighbors(ctx, coarse_edge, neighbors);
@@ -1153,12 +1219,373 @@ static void setup_foreach_callbacks(const SubdivMeshContext *subdiv_context,
 }
 
 /* =============================================================================
- * Public entry point.
+ * Result cache.
  */
 
-Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
-                         const SubdivToMeshSettings *settings,
-                         const Mesh *coarse_mesh)
+/* Number of subdivided vertices evaluated at once from the cache. */
+#define CACHE_BLOCK_SIZE 256
+
+/* Custom data layer of the coarse mesh, which the cache was created for. */
+typedef struct SubdivCoarseLayer {
+  int type;
+  /* Data of the layer, which is referenced from the base mesh. */
+  const void *data;
+  /* Copy of original indices, which are re-created by the modifier stack for
+   * every evaluation, so they are compared by value. */
+  int *origindex;
+} SubdivCoarseLayer;
+
+typedef struct SubdivCoarseData {
+  int totelem;
+  int totlayer;
+  SubdivCoarseLayer *layers;
+} SubdivCoarseData;
+
+typedef struct SubdivMeshCache {
+  /* Settings and meshes the cache was created for. */
+  int resolution;
+  bool use_optimal_display;
+  bool use_limit_stencils;
+  uint64_t base_mesh_copy_stamp;
+  SubdivCoarseData vdata, edata, ldata, pdata;
+  /* Subdivided mesh, only vertex coordinates and normals of which change when
+   * evaluated for new coarse positions. Everything else (edges, loops, polys
+   * and all interpolated custom data) is shared with the results.
+   *
+   * NULL until a coarse mesh which only differs in vertex positions is
+   * subdivided, static meshes or ones with changing topology do not pay for
+   * keeping it. */
+  Mesh *mesh;
+  /* The first num_vertices limit surface points are the ones subdivided
+   * vertices are evaluated at.
+   *
+   * They are followed by points normals of vertices on coarse edges and
+   * corners are averaged from, the ones of a vertex are in range
+   * [normal_points_offset[vertex], normal_points_offset[vertex + 1]) after
+   * num_vertices. */
+  int num_vertices;
+  int *normal_points_offset;
+  /* Points are evaluated from limit stencils when they were created,
+   * otherwise from their ptex face coordinates (which are NULL then). */
+  bool has_stencils;
+  int *point_ptex_face_index;
+  float *point_u;
+  float *point_v;
+} SubdivMeshCache;
+
+static bool custom_data_has_layer_data(const CustomData *data, const int type, const void *ptr)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    if (data->layers[i].type == type && data->layers[i].data == ptr) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool subdiv_coarse_data_init(SubdivCoarseData *coarse_data,
+                                    const CustomData *data,
+                                    const CustomData *base_data,
+                                    const int totelem)
+{
+  coarse_data->totelem = totelem;
+  coarse_data->totlayer = data->totlayer;
+  coarse_data->layers = MEM_calloc_arrayN(
+      data->totlayer, sizeof(*coarse_data->layers), "subdiv coarse layers");
+  for (int i = 0; i < data->totlayer; i++) {
+    const CustomDataLayer *layer = &data->layers[i];
+    SubdivCoarseLayer *coarse_layer = &coarse_data->layers[i];
+    coarse_layer->type = layer->type;
+    if (layer->type == CD_MVERT) {
+      /* Coordinates are what changes, everything else is deformed along with
+       * the base mesh. */
+      continue;
+    }
+    if (layer->type == CD_ORIGINDEX) {
+      coarse_layer->origindex = MEM_dupallocN(layer->data);
+      continue;
+    }
+    if (!custom_data_has_layer_data(base_data, layer->type, layer->data)) {
+      return false;
+    }
+    coarse_layer->data = layer->data;
+  }
+  return true;
+}
+
+static bool subdiv_coarse_data_match(const SubdivCoarseData *coarse_data,
+                                     const CustomData *data,
+                                     const CustomData *base_data,
+                                     const int totelem)
+{
+  if (coarse_data->totelem != totelem || coarse_data->totlayer != data->totlayer) {
+    return false;
+  }
+  for (int i = 0; i < data->totlayer; i++) {
+    const CustomDataLayer *layer = &data->layers[i];
+    const SubdivCoarseLayer *coarse_layer = &coarse_data->layers[i];
+    if (coarse_layer->type != layer->type) {
+      return false;
+    }
+    if (layer->type == CD_MVERT) {
+      continue;
+    }
+    if (layer->type == CD_ORIGINDEX) {
+      if (coarse_layer->origindex == NULL || layer->data == NULL ||
+          memcmp(coarse_layer->origindex, layer->data, sizeof(int) * (size_t)totelem) != 0) {
+        return false;
+      }
+      continue;
+    }
+    /* The base mesh is known to be unchanged, data which is still referenced
+     * from it is the same. */
+    if (coarse_layer->data != layer->data ||
+        !custom_data_has_layer_data(base_data, layer->type, layer->data)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void subdiv_coarse_data_free(SubdivCoarseData *coarse_data)
+{
+  if (coarse_data->layers == NULL) {
+    return;
+  }
+  for (int i = 0; i < coarse_data->totlayer; i++) {
+    MEM_SAFE_FREE(coarse_data->layers[i].origindex);
+  }
+  MEM_freeN(coarse_data->layers);
+}
+
+static bool subdiv_mesh_cache_base_mesh_is_valid(const Mesh *base_mesh)
+{
+  /* Only copy-on-write meshes are guaranteed to get a new copy stamp when
+   * they change. */
+  return (base_mesh != NULL) && (base_mesh->id.tag & LIB_TAG_COPIED_ON_WRITE) &&
+         (base_mesh->runtime.copy_stamp != 0);
+}
+
+/* Returns NULL if custom data of the coarse mesh is not referenced from the
+ * base mesh. */
+static SubdivMeshCache *subdiv_mesh_cache_new(const SubdivToMeshSettings *settings,
+                                              const Mesh *coarse_mesh,
+                                              const Mesh *base_mesh,
+                                              const bool use_limit_stencils)
+{
+  if (!subdiv_mesh_cache_base_mesh_is_valid(base_mesh)) {
+    return NULL;
+  }
+  SubdivMeshCache *cache = MEM_callocN(sizeof(*cache), "subdiv mesh cache");
+  cache->resolution = settings->resolution;
+  cache->use_optimal_display = settings->use_optimal_display;
+  cache->use_limit_stencils = use_limit_stencils;
+  cache->base_mesh_copy_stamp = base_mesh->runtime.copy_stamp;
+  if (!subdiv_coarse_data_init(
+          &cache->vdata, &coarse_mesh->vdata, &base_mesh->vdata, coarse_mesh->totvert) ||
+      !subdiv_coarse_data_init(
+          &cache->edata, &coarse_mesh->edata, &base_mesh->edata, coarse_mesh->totedge) ||
+      !subdiv_coarse_data_init(
+          &cache->ldata, &coarse_mesh->ldata, &base_mesh->ldata, coarse_mesh->totloop) ||
+      !subdiv_coarse_data_init(
+          &cache->pdata, &coarse_mesh->pdata, &base_mesh->pdata, coarse_mesh->totpoly)) {
+    BKE_subdiv_mesh_cache_free(cache);
+    return NULL;
+  }
+  return cache;
+}
+
+static bool subdiv_mesh_cache_match(const SubdivMeshCache *cache,
+                                    const SubdivToMeshSettings *settings,
+                                    const Mesh *coarse_mesh,
+                                    const Mesh *base_mesh,
+                                    const bool use_limit_stencils)
+{
+  return cache->resolution == settings->resolution &&
+         cache->use_optimal_display == settings->use_optimal_display &&
+         cache->use_limit_stencils == use_limit_stencils &&
+         subdiv_mesh_cache_base_mesh_is_valid(base_mesh) &&
+         cache->base_mesh_copy_stamp == base_mesh->runtime.copy_stamp &&
+         subdiv_coarse_data_match(
+             &cache->vdata, &coarse_mesh->vdata, &base_mesh->vdata, coarse_mesh->totvert) &&
+         subdiv_coarse_data_match(
+             &cache->edata, &coarse_mesh->edata, &base_mesh->edata, coarse_mesh->totedge) &&
+         subdiv_coarse_data_match(
+             &cache->ldata, &coarse_mesh->ldata, &base_mesh->ldata, coarse_mesh->totloop) &&
+         subdiv_coarse_data_match(
+             &cache->pdata, &coarse_mesh->pdata, &base_mesh->pdata, coarse_mesh->totpoly);
+}
+
+/* Store limit surface points gathered during subdivision, creating stencils
+ * of them when requested. */
+static void subdiv_mesh_cache_points_create(const SubdivMeshContext *ctx, SubdivMeshCache *cache)
+{
+  const int num_vertices = ctx->subdiv_mesh->totvert;
+  const int num_normal_points = (int)BLI_stack_count(ctx->limit_normal_points);
+  const int num_points = num_vertices + num_normal_points;
+  SubdivLimitNormalPoint *normal_points = MEM_malloc_arrayN(
+      num_normal_points, sizeof(*normal_points), __func__);
+  BLI_stack_pop_n(ctx->limit_normal_points, normal_points, (uint)num_normal_points);
+  /* Group normal points by vertex. */
+  int *normal_points_offset = MEM_calloc_arrayN(
+      num_vertices + 1, sizeof(*normal_points_offset), "subdiv cache normal offsets");
+  for (int i = 0; i < num_normal_points; i++) {
+    normal_points_offset[normal_points[i].subdiv_vertex_index + 1]++;
+  }
+  for (int vertex_index = 0; vertex_index < num_vertices; vertex_index++) {
+    normal_points_offset[vertex_index + 1] += normal_points_offset[vertex_index];
+  }
+  int *ptex_face_indices = MEM_malloc_arrayN(num_points, sizeof(int), "subdiv cache ptex faces");
+  float *u = MEM_malloc_arrayN(num_points, sizeof(float), "subdiv cache u");
+  float *v = MEM_malloc_arrayN(num_points, sizeof(float), "subdiv cache v");
+  memcpy(ptex_face_indices, ctx->limit_point_ptex_face_index, sizeof(int) * num_vertices);
+  memcpy(u, ctx->limit_point_u, sizeof(float) * num_vertices);
+  memcpy(v, ctx->limit_point_v, sizeof(float) * num_vertices);
+  int *normal_points_fill = MEM_dupallocN(normal_points_offset);
+  for (int i = 0; i < num_normal_points; i++) {
+    const SubdivLimitNormalPoint *point = &normal_points[i];
+    const int point_index = num_vertices + normal_points_fill[point->subdiv_vertex_index]++;
+    ptex_face_indices[point_index] = point->ptex_face_index;
+    u[point_index] = point->u;
+    v[point_index] = point->v;
+  }
+  MEM_freeN(normal_points_fill);
+  MEM_freeN(normal_points);
+  cache->num_vertices = num_vertices;
+  cache->normal_points_offset = normal_points_offset;
+  if (cache->use_limit_stencils &&
+      BKE_subdiv_eval_limit_stencils_create(ctx->subdiv, num_points, ptex_face_indices, u, v)) {
+    cache->has_stencils = true;
+    MEM_freeN(ptex_face_indices);
+    MEM_freeN(u);
+    MEM_freeN(v);
+    return;
+  }
+  /* Stencils are not available for all refiners, fall back to evaluating the
+   * points directly. */
+  cache->point_ptex_face_index = ptex_face_indices;
+  cache->point_u = u;
+  cache->point_v = v;
+}
+
+static Mesh *subdiv_mesh_cache_result_new(SubdivMeshCache *cache)
+{
+  Mesh *result;
+  BKE_id_copy_ex(
+      NULL, &cache->mesh->id, (ID **)&result, LIB_ID_COPY_LOCALIZE | LIB_ID_COPY_CD_SHARE);
+  return result;
+}
+
+typedef struct SubdivCacheEvalData {
+  const SubdivMeshCache *cache;
+  Subdiv *subdiv;
+  const Mesh *coarse_mesh;
+  MVert *mvert;
+} SubdivCacheEvalData;
+
+static void subdiv_mesh_cache_eval_points(const SubdivCacheEvalData *data,
+                                          const int start_point,
+                                          const int num_points,
+                                          float (*r_P)[3],
+                                          float (*r_dPdu)[3],
+                                          float (*r_dPdv)[3])
+{
+  const SubdivMeshCache *cache = data->cache;
+  if (cache->has_stencils) {
+    BKE_subdiv_eval_limit_stencils(
+        data->subdiv, data->coarse_mesh, start_point, num_points, r_P, r_dPdu, r_dPdv);
+    return;
+  }
+  for (int i = 0; i < num_points; i++) {
+    const int point = start_point + i;
+    BKE_subdiv_eval_limit_point_and_derivatives(data->subdiv,
+                                                cache->point_ptex_face_index[point],
+                                                cache->point_u[point],
+                                                cache->point_v[point],
+                                                r_P[i],
+                                                r_dPdu[i],
+                                                r_dPdv[i]);
+  }
+}
+
+static void subdiv_mesh_cache_eval_block_cb(void *__restrict userdata,
+                                            const int block_index,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SubdivCacheEvalData *data = userdata;
+  const SubdivMeshCache *cache = data->cache;
+  const int *normal_points_offset = cache->normal_points_offset;
+  const int start_vertex = block_index * CACHE_BLOCK_SIZE;
+  const int num_block_vertices = min_ii(CACHE_BLOCK_SIZE, cache->num_vertices - start_vertex);
+  float P[CACHE_BLOCK_SIZE][3], dPdu[CACHE_BLOCK_SIZE][3], dPdv[CACHE_BLOCK_SIZE][3];
+  subdiv_mesh_cache_eval_points(data, start_vertex, num_block_vertices, P, dPdu, dPdv);
+  for (int i = 0; i < num_block_vertices; i++) {
+    const int vertex_index = start_vertex + i;
+    MVert *subdiv_vert = &data->mvert[vertex_index];
+    copy_v3_v3(subdiv_vert->co, P[i]);
+    float N[3];
+    if (normal_points_offset[vertex_index] == normal_points_offset[vertex_index + 1]) {
+      cross_v3_v3v3(N, dPdu[i], dPdv[i]);
+    }
+    else {
+      /* Average normals of all adjacent ptex faces, same as subdivision does. */
+      zero_v3(N);
+      for (int point = normal_points_offset[vertex_index];
+           point < normal_points_offset[vertex_index + 1];
+           point++) {
+        float point_P[3], point_dPdu[3], point_dPdv[3], point_N[3];
+        subdiv_mesh_cache_eval_points(
+            data, cache->num_vertices + point, 1, &point_P, &point_dPdu, &point_dPdv);
+        cross_v3_v3v3(point_N, point_dPdu, point_dPdv);
+        normalize_v3(point_N);
+        add_v3_v3(N, point_N);
+      }
+    }
+    normalize_v3(N);
+    normal_float_to_short_v3(subdiv_vert->no, N);
+  }
+}
+
+/* Evaluate vertices of the cached mesh for new coarse positions. */
+static Mesh *subdiv_mesh_cache_evaluate(SubdivMeshCache *cache,
+                                        Subdiv *subdiv,
+                                        const Mesh *coarse_mesh)
+{
+  /* Stencils are applied to coarse positions directly, otherwise evaluator is
+   * to be refined for them. */
+  if (!cache->has_stencils && !BKE_subdiv_eval_update_from_mesh(subdiv, coarse_mesh)) {
+    return NULL;
+  }
+  BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH);
+  Mesh *result = subdiv_mesh_cache_result_new(cache);
+  result->mvert = CustomData_duplicate_referenced_layer(&result->vdata, CD_MVERT, result->totvert);
+  BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
+  SubdivCacheEvalData data = {
+      .cache = cache,
+      .subdiv = subdiv,
+      .coarse_mesh = coarse_mesh,
+      .mvert = result->mvert,
+  };
+  TaskParallelSettings parallel_range_settings;
+  BLI_parallel_range_settings_defaults(&parallel_range_settings);
+  BLI_task_parallel_range(0,
+                          (cache->num_vertices + CACHE_BLOCK_SIZE - 1) / CACHE_BLOCK_SIZE,
+                          &data,
+                          subdiv_mesh_cache_eval_block_cb,
+                          &parallel_range_settings);
+  BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
+  BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH);
+  return result;
+}
+
+/* =============================================================================
+ * Subdivision.
+ */
+
+static Mesh *subdiv_to_mesh(Subdiv *subdiv,
+                            const SubdivToMeshSettings *settings,
+                            const Mesh *coarse_mesh,
+                            SubdivMeshCache *cache)
 {
   BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH);
   /* Make sure evaluator is up to date with possible new topology, and that
@@ -1182,6 +1609,8 @@ Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
   subdiv_context.subdiv = subdiv;
   subdiv_context.have_displacement = (subdiv->displacement_evaluator != NULL);
   subdiv_context.can_evaluate_normals = !subdiv_context.have_displacement;
+  subdiv_context.gather_limit_points = (cache != NULL && subdiv_context.can_evaluate_normals &&
+                                        subdiv->evaluator != NULL);
   /* Multi-threaded traversal/evaluation. */
   BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
   SubdivForeachContext foreach_context;
@@ -1198,7 +1627,75 @@ Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
   if (!subdiv_context.can_evaluate_normals) {
     result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
   }
+  if (subdiv_context.gather_limit_points && !subdiv_context.have_loose_geometry) {
+    subdiv_mesh_cache_points_create(&subdiv_context, cache);
+    cache->mesh = result;
+  }
   /* Free used memoty. */
   subdiv_mesh_context_free(&subdiv_context);
   return result;
 }
+
+/* =============================================================================
+ * Public entry point.
+ */
+
+Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
+                         const SubdivToMeshSettings *settings,
+                         const Mesh *coarse_mesh)
+{
+  return subdiv_to_mesh(subdiv, settings, coarse_mesh, NULL);
+}
+
+Mesh *BKE_subdiv_to_mesh_cached(Subdiv *subdiv,
+                                const SubdivToMeshSettings *settings,
+                                const Mesh *coarse_mesh,
+                                const Mesh *base_mesh,
+                                const bool use_limit_stencils,
+                                SubdivMeshCache **cache)
+{
+  if (*cache != NULL) {
+    if (subdiv_mesh_cache_match(*cache, settings, coarse_mesh, base_mesh, use_limit_stencils)) {
+      if ((*cache)->mesh != NULL) {
+        Mesh *result = subdiv_mesh_cache_evaluate(*cache, subdiv, coarse_mesh);
+        if (result != NULL) {
+          return result;
+        }
+      }
+      else {
+        /* Only vertices changed since the last time, which is worth keeping
+         * the result for. */
+        Mesh *result = subdiv_to_mesh(subdiv, settings, coarse_mesh, *cache);
+        if ((*cache)->mesh != NULL) {
+          /* Cache keeps the result, callers get a copy which shares all of its data. */
+          return subdiv_mesh_cache_result_new(*cache);
+        }
+        BKE_subdiv_mesh_cache_free(*cache);
+        *cache = NULL;
+        return result;
+      }
+    }
+    BKE_subdiv_mesh_cache_free(*cache);
+    *cache = NULL;
+  }
+  /* Only remember what was subdivided, the result is kept by the next call
+   * if it turns out to be a deformation of the same coarse mesh. */
+  *cache = subdiv_mesh_cache_new(settings, coarse_mesh, base_mesh, use_limit_stencils);
+  return subdiv_to_mesh(subdiv, settings, coarse_mesh, NULL);
+}
+
+void BKE_subdiv_mesh_cache_free(SubdivMeshCache *cache)
+{
+  subdiv_coarse_data_free(&cache->vdata);
+  subdiv_coarse_data_free(&cache->edata);
+  subdiv_coarse_data_free(&cache->ldata);
+  subdiv_coarse_data_free(&cache->pdata);
+  MEM_SAFE_FREE(cache->normal_points_offset);
+  MEM_SAFE_FREE(cache->point_ptex_face_index);
+  MEM_SAFE_FREE(cache->point_u);
+  MEM_SAFE_FREE(cache->point_v);
+  if (cache->mesh != NULL) {
+    BKE_id_free(NULL, cache->mesh);
+  }
+  MEM_freeN(cache);
+}
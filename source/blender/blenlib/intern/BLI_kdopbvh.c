@@ -1031,6 +1031,14 @@ bool BLI_bvhtree_update_node(
   return true;
 }
 
+static void bvhtree_update_tree_task_cb(void *__restrict userdata,
+                                        const int j,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHTree *tree = userdata;
+  node_join(tree, tree->nodes[tree->totleaf + j - 1]);
+}
+
 /* call BLI_bvhtree_update_node() first for every node/point/triangle */
 void BLI_bvhtree_update_tree(BVHTree *tree)
 {
@@ -1038,12 +1046,67 @@ void BLI_bvhtree_update_tree(BVHTree *tree)
    * TRICKY: the way we build the tree all the childs have an index greater than the parent
    * This allows us todo a bottom up update by starting on the bigger numbered branch */
 
-  BVHNode **root = tree->nodes + tree->totleaf;
-  BVHNode **index = tree->nodes + tree->totleaf + tree->totbranch - 1;
+  if (tree->totleaf <= KDOPBVH_THREAD_LEAF_THRESHOLD) {
+    BVHNode **root = tree->nodes + tree->totleaf;
+    BVHNode **index = tree->nodes + tree->totleaf + tree->totbranch - 1;
 
-  for (; index >= root; index--) {
-    node_join(tree, *index);
+    for (; index >= root; index--) {
+      node_join(tree, *index);
+    }
+    return;
   }
+
+  /* Branches of the implicit tree are stored level by level (see
+   * #non_recursive_bvh_div_nodes), join all branches of a level in parallel,
+   * starting from the deepest one. */
+  const int tree_offset = 2 - tree->tree_type;
+  int level_first[32];
+  int totlevel = 0;
+
+  for (int i = 1; i <= tree->totbranch && totlevel < 32; i = i * tree->tree_type + tree_offset) {
+    level_first[totlevel++] = i;
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 64;
+
+  for (int level = totlevel - 1; level >= 0; level--) {
+    const int i_start = level_first[level];
+    const int i_stop = (level + 1 < totlevel) ? level_first[level + 1] : tree->totbranch + 1;
+    BLI_task_parallel_range(i_start, i_stop, tree, bvhtree_update_tree_task_cb, &settings);
+  }
+}
+
+/**
+ * Expected number of branches a query visits: the sum of the surface areas of all
+ * branches relative to the root. Refitting a deformed tree increases it, comparing it to the
+ * value after #BLI_bvhtree_balance tells when rebuilding the tree is worth it.
+ */
+float BLI_bvhtree_get_refit_cost(const BVHTree *tree)
+{
+  /* Use the extents along the first three k-DOP axes of the tree,
+   * the x, y and z axes for all but the 18-DOP. */
+  const axis_t axis_first = tree->start_axis;
+  const axis_t axis_last = (axis_t)MIN2(tree->start_axis + 3, tree->stop_axis);
+  double cost = 0.0, root_area = 0.0;
+
+  for (int i = tree->totbranch - 1; i >= 0; i--) {
+    const BVHNode *node = tree->nodes[tree->totleaf + i];
+    float extent[3] = {0.0f, 0.0f, 0.0f};
+
+    for (axis_t axis_iter = axis_first; axis_iter < axis_last; axis_iter++) {
+      extent[axis_iter - axis_first] = max_ff(
+          node->bv[(2 * axis_iter) + 1] - node->bv[(2 * axis_iter)], 0.0f);
+    }
+
+    const double area = (double)(extent[0] * extent[1] + extent[1] * extent[2] +
+                                 extent[2] * extent[0]);
+    cost += area;
+    root_area = area;
+  }
+
+  return (root_area > 0.0) ? (float)(cost / root_area) : 0.0f;
 }
 /**
  * Number of times #BLI_bvhtree_insert has been called.
@@ -3128,6 +3128,8 @@ static void direct_link_action(FileData *fd, bAction *act)
     agrp->channels.first = newdataadr(fd, agrp->channels.first);
     agrp->channels.last = newdataadr(fd, agrp->channels.last);
   }
+
+  act->channel_cache = NULL;
 }
 
 static void lib_link_nladata_strips(FileData *fd, ID *id, ListBase *list)
@@ -3270,6 +3272,8 @@ static void direct_link_animdata(FileData *fd, AnimData *adt)
   link_list(fd, &adt->drivers);
   direct_link_fcurves(fd, &adt->drivers);
   adt->driver_array = NULL;
+  adt->driver_bindings = NULL;
+  adt->action_bindings = NULL;
 
   /* link overrides */
   // TODO...
@@ -5001,6 +5005,7 @@ static void direct_link_customdata(FileData *fd, CustomData *data, int count)
     }
 
     layer->flag &= ~CD_FLAG_NOFREE;
+    layer->sharing = NULL;
 
     if (CustomData_verify_versions(data, i)) {
       layer->data = newdataadr(fd, layer->data);
@@ -5413,6 +5418,10 @@ static void direct_link_pose(FileData *fd, bPose *pose)
 
   pose->chanhash = NULL;
   pose->chan_array = NULL;
+  pose->level_chans = NULL;
+  pose->level_offsets = NULL;
+  pose->totlevel = 0;
+  pose->totchan = 0;
 
   for (pchan = pose->chanbase.first; pchan; pchan = pchan->next) {
     pchan->bone = NULL;
@@ -86,6 +86,14 @@ void DEG_graph_relations_update(struct Depsgraph *graph,
 /* Tag all relations in the database for update.*/
 void DEG_relations_tag_update(struct Main *bmain);
 
+/* Tag relations of the given ID for update.
+ *
+ * Unlike tagging all relations, the next relations update will only re-build nodes and
+ * relations of the tagged IDs and patch them into the existing graph, falling back to a full
+ * rebuild when this is not possible. */
+void DEG_graph_id_relations_tag_update(struct Depsgraph *graph, struct ID *id);
+void DEG_id_relations_tag_update(struct Main *bmain, struct ID *id);
+
 /* Add Dependencies  ----------------------------- */
 
 /* Handle for components to define their dependencies from callbacks.
@@ -63,17 +63,37 @@ void DEG_debug_stats_gnuplot(const struct Depsgraph *graph,
                              const char *label,
                              const char *output_filename);
 
+/* ************************************************ */
+/* Evaluation Timeline */
+
+/* Record the evaluation of all dependency graphs, written to the file on exit. */
+void DEG_debug_trace_file_set(const char *filepath);
+
+/* Record the evaluation of a single dependency graph, written to the file when ending. */
+void DEG_debug_trace_begin(struct Depsgraph *depsgraph);
+bool DEG_debug_trace_end(struct Depsgraph *depsgraph, const char *filepath);
+
 /* ************************************************ */
 
 /* Compare two dependency graphs. */
 bool DEG_debug_compare(const struct Depsgraph *graph1, const struct Depsgraph *graph2);
 
+/* Compare operations and relations of two dependency graphs, matching operations by their
+ * identifiers. Differences are printed to the stderr. */
+bool DEG_debug_compare_relations(const struct Depsgraph *graph1, const struct Depsgraph *graph2);
+
 /* Check that dependencies in the graph are really up to date. */
 bool DEG_debug_graph_relations_validate(struct Depsgraph *graph,
                                         struct Main *bmain,
                                         struct Scene *scene,
                                         struct ViewLayer *view_layer);
 
+/* Check that relations of a partially updated graph match the ones of a full rebuild. */
+bool DEG_debug_graph_relations_partial_validate(struct Depsgraph *graph,
+                                                struct Main *bmain,
+                                                struct Scene *scene,
+                                                struct ViewLayer *view_layer);
+
 /* Perform consistency check on the graph. */
 bool DEG_debug_consistency_check(struct Depsgraph *graph);
 
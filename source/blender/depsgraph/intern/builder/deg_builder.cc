@@ -126,6 +126,10 @@ bool DepsgraphBuilder::check_pchan_has_bbone_segments(Object *object, const bPos
   if (ID_IS_LINKED(object) && object->proxy_from != NULL) {
     return false;
   }
+  /* Neither do batched poses, segments are computed by POSE_EVAL_BATCHED. */
+  if (check_pose_eval_batched(object)) {
+    return false;
+  }
   return check_pchan_has_bbone(object, pchan);
 }
 
@@ -135,6 +139,17 @@ bool DepsgraphBuilder::check_pchan_has_bbone_segments(Object *object, const char
   return check_pchan_has_bbone_segments(object, pchan);
 }
 
+bool DepsgraphBuilder::check_pose_eval_batched(Object *object)
+{
+  BLI_assert(object->type == OB_ARMATURE);
+  /* Proxies copy the pose bone by bone from the proxied object. */
+  if (ID_IS_LINKED(object) && object->proxy_from != NULL) {
+    return false;
+  }
+  const bArmature *armature = static_cast<const bArmature *>(object->data);
+  return (armature->flag & ARM_POSE_EVAL_BATCHED) != 0;
+}
+
 /*******************************************************************************
  * Builder finalizer.
  */
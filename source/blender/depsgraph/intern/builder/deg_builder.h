@@ -40,6 +40,7 @@ class DepsgraphBuilder {
   bool check_pchan_has_bbone(Object *object, const bPoseChannel *pchan);
   bool check_pchan_has_bbone_segments(Object *object, const bPoseChannel *pchan);
   bool check_pchan_has_bbone_segments(Object *object, const char *bone_name);
+  bool check_pose_eval_batched(Object *object);
 
  protected:
   /* NOTE: The builder does NOT take ownership over any of those resources. */
@@ -172,13 +172,14 @@ IDNode *DepsgraphNodeBuilder::add_id_node(ID *id)
     id_info->id_cow = NULL;
   }
   id_node = graph_->add_id_node(id, id_cow);
-  id_node->previously_visible_components_mask = previously_visible_components_mask;
-  id_node->previous_eval_flags = previous_eval_flags;
-  id_node->previous_customdata_masks = previous_customdata_masks;
   /* Currently all ID nodes are supposed to have copy-on-write logic.
    *
-   * NOTE: Zero number of components indicates that ID node was just created. */
+   * NOTE: Zero number of components indicates that ID node was just created. Nodes which are
+   * kept from the previous state of a partially rebuilt graph keep their previous state. */
   if (BLI_ghash_len(id_node->components) == 0) {
+    id_node->previously_visible_components_mask = previously_visible_components_mask;
+    id_node->previous_eval_flags = previous_eval_flags;
+    id_node->previous_customdata_masks = previous_customdata_masks;
     ComponentNode *comp_cow = id_node->add_component(NodeType::COPY_ON_WRITE);
     OperationNode *op_cow = comp_cow->add_operation(
         function_bind(deg_evaluate_copy_on_write, _1, id_node),
@@ -318,31 +319,11 @@ void DepsgraphNodeBuilder::begin_build()
    * them for new ID nodes. */
   id_info_hash_ = BLI_ghash_ptr_new("Depsgraph id hash");
   for (IDNode *id_node : graph_->id_nodes) {
-    IDInfo *id_info = (IDInfo *)MEM_mallocN(sizeof(IDInfo), "depsgraph id info");
-    if (deg_copy_on_write_is_expanded(id_node->id_cow) && id_node->id_orig != id_node->id_cow) {
-      id_info->id_cow = id_node->id_cow;
-    }
-    else {
-      id_info->id_cow = NULL;
-    }
-    id_info->previously_visible_components_mask = id_node->visible_components_mask;
-    id_info->previous_eval_flags = id_node->eval_flags;
-    id_info->previous_customdata_masks = id_node->customdata_masks;
-    BLI_ghash_insert(id_info_hash_, id_node->id_orig, id_info);
-    id_node->id_cow = NULL;
+    save_id_info(id_node);
   }
 
   GSET_FOREACH_BEGIN (OperationNode *, op_node, graph_->entry_tags) {
-    ComponentNode *comp_node = op_node->owner;
-    IDNode *id_node = comp_node->owner;
-
-    SavedEntryTag entry_tag;
-    entry_tag.id_orig = id_node->id_orig;
-    entry_tag.component_type = comp_node->type;
-    entry_tag.opcode = op_node->opcode;
-    entry_tag.name = op_node->name;
-    entry_tag.name_tag = op_node->name_tag;
-    saved_entry_tags_.push_back(entry_tag);
+    save_entry_tag(op_node);
   }
   GSET_FOREACH_END();
 
@@ -352,6 +333,61 @@ void DepsgraphNodeBuilder::begin_build()
   BLI_gset_clear(graph_->entry_tags, NULL);
 }
 
+void DepsgraphNodeBuilder::begin_build_partial(const vector<IDNode *> &id_nodes)
+{
+  id_info_hash_ = BLI_ghash_ptr_new("Depsgraph id hash");
+  for (IDNode *id_node : id_nodes) {
+    save_id_info(id_node);
+  }
+
+  /* Only entry tags of the removed nodes are to be restored, the rest of the tagged operations
+   * stays in the graph. */
+  GSET_FOREACH_BEGIN (OperationNode *, op_node, graph_->entry_tags) {
+    IDNode *id_node = op_node->owner->owner;
+    if (std::find(id_nodes.begin(), id_nodes.end(), id_node) != id_nodes.end()) {
+      save_entry_tag(op_node);
+    }
+  }
+  GSET_FOREACH_END();
+
+  for (IDNode *id_node : id_nodes) {
+    graph_->remove_id_node(id_node);
+  }
+  for (IDNode *id_node : graph_->id_nodes) {
+    built_map_.tagBuild(id_node->id_orig);
+  }
+}
+
+void DepsgraphNodeBuilder::save_id_info(IDNode *id_node)
+{
+  IDInfo *id_info = (IDInfo *)MEM_mallocN(sizeof(IDInfo), "depsgraph id info");
+  if (deg_copy_on_write_is_expanded(id_node->id_cow) && id_node->id_orig != id_node->id_cow) {
+    id_info->id_cow = id_node->id_cow;
+  }
+  else {
+    id_info->id_cow = NULL;
+  }
+  id_info->previously_visible_components_mask = id_node->visible_components_mask;
+  id_info->previous_eval_flags = id_node->eval_flags;
+  id_info->previous_customdata_masks = id_node->customdata_masks;
+  BLI_ghash_insert(id_info_hash_, id_node->id_orig, id_info);
+  id_node->id_cow = NULL;
+}
+
+void DepsgraphNodeBuilder::save_entry_tag(OperationNode *op_node)
+{
+  ComponentNode *comp_node = op_node->owner;
+  IDNode *id_node = comp_node->owner;
+
+  SavedEntryTag entry_tag;
+  entry_tag.id_orig = id_node->id_orig;
+  entry_tag.component_type = comp_node->type;
+  entry_tag.opcode = op_node->opcode;
+  entry_tag.name = op_node->name;
+  entry_tag.name_tag = op_node->name_tag;
+  saved_entry_tags_.push_back(entry_tag);
+}
+
 void DepsgraphNodeBuilder::end_build()
 {
   for (const SavedEntryTag &entry_tag : saved_entry_tags_) {
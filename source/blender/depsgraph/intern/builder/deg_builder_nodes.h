@@ -96,6 +96,10 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   void begin_build();
   void end_build();
 
+  /* Partial build: only given ID nodes are removed from the graph, the rest of the graph is kept
+   * as-is and is considered built. The removed IDs are to be built again afterwards. */
+  void begin_build_partial(const vector<IDNode *> &id_nodes);
+
   IDNode *add_id_node(ID *id);
   IDNode *find_id_node(ID *id);
   TimeSourceNode *add_time_source();
@@ -155,6 +159,12 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   void build_view_layer(Scene *scene,
                         ViewLayer *view_layer,
                         eDepsNode_LinkedState_Type linked_state);
+  /* Build single object of the view layer, used by the partial build. */
+  void build_view_layer_object(Scene *scene,
+                               ViewLayer *view_layer,
+                               Object *object,
+                               eDepsNode_LinkedState_Type linked_state,
+                               bool is_visible);
   void build_collection(LayerCollection *from_layer_collection, Collection *collection);
   void build_object(int base_index,
                     Object *object,
@@ -238,6 +248,9 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   };
   vector<SavedEntryTag> saved_entry_tags_;
 
+  void save_id_info(IDNode *id_node);
+  void save_entry_tag(OperationNode *op_node);
+
   struct BuilderWalkUserData {
     DepsgraphNodeBuilder *builder;
     /* Denotes whether object the walk is invoked from is visible. */
@@ -68,6 +68,12 @@ void DepsgraphNodeBuilder::build_pose_constraints(Object *object,
   data.builder = this;
   data.is_parent_visible = is_object_visible;
   BKE_constraints_id_loop(&pchan->constraints, constraint_walk, &data);
+  /* Batched poses solve the constraints in POSE_EVAL_BATCHED, keep a noop for the relations
+   * to the constraint targets. */
+  if (check_pose_eval_batched(object)) {
+    add_operation_node(&object->id, NodeType::BONE, pchan->name, OperationCode::BONE_CONSTRAINTS);
+    return;
+  }
   /* Create node for constraint stack. */
   add_operation_node(&object->id,
                      NodeType::BONE,
@@ -207,6 +213,16 @@ void DepsgraphNodeBuilder::build_rig(Object *object, bool is_object_visible)
                                OperationCode::POSE_DONE,
                                function_bind(BKE_pose_eval_done, _1, object_cow));
   op_node->set_as_exit();
+  /* Batched evaluation of all the bones, which replaces the per-bone operations. The bone
+   * components are still created, with noop operations only, so that other data-blocks can
+   * depend on individual bones. */
+  const bool use_batched_eval = check_pose_eval_batched(object);
+  if (use_batched_eval) {
+    add_operation_node(&object->id,
+                       NodeType::EVAL_POSE,
+                       OperationCode::POSE_EVAL_BATCHED,
+                       function_bind(BKE_pose_eval_batched, _1, scene_cow, object_cow));
+  }
   /* Bones. */
   int pchan_index = 0;
   LISTBASE_FOREACH (bPoseChannel *, pchan, &object->pose->chanbase) {
@@ -215,29 +231,38 @@ void DepsgraphNodeBuilder::build_rig(Object *object, bool is_object_visible)
         &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_LOCAL);
     op_node->set_as_entry();
 
-    add_operation_node(&object->id,
-                       NodeType::BONE,
-                       pchan->name,
-                       OperationCode::BONE_POSE_PARENT,
-                       function_bind(BKE_pose_eval_bone, _1, scene_cow, object_cow, pchan_index));
-
-    /* NOTE: Dedicated noop for easier relationship construction. */
-    add_operation_node(&object->id, NodeType::BONE, pchan->name, OperationCode::BONE_READY);
+    if (use_batched_eval) {
+      add_operation_node(&object->id, NodeType::BONE, pchan->name, OperationCode::BONE_READY);
+      op_node = add_operation_node(
+          &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_DONE);
+    }
+    else {
+      add_operation_node(
+          &object->id,
+          NodeType::BONE,
+          pchan->name,
+          OperationCode::BONE_POSE_PARENT,
+          function_bind(BKE_pose_eval_bone, _1, scene_cow, object_cow, pchan_index));
 
-    op_node = add_operation_node(&object->id,
-                                 NodeType::BONE,
-                                 pchan->name,
-                                 OperationCode::BONE_DONE,
-                                 function_bind(BKE_pose_bone_done, _1, object_cow, pchan_index));
+      /* NOTE: Dedicated noop for easier relationship construction. */
+      add_operation_node(&object->id, NodeType::BONE, pchan->name, OperationCode::BONE_READY);
 
-    /* B-Bone shape computation - the real last step if present. */
-    if (check_pchan_has_bbone(object, pchan)) {
       op_node = add_operation_node(
           &object->id,
           NodeType::BONE,
           pchan->name,
-          OperationCode::BONE_SEGMENTS,
-          function_bind(BKE_pose_eval_bbone_segments, _1, object_cow, pchan_index));
+          OperationCode::BONE_DONE,
+          function_bind(BKE_pose_bone_done, _1, object_cow, pchan_index));
+
+      /* B-Bone shape computation - the real last step if present. */
+      if (check_pchan_has_bbone(object, pchan)) {
+        op_node = add_operation_node(
+            &object->id,
+            NodeType::BONE,
+            pchan->name,
+            OperationCode::BONE_SEGMENTS,
+            function_bind(BKE_pose_eval_bbone_segments, _1, object_cow, pchan_index));
+      }
     }
 
     op_node->set_as_exit();
@@ -263,6 +288,10 @@ void DepsgraphNodeBuilder::build_rig(Object *object, bool is_object_visible)
      *   as in ik-tree building
      * - Animated chain-lengths are a problem. */
     LISTBASE_FOREACH (bConstraint *, con, &pchan->constraints) {
+      /* Batched poses solve the chains at the level of their root. */
+      if (use_batched_eval) {
+        continue;
+      }
       switch (con->type) {
         case CONSTRAINT_TYPE_KINEMATIC:
           build_ik_pose(object, pchan, con);
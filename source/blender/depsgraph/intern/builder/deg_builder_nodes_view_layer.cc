@@ -74,6 +74,30 @@ void DepsgraphNodeBuilder::build_layer_collections(ListBase *lb)
   }
 }
 
+void DepsgraphNodeBuilder::build_view_layer_object(Scene *scene,
+                                                   ViewLayer *view_layer,
+                                                   Object *object,
+                                                   eDepsNode_LinkedState_Type linked_state,
+                                                   bool is_visible)
+{
+  view_layer_index_ = 0;
+  scene_ = scene;
+  view_layer_ = view_layer;
+  /* Base index is to match the one which is used by build_view_layer(). */
+  int base_index = 0;
+  LISTBASE_FOREACH (Base *, base, &view_layer->object_bases) {
+    if (!need_pull_base_into_graph(base)) {
+      continue;
+    }
+    if (base->object == object) {
+      build_object(base_index, object, linked_state, is_visible);
+      return;
+    }
+    ++base_index;
+  }
+  build_object(-1, object, linked_state, is_visible);
+}
+
 void DepsgraphNodeBuilder::build_view_layer(Scene *scene,
                                             ViewLayer *view_layer,
                                             eDepsNode_LinkedState_Type linked_state)
@@ -444,6 +444,15 @@ void DepsgraphRelationBuilder::begin_build()
 {
 }
 
+void DepsgraphRelationBuilder::begin_build_partial(const vector<IDNode *> &id_nodes)
+{
+  for (IDNode *id_node : graph_->id_nodes) {
+    if (std::find(id_nodes.begin(), id_nodes.end(), id_node) == id_nodes.end()) {
+      built_map_.tagBuild(id_node->id_orig);
+    }
+  }
+}
+
 void DepsgraphRelationBuilder::build_id(ID *id)
 {
   if (id == NULL) {
@@ -1036,6 +1045,11 @@ void DepsgraphRelationBuilder::build_constraints(ID *id,
           ComponentKey target_transform_key(&ct->tar->id, NodeType::TRANSFORM);
           add_relation(target_transform_key, constraint_op_key, cti->name);
         }
+        else if ((ct->tar->type == OB_ARMATURE) && (ct->subtarget[0]) &&
+                 (component_type == NodeType::BONE) && (&ct->tar->id == id) &&
+                 check_pose_eval_batched(ct->tar)) {
+          /* Bones of a batched pose are ordered by its evaluation levels. */
+        }
         else if ((ct->tar->type == OB_ARMATURE) && (ct->subtarget[0])) {
           OperationCode opcode;
           /* relation to bone */
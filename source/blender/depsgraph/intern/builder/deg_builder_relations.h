@@ -158,6 +158,9 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
   DepsgraphRelationBuilder(Main *bmain, Depsgraph *graph, DepsgraphBuilderCache *cache);
 
   void begin_build();
+  /* Partial build: relations of all ID nodes which are not in the given list are considered
+   * built, see DepsgraphNodeBuilder::begin_build_partial(). */
+  void begin_build_partial(const vector<IDNode *> &id_nodes);
 
   template<typename KeyFrom, typename KeyTo>
   Relation *add_relation(const KeyFrom &key_from,
@@ -201,6 +204,7 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
   void build_view_layer(Scene *scene,
                         ViewLayer *view_layer,
                         eDepsNode_LinkedState_Type linked_state);
+  void build_view_layer_object(Scene *scene, ViewLayer *view_layer, Object *object);
   void build_collection(LayerCollection *from_layer_collection,
                         Object *object,
                         Collection *collection);
@@ -254,6 +258,7 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
                            bConstraint *con,
                            RootPChanMap *root_map);
   void build_rig(Object *object);
+  void build_rig_batched(Object *object);
   void build_proxy_rig(Object *object);
   void build_shapekeys(Key *key);
   void build_armature(bArmature *armature);
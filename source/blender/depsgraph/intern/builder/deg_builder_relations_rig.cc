@@ -246,6 +246,88 @@ void DepsgraphRelationBuilder::build_splineik_pose(Object *object,
   add_relation(solver_key, pose_done_key, "PoseEval Result-Bone Link");
 }
 
+/* Pose evaluated by a single operation, see BKE_pose_eval_batched(). The bone components only
+ * connect the bones to the rest of the graph: everything the pose depends on goes into the
+ * batched operation, everything depending on a bone comes out of it. */
+void DepsgraphRelationBuilder::build_rig_batched(Object *object)
+{
+  OperationKey pose_init_key(&object->id, NodeType::EVAL_POSE, OperationCode::POSE_INIT);
+  OperationKey pose_init_ik_key(&object->id, NodeType::EVAL_POSE, OperationCode::POSE_INIT_IK);
+  OperationKey pose_batched_key(
+      &object->id, NodeType::EVAL_POSE, OperationCode::POSE_EVAL_BATCHED);
+  OperationKey pose_cleanup_key(&object->id, NodeType::EVAL_POSE, OperationCode::POSE_CLEANUP);
+  OperationKey pose_done_key(&object->id, NodeType::EVAL_POSE, OperationCode::POSE_DONE);
+  add_relation(pose_init_ik_key, pose_batched_key, "Pose Init IK -> Pose Batched");
+  add_relation(pose_batched_key, pose_cleanup_key, "Pose Batched -> Pose Cleanup");
+  add_relation(pose_batched_key, pose_done_key, "Pose Batched -> Pose Done");
+  /* Dependencies between bones of this armature are handled by the evaluation levels, so an
+   * empty map is enough for the constraints. */
+  RootPChanMap root_map;
+  LISTBASE_FOREACH (bPoseChannel *, pchan, &object->pose->chanbase) {
+    OperationKey bone_local_key(
+        &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_LOCAL);
+    OperationKey bone_ready_key(
+        &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_READY);
+    OperationKey bone_done_key(&object->id, NodeType::BONE, pchan->name, OperationCode::BONE_DONE);
+    add_relation(pose_init_key, bone_local_key, "Pose Init - Bone Local", RELATION_FLAG_GODMODE);
+    add_relation(bone_local_key, pose_batched_key, "Bone Local -> Pose Batched");
+    if (pchan->constraints.first != NULL) {
+      /* Build relations for indirectly linked objects. */
+      BuilderWalkUserData data;
+      data.builder = this;
+      BKE_constraints_id_loop(&pchan->constraints, constraint_walk, &data);
+      /* Constraint dependencies. */
+      build_constraints(&object->id, NodeType::BONE, pchan->name, &pchan->constraints, &root_map);
+      OperationKey constraints_key(
+          &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_CONSTRAINTS);
+      add_relation(bone_local_key, constraints_key, "Local -> Constraints Stack");
+      add_relation(constraints_key, pose_batched_key, "Constraints -> Pose Batched");
+      /* IK targets from other objects, the ITASC solver reads them in init tree already. */
+      LISTBASE_FOREACH (bConstraint *, con, &pchan->constraints) {
+        if (!ELEM(con->type, CONSTRAINT_TYPE_KINEMATIC, CONSTRAINT_TYPE_SPLINEIK)) {
+          continue;
+        }
+        const bConstraintTypeInfo *cti = BKE_constraint_typeinfo_get(con);
+        ListBase targets = {NULL, NULL};
+        cti->get_constraint_targets(con, &targets);
+        LISTBASE_FOREACH (bConstraintTarget *, ct, &targets) {
+          if (ct->tar == NULL || ct->tar == object) {
+            continue;
+          }
+          ComponentKey target_transform_key(&ct->tar->id, NodeType::TRANSFORM);
+          add_relation(target_transform_key, pose_init_ik_key, con->name);
+          if (ct->tar->type == OB_ARMATURE && ct->subtarget[0]) {
+            OperationKey target_key(
+                &ct->tar->id, NodeType::BONE, ct->subtarget, OperationCode::BONE_DONE);
+            add_relation(target_key, pose_init_ik_key, con->name);
+          }
+          else if (ct->subtarget[0] && ELEM(ct->tar->type, OB_MESH, OB_LATTICE)) {
+            ComponentKey target_geometry_key(&ct->tar->id, NodeType::GEOMETRY);
+            add_relation(target_geometry_key, pose_init_ik_key, con->name);
+            add_customdata_mask(ct->tar, DEGCustomDataMeshMasks::MaskVert(CD_MASK_MDEFORMVERT));
+          }
+          else if (con->type == CONSTRAINT_TYPE_SPLINEIK) {
+            ComponentKey target_geometry_key(&ct->tar->id, NodeType::GEOMETRY);
+            add_relation(target_geometry_key, pose_init_ik_key, "Curve.Path -> Spline IK");
+            add_special_eval_flag(&ct->tar->id, DAG_EVAL_NEED_CURVE_PATH);
+          }
+        }
+        if (cti->flush_constraint_targets) {
+          cti->flush_constraint_targets(con, &targets, 1);
+        }
+      }
+    }
+    add_relation(pose_batched_key, bone_ready_key, "Pose Batched -> Ready");
+    add_relation(bone_ready_key, bone_done_key, "Ready -> Done");
+    add_relation(bone_done_key, pose_done_key, "PoseEval Result-Bone Link");
+    add_relation(bone_done_key, pose_cleanup_key, "Done -> Cleanup");
+    /* Custom shape. */
+    if (pchan->custom != NULL) {
+      build_object(NULL, pchan->custom);
+    }
+  }
+}
+
 /* Pose/Armature Bones Graph */
 void DepsgraphRelationBuilder::build_rig(Object *object)
 {
@@ -267,6 +349,10 @@ void DepsgraphRelationBuilder::build_rig(Object *object)
   add_relation(armature_key, pose_init_key, "Data dependency");
   /* Run cleanup even when there are no bones. */
   add_relation(pose_init_key, pose_cleanup_key, "Init -> Cleanup");
+  if (check_pose_eval_batched(object)) {
+    build_rig_batched(object);
+    return;
+  }
   /* IK Solvers.
    *
    * - These require separate processing steps are pose-level to be executed
@@ -75,6 +75,20 @@ void DepsgraphRelationBuilder::build_layer_collections(ListBase *lb)
   }
 }
 
+void DepsgraphRelationBuilder::build_view_layer_object(Scene *scene,
+                                                       ViewLayer *view_layer,
+                                                       Object *object)
+{
+  scene_ = scene;
+  LISTBASE_FOREACH (Base *, base, &view_layer->object_bases) {
+    if (base->object == object && need_pull_base_into_graph(base)) {
+      build_object(base, object);
+      return;
+    }
+  }
+  build_object(NULL, object);
+}
+
 void DepsgraphRelationBuilder::build_view_layer(Scene *scene,
                                                 ViewLayer *view_layer,
                                                 eDepsNode_LinkedState_Type linked_state)
@@ -202,7 +202,13 @@ RNANodeIdentifier RNANodeQuery::construct_node_identifier(const PointerRNA *ptr,
         const char *prop_name = RNA_property_identifier(prop);
         /* B-Bone properties should connect to the final operation. */
         if (STRPREFIX(prop_name, "bbone_")) {
-          if (builder_->check_pchan_has_bbone_segments(object, pchan)) {
+          /* Batched poses compute the segments together with everything else. */
+          if (builder_->check_pose_eval_batched(object)) {
+            node_identifier.operation_code = (source == RNAPointerSource::EXIT) ?
+                                                 OperationCode::BONE_DONE :
+                                                 OperationCode::BONE_LOCAL;
+          }
+          else if (builder_->check_pchan_has_bbone_segments(object, pchan)) {
             node_identifier.operation_code = OperationCode::BONE_SEGMENTS;
           }
           else {
@@ -0,0 +1,203 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/debug/deg_debug_trace.h"
+
+#include <cstdio>
+
+#include "MEM_guardedalloc.h"
+
+#include "PIL_time.h"
+
+#include "BLI_fileops.h"
+#include "BLI_utildefines.h"
+
+#include "DEG_depsgraph_debug.h"
+
+#include "intern/depsgraph.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
+
+namespace DEG {
+
+namespace {
+
+DebugTrace *global_trace = NULL;
+string global_trace_filepath;
+
+/* Write a string as a JSON string literal. */
+void trace_write_string(FILE *file, const string &str)
+{
+  fputc('"', file);
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        fputs("\\\"", file);
+        break;
+      case '\\':
+        fputs("\\\\", file);
+        break;
+      case '\n':
+        fputs("\\n", file);
+        break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          fprintf(file, "\\u%04x", c);
+        }
+        else {
+          fputc(c, file);
+        }
+        break;
+    }
+  }
+  fputc('"', file);
+}
+
+}  // namespace
+
+DebugTrace::DebugTrace() : time_origin_(PIL_check_seconds_timer())
+{
+  BLI_mutex_init(&mutex_);
+}
+
+DebugTrace::~DebugTrace()
+{
+  BLI_mutex_end(&mutex_);
+}
+
+void DebugTrace::add_evaluation(const Depsgraph *graph,
+                                double start_time,
+                                double end_time,
+                                const DebugTraceOperation *operations,
+                                int num_operations)
+{
+  BLI_mutex_lock(&mutex_);
+  /* The update itself, on the thread which started it. */
+  Event update_event;
+  update_event.name = graph->debug_name.empty() ? "Depsgraph" : graph->debug_name;
+  update_event.category = "update";
+  update_event.start_time = start_time;
+  update_event.end_time = end_time;
+  update_event.thread_id = 0;
+  events_.push_back(update_event);
+  for (int i = 0; i < num_operations; i++) {
+    const DebugTraceOperation &operation = operations[i];
+    if (operation.node == NULL) {
+      continue;
+    }
+    Event event;
+    event.name = operation.node->full_identifier();
+    event.category = nodeTypeAsString(operation.node->owner->type);
+    event.start_time = operation.start_time;
+    event.end_time = operation.end_time;
+    event.thread_id = operation.thread_id;
+    events_.push_back(event);
+  }
+  BLI_mutex_unlock(&mutex_);
+}
+
+bool DebugTrace::write(const char *filepath)
+{
+  FILE *file = BLI_fopen(filepath, "w");
+  if (file == NULL) {
+    return false;
+  }
+  BLI_mutex_lock(&mutex_);
+  fputs("{\"traceEvents\": [\n", file);
+  bool is_first = true;
+  for (const Event &event : events_) {
+    if (!is_first) {
+      fputs(",\n", file);
+    }
+    is_first = false;
+    /* Complete events, with timestamps in microseconds. */
+    fputs("{\"name\": ", file);
+    trace_write_string(file, event.name);
+    fputs(", \"cat\": ", file);
+    trace_write_string(file, event.category);
+    fprintf(file,
+            ", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d}",
+            (event.start_time - time_origin_) * 1e6,
+            (event.end_time - event.start_time) * 1e6,
+            event.thread_id);
+  }
+  fputs("\n],\n\"displayTimeUnit\": \"ms\"}\n", file);
+  BLI_mutex_unlock(&mutex_);
+  fclose(file);
+  return true;
+}
+
+DebugTrace *deg_debug_trace_global()
+{
+  return global_trace;
+}
+
+void deg_debug_trace_global_exit()
+{
+  if (global_trace == NULL) {
+    return;
+  }
+  const char *filepath = global_trace_filepath.c_str();
+  if (global_trace->write(filepath)) {
+    printf("Depsgraph trace written to '%s'\n", filepath);
+  }
+  else {
+    fprintf(stderr, "Error: could not write depsgraph trace to '%s'\n", filepath);
+  }
+  OBJECT_GUARDED_DELETE(global_trace, DebugTrace);
+  global_trace = NULL;
+}
+
+}  // namespace DEG
+
+void DEG_debug_trace_file_set(const char *filepath)
+{
+  if (DEG::global_trace == NULL) {
+    DEG::global_trace = OBJECT_GUARDED_NEW(DEG::DebugTrace);
+  }
+  DEG::global_trace_filepath = filepath;
+}
+
+void DEG_debug_trace_begin(Depsgraph *depsgraph)
+{
+  using DEG::DebugTrace;
+  DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(depsgraph);
+  if (deg_graph->debug_trace != NULL) {
+    OBJECT_GUARDED_DELETE(deg_graph->debug_trace, DebugTrace);
+  }
+  deg_graph->debug_trace = OBJECT_GUARDED_NEW(DEG::DebugTrace);
+}
+
+bool DEG_debug_trace_end(Depsgraph *depsgraph, const char *filepath)
+{
+  using DEG::DebugTrace;
+  DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(depsgraph);
+  if (deg_graph->debug_trace == NULL) {
+    return false;
+  }
+  const bool ok = deg_graph->debug_trace->write(filepath);
+  OBJECT_GUARDED_DELETE(deg_graph->debug_trace, DebugTrace);
+  deg_graph->debug_trace = NULL;
+  return ok;
+}
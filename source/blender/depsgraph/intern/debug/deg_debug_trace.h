@@ -0,0 +1,76 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+#include "intern/depsgraph_type.h"
+
+#include "BLI_threads.h"
+
+namespace DEG {
+
+struct Depsgraph;
+struct OperationNode;
+
+/* Timing of a single operation evaluation. */
+struct DebugTraceOperation {
+  const OperationNode *node;
+  double start_time;
+  double end_time;
+  int thread_id;
+};
+
+/* Timeline of dependency graph evaluations, written in the Chrome trace event format which can
+ * be opened with chrome://tracing or Perfetto. */
+struct DebugTrace {
+  DebugTrace();
+  ~DebugTrace();
+
+  /* Add an evaluation of the graph, can be called from multiple threads. */
+  void add_evaluation(const Depsgraph *graph,
+                      double start_time,
+                      double end_time,
+                      const DebugTraceOperation *operations,
+                      int num_operations);
+
+  bool write(const char *filepath);
+
+ protected:
+  struct Event {
+    string name;
+    string category;
+    double start_time;
+    double end_time;
+    int thread_id;
+  };
+
+  double time_origin_;
+  vector<Event> events_;
+  ThreadMutex mutex_;
+};
+
+/* Trace of all dependency graphs, NULL when not requested from the command line. */
+DebugTrace *deg_debug_trace_global();
+void deg_debug_trace_global_exit();
+
+}  // namespace DEG
@@ -46,6 +46,8 @@ extern "C" {
 
 #include "intern/depsgraph_update.h"
 
+#include "intern/debug/deg_debug_trace.h"
+
 #include "intern/eval/deg_eval_copy_on_write.h"
 
 #include "intern/node/deg_node.h"
@@ -76,11 +78,13 @@ Depsgraph::Depsgraph(Scene *scene, ViewLayer *view_layer, eEvaluationMode mode)
       scene_cow(NULL),
       is_active(false),
       debug_is_evaluating(false),
+      debug_trace(NULL),
       is_render_pipeline_depsgraph(false)
 {
   BLI_spin_init(&lock);
   id_hash = BLI_ghash_ptr_new("Depsgraph id hash");
   entry_tags = BLI_gset_ptr_new("Depsgraph entry_tags");
+  relations_update_ids = BLI_gset_ptr_new("Depsgraph relations_update_ids");
   debug_flags = G.debug;
   memset(id_type_updated, 0, sizeof(id_type_updated));
   memset(id_type_exist, 0, sizeof(id_type_exist));
@@ -92,9 +96,13 @@ Depsgraph::~Depsgraph()
   clear_id_nodes();
   BLI_ghash_free(id_hash, NULL, NULL);
   BLI_gset_free(entry_tags, NULL);
+  BLI_gset_free(relations_update_ids, NULL);
   if (time_source != NULL) {
     OBJECT_GUARDED_DELETE(time_source, TimeSourceNode);
   }
+  if (debug_trace != NULL) {
+    OBJECT_GUARDED_DELETE(debug_trace, DebugTrace);
+  }
   BLI_spin_end(&lock);
 }
 
@@ -175,6 +183,57 @@ void Depsgraph::clear_id_nodes()
   clear_physics_relations(this);
 }
 
+static IDNode *node_owner_id_node(Node *node)
+{
+  if (node->type == NodeType::OPERATION) {
+    return static_cast<OperationNode *>(node)->owner->owner;
+  }
+  if (node->get_class() == NodeClass::COMPONENT) {
+    return static_cast<ComponentNode *>(node)->owner;
+  }
+  return NULL;
+}
+
+static void unlink_external_relations(IDNode *id_node, Node *node)
+{
+  /* Outgoing relations are owned by the node they are pointing to, so the ones pointing outside
+   * of the ID are to be freed here. Incoming relations are freed together with the node, but
+   * need to be removed from the source node first. */
+  vector<Relation *> outlinks = node->outlinks;
+  for (Relation *rel : outlinks) {
+    if (node_owner_id_node(rel->to) != id_node) {
+      rel->unlink();
+      OBJECT_GUARDED_DELETE(rel, Relation);
+    }
+  }
+  for (Relation *rel : node->inlinks) {
+    if (node_owner_id_node(rel->from) != id_node) {
+      remove_from_vector(&rel->from->outlinks, rel);
+    }
+  }
+}
+
+void Depsgraph::remove_id_node(IDNode *id_node)
+{
+  GHASH_FOREACH_BEGIN (ComponentNode *, comp_node, id_node->components) {
+    unlink_external_relations(id_node, comp_node);
+    for (OperationNode *op_node : comp_node->operations) {
+      unlink_external_relations(id_node, op_node);
+      BLI_gset_remove(entry_tags, op_node, NULL);
+    }
+  }
+  GHASH_FOREACH_END();
+  operations.erase(std::remove_if(operations.begin(),
+                                  operations.end(),
+                                  [id_node](OperationNode *op_node) {
+                                    return op_node->owner->owner == id_node;
+                                  }),
+                   operations.end());
+  BLI_ghash_remove(id_hash, id_node->id_orig, NULL, NULL);
+  remove_from_vector(&id_nodes, id_node);
+  OBJECT_GUARDED_DELETE(id_node, IDNode);
+}
+
 /* Add new relation between two nodes */
 Relation *Depsgraph::add_new_relation(Node *from, Node *to, const char *description, int flags)
 {
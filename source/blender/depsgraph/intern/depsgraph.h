@@ -50,6 +50,7 @@ struct ViewLayer;
 
 namespace DEG {
 
+struct DebugTrace;
 struct IDNode;
 struct Node;
 struct OperationNode;
@@ -110,6 +111,9 @@ struct Depsgraph {
   IDNode *add_id_node(ID *id, ID *id_cow_hint = NULL);
   void clear_id_nodes();
   void clear_id_nodes_conditional(const std::function<bool(ID_Type id_type)> &filter);
+  /* Remove ID node from the graph, together with all relations which connect it to the rest of
+   * the graph. Copy-on-write datablock is freed unless it was taken over by the caller. */
+  void remove_id_node(IDNode *id_node);
 
   /* Add new relationship between two nodes. */
   Relation *add_new_relation(Node *from, Node *to, const char *description, int flags = 0);
@@ -147,6 +151,11 @@ struct Depsgraph {
   /* Indicates whether relations needs to be updated. */
   bool need_update;
 
+  /* Original IDs which relations were tagged for update with DEG_id_relations_tag_update().
+   * Only used when need_update is set: empty set means the whole graph is to be rebuilt,
+   * otherwise only nodes and relations of these IDs are re-built and patched into the graph. */
+  GSet *relations_update_ids;
+
   /* Indicates which ID types were updated. */
   char id_type_updated[MAX_LIBARRAY];
 
@@ -199,6 +208,9 @@ struct Depsgraph {
 
   bool debug_is_evaluating;
 
+  /* Evaluation timeline recorded for debugging, see DEG_debug_trace_begin(). */
+  DebugTrace *debug_trace;
+
   /* Is set to truth for dependency graph which are used for post-processing (compositor and
    * sequencer).
    * Such dependency graph needs all view layers (so render pipeline can access names), but it
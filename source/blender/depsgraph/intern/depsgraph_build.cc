@@ -44,6 +44,8 @@ extern "C" {
 #include "DEG_depsgraph.h"
 #include "DEG_depsgraph_debug.h"
 #include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_physics.h"
+#include "DEG_depsgraph_query.h"
 
 #include "builder/deg_builder.h"
 #include "builder/deg_builder_cache.h"
@@ -59,6 +61,7 @@ extern "C" {
 #include "intern/node/deg_node_id.h"
 #include "intern/node/deg_node_operation.h"
 
+#include "intern/depsgraph.h"
 #include "intern/depsgraph_type.h"
 
 /* ****************** */
@@ -221,6 +224,298 @@ static void graph_build_finalize_common(DEG::Depsgraph *deg_graph, Main *bmain)
 #endif
   /* Relations are up to date. */
   deg_graph->need_update = false;
+  BLI_gset_clear(deg_graph->relations_update_ids, NULL);
+}
+
+namespace {
+
+/* Operation identifier which survives re-creation of the operation node. */
+struct SavedOperationKey {
+  ID *id_orig;
+  DEG::NodeType component_type;
+  DEG::string component_name;
+  DEG::OperationCode opcode;
+  DEG::string name;
+  int name_tag;
+};
+
+struct SavedRelation {
+  SavedOperationKey from;
+  SavedOperationKey to;
+  const char *name;
+  int flag;
+};
+
+/* Name the component is looked up by, which is not the node name for unnamed components. */
+const char *component_key_name(const DEG::ComponentNode *comp_node)
+{
+  GHashIterator gh_iter;
+  GHASH_ITER (gh_iter, comp_node->owner->components) {
+    if (BLI_ghashIterator_getValue(&gh_iter) == comp_node) {
+      const DEG::IDNode::ComponentIDKey *comp_key =
+          static_cast<const DEG::IDNode::ComponentIDKey *>(BLI_ghashIterator_getKey(&gh_iter));
+      return comp_key->name;
+    }
+  }
+  BLI_assert(!"Component is not owned by its ID node");
+  return "";
+}
+
+SavedOperationKey operation_key_save(const DEG::OperationNode *op_node)
+{
+  SavedOperationKey key;
+  key.id_orig = op_node->owner->owner->id_orig;
+  key.component_type = op_node->owner->type;
+  key.component_name = component_key_name(op_node->owner);
+  key.opcode = op_node->opcode;
+  key.name = op_node->name;
+  key.name_tag = op_node->name_tag;
+  return key;
+}
+
+DEG::OperationNode *operation_key_find(const DEG::Depsgraph *graph, const SavedOperationKey &key)
+{
+  DEG::IDNode *id_node = graph->find_id_node(key.id_orig);
+  if (id_node == NULL) {
+    return NULL;
+  }
+  DEG::ComponentNode *comp_node = id_node->find_component(key.component_type,
+                                                          key.component_name.c_str());
+  if (comp_node == NULL) {
+    return NULL;
+  }
+  return comp_node->find_operation(key.opcode, key.name.c_str(), key.name_tag);
+}
+
+bool node_is_rebuilt(const DEG::Node *node, const DEG::set<DEG::IDNode *> &id_nodes)
+{
+  if (node->type != DEG::NodeType::OPERATION) {
+    return false;
+  }
+  const DEG::OperationNode *op_node = static_cast<const DEG::OperationNode *>(node);
+  return id_nodes.find(op_node->owner->owner) != id_nodes.end();
+}
+
+/* Collect relations which connect rebuilt ID nodes with the rest of the graph and which will not
+ * be re-created by the builders of the rebuilt IDs.
+ *
+ * Relations are added by the builder of the ID which depends on the other one, so all outgoing
+ * relations are to be restored. Incoming relations are expected to be re-created, with the
+ * exception of the ones added by the scene: rigid body world, view layer and scene drivers.
+ *
+ * Returns false if the ID nodes are connected to the graph in a way which can not be restored. */
+bool graph_save_external_relations(const DEG::set<DEG::IDNode *> &id_nodes,
+                                   DEG::vector<SavedRelation> *r_relations)
+{
+  for (DEG::IDNode *id_node : id_nodes) {
+    GHASH_FOREACH_BEGIN (DEG::ComponentNode *, comp_node, id_node->components) {
+      if (!comp_node->inlinks.empty() || !comp_node->outlinks.empty()) {
+        return false;
+      }
+      for (DEG::OperationNode *op_node : comp_node->operations) {
+        for (DEG::Relation *rel : op_node->outlinks) {
+          if (node_is_rebuilt(rel->to, id_nodes)) {
+            continue;
+          }
+          if (rel->to->type != DEG::NodeType::OPERATION) {
+            return false;
+          }
+          SavedRelation saved_rel;
+          saved_rel.from = operation_key_save(op_node);
+          saved_rel.to = operation_key_save(static_cast<DEG::OperationNode *>(rel->to));
+          saved_rel.name = rel->name;
+          saved_rel.flag = rel->flag & ~DEG::RELATION_FLAG_CYCLIC;
+          r_relations->push_back(saved_rel);
+        }
+        for (DEG::Relation *rel : op_node->inlinks) {
+          if (node_is_rebuilt(rel->from, id_nodes)) {
+            continue;
+          }
+          if (rel->from->type == DEG::NodeType::TIMESOURCE) {
+            continue;
+          }
+          if (rel->from->type != DEG::NodeType::OPERATION) {
+            return false;
+          }
+          const DEG::OperationNode *op_from = static_cast<DEG::OperationNode *>(rel->from);
+          if (GS(op_from->owner->owner->id_orig->name) != ID_SCE) {
+            continue;
+          }
+          SavedRelation saved_rel;
+          saved_rel.from = operation_key_save(op_from);
+          saved_rel.to = operation_key_save(op_node);
+          saved_rel.name = rel->name;
+          saved_rel.flag = rel->flag & ~DEG::RELATION_FLAG_CYCLIC;
+          r_relations->push_back(saved_rel);
+        }
+      }
+    }
+    GHASH_FOREACH_END();
+  }
+  return true;
+}
+
+bool graph_restore_external_relations(DEG::Depsgraph *graph,
+                                      const DEG::vector<SavedRelation> &relations)
+{
+  for (const SavedRelation &saved_rel : relations) {
+    DEG::OperationNode *op_from = operation_key_find(graph, saved_rel.from);
+    DEG::OperationNode *op_to = operation_key_find(graph, saved_rel.to);
+    if (op_from == NULL || op_to == NULL) {
+      return false;
+    }
+    if (graph->check_nodes_connected(op_from, op_to, saved_rel.name) == NULL) {
+      graph->add_new_relation(op_from, op_to, saved_rel.name, saved_rel.flag);
+    }
+  }
+  return true;
+}
+
+/* Reset state which is accumulated by the builders and the finalization, so that the kept part of
+ * the graph is finalized the same way as a freshly built one. */
+void graph_partial_build_reset_state(DEG::Depsgraph *graph)
+{
+  for (DEG::IDNode *id_node : graph->id_nodes) {
+    id_node->previously_visible_components_mask = id_node->visible_components_mask;
+    id_node->previous_eval_flags = id_node->eval_flags;
+    id_node->previous_customdata_masks = id_node->customdata_masks;
+  }
+}
+
+void graph_partial_build_reset_flush_state(DEG::Depsgraph *graph)
+{
+  for (DEG::IDNode *id_node : graph->id_nodes) {
+    GHASH_FOREACH_BEGIN (DEG::ComponentNode *, comp_node, id_node->components) {
+      comp_node->affects_directly_visible = false;
+    }
+    GHASH_FOREACH_END();
+  }
+  for (DEG::OperationNode *op_node : graph->operations) {
+    for (DEG::Relation *rel : op_node->outlinks) {
+      rel->flag &= ~DEG::RELATION_FLAG_CYCLIC;
+    }
+  }
+}
+
+struct PartialBuildObject {
+  Object *object;
+  DEG::eDepsNode_LinkedState_Type linked_state;
+  bool is_directly_visible;
+};
+
+/* Re-build nodes and relations of IDs from relations_update_ids, patching them into the existing
+ * graph.
+ *
+ * Returns false if the graph is to be fully rebuilt. This happens when the graph can not be
+ * updated partially, in which case it is left untouched, or when the partial update failed to
+ * re-attach the rebuilt IDs, in which case the graph is left in a consistent but incomplete
+ * state. */
+bool graph_build_partial(DEG::Depsgraph *deg_graph,
+                         Main *bmain,
+                         Scene *scene,
+                         ViewLayer *view_layer)
+{
+  if (BLI_gset_len(deg_graph->relations_update_ids) == 0) {
+    return false;
+  }
+  /* Physics relations are cached for the whole graph, objects which depend on them would need to
+   * be re-built as well. */
+  for (int i = 0; i < DEG_PHYSICS_RELATIONS_NUM; i++) {
+    if (deg_graph->physics_relations[i] != NULL) {
+      return false;
+    }
+  }
+  DEG::vector<DEG::IDNode *> id_nodes;
+  DEG::vector<PartialBuildObject> objects;
+  GSET_FOREACH_BEGIN (ID *, id, deg_graph->relations_update_ids) {
+    DEG::IDNode *id_node = deg_graph->find_id_node(id);
+    if (id_node == NULL || GS(id->name) != ID_OB) {
+      return false;
+    }
+    /* Objects of the set scenes are built as a part of a different view layer. */
+    if (id_node->linked_state == DEG::DEG_ID_LINKED_VIA_SET) {
+      return false;
+    }
+    /* Relations of rigid body objects are built by the scene. */
+    Object *object = (Object *)id;
+    if (object->rigidbody_object != NULL || object->rigidbody_constraint != NULL) {
+      return false;
+    }
+    PartialBuildObject partial_object;
+    partial_object.object = object;
+    partial_object.linked_state = id_node->linked_state;
+    partial_object.is_directly_visible = id_node->is_directly_visible;
+    objects.push_back(partial_object);
+    id_nodes.push_back(id_node);
+  }
+  GSET_FOREACH_END();
+  const DEG::set<DEG::IDNode *> id_nodes_set(id_nodes.begin(), id_nodes.end());
+  DEG::vector<SavedRelation> external_relations;
+  if (!graph_save_external_relations(id_nodes_set, &external_relations)) {
+    return false;
+  }
+  graph_partial_build_reset_state(deg_graph);
+  DEG::DepsgraphBuilderCache builder_cache;
+  /* Re-create nodes of the tagged IDs. */
+  DEG::DepsgraphNodeBuilder node_builder(bmain, deg_graph, &builder_cache);
+  node_builder.begin_build_partial(id_nodes);
+  const size_t num_kept_id_nodes = deg_graph->id_nodes.size();
+  const size_t num_kept_operations = deg_graph->operations.size();
+  for (const PartialBuildObject &partial_object : objects) {
+    node_builder.build_view_layer_object(scene,
+                                         view_layer,
+                                         partial_object.object,
+                                         partial_object.linked_state,
+                                         partial_object.is_directly_visible);
+  }
+  node_builder.end_build();
+  /* Builders of the tagged IDs are not supposed to add operations to the kept IDs, otherwise
+   * relations of those operations would need to be re-built as well. */
+  for (size_t i = num_kept_operations; i < deg_graph->operations.size(); i++) {
+    const DEG::IDNode *id_node = deg_graph->operations[i]->owner->owner;
+    if (std::find(deg_graph->id_nodes.begin(),
+                  deg_graph->id_nodes.begin() + num_kept_id_nodes,
+                  id_node) != deg_graph->id_nodes.begin() + num_kept_id_nodes) {
+      return false;
+    }
+  }
+  /* IDs which were pulled into the graph by the tagged ones are to have their relations built
+   * as well. */
+  DEG::vector<DEG::IDNode *> new_id_nodes(deg_graph->id_nodes.begin() + num_kept_id_nodes,
+                                          deg_graph->id_nodes.end());
+  /* Hook up relationships of the new nodes. */
+  DEG::DepsgraphRelationBuilder relation_builder(bmain, deg_graph, &builder_cache);
+  relation_builder.begin_build_partial(new_id_nodes);
+  for (const PartialBuildObject &partial_object : objects) {
+    relation_builder.build_view_layer_object(scene, view_layer, partial_object.object);
+  }
+  for (DEG::IDNode *id_node : new_id_nodes) {
+    relation_builder.build_copy_on_write_relations(id_node);
+  }
+  if (!graph_restore_external_relations(deg_graph, external_relations)) {
+    return false;
+  }
+  graph_partial_build_reset_flush_state(deg_graph);
+  return true;
+}
+
+}  // namespace
+
+/* Compare partially updated graph against a full rebuild. */
+bool DEG_debug_graph_relations_partial_validate(Depsgraph *graph,
+                                                Main *bmain,
+                                                Scene *scene,
+                                                ViewLayer *view_layer)
+{
+  ::Depsgraph *temp_depsgraph = DEG_graph_new(scene, view_layer, DEG_get_mode(graph));
+  bool valid = true;
+  DEG_graph_build_from_view_layer(temp_depsgraph, bmain, scene, view_layer);
+  if (!DEG_debug_compare_relations(temp_depsgraph, graph)) {
+    fprintf(stderr, "ERROR! Partial depsgraph relations update differs from a full rebuild!\n");
+    valid = false;
+  }
+  DEG_graph_free(temp_depsgraph);
+  return valid;
 }
 
 /* Build depsgraph for the given scene layer, and dump results in given graph container. */
@@ -329,6 +624,7 @@ void DEG_graph_tag_relations_update(Depsgraph *graph)
   DEG_DEBUG_PRINTF(graph, TAG, "%s: Tagging relations for update.\n", __func__);
   DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
   deg_graph->need_update = true;
+  BLI_gset_clear(deg_graph->relations_update_ids, NULL);
   /* NOTE: When relations are updated, it's quite possible that
    * we've got new bases in the scene. This means, we need to
    * re-create flat array of bases in view layer.
@@ -349,6 +645,21 @@ void DEG_graph_relations_update(Depsgraph *graph, Main *bmain, Scene *scene, Vie
     /* Graph is up to date, nothing to do. */
     return;
   }
+  double start_time = 0.0;
+  if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+    start_time = PIL_check_seconds_timer();
+  }
+  if (graph_build_partial(deg_graph, bmain, scene, view_layer)) {
+    graph_build_finalize_common(deg_graph, bmain);
+    if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+      printf("Depsgraph partially updated in %f seconds.\n",
+             PIL_check_seconds_timer() - start_time);
+    }
+    if (G.debug_value == 798) {
+      DEG_debug_graph_relations_partial_validate(graph, bmain, scene, view_layer);
+    }
+    return;
+  }
   DEG_graph_build_from_view_layer(graph, bmain, scene, view_layer);
 }
 
@@ -365,3 +676,36 @@ void DEG_relations_tag_update(Main *bmain)
     }
   }
 }
+
+void DEG_graph_id_relations_tag_update(Depsgraph *graph, ID *id)
+{
+  DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+  DEG::IDNode *id_node = deg_graph->find_id_node(id);
+  if (id_node == NULL || GS(id->name) != ID_OB) {
+    /* Only objects which are already in the graph can be re-built partially. */
+    DEG_graph_tag_relations_update(graph);
+    return;
+  }
+  if (deg_graph->need_update && BLI_gset_len(deg_graph->relations_update_ids) == 0) {
+    /* Full rebuild is already scheduled. */
+    return;
+  }
+  DEG_DEBUG_PRINTF(graph, TAG, "%s: Tagging relations of %s for update.\n", __func__, id->name);
+  deg_graph->need_update = true;
+  BLI_gset_add(deg_graph->relations_update_ids, id);
+  id_node->tag_update(deg_graph, DEG::DEG_UPDATE_SOURCE_RELATIONS);
+}
+
+/* Tag relations of the given ID for update. */
+void DEG_id_relations_tag_update(Main *bmain, ID *id)
+{
+  DEG_GLOBAL_DEBUG_PRINTF(TAG, "%s: Tagging relations of %s for update.\n", __func__, id->name);
+  LISTBASE_FOREACH (Scene *, scene, &bmain->scenes) {
+    LISTBASE_FOREACH (ViewLayer *, view_layer, &scene->view_layers) {
+      Depsgraph *depsgraph = (Depsgraph *)BKE_scene_get_depsgraph(scene, view_layer, false);
+      if (depsgraph != NULL) {
+        DEG_graph_id_relations_tag_update(depsgraph, id);
+      }
+    }
+  }
+}
@@ -42,6 +42,7 @@ extern "C" {
 #include "intern/debug/deg_debug.h"
 #include "intern/node/deg_node_component.h"
 #include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
 #include "intern/node/deg_node_time.h"
 
 void DEG_debug_flags_set(Depsgraph *depsgraph, int flags)
@@ -86,6 +87,65 @@ bool DEG_debug_compare(const struct Depsgraph *graph1, const struct Depsgraph *g
   return true;
 }
 
+static DEG::string deg_debug_operation_identifier(const DEG::Node *node)
+{
+  if (node->type != DEG::NodeType::OPERATION) {
+    return node->identifier();
+  }
+  const DEG::OperationNode *op_node = static_cast<const DEG::OperationNode *>(node);
+  return op_node->full_identifier() + "[" + DEG::to_string(op_node->name_tag) + "]";
+}
+
+static void deg_debug_graph_relations_identifiers(const DEG::Depsgraph *graph,
+                                                  DEG::set<DEG::string> *r_operations,
+                                                  DEG::set<DEG::string> *r_relations)
+{
+  for (const DEG::OperationNode *op_node : graph->operations) {
+    const DEG::string op_identifier = deg_debug_operation_identifier(op_node);
+    r_operations->insert(op_identifier);
+    for (const DEG::Relation *rel : op_node->inlinks) {
+      r_relations->insert(deg_debug_operation_identifier(rel->from) + " -> " + op_identifier +
+                          " (" + rel->name + ")");
+    }
+  }
+}
+
+static bool deg_debug_compare_identifiers(const DEG::set<DEG::string> &identifiers1,
+                                          const DEG::set<DEG::string> &identifiers2,
+                                          const char *what)
+{
+  bool is_equal = true;
+  for (const DEG::string &identifier : identifiers1) {
+    if (identifiers2.find(identifier) == identifiers2.end()) {
+      fprintf(stderr, "Only in first graph %s: %s\n", what, identifier.c_str());
+      is_equal = false;
+    }
+  }
+  for (const DEG::string &identifier : identifiers2) {
+    if (identifiers1.find(identifier) == identifiers1.end()) {
+      fprintf(stderr, "Only in second graph %s: %s\n", what, identifier.c_str());
+      is_equal = false;
+    }
+  }
+  return is_equal;
+}
+
+bool DEG_debug_compare_relations(const struct Depsgraph *graph1, const struct Depsgraph *graph2)
+{
+  BLI_assert(graph1 != NULL);
+  BLI_assert(graph2 != NULL);
+  const DEG::Depsgraph *deg_graph1 = reinterpret_cast<const DEG::Depsgraph *>(graph1);
+  const DEG::Depsgraph *deg_graph2 = reinterpret_cast<const DEG::Depsgraph *>(graph2);
+  DEG::set<DEG::string> operations1, operations2;
+  DEG::set<DEG::string> relations1, relations2;
+  deg_debug_graph_relations_identifiers(deg_graph1, &operations1, &relations1);
+  deg_debug_graph_relations_identifiers(deg_graph2, &operations2, &relations2);
+  const bool operations_equal = deg_debug_compare_identifiers(
+      operations1, operations2, "operation");
+  const bool relations_equal = deg_debug_compare_identifiers(relations1, relations2, "relation");
+  return operations_equal && relations_equal;
+}
+
 bool DEG_debug_graph_relations_validate(Depsgraph *graph,
                                         Main *bmain,
                                         Scene *scene,
@@ -33,6 +33,7 @@
 #include "DEG_depsgraph.h"
 
 #include "intern/depsgraph_type.h"
+#include "intern/debug/deg_debug_trace.h"
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_component.h"
 #include "intern/node/deg_node_factory.h"
@@ -50,6 +51,7 @@ void DEG_register_node_types(void)
 /* Free registry on exit */
 void DEG_free_node_types(void)
 {
+  DEG::deg_debug_trace_global_exit();
 }
 
 DEG::DEGCustomDataMeshMasks::DEGCustomDataMeshMasks(const CustomData_MeshMasks *other)
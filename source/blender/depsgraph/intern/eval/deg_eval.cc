@@ -25,12 +25,18 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <algorithm>
+#include <array>
+
+#include "MEM_guardedalloc.h"
+
 #include "PIL_time.h"
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_utildefines.h"
 #include "BLI_task.h"
 #include "BLI_ghash.h"
+#include "BLI_math_base.h"
 
 #include "BKE_global.h"
 
@@ -42,6 +48,7 @@
 
 #include "atomic_ops.h"
 
+#include "intern/debug/deg_debug_trace.h"
 #include "intern/eval/deg_eval_copy_on_write.h"
 #include "intern/eval/deg_eval_flush.h"
 #include "intern/eval/deg_eval_stats.h"
@@ -57,38 +64,106 @@ namespace DEG {
 /* ********************** */
 /* Evaluation Entrypoints */
 
+/* Operations which took less than this (in seconds) during the previous update are evaluated
+ * right away by the thread which made them ready, pushing them to the task pool costs more. */
+#define DEG_INLINE_EVAL_MAX_TIME 2e-6f
+/* Limit recursion of inline evaluation, to keep the stack of the worker threads small. */
+#define DEG_INLINE_EVAL_MAX_DEPTH 8
+/* Number of ready children which are ordered by priority before being pushed. */
+#define DEG_SCHEDULE_SORT_MAX 16
+
+/* Operations which became ready for evaluation once their parent was evaluated. */
+struct ScheduleReadyNodes {
+  /* Pushed to the task pool ordered by priority, others are pushed right away. */
+  std::array<OperationNode *, DEG_SCHEDULE_SORT_MAX> push_nodes;
+  int num_push_nodes;
+  /* Cheap operations evaluated by the same thread, once the others have been pushed. */
+  std::array<OperationNode *, DEG_SCHEDULE_SORT_MAX> inline_nodes;
+  int num_inline_nodes;
+};
+
 /* Forward declarations. */
 static void schedule_children(TaskPool *pool,
                               Depsgraph *graph,
                               OperationNode *node,
-                              const int thread_id);
+                              const int thread_id,
+                              const bool allow_inline,
+                              ScheduleReadyNodes *ready);
 
 struct DepsgraphEvalState {
   Depsgraph *graph;
   bool do_stats;
   bool is_cow_stage;
+  /* Operations in the order they have been evaluated (or skipped, for NOOP nodes), used to
+   * update the critical path estimates once the evaluation is done. */
+  OperationNode **evaluated_operations;
+  uint32_t num_evaluated_operations;
+  /* Timing of the evaluated operations for the debug trace, indexed like evaluated_operations.
+   * NULL when not recording a trace. */
+  DebugTraceOperation *trace_operations;
 };
 
-static void deg_task_run_func(TaskPool *pool, void *taskdata, int thread_id)
+static uint32_t deg_eval_operation_done(DepsgraphEvalState *state, OperationNode *node)
+{
+  const uint32_t index = atomic_fetch_and_add_uint32(&state->num_evaluated_operations, 1);
+  state->evaluated_operations[index] = node;
+  return index;
+}
+
+static void deg_eval_operation(DepsgraphEvalState *state,
+                               OperationNode *node,
+                               const int thread_id)
 {
-  void *userdata_v = BLI_task_pool_userdata(pool);
-  DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
-  OperationNode *node = (OperationNode *)taskdata;
   /* Sanity checks. */
   BLI_assert(!node->is_noop() && "NOOP nodes should not actually be scheduled");
-  /* Perform operation. */
+  /* Perform operation, timing is always needed for the scheduling priorities. */
+  const double start_time = PIL_check_seconds_timer();
+  node->evaluate((::Depsgraph *)state->graph);
+  const double eval_time = PIL_check_seconds_timer() - start_time;
+  node->eval_time = (float)eval_time;
   if (state->do_stats) {
-    const double start_time = PIL_check_seconds_timer();
-    node->evaluate((::Depsgraph *)state->graph);
-    node->stats.current_time += PIL_check_seconds_timer() - start_time;
+    node->stats.current_time += eval_time;
   }
-  else {
-    node->evaluate((::Depsgraph *)state->graph);
+  const uint32_t index = deg_eval_operation_done(state, node);
+  if (state->trace_operations != NULL) {
+    DebugTraceOperation *trace_operation = &state->trace_operations[index];
+    trace_operation->node = node;
+    trace_operation->start_time = start_time;
+    trace_operation->end_time = start_time + eval_time;
+    trace_operation->thread_id = thread_id;
   }
+}
+
+/* Evaluate the operation and schedule its children.
+ *   depth: Number of nested inline evaluations, cheap children are evaluated right away
+ *          (instead of being pushed to the task pool) until the limit is reached.
+ *
+ * Cheap children are only evaluated after the delayed push ended, operations are free to push
+ * tasks or to run parallel ranges of their own, which is not possible while delaying pushes. */
+static void deg_eval_operation_and_children(TaskPool *pool,
+                                            DepsgraphEvalState *state,
+                                            OperationNode *node,
+                                            const int thread_id,
+                                            const int depth)
+{
+  deg_eval_operation(state, node, thread_id);
   /* Schedule children. */
+  ScheduleReadyNodes ready;
   BLI_task_pool_delayed_push_begin(pool, thread_id);
-  schedule_children(pool, state->graph, node, thread_id);
+  schedule_children(
+      pool, state->graph, node, thread_id, depth < DEG_INLINE_EVAL_MAX_DEPTH, &ready);
   BLI_task_pool_delayed_push_end(pool, thread_id);
+  for (int i = 0; i < ready.num_inline_nodes; i++) {
+    deg_eval_operation_and_children(pool, state, ready.inline_nodes[i], thread_id, depth + 1);
+  }
+}
+
+static void deg_task_run_func(TaskPool *pool, void *taskdata, int thread_id)
+{
+  void *userdata_v = BLI_task_pool_userdata(pool);
+  DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
+  OperationNode *node = (OperationNode *)taskdata;
+  deg_eval_operation_and_children(pool, state, node, thread_id, 0);
 }
 
 struct CalculatePendingData {
@@ -166,21 +241,21 @@ static void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
   }
 }
 
-/* Schedule a node if it needs evaluation.
+/* Check if a node needs evaluation and all its dependencies are evaluated, marking it as
+ * scheduled when it is.
  *   dec_parents: Decrement pending parents count, true when child nodes are
  *                scheduled after a task has been completed.
  */
-static void schedule_node(
-    TaskPool *pool, Depsgraph *graph, OperationNode *node, bool dec_parents, const int thread_id)
+static bool schedule_node_is_ready(TaskPool *pool, OperationNode *node, bool dec_parents)
 {
   /* No need to schedule nodes of invisible ID. */
   if (!check_operation_node_visible(node)) {
-    return;
+    return false;
   }
   /* No need to schedule operations which are not tagged for update, they are
    * considered to be up to date. */
   if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) == 0) {
-    return;
+    return false;
   }
   /* TODO(sergey): This is not strictly speaking safe to read
    * num_links_pending. */
@@ -191,13 +266,13 @@ static void schedule_node(
   /* Cal not schedule operation while its dependencies are not yet
    * evaluated. */
   if (node->num_links_pending != 0) {
-    return;
+    return false;
   }
   /* During the COW stage only schedule COW nodes. */
   DepsgraphEvalState *state = (DepsgraphEvalState *)BLI_task_pool_userdata(pool);
   if (state->is_cow_stage) {
     if (node->owner->type != NodeType::COPY_ON_WRITE) {
-      return;
+      return false;
     }
   }
   else {
@@ -205,31 +280,79 @@ static void schedule_node(
   }
   /* Actually schedule the node. */
   bool is_scheduled = atomic_fetch_and_or_uint8((uint8_t *)&node->scheduled, (uint8_t) true);
-  if (!is_scheduled) {
-    if (node->is_noop()) {
-      /* skip NOOP node, schedule children right away */
-      schedule_children(pool, graph, node, thread_id);
-    }
-    else {
-      /* children are scheduled once this task is completed */
-      BLI_task_pool_push_from_thread(
-          pool, deg_task_run_func, node, false, TASK_PRIORITY_HIGH, thread_id);
-    }
+  return !is_scheduled;
+}
+
+static bool schedule_node_is_cheap(const OperationNode *node)
+{
+  return node->eval_time >= 0.0f && node->eval_time < DEG_INLINE_EVAL_MAX_TIME;
+}
+
+static bool schedule_node_priority_cmp(const OperationNode *a, const OperationNode *b)
+{
+  return a->critical_path_time < b->critical_path_time;
+}
+
+/* Push nodes which are ready to be evaluated to the task pool. The first pushed task is picked
+ * up next by the same thread, the following ones are picked up by other threads in reverse
+ * order. So the node on the longest path goes first, followed by the others from the shortest
+ * path to the longest. */
+static void schedule_nodes_by_priority(TaskPool *pool,
+                                       std::array<OperationNode *, DEG_SCHEDULE_SORT_MAX> &nodes,
+                                       const int num_nodes,
+                                       const int thread_id)
+{
+  BLI_assert(num_nodes <= DEG_SCHEDULE_SORT_MAX);
+  if (num_nodes == 0) {
+    return;
+  }
+  /* Bound the range explicitly, so the compiler does not consider sorting past the array. */
+  auto nodes_end = nodes.begin() + min_ii(num_nodes, DEG_SCHEDULE_SORT_MAX);
+  std::iter_swap(nodes.begin(),
+                 std::max_element(nodes.begin(), nodes_end, schedule_node_priority_cmp));
+  std::sort(nodes.begin() + 1, nodes_end, schedule_node_priority_cmp);
+  for (auto node = nodes.begin(); node != nodes_end; ++node) {
+    /* children are scheduled once this task is completed */
+    BLI_task_pool_push_from_thread(
+        pool, deg_task_run_func, *node, false, TASK_PRIORITY_HIGH, thread_id);
   }
 }
 
 static void schedule_graph(TaskPool *pool, Depsgraph *graph)
 {
+  DepsgraphEvalState *state = (DepsgraphEvalState *)BLI_task_pool_userdata(pool);
+  vector<OperationNode *> ready_nodes;
   for (OperationNode *node : graph->operations) {
-    schedule_node(pool, graph, node, false, 0);
+    if (!schedule_node_is_ready(pool, node, false)) {
+      continue;
+    }
+    if (node->is_noop()) {
+      /* skip NOOP node, schedule children right away */
+      deg_eval_operation_done(state, node);
+      ScheduleReadyNodes ready_children;
+      schedule_children(pool, graph, node, 0, false, &ready_children);
+    }
+    else {
+      ready_nodes.push_back(node);
+    }
+  }
+  /* Tasks pushed before the pool starts working are picked up in reverse order. */
+  std::sort(ready_nodes.begin(), ready_nodes.end(), schedule_node_priority_cmp);
+  for (OperationNode *node : ready_nodes) {
+    BLI_task_pool_push_from_thread(pool, deg_task_run_func, node, false, TASK_PRIORITY_HIGH, 0);
   }
 }
 
-static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
-                              OperationNode *node,
-                              const int thread_id)
+/* Gather the children of an evaluated node which became ready for evaluation, going through
+ * NOOP children. Nodes which do not fit into the ready arrays are pushed right away. */
+static void schedule_children_gather(TaskPool *pool,
+                                     Depsgraph *graph,
+                                     OperationNode *node,
+                                     const int thread_id,
+                                     const bool allow_inline,
+                                     ScheduleReadyNodes *ready)
 {
+  DepsgraphEvalState *state = (DepsgraphEvalState *)BLI_task_pool_userdata(pool);
   for (Relation *rel : node->outlinks) {
     OperationNode *child = (OperationNode *)rel->to;
     BLI_assert(child->type == NodeType::OPERATION);
@@ -237,7 +360,62 @@ static void schedule_children(TaskPool *pool,
       /* Happens when having cyclic dependencies. */
       continue;
     }
-    schedule_node(pool, graph, child, (rel->flag & RELATION_FLAG_CYCLIC) == 0, thread_id);
+    if (!schedule_node_is_ready(pool, child, (rel->flag & RELATION_FLAG_CYCLIC) == 0)) {
+      continue;
+    }
+    if (child->is_noop()) {
+      /* skip NOOP node, schedule children right away */
+      deg_eval_operation_done(state, child);
+      schedule_children_gather(pool, graph, child, thread_id, allow_inline, ready);
+    }
+    else if (allow_inline && schedule_node_is_cheap(child) &&
+             ready->num_inline_nodes < DEG_SCHEDULE_SORT_MAX) {
+      ready->inline_nodes[ready->num_inline_nodes++] = child;
+    }
+    else if (ready->num_push_nodes < DEG_SCHEDULE_SORT_MAX) {
+      ready->push_nodes[ready->num_push_nodes++] = child;
+    }
+    else {
+      /* children are scheduled once this task is completed */
+      BLI_task_pool_push_from_thread(
+          pool, deg_task_run_func, child, false, TASK_PRIORITY_HIGH, thread_id);
+    }
+  }
+}
+
+/* Schedule the children of an evaluated node which became ready for evaluation.
+ *   allow_inline: Cheap children are not pushed but returned in ready->inline_nodes,
+ *                 to be evaluated by the caller.
+ */
+static void schedule_children(TaskPool *pool,
+                              Depsgraph *graph,
+                              OperationNode *node,
+                              const int thread_id,
+                              const bool allow_inline,
+                              ScheduleReadyNodes *ready)
+{
+  ready->num_push_nodes = 0;
+  ready->num_inline_nodes = 0;
+  schedule_children_gather(pool, graph, node, thread_id, allow_inline, ready);
+  schedule_nodes_by_priority(pool, ready->push_nodes, ready->num_push_nodes, thread_id);
+}
+
+/* Update the critical path estimates from the evaluation times of this update. Visiting the
+ * operations in reverse evaluation order handles all children evaluated in this update before
+ * their parents, other children keep the estimate of a previous update. */
+static void update_critical_path_times(DepsgraphEvalState *state)
+{
+  for (int i = (int)state->num_evaluated_operations - 1; i >= 0; i--) {
+    OperationNode *node = state->evaluated_operations[i];
+    float children_time = 0.0f;
+    for (Relation *rel : node->outlinks) {
+      if (rel->flag & RELATION_FLAG_CYCLIC) {
+        continue;
+      }
+      const OperationNode *child = (const OperationNode *)rel->to;
+      children_time = max_ff(children_time, child->critical_path_time);
+    }
+    node->critical_path_time = max_ff(node->eval_time, 0.0f) + children_time;
   }
 }
 
@@ -276,6 +454,18 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   DepsgraphEvalState state;
   state.graph = graph;
   state.do_stats = do_time_debug;
+  state.evaluated_operations = (OperationNode **)MEM_malloc_arrayN(
+      graph->operations.size(), sizeof(OperationNode *), __func__);
+  state.num_evaluated_operations = 0;
+  /* Record the timeline for debugging. */
+  DebugTrace *traces[2] = {graph->debug_trace, deg_debug_trace_global()};
+  const bool do_trace = (traces[0] != NULL || traces[1] != NULL);
+  const double trace_start_time = do_trace ? PIL_check_seconds_timer() : 0.0;
+  state.trace_operations = NULL;
+  if (do_trace) {
+    state.trace_operations = (DebugTraceOperation *)MEM_calloc_arrayN(
+        graph->operations.size(), sizeof(DebugTraceOperation), __func__);
+  }
   /* Set up task scheduler and pull for threaded evaluation. */
   TaskScheduler *task_scheduler;
   bool need_free_scheduler;
@@ -300,6 +490,22 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   schedule_graph(task_pool, graph);
   BLI_task_pool_work_and_wait(task_pool);
   BLI_task_pool_free(task_pool);
+  /* Prioritize the operations of the next update. */
+  update_critical_path_times(&state);
+  MEM_freeN(state.evaluated_operations);
+  if (do_trace) {
+    const double trace_end_time = PIL_check_seconds_timer();
+    for (DebugTrace *trace : traces) {
+      if (trace != NULL) {
+        trace->add_evaluation(graph,
+                              trace_start_time,
+                              trace_end_time,
+                              state.trace_operations,
+                              state.num_evaluated_operations);
+      }
+    }
+    MEM_freeN(state.trace_operations);
+  }
   /* Finalize statistics gathering. This is because we only gather single
    * operation timing here, without aggregating anything to avoid any extra
    * synchronization. */
@@ -117,6 +117,8 @@ const char *operationCodeAsString(OperationCode opcode)
       return "POSE_IK_SOLVER";
     case OperationCode::POSE_SPLINE_IK_SOLVER:
       return "POSE_SPLINE_IK_SOLVER";
+    case OperationCode::POSE_EVAL_BATCHED:
+      return "POSE_EVAL_BATCHED";
     /* Bone. */
     case OperationCode::BONE_LOCAL:
       return "BONE_LOCAL";
@@ -196,7 +198,8 @@ const char *operationCodeAsString(OperationCode opcode)
   return "UNKNOWN";
 }
 
-OperationNode::OperationNode() : name_tag(-1), flag(0)
+OperationNode::OperationNode()
+    : name_tag(-1), flag(0), eval_time(-1.0f), critical_path_time(0.0f)
 {
 }
 
@@ -120,6 +120,8 @@ enum class OperationCode {
   /* IK/Spline Solvers */
   POSE_IK_SOLVER,
   POSE_SPLINE_IK_SOLVER,
+  /* All bones of the pose, evaluated level by level (ARM_POSE_EVAL_BATCHED). */
+  POSE_EVAL_BATCHED,
 
   /* Bone. ---------------------------------------------------------------- */
   /* Bone local transforms - entry point */
@@ -259,6 +261,13 @@ struct OperationNode : public Node {
   /* (OperationFlag) extra settings affecting evaluation. */
   int flag;
 
+  /* Time spent evaluating the operation during the last update, in seconds.
+   * Negative when it hasn't been evaluated yet. */
+  float eval_time;
+  /* Estimated time of the longest chain of operations starting at this one, computed from the
+   * eval_time of previous updates. Operations on the critical path are scheduled first. */
+  float critical_path_time;
+
   DEG_DEPSNODE_DECLARE;
 };
 
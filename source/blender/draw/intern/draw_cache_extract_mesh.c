@@ -122,6 +122,8 @@ typedef struct MeshRenderData {
   MLoopTri *mlooptri;
   float (*loop_normals)[3];
   float (*poly_normals)[3];
+  /* Float vertex normals kept by the mesh, may be NULL (use MVert.no then). */
+  const float (*vert_normals)[3];
   int *lverts, *ledges;
 } MeshRenderData;
 
@@ -205,6 +207,8 @@ static MeshRenderData *mesh_render_data_create(Mesh *me,
     mr->e_origindex = CustomData_get_layer(&mr->me->edata, CD_ORIGINDEX);
     mr->p_origindex = CustomData_get_layer(&mr->me->pdata, CD_ORIGINDEX);
 
+    mr->vert_normals = BKE_mesh_runtime_vert_normals_get(mr->me);
+
     if (data_flag & (MR_DATA_POLY_NOR | MR_DATA_LOOP_NOR | MR_DATA_TAN_LOOP_NOR)) {
       mr->poly_normals = MEM_mallocN(sizeof(*mr->poly_normals) * mr->poly_len, __func__);
       BKE_mesh_calc_normals_poly((MVert *)mr->mvert,
@@ -1409,6 +1413,11 @@ static void *extract_pos_nor_init(const MeshRenderData *mr, void *buf)
       data->packed_nor[v] = GPU_normal_convert_i10_v3(eve->no);
     }
   }
+  else if (mr->vert_normals) {
+    for (int v = 0; v < mr->vert_len; v++) {
+      data->packed_nor[v] = GPU_normal_convert_i10_v3(mr->vert_normals[v]);
+    }
+  }
   else {
     const MVert *mvert = mr->mvert;
     for (int v = 0; v < mr->vert_len; v++, mvert++) {
@@ -1559,7 +1568,12 @@ static void extract_lnor_loop_mesh(
     ((GPUPackedNormal *)data)[l] = GPU_normal_convert_i10_v3(mr->loop_normals[l]);
   }
   else if (mpoly->flag & ME_SMOOTH) {
-    ((GPUPackedNormal *)data)[l] = GPU_normal_convert_i10_s3(mr->mvert[mloop->v].no);
+    if (mr->vert_normals) {
+      ((GPUPackedNormal *)data)[l] = GPU_normal_convert_i10_v3(mr->vert_normals[mloop->v]);
+    }
+    else {
+      ((GPUPackedNormal *)data)[l] = GPU_normal_convert_i10_s3(mr->mvert[mloop->v].no);
+    }
   }
   else {
     ((GPUPackedNormal *)data)[l] = GPU_normal_convert_i10_v3(mr->poly_normals[p]);
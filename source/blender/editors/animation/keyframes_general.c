@@ -478,12 +478,14 @@ void sample_fcurve(FCurve *fcu)
         sfra = (int)(floor(start->vec[1][0]));
 
         if (range) {
+          int segment_hint = 0;
+
           value_cache = MEM_callocN(sizeof(TempFrameValCache) * range, "IcuFrameValCache");
 
           /* sample values */
           for (n = 1, fp = value_cache; n < range && fp; n++, fp++) {
             fp->frame = (float)(sfra + n);
-            fp->val = evaluate_fcurve(fcu, fp->frame);
+            fp->val = evaluate_fcurve_sequential(fcu, fp->frame, &segment_hint);
           }
 
           /* add keyframes with these, tagging as 'breakdowns' */
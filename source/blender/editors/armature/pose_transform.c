@@ -1242,6 +1242,7 @@ static int pose_clear_user_transforms_exec(bContext *C, wmOperator *op)
 
       /* was copied without constraints */
       BLI_freelistN(&dummyPose->chanbase);
+      BKE_pose_channels_hash_free(dummyPose);
       MEM_freeN(dummyPose);
     }
     else {
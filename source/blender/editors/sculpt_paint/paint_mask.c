@@ -170,7 +170,7 @@ static int mask_flood_fill_exec(bContext *C, wmOperator *op)
     multires_mark_as_modified(depsgraph, ob, MULTIRES_COORDS_MODIFIED);
   }
 
-  sculpt_undo_push_end();
+  sculpt_undo_push_end(ob);
 
   if (nodes) {
     MEM_freeN(nodes);
@@ -344,7 +344,7 @@ bool ED_sculpt_mask_box_select(struct bContext *C, ViewContext *vc, const rcti *
     multires_mark_as_modified(depsgraph, ob, MULTIRES_COORDS_MODIFIED);
   }
 
-  sculpt_undo_push_end();
+  sculpt_undo_push_end(ob);
 
   ED_region_tag_redraw(ar);
 
@@ -531,7 +531,7 @@ static int paint_mask_gesture_lasso_exec(bContext *C, wmOperator *op)
       multires_mark_as_modified(depsgraph, ob, MULTIRES_COORDS_MODIFIED);
     }
 
-    sculpt_undo_push_end();
+    sculpt_undo_push_end(ob);
 
     ED_region_tag_redraw(vc.ar);
     MEM_freeN((void *)mcords);
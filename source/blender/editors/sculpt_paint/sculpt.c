@@ -5801,7 +5801,7 @@ static void sculpt_stroke_done(const bContext *C, struct PaintStroke *UNUSED(str
     sculpt_cache_free(ss->cache);
     ss->cache = NULL;
 
-    sculpt_undo_push_end();
+    sculpt_undo_push_end(ob);
 
     sculpt_flush_update_done(C, ob);
 
@@ -6141,7 +6141,7 @@ static void sculpt_dynamic_topology_disable_with_undo(Main *bmain,
     sculpt_undo_push_begin("Dynamic topology disable");
     sculpt_undo_push_node(ob, NULL, SCULPT_UNDO_DYNTOPO_END);
     sculpt_dynamic_topology_disable_ex(bmain, depsgraph, scene, ob, NULL);
-    sculpt_undo_push_end();
+    sculpt_undo_push_end(ob);
   }
 }
 
@@ -6155,7 +6155,7 @@ static void sculpt_dynamic_topology_enable_with_undo(Main *bmain,
     sculpt_undo_push_begin("Dynamic topology enable");
     sculpt_dynamic_topology_enable_ex(bmain, depsgraph, scene, ob);
     sculpt_undo_push_node(ob, NULL, SCULPT_UNDO_DYNTOPO_BEGIN);
-    sculpt_undo_push_end();
+    sculpt_undo_push_end(ob);
   }
 }
 
@@ -6369,7 +6369,7 @@ static int sculpt_symmetrize_exec(bContext *C, wmOperator *UNUSED(op))
 
   /* Finish undo */
   BM_log_all_added(ss->bm, ss->bm_log);
-  sculpt_undo_push_end();
+  sculpt_undo_push_end(ob);
 
   /* Redraw */
   sculpt_pbvh_clear(ob);
@@ -6511,7 +6511,7 @@ void ED_object_sculptmode_enter_ex(Main *bmain,
       sculpt_dynamic_topology_enable_ex(bmain, depsgraph, scene, ob);
       if (has_undo) {
         sculpt_undo_push_node(ob, NULL, SCULPT_UNDO_DYNTOPO_BEGIN);
-        sculpt_undo_push_end();
+        sculpt_undo_push_end(ob);
       }
     }
     else {
@@ -6691,7 +6691,7 @@ static int sculpt_detail_flood_fill_exec(bContext *C, wmOperator *UNUSED(op))
   }
 
   MEM_freeN(nodes);
-  sculpt_undo_push_end();
+  sculpt_undo_push_end(ob);
 
   /* force rebuild of pbvh for better BB placement */
   sculpt_pbvh_clear(ob);
@@ -89,6 +89,14 @@ typedef struct SculptUndoNode {
   float *mask;
   int totvert;
 
+  /* Once the step is complete, co or mask is replaced by the stored values of
+   * elements which differ from their current values, restoring swaps them.
+   * See sculpt_undo_delta_encode(). */
+  bool is_delta;
+  int totdelta;
+  int *delta_index;
+  float *delta_value;
+
   /* non-multires */
   int maxvert; /* to verify if totvert it still the same */
   int *index;  /* to restore into right location */
@@ -350,7 +358,7 @@ void sculpt_cache_free(StrokeCache *cache);
 SculptUndoNode *sculpt_undo_push_node(Object *ob, PBVHNode *node, SculptUndoType type);
 SculptUndoNode *sculpt_undo_get_node(PBVHNode *node);
 void sculpt_undo_push_begin(const char *name);
-void sculpt_undo_push_end(void);
+void sculpt_undo_push_end(Object *ob);
 
 void sculpt_vertcos_to_key(Object *ob, KeyBlock *kb, const float (*vertCos)[3]);
 
@@ -26,6 +26,9 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "CLG_log.h"
+
+#include "BLI_array.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 #include "BLI_string.h"
@@ -71,6 +74,8 @@
 #include "paint_intern.h"
 #include "sculpt_intern.h"
 
+static CLG_LogRef LOG = {"ed.undo.sculpt"};
+
 typedef struct UndoSculpt {
   ListBase nodes;
 
@@ -480,6 +485,287 @@ static int sculpt_undo_bmesh_restore(bContext *C,
   return false;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Sparse Deltas
+ *
+ * Coordinates and masks of a complete step only keep the elements which
+ * differ from the current values, as pairs of element index and stored value.
+ * Restoring swaps the stored values with the current ones like it is done for
+ * full copies, so that the same delta both undoes and redoes the step. Values
+ * are stored as they are, which keeps undo exact whatever the current values
+ * are when the step is restored.
+ * \{ */
+
+typedef struct SculptUndoDeltaData {
+  SculptSession *ss;
+  CCGKey key;
+  SculptUndoNode **unodes;
+  /* Shape key coordinates to apply mesh coordinate deltas to instead of the vertices. */
+  float (*vert_cos)[3];
+} SculptUndoDeltaData;
+
+static bool sculpt_undo_delta_supported(const SculptSession *ss, const SculptUndoNode *unode)
+{
+  if (unode->type == SCULPT_UNDO_COORDS) {
+    /* Deformed and shape key coordinates are not restored by a plain swap. */
+    if (unode->co == NULL || unode->orig_co != NULL || unode->shapeName[0] != '\0' ||
+        ss->kb != NULL) {
+      return false;
+    }
+  }
+  else if (unode->type == SCULPT_UNDO_MASK) {
+    if (unode->mask == NULL) {
+      return false;
+    }
+  }
+  else {
+    return false;
+  }
+
+  if (unode->maxvert) {
+    return (ss->totvert == unode->maxvert) && (ss->mvert != NULL) &&
+           (unode->type != SCULPT_UNDO_MASK || ss->vmask != NULL);
+  }
+  else if (unode->maxgrid && ss->subdiv_ccg != NULL) {
+    return (ss->subdiv_ccg->num_grids == unode->maxgrid) &&
+           (ss->subdiv_ccg->grid_size == unode->gridsize);
+  }
+  return false;
+}
+
+static int sculpt_undo_delta_totelem(const SculptUndoNode *unode)
+{
+  if (unode->maxvert) {
+    return unode->totvert;
+  }
+  return unode->totgrid * unode->gridsize * unode->gridsize;
+}
+
+/* Current value of an element, the mesh vertex is returned for non-multires. */
+static float *sculpt_undo_delta_elem(const SculptUndoDeltaData *data,
+                                     const SculptUndoNode *unode,
+                                     const int i,
+                                     MVert **r_mvert)
+{
+  SculptSession *ss = data->ss;
+
+  if (unode->maxvert) {
+    const int index = unode->index[i];
+    if (unode->type == SCULPT_UNDO_COORDS && data->vert_cos) {
+      *r_mvert = NULL;
+      return data->vert_cos[index];
+    }
+    *r_mvert = &ss->mvert[index];
+    return (unode->type == SCULPT_UNDO_COORDS) ? ss->mvert[index].co : &ss->vmask[index];
+  }
+
+  const int gridarea = unode->gridsize * unode->gridsize;
+  CCGElem *grid = ss->subdiv_ccg->grids[unode->grids[i / gridarea]];
+  *r_mvert = NULL;
+  return (unode->type == SCULPT_UNDO_COORDS) ?
+             CCG_elem_offset_co(&data->key, grid, i % gridarea) :
+             CCG_elem_offset_mask(&data->key, grid, i % gridarea);
+}
+
+static void sculpt_undo_delta_encode(const SculptUndoDeltaData *data, SculptUndoNode *unode)
+{
+  const bool is_coords = (unode->type == SCULPT_UNDO_COORDS);
+  const int totcomp = is_coords ? 3 : 1;
+  const float *stored = is_coords ? (float *)unode->co : unode->mask;
+  const int totelem = sculpt_undo_delta_totelem(unode);
+  MVert *mvert;
+  int totdelta = 0;
+
+  for (int i = 0; i < totelem; i++) {
+    const float *value = sculpt_undo_delta_elem(data, unode, i, &mvert);
+    if (memcmp(value, &stored[i * totcomp], sizeof(float) * totcomp) != 0) {
+      totdelta++;
+    }
+  }
+
+  if (totdelta != 0) {
+    unode->delta_index = MEM_mallocN(sizeof(int) * totdelta, "SculptUndoNode.delta_index");
+    unode->delta_value = MEM_mallocN(sizeof(float) * totcomp * totdelta,
+                                     "SculptUndoNode.delta_value");
+
+    for (int i = 0, d = 0; i < totelem; i++) {
+      const float *value = sculpt_undo_delta_elem(data, unode, i, &mvert);
+      if (memcmp(value, &stored[i * totcomp], sizeof(float) * totcomp) != 0) {
+        unode->delta_index[d] = i;
+        memcpy(&unode->delta_value[d * totcomp], &stored[i * totcomp], sizeof(float) * totcomp);
+        d++;
+      }
+    }
+  }
+  unode->totdelta = totdelta;
+  unode->is_delta = true;
+
+  if (is_coords) {
+    MEM_freeN(unode->co);
+    unode->co = NULL;
+  }
+  else {
+    MEM_freeN(unode->mask);
+    unode->mask = NULL;
+  }
+}
+
+static void sculpt_undo_delta_apply(const SculptUndoDeltaData *data, SculptUndoNode *unode)
+{
+  const int totcomp = (unode->type == SCULPT_UNDO_COORDS) ? 3 : 1;
+
+  for (int d = 0; d < unode->totdelta; d++) {
+    MVert *mvert;
+    float *value = sculpt_undo_delta_elem(data, unode, unode->delta_index[d], &mvert);
+    float *stored = &unode->delta_value[d * totcomp];
+    for (int c = 0; c < totcomp; c++) {
+      SWAP(float, value[c], stored[c]);
+    }
+
+    if (mvert) {
+      mvert->flag |= ME_VERT_PBVH_UPDATE;
+    }
+  }
+}
+
+static void sculpt_undo_delta_encode_task_cb(void *__restrict userdata,
+                                             const int n,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptUndoDeltaData *data = userdata;
+  sculpt_undo_delta_encode(data, data->unodes[n]);
+}
+
+static void sculpt_undo_delta_apply_task_cb(void *__restrict userdata,
+                                            const int n,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptUndoDeltaData *data = userdata;
+  sculpt_undo_delta_apply(data, data->unodes[n]);
+}
+
+static void sculpt_undo_delta_data_init(SculptUndoDeltaData *data,
+                                        SculptSession *ss,
+                                        SculptUndoNode **unodes)
+{
+  data->ss = ss;
+  data->unodes = unodes;
+  data->vert_cos = NULL;
+  if (ss->subdiv_ccg != NULL) {
+    BKE_subdiv_ccg_key_top_level(&data->key, ss->subdiv_ccg);
+  }
+}
+
+/* Apply deltas of nodes in parallel, every node has its own vertices or grids. */
+static void sculpt_undo_delta_apply_nodes(SculptSession *ss,
+                                          SculptUndoNode **unodes,
+                                          int totunode)
+{
+  SculptUndoDeltaData data;
+  sculpt_undo_delta_data_init(&data, ss, unodes);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (totunode > 1);
+  BLI_task_parallel_range(0, totunode, &data, sculpt_undo_delta_apply_task_cb, &settings);
+}
+
+/* Replace full copies of the complete step by deltas where possible. */
+static void sculpt_undo_delta_encode_nodes(Object *ob, UndoSculpt *usculpt)
+{
+  SculptSession *ss = ob->sculpt;
+  SculptUndoNode **unodes = NULL;
+  BLI_array_declare(unodes);
+  size_t full_size = 0, delta_size = 0;
+
+  if (ss == NULL || ss->bm != NULL) {
+    return;
+  }
+
+  for (SculptUndoNode *unode = usculpt->nodes.first; unode; unode = unode->next) {
+    if (STREQ(unode->idname, ob->id.name) && sculpt_undo_delta_supported(ss, unode)) {
+      BLI_array_append(unodes, unode);
+    }
+  }
+
+  const int totunode = BLI_array_len(unodes);
+  if (totunode == 0) {
+    BLI_array_free(unodes);
+    return;
+  }
+
+  SculptUndoDeltaData data;
+  sculpt_undo_delta_data_init(&data, ss, unodes);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (totunode > 1);
+  BLI_task_parallel_range(0, totunode, &data, sculpt_undo_delta_encode_task_cb, &settings);
+
+  for (int i = 0; i < totunode; i++) {
+    const SculptUndoNode *unode = unodes[i];
+    const size_t elem_size = (unode->type == SCULPT_UNDO_COORDS) ? sizeof(float[3]) :
+                                                                   sizeof(float);
+    const size_t size = elem_size * (size_t)sculpt_undo_delta_totelem(unode);
+    const size_t size_delta = (sizeof(int) + elem_size) * (size_t)unode->totdelta;
+    full_size += size;
+    delta_size += size_delta;
+    usculpt->undo_size = usculpt->undo_size - size + size_delta;
+  }
+
+  CLOG_INFO(&LOG,
+            1,
+            "%d nodes stored as deltas, step size %zu bytes (%zu bytes with full copies)",
+            totunode,
+            usculpt->undo_size,
+            usculpt->undo_size - delta_size + full_size);
+
+  BLI_array_free(unodes);
+}
+
+/**
+ * Apply the delta of mesh coordinates to the active shape key, the same way as
+ * sculpt_undo_restore_coords() does for full copies.
+ */
+static bool sculpt_undo_delta_apply_key(bContext *C,
+                                        Depsgraph *depsgraph,
+                                        Object *ob,
+                                        SculptUndoNode *unode)
+{
+  SculptSession *ss = ob->sculpt;
+
+  if (!STREQ(ss->kb->name, unode->shapeName)) {
+    /* shape key has been changed before calling undo operator */
+    Key *key = BKE_key_from_object(ob);
+    KeyBlock *kb = key ? BKE_keyblock_find_name(key, unode->shapeName) : NULL;
+
+    if (kb == NULL) {
+      /* key has been removed -- skip this undo node */
+      return false;
+    }
+
+    ob->shapenr = BLI_findindex(&key->block, kb) + 1;
+    BKE_sculpt_update_object_for_edit(depsgraph, ob, false, false);
+    WM_event_add_notifier(C, NC_OBJECT | ND_DATA, ob);
+  }
+
+  float(*vertCos)[3] = BKE_keyblock_convert_to_vertcos(ob, ss->kb);
+
+  SculptUndoDeltaData data;
+  sculpt_undo_delta_data_init(&data, ss, NULL);
+  data.vert_cos = vertCos;
+  sculpt_undo_delta_apply(&data, unode);
+
+  /* propagate new coords to keyblock and pbvh */
+  sculpt_vertcos_to_key(ob, ss->kb, vertCos);
+  BKE_pbvh_vert_coords_apply(ss->pbvh, vertCos, ss->kb->totelem);
+
+  MEM_freeN(vertCos);
+  return true;
+}
+
+/** \} */
+
 static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase *lb)
 {
   Scene *scene = CTX_data_scene(C);
@@ -489,6 +775,8 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
   SculptSession *ss = ob->sculpt;
   SubdivCCG *subdiv_ccg = ss->subdiv_ccg;
   SculptUndoNode *unode;
+  SculptUndoNode **delta_unodes = NULL;
+  BLI_array_declare(delta_unodes);
   bool update = false, rebuild = false;
   bool need_mask = false;
   bool partial_update = true;
@@ -553,6 +841,25 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
       partial_update = false;
     }
 
+    if (unode->is_delta) {
+      if (unode->maxvert == 0 && subdiv_ccg == NULL) {
+        /* Multires grids are not available, same as the full copy restore. */
+        continue;
+      }
+      if (unode->maxvert && unode->type == SCULPT_UNDO_COORDS && ss->kb != NULL) {
+        if (sculpt_undo_delta_apply_key(C, depsgraph, ob, unode)) {
+          update = true;
+        }
+        continue;
+      }
+      if (unode->maxvert && unode->type == SCULPT_UNDO_MASK && ss->vmask == NULL) {
+        continue;
+      }
+      BLI_array_append(delta_unodes, unode);
+      update = true;
+      continue;
+    }
+
     switch (unode->type) {
       case SCULPT_UNDO_COORDS:
         if (sculpt_undo_restore_coords(C, depsgraph, unode)) {
@@ -580,6 +887,11 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
     }
   }
 
+  if (delta_unodes != NULL) {
+    sculpt_undo_delta_apply_nodes(ss, delta_unodes, BLI_array_len(delta_unodes));
+    BLI_array_free(delta_unodes);
+  }
+
   if (update || rebuild) {
     bool tag_update = false;
     /* we update all nodes still, should be more clever, but also
@@ -659,6 +971,12 @@ static void sculpt_undo_free_list(ListBase *lb)
     if (unode->mask) {
       MEM_freeN(unode->mask);
     }
+    if (unode->delta_index) {
+      MEM_freeN(unode->delta_index);
+    }
+    if (unode->delta_value) {
+      MEM_freeN(unode->delta_value);
+    }
 
     if (unode->bm_entry) {
       BM_log_entry_drop(unode->bm_entry);
@@ -769,7 +1087,7 @@ static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, Sculpt
       unode->co = MEM_mapallocN(sizeof(float[3]) * allvert, "SculptUndoNode.co");
       unode->no = MEM_mapallocN(sizeof(short[3]) * allvert, "SculptUndoNode.no");
 
-      usculpt->undo_size = (sizeof(float[3]) + sizeof(short[3]) + sizeof(int)) * allvert;
+      usculpt->undo_size += (sizeof(float[3]) + sizeof(short[3]) + sizeof(int)) * allvert;
       break;
     case SCULPT_UNDO_HIDDEN:
       if (maxgrid) {
@@ -783,7 +1101,7 @@ static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, Sculpt
     case SCULPT_UNDO_MASK:
       unode->mask = MEM_mapallocN(sizeof(float) * allvert, "SculptUndoNode.mask");
 
-      usculpt->undo_size += (sizeof(float) * sizeof(int)) * allvert;
+      usculpt->undo_size += (sizeof(float) + sizeof(int)) * allvert;
 
       break;
     case SCULPT_UNDO_DYNTOPO_BEGIN:
@@ -1075,7 +1393,7 @@ void sculpt_undo_push_begin(const char *name)
   BKE_undosys_step_push_init_with_type(ustack, C, name, BKE_UNDOSYS_TYPE_SCULPT);
 }
 
-void sculpt_undo_push_end(void)
+void sculpt_undo_push_end(Object *ob)
 {
   UndoSculpt *usculpt = sculpt_undo_get_nodes();
   SculptUndoNode *unode;
@@ -1095,6 +1413,8 @@ void sculpt_undo_push_end(void)
   /* We could remove this and enforce all callers run in an operator using 'OPTYPE_UNDO'. */
   wmWindowManager *wm = G_MAIN->wm.first;
   if (wm->op_undo_depth == 0) {
+    sculpt_undo_delta_encode_nodes(ob, usculpt);
+
     UndoStack *ustack = ED_undo_stack_get();
     BKE_undosys_step_push(ustack, NULL, NULL);
     WM_file_tag_modified();
@@ -1257,7 +1577,7 @@ void ED_sculpt_undo_geometry_begin(struct Object *ob)
 void ED_sculpt_undo_geometry_end(struct Object *ob)
 {
   sculpt_undo_push_node(ob, NULL, SCULPT_UNDO_GEOMETRY);
-  sculpt_undo_push_end();
+  sculpt_undo_push_end(ob);
 }
 
 /* Export for ED_undo_sys. */
@@ -566,11 +566,17 @@ static void draw_fcurve_curve(
   n = (etime - stime) / samplefreq + 0.5f;
 
   if (n > 0) {
+    /* Samples are in increasing order, so the keyframe segment can be looked up sequentially. */
+    int segment_hint = 0;
+
     immBegin(GPU_PRIM_LINE_STRIP, (n + 1));
 
     for (i = 0; i <= n; i++) {
       float ctime = stime + i * samplefreq;
-      immVertex2f(pos, ctime, (evaluate_fcurve(&fcurve_for_draw, ctime) + offset) * unitFac);
+      immVertex2f(
+          pos,
+          ctime,
+          (evaluate_fcurve_sequential(&fcurve_for_draw, ctime, &segment_hint) + offset) * unitFac);
     }
 
     immEnd();
@@ -46,19 +46,29 @@
 
 /* ********************** THE IK SOLVER ******************* */
 
-/* allocates PoseTree, and links that to root bone/channel */
-/* Note: detecting the IK chain is duplicate code...
- * in drawarmature.c and in transform_conversions.c */
-static void initialize_posetree(struct Object *UNUSED(ob), bPoseChannel *pchan_tip)
+/* Persistent state of the legacy solver, stored in bPose.ikdata. */
+typedef struct IKSolverChainKey {
+  bPoseChannel *pchan;
+  /* IK constraint that was chosen for the chain, NULL if none. */
+  bConstraint *con;
+  short flag, rootbone, iterations;
+} IKSolverChainKey;
+
+typedef struct IKSolverPoseData {
+  /* One key per channel with PCHAN_HAS_IK, for detecting when the trees have to be rebuilt. */
+  IKSolverChainKey *keys;
+  int totkey;
+} IKSolverPoseData;
+
+/* Constraint settings which affect the layout of the trees. */
+#define IK_TREE_FLAG_MASK (CONSTRAINT_IK_AUTO | CONSTRAINT_IK_TIP | CONSTRAINT_IK_STRETCH)
+
+/* find IK constraint, and validate it */
+static bConstraint *posetree_constraint_find(bPoseChannel *pchan_tip)
 {
-  bPoseChannel *curchan, *pchan_root = NULL, *chanlist[256], **oldchan;
-  PoseTree *tree;
-  PoseTarget *target;
   bConstraint *con;
   bKinematicConstraint *data;
-  int a, t, segcount = 0, size, newsize, *oldparent, parent;
 
-  /* find IK constraint, and validate it */
   for (con = pchan_tip->constraints.first; con; con = con->next) {
     if (con->type == CONSTRAINT_TYPE_KINEMATIC) {
       data = (bKinematicConstraint *)con->data;
@@ -76,9 +86,26 @@ static void initialize_posetree(struct Object *UNUSED(ob), bPoseChannel *pchan_t
       }
     }
   }
+  return con;
+}
+
+/* allocates PoseTree, and links that to root bone/channel */
+/* Note: detecting the IK chain is duplicate code...
+ * in drawarmature.c and in transform_conversions.c */
+static void initialize_posetree(struct Object *UNUSED(ob), bPoseChannel *pchan_tip)
+{
+  bPoseChannel *curchan, *pchan_root = NULL, *chanlist[256], **oldchan;
+  PoseTree *tree;
+  PoseTarget *target;
+  bConstraint *con;
+  bKinematicConstraint *data;
+  int a, t, segcount = 0, size, newsize, *oldparent, parent;
+
+  con = posetree_constraint_find(pchan_tip);
   if (con == NULL) {
     return;
   }
+  data = (bKinematicConstraint *)con->data;
 
   /* exclude tip from chain? */
   if (!(data->flag & CONSTRAINT_IK_TIP)) {
@@ -133,6 +160,7 @@ static void initialize_posetree(struct Object *UNUSED(ob), bPoseChannel *pchan_t
     tree->iterations = data->iterations;
     tree->totchannel = segcount;
     tree->stretch = (data->flag & CONSTRAINT_IK_STRETCH);
+    tree->two_bone_analytic = (data->flag & CONSTRAINT_IK_TWO_BONE_ANALYTIC);
 
     tree->pchan = MEM_callocN(segcount * sizeof(void *), "ik tree pchan");
     tree->parent = MEM_callocN(segcount * sizeof(int), "ik tree parent");
@@ -148,6 +176,8 @@ static void initialize_posetree(struct Object *UNUSED(ob), bPoseChannel *pchan_t
   else {
     tree->iterations = MAX2(data->iterations, tree->iterations);
     tree->stretch = tree->stretch && !(data->flag & CONSTRAINT_IK_STRETCH);
+    tree->two_bone_analytic = tree->two_bone_analytic &&
+                              (data->flag & CONSTRAINT_IK_TWO_BONE_ANALYTIC);
 
     /* skip common pose channels and add remaining*/
     size = MIN2(segcount, tree->totchannel);
@@ -272,6 +302,95 @@ static void where_is_ik_bone(bPoseChannel *pchan,
   pchan->flag |= POSE_DONE;
 }
 
+static void posetree_solver_free(PoseTree *tree)
+{
+  if (tree->solver) {
+    IK_FreeSolver(tree->solver);
+    tree->solver = NULL;
+  }
+  if (tree->segments) {
+    for (int a = 0; a < tree->totchannel; a++) {
+      IK_FreeSegment(tree->segments[a]);
+    }
+    MEM_freeN(tree->segments);
+    tree->segments = NULL;
+  }
+  MEM_SAFE_FREE(tree->segment_flag);
+}
+
+/* Limits can only be added to a segment and not removed, so they are part of the segment flag,
+ * shifted past the IK_SegmentFlag bits. */
+#define SEGMENT_FLAG_LIMIT_SHIFT 8
+
+/* DoF and limits of the segment of a pose channel. */
+static int posetree_segment_flag(const PoseTree *tree, const bPoseChannel *pchan)
+{
+  int flag = 0;
+
+  if (!(pchan->ikflag & BONE_IK_NO_XDOF) && !(pchan->ikflag & BONE_IK_NO_XDOF_TEMP)) {
+    flag |= IK_XDOF;
+  }
+  if (!(pchan->ikflag & BONE_IK_NO_YDOF) && !(pchan->ikflag & BONE_IK_NO_YDOF_TEMP)) {
+    flag |= IK_YDOF;
+  }
+  if (!(pchan->ikflag & BONE_IK_NO_ZDOF) && !(pchan->ikflag & BONE_IK_NO_ZDOF_TEMP)) {
+    flag |= IK_ZDOF;
+  }
+
+  if (tree->stretch && (pchan->ikstretch > 0.0f)) {
+    flag |= IK_TRANS_YDOF;
+  }
+
+  flag |= (pchan->ikflag & (BONE_IK_XLIMIT | BONE_IK_YLIMIT | BONE_IK_ZLIMIT))
+          << SEGMENT_FLAG_LIMIT_SHIFT;
+
+  return flag;
+}
+
+/* Create the solver segments of the tree, or keep the ones of the previous evaluation when the
+ * DoF of the chain did not change. Returns true when the segments were kept. */
+static bool posetree_segments_ensure(PoseTree *tree)
+{
+  int a;
+
+  if (tree->segments) {
+    for (a = 0; a < tree->totchannel; a++) {
+      if (tree->segment_flag[a] != posetree_segment_flag(tree, tree->pchan[a])) {
+        break;
+      }
+    }
+    if (a == tree->totchannel) {
+      return true;
+    }
+    posetree_solver_free(tree);
+  }
+
+  tree->segments = MEM_mallocN(sizeof(void *) * tree->totchannel, "ik tree");
+  tree->segment_flag = MEM_mallocN(sizeof(int) * tree->totchannel, "ik tree segment flag");
+
+  for (a = 0; a < tree->totchannel; a++) {
+    IK_Segment *seg, *parent;
+
+    tree->segment_flag[a] = posetree_segment_flag(tree, tree->pchan[a]);
+    seg = tree->segments[a] = IK_CreateSegment(
+        tree->segment_flag[a] & ((1 << SEGMENT_FLAG_LIMIT_SHIFT) - 1));
+
+    /* find parent */
+    if (a == 0) {
+      parent = NULL;
+    }
+    else {
+      parent = tree->segments[tree->parent[a]];
+    }
+
+    IK_SetParent(seg, parent);
+  }
+
+  tree->solver = IK_CreateSolver(tree->segments[0]);
+
+  return false;
+}
+
 /* called from within the core BKE_pose_where_is loop, all animsystems and constraints
  * were executed & assigned. Now as last we do an IK pass */
 static void execute_posetree(struct Depsgraph *depsgraph,
@@ -288,10 +407,12 @@ static void execute_posetree(struct Depsgraph *depsgraph,
   float irest_basis[3][3], full_basis[3][3];
   float end_pose[4][4], world_pose[4][4];
   float basis[3][3], rest_basis[3][3], start[3], *ikstretch = NULL;
+  float prev_change[3][3];
   float resultinf = 0.0f;
-  int a, flag, hasstretch = 0, resultblend = 0;
+  int a, hasstretch = 0, resultblend = 0;
+  bool use_warm_start;
   bPoseChannel *pchan;
-  IK_Segment *seg, *parent, **iktree, *iktarget;
+  IK_Segment *seg, **iktree, *iktarget;
   IK_Solver *solver;
   PoseTarget *target;
   bKinematicConstraint *data, *poleangledata = NULL;
@@ -301,42 +422,31 @@ static void execute_posetree(struct Depsgraph *depsgraph,
     return;
   }
 
-  iktree = MEM_mallocN(sizeof(void *) * tree->totchannel, "ik tree");
+  /* Warm start from the previous solution, unless the segments are new. Pole targets rotate
+   * the whole chain after solving, so the previous solution is not a sensible starting point. */
+  use_warm_start = posetree_segments_ensure(tree) &&
+                   (((bArmature *)ob->data)->flag & ARM_IK_WARM_START);
+  for (target = tree->targets.first; target && use_warm_start; target = target->next) {
+    data = (bKinematicConstraint *)target->con->data;
+    if (data->poletar) {
+      use_warm_start = false;
+    }
+  }
+
+  iktree = (IK_Segment **)tree->segments;
+  solver = tree->solver;
+  IK_SolverClearGoals(solver);
 
   for (a = 0; a < tree->totchannel; a++) {
     float length;
     pchan = tree->pchan[a];
     bone = pchan->bone;
-
-    /* set DoF flag */
-    flag = 0;
-    if (!(pchan->ikflag & BONE_IK_NO_XDOF) && !(pchan->ikflag & BONE_IK_NO_XDOF_TEMP)) {
-      flag |= IK_XDOF;
-    }
-    if (!(pchan->ikflag & BONE_IK_NO_YDOF) && !(pchan->ikflag & BONE_IK_NO_YDOF_TEMP)) {
-      flag |= IK_YDOF;
-    }
-    if (!(pchan->ikflag & BONE_IK_NO_ZDOF) && !(pchan->ikflag & BONE_IK_NO_ZDOF_TEMP)) {
-      flag |= IK_ZDOF;
-    }
+    seg = iktree[a];
 
     if (tree->stretch && (pchan->ikstretch > 0.0f)) {
-      flag |= IK_TRANS_YDOF;
       hasstretch = 1;
     }
 
-    seg = iktree[a] = IK_CreateSegment(flag);
-
-    /* find parent */
-    if (a == 0) {
-      parent = NULL;
-    }
-    else {
-      parent = iktree[tree->parent[a]];
-    }
-
-    IK_SetParent(seg, parent);
-
     /* get the matrix that transforms from prevbone into this bone */
     copy_m3_m4(R_bonemat, pchan->pose_mat);
 
@@ -377,8 +487,17 @@ static void execute_posetree(struct Depsgraph *depsgraph,
     /* transform offset into local bone space */
     mul_m3_v3(iR_parmat, start);
 
+    if (use_warm_start) {
+      /* the segment still holds the previous solution */
+      IK_GetBasisChange(seg, prev_change);
+    }
+
     IK_SetTransform(seg, start, rest_basis, basis, length);
 
+    if (use_warm_start) {
+      IK_SetBasisChange(seg, prev_change);
+    }
+
     if (pchan->ikflag & BONE_IK_XLIMIT) {
       IK_SetLimit(seg, IK_X, pchan->limitmin[0], pchan->limitmax[0]);
     }
@@ -401,8 +520,6 @@ static void execute_posetree(struct Depsgraph *depsgraph,
     }
   }
 
-  solver = IK_CreateSolver(iktree[0]);
-
   /* set solver goals */
 
   /* first set the goal inverse transform, assuming the root of tree was done ok! */
@@ -512,16 +629,18 @@ static void execute_posetree(struct Depsgraph *depsgraph,
   }
 
   /* solve */
+  IK_SolverSetTwoBoneAnalytic(solver, tree->two_bone_analytic);
   IK_Solve(solver, 0.0f, tree->iterations);
 
   if (poleangledata) {
     poleangledata->poleangle = IK_SolverGetPoleAngle(solver);
   }
 
-  IK_FreeSolver(solver);
-
   /* gather basis changes */
-  tree->basis_change = MEM_mallocN(sizeof(float[3][3]) * tree->totchannel, "ik basis change");
+  if (tree->basis_change == NULL) {
+    tree->basis_change = MEM_mallocN(sizeof(float[3][3]) * tree->totchannel,
+                                     "ik basis change");
+  }
   if (hasstretch) {
     ikstretch = MEM_mallocN(sizeof(float) * tree->totchannel, "ik stretch");
   }
@@ -559,11 +678,8 @@ static void execute_posetree(struct Depsgraph *depsgraph,
       unit_m3(identity);
       blend_m3_m3m3(tree->basis_change[a], identity, tree->basis_change[a], resultinf);
     }
-
-    IK_FreeSegment(iktree[a]);
   }
 
-  MEM_freeN(iktree);
   if (ikstretch) {
     MEM_freeN(ikstretch);
   }
@@ -571,6 +687,7 @@ static void execute_posetree(struct Depsgraph *depsgraph,
 
 static void free_posetree(PoseTree *tree)
 {
+  posetree_solver_free(tree);
   BLI_freelistN(&tree->targets);
   if (tree->pchan) {
     MEM_freeN(tree->pchan);
@@ -584,22 +701,113 @@ static void free_posetree(PoseTree *tree)
   MEM_freeN(tree);
 }
 
+static IKSolverPoseData *iksolver_pose_data_create(bPose *pose)
+{
+  IKSolverPoseData *pdata = MEM_callocN(sizeof(IKSolverPoseData), "IKSolverPoseData");
+  bPoseChannel *pchan;
+
+  for (pchan = pose->chanbase.first; pchan; pchan = pchan->next) {
+    if (pchan->constflag & PCHAN_HAS_IK) {
+      pdata->totkey++;
+    }
+  }
+  if (pdata->totkey == 0) {
+    return pdata;
+  }
+
+  pdata->keys = MEM_callocN(sizeof(IKSolverChainKey) * pdata->totkey, "IKSolverChainKey");
+
+  IKSolverChainKey *key = pdata->keys;
+  for (pchan = pose->chanbase.first; pchan; pchan = pchan->next) {
+    if (pchan->constflag & PCHAN_HAS_IK) {
+      key->pchan = pchan;
+      key->con = posetree_constraint_find(pchan);
+      if (key->con) {
+        bKinematicConstraint *data = (bKinematicConstraint *)key->con->data;
+        key->flag = data->flag & IK_TREE_FLAG_MASK;
+        key->rootbone = data->rootbone;
+        key->iterations = data->iterations;
+      }
+      key++;
+    }
+  }
+  return pdata;
+}
+
+/* Check whether the trees built in a previous evaluation still match the constraints, which
+ * can change without the pose being rebuilt (e.g. animated influence or chain length). */
+static bool iksolver_pose_data_is_valid(const IKSolverPoseData *pdata, bPose *pose)
+{
+  int index = 0;
+
+  for (bPoseChannel *pchan = pose->chanbase.first; pchan; pchan = pchan->next) {
+    if ((pchan->constflag & PCHAN_HAS_IK) == 0) {
+      continue;
+    }
+    if (index == pdata->totkey) {
+      return false;
+    }
+
+    const IKSolverChainKey *key = &pdata->keys[index++];
+    bConstraint *con = posetree_constraint_find(pchan);
+    if (key->pchan != pchan || key->con != con) {
+      return false;
+    }
+    if (con) {
+      bKinematicConstraint *data = (bKinematicConstraint *)con->data;
+      if (key->flag != (data->flag & IK_TREE_FLAG_MASK) || key->rootbone != data->rootbone ||
+          key->iterations != data->iterations) {
+        return false;
+      }
+    }
+  }
+  return index == pdata->totkey;
+}
+
+static void iksolver_pose_data_free(bPose *pose)
+{
+  IKSolverPoseData *pdata = pose->ikdata;
+
+  if (pdata) {
+    MEM_SAFE_FREE(pdata->keys);
+    MEM_freeN(pdata);
+    pose->ikdata = NULL;
+  }
+}
+
 ///----------------------------------------
 /// Plugin API for legacy iksolver
 
+/* The trees are kept in the pose channels between evaluations, together with the solver
+ * segments, and only rebuilt when the pose or its IK constraints change. */
 void iksolver_initialize_tree(struct Depsgraph *UNUSED(depsgraph),
                               struct Scene *UNUSED(scene),
                               struct Object *ob,
                               float UNUSED(ctime))
 {
+  bPose *pose = ob->pose;
   bPoseChannel *pchan;
 
-  for (pchan = ob->pose->chanbase.first; pchan; pchan = pchan->next) {
-    if (pchan->constflag & PCHAN_HAS_IK) {  // flag is set on editing constraints
-      initialize_posetree(ob, pchan);       // will attach it to root!
+  if ((pose->flag & POSE_WAS_REBUILT) || pose->ikdata == NULL ||
+      !iksolver_pose_data_is_valid(pose->ikdata, pose)) {
+    iksolver_clear_data(pose);
+
+    for (pchan = pose->chanbase.first; pchan; pchan = pchan->next) {
+      if (pchan->constflag & PCHAN_HAS_IK) {  // flag is set on editing constraints
+        initialize_posetree(ob, pchan);       // will attach it to root!
+      }
     }
+    pose->ikdata = iksolver_pose_data_create(pose);
   }
-  ob->pose->flag &= ~POSE_WAS_REBUILT;
+  else {
+    /* POSE_IKTREE is cleared on every evaluation, mark the roots of the kept trees again. */
+    for (pchan = pose->chanbase.first; pchan; pchan = pchan->next) {
+      if (!BLI_listbase_is_empty(&pchan->iktree)) {
+        pchan->flag |= POSE_IKTREE;
+      }
+    }
+  }
+  pose->flag &= ~POSE_WAS_REBUILT;
 }
 
 void iksolver_execute_tree(struct Depsgraph *depsgraph,
@@ -608,8 +816,7 @@ void iksolver_execute_tree(struct Depsgraph *depsgraph,
                            bPoseChannel *pchan_root,
                            float ctime)
 {
-  while (pchan_root->iktree.first) {
-    PoseTree *tree = pchan_root->iktree.first;
+  for (PoseTree *tree = pchan_root->iktree.first; tree; tree = tree->next) {
     int a;
 
     /* stop on the first tree that isn't a standard IK chain */
@@ -640,25 +847,19 @@ void iksolver_execute_tree(struct Depsgraph *depsgraph,
       /* sets POSE_DONE */
       where_is_ik_bone(tree->pchan[a], tree->basis_change[a]);
     }
-
-    /* 7. and free */
-    BLI_remlink(&pchan_root->iktree, tree);
-    free_posetree(tree);
   }
 }
 
-void iksolver_release_tree(struct Scene *UNUSED(scene), struct Object *ob, float UNUSED(ctime))
+void iksolver_release_tree(struct Scene *UNUSED(scene),
+                           struct Object *UNUSED(ob),
+                           float UNUSED(ctime))
 {
-  iksolver_clear_data(ob->pose);
+  /* The trees are kept for the next evaluation, they are freed by iksolver_clear_data(). */
 }
 
 void iksolver_clear_data(bPose *pose)
 {
   for (bPoseChannel *pchan = pose->chanbase.first; pchan; pchan = pchan->next) {
-    if ((pchan->flag & POSE_IKTREE) == 0) {
-      continue;
-    }
-
     while (pchan->iktree.first) {
       PoseTree *tree = pchan->iktree.first;
 
@@ -671,4 +872,5 @@ void iksolver_clear_data(bPose *pose)
       free_posetree(tree);
     }
   }
+  iksolver_pose_data_free(pose);
 }
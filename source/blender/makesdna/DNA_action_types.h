@@ -197,6 +197,9 @@ typedef struct bPoseChannel_Runtime {
   /* Delta from rest to pose in matrix and DualQuat form. */
   struct Mat4 *bbone_deform_mats;
   struct DualQuat *bbone_dual_quats;
+
+  /* Inputs the segments were computed from, to skip unchanged B-Bones (see armature.c). */
+  struct BBoneSegmentsKey *bbone_segments_key;
 } bPoseChannel_Runtime;
 
 /* ************************************************ */
@@ -464,10 +467,21 @@ typedef struct bPose {
    */
   bPoseChannel **chan_array;
 
+  /* Pose channels sorted by their level in the bone dependency graph, the channels of level i
+   * are level_chans[level_offsets[i]] to level_chans[level_offsets[i + 1] - 1].
+   * Runtime only, see BKE_pose_eval_levels_ensure().
+   */
+  bPoseChannel **level_chans;
+  int *level_offsets;
+
   short flag;
   char _pad[2];
   /** Proxy layer: copy from armature, gets synced. */
   unsigned int proxy_layer;
+  /** Number of levels in level_offsets (excluding the terminating offset). */
+  int totlevel;
+  /** Length of chan_array. */
+  int totchan;
   char _pad1[4];
 
   /** Local action time of this pose. */
@@ -669,6 +683,9 @@ typedef struct bAction {
    */
   int idroot;
   char _pad[4];
+
+  /** Runtime data, F-Curves of every pose channel of evaluated actions, see action.c. */
+  struct ActionChannelCache *channel_cache;
 } bAction;
 
 /* Flags for the action */
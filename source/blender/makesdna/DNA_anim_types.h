@@ -1073,6 +1073,10 @@ typedef struct AnimData {
 
   /** Runtime data, for depsgraph evaluation. */
   FCurve **driver_array;
+  /** Runtime data, resolved RNA paths of the drivers, see anim_sys.c. */
+  struct AnimDriverBindings *driver_bindings;
+  /** Runtime data, resolved RNA paths of the active action F-Curves, see anim_sys.c. */
+  struct AnimActionBindings *action_bindings;
 
   /* settings for animation evaluation */
   /** User-defined settings. */
@@ -161,6 +161,10 @@ typedef enum eArmature_Flag {
   ARM_DS_EXPAND = (1 << 13),
   /** other objects are used for visualizing various states (hack for efficient updates) */
   ARM_HAS_VIZ_DEPS = (1 << 14),
+  /** evaluate the pose in batches of bones per hierarchy level instead of per bone */
+  ARM_POSE_EVAL_BATCHED = (1 << 15),
+  /** standard IK solver starts from the solution of the previous evaluation */
+  ARM_IK_WARM_START = (1 << 16),
 } eArmature_Flag;
 
 /* armature->drawtype */
@@ -114,6 +114,8 @@ typedef struct bConstraintTarget {
 typedef enum eConstraintTargetFlag {
   /** temporary target-struct that needs to be freed after use */
   CONSTRAINT_TAR_TEMP = (1 << 0),
+  /** temporary target-struct in storage of the constraint solver, must not be freed */
+  CONSTRAINT_TAR_SOLVER_STORAGE = (1 << 1),
 } eConstraintTargetFlag;
 
 /* bConstraintTarget/bConstraintOb -> type */
@@ -884,6 +886,8 @@ typedef enum eKinematic_Flags {
   CONSTRAINT_IK_NO_ROT_Z = (1 << 13),
   /* axis relative to target */
   CONSTRAINT_IK_TARGETAXIS = (1 << 14),
+  /* closed form solution for two bone chains */
+  CONSTRAINT_IK_TWO_BONE_ANALYTIC = (1 << 15),
 } eKinematic_Flags;
 
 /* bSplineIKConstraint->flag */
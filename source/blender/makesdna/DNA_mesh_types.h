@@ -37,10 +37,12 @@ struct MEdge;
 struct MFace;
 struct MLoop;
 struct MLoopCol;
+struct MLoopFans;
 struct MLoopTri;
 struct MLoopUV;
 struct MPoly;
 struct MVert;
+struct MVertLoopMap;
 struct Material;
 struct Mesh;
 struct Multires;
@@ -93,6 +95,11 @@ typedef struct Mesh_Runtime {
   int64_t cd_dirty_loop;
   int64_t cd_dirty_poly;
 
+  /**
+   * Unique number assigned on every copy of the mesh, including copy-on-write updates.
+   * Allows caches of evaluated data to detect the mesh they were built from was replaced. */
+  uint64_t copy_stamp;
+
   struct MLoopTri_Store looptris;
 
   /** 'BVHCache', for 'BKE_bvhutil.c' */
@@ -101,6 +108,15 @@ typedef struct Mesh_Runtime {
   /** Non-manifold boundary data for Shrinkwrap Target Project. */
   struct ShrinkwrapBoundaryData *shrinkwrap_data;
 
+  /** Smooth fans used for split normals, may be shared with the mesh this one comes from. */
+  struct MLoopFans *loop_fans;
+  /** Vertex to loops mapping used for vertex normals, shared like `loop_fans`. */
+  struct MVertLoopMap *vert_loop_map;
+  /**
+   * Float version of #MVert.no, only valid when vertex normals are not dirty,
+   * see #BKE_mesh_runtime_vert_normals_get. */
+  float (*vert_normals)[3];
+
   /** Set by modifier stack if only deformed from original. */
   char deformed_only;
   /**
@@ -143,6 +143,8 @@ typedef enum {
   /* DEPRECATED, ONLY USED FOR DO-VERSIONS */
   eSubsurfModifierFlag_SubsurfUv_DEPRECATED = (1 << 3),
   eSubsurfModifierFlag_UseCrease = (1 << 4),
+  eSubsurfModifierFlag_UseStencils = (1 << 5),
+  eSubsurfModifierFlag_UseTopologyCache = (1 << 6),
 } SubsurfModifierFlag;
 
 typedef enum {
@@ -183,6 +183,9 @@ typedef struct Object_Runtime {
   /** Runtime grease pencil evaluated data created by modifiers */
   struct bGPDframe *gpencil_evaluated_frames;
 
+  /** BVH trees of the evaluated mesh kept across evaluations, see bvhutils.c. */
+  struct LinkNode *bvh_persistent;
+
   void *_pad2; /* Padding is here for win32s unconventional struct alignment rules. */
 } Object_Runtime;
 
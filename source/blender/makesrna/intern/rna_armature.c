@@ -1419,6 +1419,26 @@ static void rna_def_armature(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Display Bone Group Colors", "Display bone group colors");
   RNA_def_property_update(prop, 0, "rna_Armature_redraw_data");
 
+  prop = RNA_def_property(srna, "use_batched_evaluation", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", ARM_POSE_EVAL_BATCHED);
+  RNA_def_property_ui_text(
+      prop,
+      "Batched Evaluation",
+      "Evaluate the pose level by level in parallel batches of bones, instead of scheduling "
+      "every bone separately in the dependency graph (faster for rigs with many bones, "
+      "drivers between bones of the same armature may cause dependency cycles)");
+  RNA_def_property_update(prop, 0, "rna_Armature_dependency_update");
+
+  prop = RNA_def_property(srna, "use_ik_warm_start", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", ARM_IK_WARM_START);
+  RNA_def_property_ui_text(
+      prop,
+      "IK Warm Start",
+      "Start the Standard IK solver from the solution of the previously evaluated frame "
+      "(converges in fewer iterations on continuous motion, but the result depends on the "
+      "previously evaluated frame; not used for chains with a pole target)");
+  RNA_def_property_update(prop, 0, "rna_Armature_update_data");
+
   prop = RNA_def_property(srna, "is_editmode", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_funcs(prop, "rna_Armature_is_editmode_get", NULL);
   RNA_def_property_clear_flag(prop, PROP_EDITABLE);
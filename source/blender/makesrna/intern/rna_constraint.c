@@ -1167,6 +1167,15 @@ static void rna_def_constraint_kinematic(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Stretch", "Enable IK Stretching");
   RNA_def_property_update(prop, NC_OBJECT | ND_CONSTRAINT, "rna_Constraint_dependency_update");
 
+  prop = RNA_def_property(srna, "use_two_bone_analytic", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", CONSTRAINT_IK_TWO_BONE_ANALYTIC);
+  RNA_def_property_ui_text(
+      prop,
+      "Analytic Two Bone",
+      "Solve chains of two bones without limits and a single position goal directly instead of "
+      "iteratively, faster but the bend plane of the chain is kept (Standard solver only)");
+  RNA_def_property_update(prop, NC_OBJECT | ND_CONSTRAINT, "rna_Constraint_update");
+
   prop = RNA_def_property(srna, "ik_type", PROP_ENUM, PROP_NONE);
   RNA_def_property_enum_sdna(prop, NULL, "type");
   RNA_def_property_enum_funcs(prop, NULL, "rna_Constraint_ik_type_set", NULL);
@@ -109,6 +109,19 @@ static CustomData *rna_mesh_fdata_helper(Mesh *me)
   return (me->edit_mesh) ? NULL : &me->fdata;
 }
 
+/**
+ * Layers of original meshes may be shared with their copy-on-write copies (see #CD_SHARE),
+ * they get their own copy before data is accessed, which may be for writing.
+ * Evaluated meshes are read-only.
+ */
+static void rna_mesh_layer_unshare(Mesh *me, CustomData *data, int type)
+{
+  if (me->edit_mesh == NULL && (me->id.tag & LIB_TAG_COPIED_ON_WRITE) == 0) {
+    CustomData_unshare_layers(data, CD_TYPE_AS_MASK(type));
+    BKE_mesh_update_customdata_pointers(me, false);
+  }
+}
+
 static CustomData *rna_mesh_vdata(PointerRNA *ptr)
 {
   Mesh *me = rna_mesh(ptr);
@@ -271,8 +284,17 @@ static void rna_Mesh_update_facemask(Main *bmain, Scene *scene, PointerRNA *ptr)
 
 static void rna_MeshVertex_normal_get(PointerRNA *ptr, float *value)
 {
+  Mesh *me = rna_mesh(ptr);
   MVert *mvert = (MVert *)ptr->data;
-  normal_short_to_float_v3(value, mvert->no);
+  const float(*vert_normals)[3] = BKE_mesh_runtime_vert_normals_get(me);
+  const int index = (int)(mvert - me->mvert);
+
+  if (vert_normals && index >= 0 && index < me->totvert) {
+    copy_v3_v3(value, vert_normals[index]);
+  }
+  else {
+    normal_short_to_float_v3(value, mvert->no);
+  }
 }
 
 static void rna_MeshVertex_normal_set(PointerRNA *ptr, const float *value)
@@ -283,6 +305,9 @@ static void rna_MeshVertex_normal_set(PointerRNA *ptr, const float *value)
   copy_v3_v3(no, value);
   normalize_v3(no);
   normal_float_to_short_v3(mvert->no, no);
+
+  /* Float normals would not match anymore. */
+  MEM_SAFE_FREE(rna_mesh(ptr)->runtime.vert_normals);
 }
 
 static float rna_MeshVertex_bevel_weight_get(PointerRNA *ptr)
@@ -518,6 +543,7 @@ static void rna_Mesh_texspace_loc_get(PointerRNA *ptr, float values[3])
 static void rna_MeshVertex_groups_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
 {
   Mesh *me = rna_mesh(ptr);
+  rna_mesh_layer_unshare(me, &me->vdata, CD_MDEFORMVERT);
 
   if (me->dvert) {
     MVert *mvert = (MVert *)ptr->data;
@@ -674,6 +700,7 @@ static void rna_MeshUVLoopLayer_data_begin(CollectionPropertyIterator *iter, Poi
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_unshare(me, &me->ldata, CD_MLOOPUV);
   rna_iterator_array_begin(
       iter, layer->data, sizeof(MLoopUV), (me->edit_mesh) ? 0 : me->totloop, 0, NULL);
 }
@@ -726,6 +753,7 @@ static void rna_MeshLoopColorLayer_data_begin(CollectionPropertyIterator *iter,
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_unshare(me, &me->ldata, CD_MLOOPCOL);
   rna_iterator_array_begin(
       iter, layer->data, sizeof(MLoopCol), (me->edit_mesh) ? 0 : me->totloop, 0, NULL);
 }
@@ -885,6 +913,7 @@ static void rna_MeshSkinVertexLayer_data_begin(CollectionPropertyIterator *iter,
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_unshare(me, &me->vdata, CD_MVERT_SKIN);
   rna_iterator_array_begin(iter, layer->data, sizeof(MVertSkin), me->totvert, 0, NULL);
 }
 
@@ -916,6 +945,7 @@ static void rna_MeshPaintMaskLayer_data_begin(CollectionPropertyIterator *iter,
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_unshare(me, &me->vdata, CD_PAINT_MASK);
   rna_iterator_array_begin(iter, layer->data, sizeof(MFloatProperty), me->totvert, 0, NULL);
 }
 
@@ -945,6 +975,7 @@ static void rna_MeshFaceMapLayer_data_begin(CollectionPropertyIterator *iter, Po
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_unshare(me, &me->pdata, CD_FACEMAP);
   rna_iterator_array_begin(iter, layer->data, sizeof(int), me->totpoly, 0, NULL);
 }
 
@@ -1246,6 +1277,7 @@ static void rna_MeshVertexFloatPropertyLayer_data_begin(CollectionPropertyIterat
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_unshare(me, &me->vdata, CD_PROP_FLT);
   rna_iterator_array_begin(iter, layer->data, sizeof(MFloatProperty), me->totvert, 0, NULL);
 }
 static void rna_MeshPolygonFloatPropertyLayer_data_begin(CollectionPropertyIterator *iter,
@@ -1253,6 +1285,7 @@ static void rna_MeshPolygonFloatPropertyLayer_data_begin(CollectionPropertyItera
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_unshare(me, &me->pdata, CD_PROP_FLT);
   rna_iterator_array_begin(iter, layer->data, sizeof(MFloatProperty), me->totpoly, 0, NULL);
 }
 
@@ -1297,6 +1330,7 @@ static void rna_MeshVertexIntPropertyLayer_data_begin(CollectionPropertyIterator
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_unshare(me, &me->vdata, CD_PROP_INT);
   rna_iterator_array_begin(iter, layer->data, sizeof(MIntProperty), me->totvert, 0, NULL);
 }
 static void rna_MeshPolygonIntPropertyLayer_data_begin(CollectionPropertyIterator *iter,
@@ -1304,6 +1338,7 @@ static void rna_MeshPolygonIntPropertyLayer_data_begin(CollectionPropertyIterato
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_unshare(me, &me->pdata, CD_PROP_INT);
   rna_iterator_array_begin(iter, layer->data, sizeof(MIntProperty), me->totpoly, 0, NULL);
 }
 
@@ -1348,6 +1383,7 @@ static void rna_MeshVertexStringPropertyLayer_data_begin(CollectionPropertyItera
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_unshare(me, &me->vdata, CD_PROP_STR);
   rna_iterator_array_begin(iter, layer->data, sizeof(MStringProperty), me->totvert, 0, NULL);
 }
 static void rna_MeshPolygonStringPropertyLayer_data_begin(CollectionPropertyIterator *iter,
@@ -1355,6 +1391,7 @@ static void rna_MeshPolygonStringPropertyLayer_data_begin(CollectionPropertyIter
 {
   Mesh *me = rna_mesh(ptr);
   CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+  rna_mesh_layer_unshare(me, &me->pdata, CD_PROP_STR);
   rna_iterator_array_begin(iter, layer->data, sizeof(MStringProperty), me->totpoly, 0, NULL);
 }
 
@@ -1396,6 +1433,34 @@ static char *rna_MeshFaceMap_path(PointerRNA *ptr)
 
 /***************************************/
 
+static void rna_Mesh_vertices_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
+{
+  Mesh *me = rna_mesh(ptr);
+  rna_mesh_layer_unshare(me, &me->vdata, CD_MVERT);
+  rna_iterator_array_begin(iter, me->mvert, sizeof(MVert), me->totvert, 0, NULL);
+}
+
+static void rna_Mesh_edges_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
+{
+  Mesh *me = rna_mesh(ptr);
+  rna_mesh_layer_unshare(me, &me->edata, CD_MEDGE);
+  rna_iterator_array_begin(iter, me->medge, sizeof(MEdge), me->totedge, 0, NULL);
+}
+
+static void rna_Mesh_loops_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
+{
+  Mesh *me = rna_mesh(ptr);
+  rna_mesh_layer_unshare(me, &me->ldata, CD_MLOOP);
+  rna_iterator_array_begin(iter, me->mloop, sizeof(MLoop), me->totloop, 0, NULL);
+}
+
+static void rna_Mesh_polygons_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
+{
+  Mesh *me = rna_mesh(ptr);
+  rna_mesh_layer_unshare(me, &me->pdata, CD_MPOLY);
+  rna_iterator_array_begin(iter, me->mpoly, sizeof(MPoly), me->totpoly, 0, NULL);
+}
+
 static int rna_Mesh_tot_vert_get(PointerRNA *ptr)
 {
   Mesh *me = rna_mesh(ptr);
@@ -2749,24 +2814,60 @@ static void rna_def_mesh(BlenderRNA *brna)
 
   prop = RNA_def_property(srna, "vertices", PROP_COLLECTION, PROP_NONE);
   RNA_def_property_collection_sdna(prop, NULL, "mvert", "totvert");
+  RNA_def_property_collection_funcs(prop,
+                                    "rna_Mesh_vertices_begin",
+                                    "rna_iterator_array_next",
+                                    "rna_iterator_array_end",
+                                    "rna_iterator_array_get",
+                                    NULL,
+                                    NULL,
+                                    NULL,
+                                    NULL);
   RNA_def_property_struct_type(prop, "MeshVertex");
   RNA_def_property_ui_text(prop, "Vertices", "Vertices of the mesh");
   rna_def_mesh_vertices(brna, prop);
 
   prop = RNA_def_property(srna, "edges", PROP_COLLECTION, PROP_NONE);
   RNA_def_property_collection_sdna(prop, NULL, "medge", "totedge");
+  RNA_def_property_collection_funcs(prop,
+                                    "rna_Mesh_edges_begin",
+                                    "rna_iterator_array_next",
+                                    "rna_iterator_array_end",
+                                    "rna_iterator_array_get",
+                                    NULL,
+                                    NULL,
+                                    NULL,
+                                    NULL);
   RNA_def_property_struct_type(prop, "MeshEdge");
   RNA_def_property_ui_text(prop, "Edges", "Edges of the mesh");
   rna_def_mesh_edges(brna, prop);
 
   prop = RNA_def_property(srna, "loops", PROP_COLLECTION, PROP_NONE);
   RNA_def_property_collection_sdna(prop, NULL, "mloop", "totloop");
+  RNA_def_property_collection_funcs(prop,
+                                    "rna_Mesh_loops_begin",
+                                    "rna_iterator_array_next",
+                                    "rna_iterator_array_end",
+                                    "rna_iterator_array_get",
+                                    NULL,
+                                    NULL,
+                                    NULL,
+                                    NULL);
   RNA_def_property_struct_type(prop, "MeshLoop");
   RNA_def_property_ui_text(prop, "Loops", "Loops of the mesh (polygon corners)");
   rna_def_mesh_loops(brna, prop);
 
   prop = RNA_def_property(srna, "polygons", PROP_COLLECTION, PROP_NONE);
   RNA_def_property_collection_sdna(prop, NULL, "mpoly", "totpoly");
+  RNA_def_property_collection_funcs(prop,
+                                    "rna_Mesh_polygons_begin",
+                                    "rna_iterator_array_next",
+                                    "rna_iterator_array_end",
+                                    "rna_iterator_array_get",
+                                    NULL,
+                                    NULL,
+                                    NULL,
+                                    NULL);
   RNA_def_property_struct_type(prop, "MeshPolygon");
   RNA_def_property_ui_text(prop, "Polygons", "Polygons of the mesh");
   rna_def_mesh_polygons(brna, prop);
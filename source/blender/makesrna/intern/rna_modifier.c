@@ -1634,6 +1634,24 @@ static void rna_def_modifier_subsurf(BlenderRNA *brna)
   RNA_def_property_ui_text(
       prop, "Use Creases", "Use mesh edge crease information to sharpen edges");
   RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
+  prop = RNA_def_property(srna, "use_topology_cache", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flags", eSubsurfModifierFlag_UseTopologyCache);
+  RNA_def_property_ui_text(prop,
+                           "Cache Topology",
+                           "Keep the subdivided mesh when only vertex positions of the input "
+                           "change, which makes subdivision of deformed meshes faster at the "
+                           "cost of memory");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
+  prop = RNA_def_property(srna, "use_limit_stencils", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flags", eSubsurfModifierFlag_UseStencils);
+  RNA_def_property_ui_text(prop,
+                           "Use Limit Stencils",
+                           "Keep weights of base mesh vertices for every subdivided vertex "
+                           "of the cached topology, which makes its evaluation faster at the "
+                           "cost of more memory");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
 }
 
 static void rna_def_modifier_generic_map_info(StructRNA *srna)
@@ -65,6 +65,18 @@ static void copyData(const ModifierData *md, ModifierData *target, const int fla
   tamd->prevCos = NULL;
 }
 
+static void freeRuntimeData(void *runtime_data)
+{
+  if (runtime_data != NULL) {
+    BKE_armature_skin_cache_free(runtime_data);
+  }
+}
+
+static void freeData(ModifierData *md)
+{
+  freeRuntimeData(md->runtime);
+}
+
 static void requiredDataMask(Object *UNUSED(ob),
                              ModifierData *UNUSED(md),
                              CustomData_MeshMasks *r_cddata_masks)
@@ -134,16 +146,17 @@ static void deformVerts(ModifierData *md,
 
   MOD_previous_vcos_store(md, vertexCos); /* if next modifier needs original vertices */
 
-  armature_deform_verts(amd->object,
-                        ctx->object,
-                        mesh,
-                        vertexCos,
-                        NULL,
-                        numVerts,
-                        amd->deformflag,
-                        (float(*)[3])amd->prevCos,
-                        amd->defgrp_name,
-                        NULL);
+  armature_deform_verts_ex(amd->object,
+                           ctx->object,
+                           mesh,
+                           vertexCos,
+                           NULL,
+                           numVerts,
+                           amd->deformflag,
+                           (float(*)[3])amd->prevCos,
+                           amd->defgrp_name,
+                           NULL,
+                           (struct ArmatureSkinCache **)&md->runtime);
 
   /* free cache */
   if (amd->prevCos) {
@@ -164,16 +177,17 @@ static void deformVertsEM(ModifierData *md,
 
   MOD_previous_vcos_store(md, vertexCos); /* if next modifier needs original vertices */
 
-  armature_deform_verts(amd->object,
-                        ctx->object,
-                        mesh_src,
-                        vertexCos,
-                        NULL,
-                        numVerts,
-                        amd->deformflag,
-                        (float(*)[3])amd->prevCos,
-                        amd->defgrp_name,
-                        NULL);
+  armature_deform_verts_ex(amd->object,
+                           ctx->object,
+                           mesh_src,
+                           vertexCos,
+                           NULL,
+                           numVerts,
+                           amd->deformflag,
+                           (float(*)[3])amd->prevCos,
+                           amd->defgrp_name,
+                           NULL,
+                           (struct ArmatureSkinCache **)&md->runtime);
 
   /* free cache */
   if (amd->prevCos) {
@@ -197,16 +211,17 @@ static void deformMatricesEM(ModifierData *md,
   ArmatureModifierData *amd = (ArmatureModifierData *)md;
   Mesh *mesh_src = MOD_deform_mesh_eval_get(ctx->object, em, mesh, NULL, numVerts, false, false);
 
-  armature_deform_verts(amd->object,
-                        ctx->object,
-                        mesh_src,
-                        vertexCos,
-                        defMats,
-                        numVerts,
-                        amd->deformflag,
-                        NULL,
-                        amd->defgrp_name,
-                        NULL);
+  armature_deform_verts_ex(amd->object,
+                           ctx->object,
+                           mesh_src,
+                           vertexCos,
+                           defMats,
+                           numVerts,
+                           amd->deformflag,
+                           NULL,
+                           amd->defgrp_name,
+                           NULL,
+                           (struct ArmatureSkinCache **)&md->runtime);
 
   if (mesh_src != mesh) {
     BKE_id_free(NULL, mesh_src);
@@ -223,16 +238,17 @@ static void deformMatrices(ModifierData *md,
   ArmatureModifierData *amd = (ArmatureModifierData *)md;
   Mesh *mesh_src = MOD_deform_mesh_eval_get(ctx->object, NULL, mesh, NULL, numVerts, false, false);
 
-  armature_deform_verts(amd->object,
-                        ctx->object,
-                        mesh_src,
-                        vertexCos,
-                        defMats,
-                        numVerts,
-                        amd->deformflag,
-                        NULL,
-                        amd->defgrp_name,
-                        NULL);
+  armature_deform_verts_ex(amd->object,
+                           ctx->object,
+                           mesh_src,
+                           vertexCos,
+                           defMats,
+                           numVerts,
+                           amd->deformflag,
+                           NULL,
+                           amd->defgrp_name,
+                           NULL,
+                           (struct ArmatureSkinCache **)&md->runtime);
 
   if (mesh_src != mesh) {
     BKE_id_free(NULL, mesh_src);
@@ -257,7 +273,7 @@ ModifierTypeInfo modifierType_Armature = {
 
     /* initData */ initData,
     /* requiredDataMask */ requiredDataMask,
-    /* freeData */ NULL,
+    /* freeData */ freeData,
     /* isDisabled */ isDisabled,
     /* updateDepsgraph */ updateDepsgraph,
     /* dependsOnTime */ NULL,
@@ -265,5 +281,5 @@ ModifierTypeInfo modifierType_Armature = {
     /* foreachObjectLink */ foreachObjectLink,
     /* foreachIDLink */ NULL,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
 };
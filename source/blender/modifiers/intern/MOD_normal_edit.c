@@ -550,6 +550,10 @@ static Mesh *normalEditModifier_do(NormalEditModifierData *enmd,
                              polynors,
                              (result->runtime.cd_dirty_vert & CD_MASK_NORMAL) ? false : true);
 
+  /* Only #MVert.no got updated, float vertex normals would remain outdated. */
+  if (result->runtime.cd_dirty_vert & CD_MASK_NORMAL) {
+    MEM_SAFE_FREE(result->runtime.vert_normals);
+  }
   result->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
 
   if (use_current_clnors) {
@@ -32,6 +32,7 @@
 #include "DNA_mesh_types.h"
 
 #include "BKE_cdderivedmesh.h"
+#include "BKE_object.h"
 #include "BKE_scene.h"
 #include "BKE_subdiv.h"
 #include "BKE_subdiv_ccg.h"
@@ -48,8 +49,18 @@
 typedef struct SubsurfRuntimeData {
   /* Cached subdivision surface descriptor, with topology and settings. */
   struct Subdiv *subdiv;
+  /* Last result, created for the cached descriptor. */
+  struct SubdivMeshCache *mesh_cache;
 } SubsurfRuntimeData;
 
+static void subsurf_runtime_mesh_cache_free(SubsurfRuntimeData *runtime_data)
+{
+  if (runtime_data->mesh_cache != NULL) {
+    BKE_subdiv_mesh_cache_free(runtime_data->mesh_cache);
+    runtime_data->mesh_cache = NULL;
+  }
+}
+
 static void initData(ModifierData *md)
 {
   SubsurfModifierData *smd = (SubsurfModifierData *)md;
@@ -79,6 +90,7 @@ static void freeRuntimeData(void *runtime_data_v)
     return;
   }
   SubsurfRuntimeData *runtime_data = (SubsurfRuntimeData *)runtime_data_v;
+  subsurf_runtime_mesh_cache_free(runtime_data);
   if (runtime_data->subdiv != NULL) {
     BKE_subdiv_free(runtime_data->subdiv);
   }
@@ -136,6 +148,9 @@ static Subdiv *subdiv_descriptor_ensure(SubsurfModifierData *smd,
 {
   SubsurfRuntimeData *runtime_data = (SubsurfRuntimeData *)smd->modifier.runtime;
   Subdiv *subdiv = BKE_subdiv_update_from_mesh(runtime_data->subdiv, subdiv_settings, mesh);
+  if (subdiv != runtime_data->subdiv) {
+    subsurf_runtime_mesh_cache_free(runtime_data);
+  }
   runtime_data->subdiv = subdiv;
   return subdiv;
 }
@@ -151,6 +166,9 @@ static void subdiv_mesh_settings_init(SubdivToMeshSettings *settings,
   settings->use_optimal_display = (smd->flags & eSubsurfModifierFlag_ControlEdges);
 }
 
+/* Only vertices of a mesh deformed from the object's own mesh change during
+ * playback, so topology and custom data of the previous result can be re-used
+ * when the topology cache is enabled. */
 static Mesh *subdiv_as_mesh(SubsurfModifierData *smd,
                             const ModifierEvalContext *ctx,
                             Mesh *mesh,
@@ -162,7 +180,19 @@ static Mesh *subdiv_as_mesh(SubsurfModifierData *smd,
   if (mesh_settings.resolution < 3) {
     return result;
   }
-  result = BKE_subdiv_to_mesh(subdiv, &mesh_settings, mesh);
+  SubsurfRuntimeData *runtime_data = (SubsurfRuntimeData *)smd->modifier.runtime;
+  Object *object = ctx->object;
+  const Mesh *base_mesh = NULL;
+  if (object->type == OB_MESH && (object->id.tag & LIB_TAG_COPIED_ON_WRITE)) {
+    base_mesh = BKE_object_get_pre_modified_mesh(object);
+  }
+  if (base_mesh == NULL || (smd->flags & eSubsurfModifierFlag_UseTopologyCache) == 0) {
+    subsurf_runtime_mesh_cache_free(runtime_data);
+    return BKE_subdiv_to_mesh(subdiv, &mesh_settings, mesh);
+  }
+  const bool use_limit_stencils = (smd->flags & eSubsurfModifierFlag_UseStencils);
+  result = BKE_subdiv_to_mesh_cached(
+      subdiv, &mesh_settings, mesh, base_mesh, use_limit_stencils, &runtime_data->mesh_cache);
   return result;
 }
 
@@ -0,0 +1,276 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_ID.h"
+#include "DNA_action_types.h"
+#include "DNA_armature_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_action.h"
+#include "BKE_customdata.h"
+#include "BKE_deform.h"
+#include "BKE_lattice.h"
+#include "BKE_library.h"
+#include "BKE_mesh.h"
+
+#include "CLG_log.h"
+}
+
+#define BONES_NUM 6
+/* One vertex group more than bones, to have a group which does not deform. */
+#define DEFGROUPS_NUM (BONES_NUM + 1)
+/* Not a multiple of the number of vertices deformed together by the SIMD kernels. */
+#define VERTS_NUM 103
+
+#define DEFORM_EPS 1e-4f
+
+/* Deforming without defMats uses the packed SIMD kernels where available,
+ * asking for defMats forces armature_vert_task() for every vertex.
+ * Both have to give the same coordinates. */
+class ArmatureDeformTest : public testing::Test {
+ protected:
+  Object arm_ob;
+  Object ob;
+  bArmature arm;
+  Bone bones[BONES_NUM];
+  Mesh *mesh;
+  float (*orig_cos)[3];
+
+  /* Log references keep their type once used, which is freed along with the log context. */
+  static void SetUpTestCase()
+  {
+    CLG_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    CLG_exit();
+  }
+
+  virtual void SetUp()
+  {
+    BLI_threadapi_init();
+
+    memset(&arm_ob, 0, sizeof(arm_ob));
+    memset(&ob, 0, sizeof(ob));
+    memset(&arm, 0, sizeof(arm));
+    memset(bones, 0, sizeof(bones));
+
+    RNG *rng = BLI_rng_new(0);
+
+    arm_ob.type = OB_ARMATURE;
+    arm_ob.data = &arm;
+    arm_ob.pose = (bPose *)MEM_callocN(sizeof(bPose), __func__);
+    unit_m4(arm_ob.obmat);
+    copy_v3_fl3(arm_ob.obmat[3], 0.5f, -1.0f, 2.0f);
+
+    ob.type = OB_MESH;
+    unit_m4(ob.obmat);
+    copy_v3_fl3(ob.obmat[3], -1.0f, 0.0f, 0.25f);
+
+    for (int i = 0; i < DEFGROUPS_NUM; i++) {
+      bDeformGroup *dg = (bDeformGroup *)MEM_callocN(sizeof(bDeformGroup), __func__);
+      BLI_snprintf(dg->name, sizeof(dg->name), "Bone.%d", i);
+      BLI_addtail(&ob.defbase, dg);
+    }
+
+    for (int i = 0; i < BONES_NUM; i++) {
+      Bone *bone = &bones[i];
+      BLI_snprintf(bone->name, sizeof(bone->name), "Bone.%d", i);
+      bone->segments = 1;
+      unit_m4(bone->arm_mat);
+      copy_v3_fl3(bone->arm_mat[3], (float)i, 0.5f * (float)i, 0.0f);
+
+      bPoseChannel *pchan = BKE_pose_channel_verify(arm_ob.pose, bone->name);
+      pchan->bone = bone;
+
+      float rot[3], loc[3], size[3];
+      for (int c = 0; c < 3; c++) {
+        rot[c] = BLI_rng_get_float(rng) * (float)M_PI;
+        loc[c] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+        size[c] = 1.0f;
+      }
+      /* Non-uniform scale goes through the scale of the dual quaternions. */
+      if (i % 2) {
+        copy_v3_fl3(size, 1.5f, 0.75f, 1.25f);
+      }
+      loc_eul_size_to_mat4(pchan->chan_mat, loc, rot, size);
+      mat4_to_dquat(&pchan->runtime.deform_dual_quat, bone->arm_mat, pchan->chan_mat);
+    }
+
+    mesh = BKE_mesh_new_nomain(VERTS_NUM, 0, 0, 0, 0);
+    mesh->dvert = (MDeformVert *)CustomData_add_layer(
+        &mesh->vdata, CD_MDEFORMVERT, CD_CALLOC, NULL, VERTS_NUM);
+    ob.data = mesh;
+    orig_cos = (float(*)[3])MEM_malloc_arrayN(VERTS_NUM, sizeof(*orig_cos), __func__);
+
+    for (int i = 0; i < VERTS_NUM; i++) {
+      MDeformVert *dvert = &mesh->dvert[i];
+      BLI_rng_get_float_unit_v3(rng, orig_cos[i]);
+      mul_v3_fl(orig_cos[i], 4.0f);
+      copy_v3_v3(mesh->mvert[i].co, orig_cos[i]);
+
+      /* Vertices without weights, with a few of them, and with more than the packed table
+       * stores (those are deformed by the scalar path in both cases). */
+      const int totweight = (i == VERTS_NUM - 1) ? 2 * DEFGROUPS_NUM : i % 5;
+      for (int j = 0; j < totweight; j++) {
+        defvert_add_index_notest(
+            dvert, BLI_rng_get_int(rng) % DEFGROUPS_NUM, 0.1f + BLI_rng_get_float(rng));
+      }
+    }
+
+    BLI_rng_free(rng);
+
+    /* Influence tables are only cached for copy-on-write meshes, they get a copy stamp. */
+    Mesh *mesh_orig = mesh;
+    mesh = BKE_mesh_copy_for_eval(mesh_orig, false);
+    mesh->id.tag |= LIB_TAG_COPIED_ON_WRITE;
+    ob.data = mesh;
+    BKE_id_free(NULL, mesh_orig);
+  }
+
+  virtual void TearDown()
+  {
+    BKE_pose_free(arm_ob.pose);
+    BLI_freelistN(&ob.defbase);
+    BKE_id_free(NULL, mesh);
+    MEM_freeN(orig_cos);
+
+    BLI_threadapi_exit();
+  }
+
+  float (*deform(const int deformflag, const bool use_scalar, struct ArmatureSkinCache **cache))[3]
+  {
+    float(*cos)[3] = (float(*)[3])MEM_dupallocN(orig_cos);
+    float(*def_mats)[3][3] = NULL;
+
+    if (use_scalar) {
+      def_mats = (float(*)[3][3])MEM_malloc_arrayN(VERTS_NUM, sizeof(*def_mats), __func__);
+      for (int i = 0; i < VERTS_NUM; i++) {
+        unit_m3(def_mats[i]);
+      }
+    }
+
+    armature_deform_verts_ex(
+        &arm_ob, &ob, mesh, cos, def_mats, VERTS_NUM, deformflag, NULL, NULL, NULL, cache);
+
+    MEM_SAFE_FREE(def_mats);
+    return cos;
+  }
+
+  void expect_packed_matches_scalar(const int deformflag)
+  {
+    float(*scalar_cos)[3] = deform(deformflag, true, NULL);
+    float(*packed_cos)[3] = deform(deformflag, false, NULL);
+
+    for (int i = 0; i < VERTS_NUM; i++) {
+      EXPECT_V3_NEAR(packed_cos[i], scalar_cos[i], DEFORM_EPS);
+    }
+
+    /* Cached influence tables and bone indices are used from the second evaluation on. */
+    struct ArmatureSkinCache *cache = NULL;
+    for (int pass = 0; pass < 2; pass++) {
+      float(*cached_cos)[3] = deform(deformflag, false, &cache);
+      for (int i = 0; i < VERTS_NUM; i++) {
+        EXPECT_V3_NEAR(cached_cos[i], scalar_cos[i], DEFORM_EPS);
+      }
+      MEM_freeN(cached_cos);
+    }
+    ASSERT_TRUE(cache != NULL);
+    BKE_armature_skin_cache_free(cache);
+
+    MEM_freeN(scalar_cos);
+    MEM_freeN(packed_cos);
+  }
+};
+
+TEST_F(ArmatureDeformTest, LinearBlend)
+{
+  expect_packed_matches_scalar(ARM_DEF_VGROUP);
+}
+
+TEST_F(ArmatureDeformTest, DualQuaternion)
+{
+  expect_packed_matches_scalar(ARM_DEF_VGROUP | ARM_DEF_QUATERNION);
+}
+
+TEST_F(ArmatureDeformTest, NonDeformingBone)
+{
+  bones[0].flag |= BONE_NO_DEFORM;
+  expect_packed_matches_scalar(ARM_DEF_VGROUP);
+}
+
+TEST_F(ArmatureDeformTest, BonesMoved)
+{
+  float(*rest_cos)[3] = deform(ARM_DEF_VGROUP, false, NULL);
+
+  /* The skinned result must follow the pose channels. */
+  LISTBASE_FOREACH (bPoseChannel *, pchan, &arm_ob.pose->chanbase) {
+    pchan->chan_mat[3][2] += 1.0f;
+  }
+  float(*moved_cos)[3] = deform(ARM_DEF_VGROUP, false, NULL);
+  float(*scalar_cos)[3] = deform(ARM_DEF_VGROUP, true, NULL);
+
+  bool any_moved = false;
+  for (int i = 0; i < VERTS_NUM; i++) {
+    EXPECT_V3_NEAR(moved_cos[i], scalar_cos[i], DEFORM_EPS);
+    any_moved |= !compare_v3v3(moved_cos[i], rest_cos[i], DEFORM_EPS);
+  }
+  EXPECT_TRUE(any_moved);
+
+  MEM_freeN(rest_cos);
+  MEM_freeN(moved_cos);
+  MEM_freeN(scalar_cos);
+}
+
+TEST_F(ArmatureDeformTest, WeightsChanged)
+{
+  struct ArmatureSkinCache *cache = NULL;
+  float(*rest_cos)[3] = deform(ARM_DEF_VGROUP, false, &cache);
+
+  /* Weights written in place, then copied to a new evaluated mesh which references the same
+   * array: the cached table must not be used. */
+  Mesh *mesh_prev = mesh;
+  mesh = BKE_mesh_copy_for_eval(mesh_prev, true);
+  mesh->id.tag |= LIB_TAG_COPIED_ON_WRITE;
+  ob.data = mesh;
+  EXPECT_EQ(mesh->dvert, mesh_prev->dvert);
+  for (int i = 0; i < VERTS_NUM; i++) {
+    MDeformVert *dvert = &mesh->dvert[i];
+    if (dvert->totweight != 0) {
+      dvert->dw[0].def_nr = (dvert->dw[0].def_nr + 1) % DEFGROUPS_NUM;
+    }
+  }
+
+  float(*cached_cos)[3] = deform(ARM_DEF_VGROUP, false, &cache);
+  float(*scalar_cos)[3] = deform(ARM_DEF_VGROUP, true, NULL);
+
+  bool any_moved = false;
+  for (int i = 0; i < VERTS_NUM; i++) {
+    EXPECT_V3_NEAR(cached_cos[i], scalar_cos[i], DEFORM_EPS);
+    any_moved |= !compare_v3v3(cached_cos[i], rest_cos[i], DEFORM_EPS);
+  }
+  EXPECT_TRUE(any_moved);
+
+  BKE_armature_skin_cache_free(cache);
+  BKE_id_free(NULL, mesh);
+  mesh = mesh_prev;
+  ob.data = mesh;
+
+  MEM_freeN(rest_cos);
+  MEM_freeN(cached_cos);
+  MEM_freeN(scalar_cos);
+}
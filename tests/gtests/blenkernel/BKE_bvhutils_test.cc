@@ -0,0 +1,212 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BKE_mesh_test_util.h"
+
+extern "C" {
+#include "BLI_kdopbvh.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_ID.h"
+#include "DNA_object_types.h"
+
+#include "BKE_bvhutils.h"
+#include "BKE_library.h"
+}
+
+#define GRID_SIZE 16
+/* Above KDOPBVH_THREAD_LEAF_THRESHOLD, trees are built and refitted in parallel. */
+#define GRID_SIZE_THREADED 40
+#define QUERIES_NUM 200
+#define DIST_EPS 1e-5f
+
+/* Trees of the evaluated mesh of an object are kept by the object and refitted
+ * to the next evaluated mesh, they must answer queries like freshly built ones. */
+class BVHPersistentTest : public testing::Test {
+ protected:
+  Object ob;
+  int grid_size;
+
+  virtual void SetUp()
+  {
+    BLI_threadapi_init();
+
+    memset(&ob, 0, sizeof(ob));
+    ob.type = OB_MESH;
+    ob.id.tag |= LIB_TAG_COPIED_ON_WRITE;
+    grid_set(GRID_SIZE);
+  }
+
+  virtual void TearDown()
+  {
+    BKE_bvhtree_object_persistent_free(&ob);
+    object_mesh_eval_set(NULL);
+
+    BLI_threadapi_exit();
+  }
+
+  /* Same as a new evaluation of the object. */
+  void object_mesh_eval_set(Mesh *mesh)
+  {
+    if (ob.runtime.mesh_eval != NULL) {
+      BKE_bvhtree_object_persistent_invalidate(&ob);
+      BKE_id_free(NULL, ob.runtime.mesh_eval);
+    }
+    ob.runtime.mesh_eval = mesh;
+    ob.runtime.is_mesh_eval_owned = (mesh != NULL);
+  }
+
+  void grid_set(const int size)
+  {
+    grid_size = size;
+    object_mesh_eval_set(mesh_test_grid_create(size));
+  }
+
+  Mesh *mesh_deformed(const unsigned int seed, const float scale)
+  {
+    Mesh *mesh = BKE_mesh_copy_for_eval(ob.runtime.mesh_eval, false);
+    mesh_test_verts_jitter(mesh, seed, scale);
+    return mesh;
+  }
+
+  /* Compare nearest points found in the tree with the ones of a tree built from scratch. */
+  void expect_nearest_match(BVHTreeFromMesh *data, const int bvh_cache_type)
+  {
+    Mesh *mesh = ob.runtime.mesh_eval;
+    BVHTreeFromMesh data_ref = {NULL};
+    BKE_bvhtree_from_mesh_get(&data_ref, mesh, bvh_cache_type, 4);
+    ASSERT_TRUE(data_ref.tree != NULL);
+    EXPECT_NE(data->tree, data_ref.tree);
+
+    RNG *rng = BLI_rng_new(0);
+    for (int i = 0; i < QUERIES_NUM; i++) {
+      float co[3];
+      co[0] = BLI_rng_get_float(rng) * (grid_size + 2) - 1.0f;
+      co[1] = BLI_rng_get_float(rng) * (grid_size + 2) - 1.0f;
+      co[2] = BLI_rng_get_float(rng) * 4.0f - grid_size / 2;
+
+      BVHTreeNearest nearest, nearest_ref;
+      nearest.index = nearest_ref.index = -1;
+      nearest.dist_sq = nearest_ref.dist_sq = FLT_MAX;
+      BLI_bvhtree_find_nearest(data->tree, co, &nearest, data->nearest_callback, data);
+      BLI_bvhtree_find_nearest(
+          data_ref.tree, co, &nearest_ref, data_ref.nearest_callback, &data_ref);
+
+      EXPECT_NE(nearest.index, -1);
+      EXPECT_NEAR(nearest.dist_sq, nearest_ref.dist_sq, DIST_EPS);
+      /* Several points of the surface can be nearest, any of them will do. */
+      EXPECT_NEAR(len_squared_v3v3(co, nearest.co), nearest.dist_sq, DIST_EPS);
+    }
+    BLI_rng_free(rng);
+
+    free_bvhtree_from_mesh(&data_ref);
+  }
+
+  void expect_persistent_tree_follows_mesh(const int bvh_cache_type)
+  {
+    BVHTreeFromMesh data;
+    BVHTree *tree = BKE_bvhtree_from_object_mesh_get(
+        &data, &ob, ob.runtime.mesh_eval, bvh_cache_type, 4);
+    ASSERT_TRUE(tree != NULL);
+    EXPECT_TRUE(data.cached);
+    expect_nearest_match(&data, bvh_cache_type);
+    free_bvhtree_from_mesh(&data);
+
+    /* Small deformations are refitted, the tree is kept. */
+    for (unsigned int seed = 1; seed < 4; seed++) {
+      object_mesh_eval_set(mesh_deformed(seed, 0.1f));
+      BVHTree *tree_next = BKE_bvhtree_from_object_mesh_get(
+          &data, &ob, ob.runtime.mesh_eval, bvh_cache_type, 4);
+      EXPECT_EQ(tree_next, tree);
+      expect_nearest_match(&data, bvh_cache_type);
+      free_bvhtree_from_mesh(&data);
+    }
+
+    /* Large ones may rebuild it, queries must not notice. */
+    object_mesh_eval_set(mesh_deformed(4, 4.0f));
+    BKE_bvhtree_from_object_mesh_get(&data, &ob, ob.runtime.mesh_eval, bvh_cache_type, 4);
+    expect_nearest_match(&data, bvh_cache_type);
+    free_bvhtree_from_mesh(&data);
+
+    /* Same for other topology. */
+    object_mesh_eval_set(mesh_test_grid_create(grid_size / 2));
+    BKE_bvhtree_from_object_mesh_get(&data, &ob, ob.runtime.mesh_eval, bvh_cache_type, 4);
+    expect_nearest_match(&data, bvh_cache_type);
+    free_bvhtree_from_mesh(&data);
+  }
+};
+
+TEST_F(BVHPersistentTest, Verts)
+{
+  expect_persistent_tree_follows_mesh(BVHTREE_FROM_VERTS);
+}
+
+TEST_F(BVHPersistentTest, LoopTri)
+{
+  expect_persistent_tree_follows_mesh(BVHTREE_FROM_LOOPTRI);
+}
+
+TEST_F(BVHPersistentTest, VertsThreaded)
+{
+  grid_set(GRID_SIZE_THREADED);
+  expect_persistent_tree_follows_mesh(BVHTREE_FROM_VERTS);
+}
+
+TEST_F(BVHPersistentTest, LoopTriThreaded)
+{
+  grid_set(GRID_SIZE_THREADED);
+  expect_persistent_tree_follows_mesh(BVHTREE_FROM_LOOPTRI);
+}
+
+TEST_F(BVHPersistentTest, LoopTriTopologyChanged)
+{
+  BVHTreeFromMesh data;
+  BKE_bvhtree_from_object_mesh_get(&data, &ob, ob.runtime.mesh_eval, BVHTREE_FROM_LOOPTRI, 4);
+  free_bvhtree_from_mesh(&data);
+
+  /* Same number of triangles, different vertices: the tree can not be refitted. */
+  Mesh *mesh = BKE_mesh_copy_for_eval(ob.runtime.mesh_eval, false);
+  for (int i = 0; i < mesh->totloop; i++) {
+    mesh->mloop[i].v = (mesh->mloop[i].v + 1) % (unsigned int)mesh->totvert;
+  }
+  object_mesh_eval_set(mesh);
+
+  BKE_bvhtree_from_object_mesh_get(&data, &ob, ob.runtime.mesh_eval, BVHTREE_FROM_LOOPTRI, 4);
+  expect_nearest_match(&data, BVHTREE_FROM_LOOPTRI);
+  free_bvhtree_from_mesh(&data);
+}
+
+TEST_F(BVHPersistentTest, NotCopiedOnWrite)
+{
+  /* Only evaluated objects keep trees, others use the cache of the mesh. */
+  ob.id.tag &= ~LIB_TAG_COPIED_ON_WRITE;
+
+  BVHTreeFromMesh data, data_mesh;
+  BVHTree *tree = BKE_bvhtree_from_object_mesh_get(
+      &data, &ob, ob.runtime.mesh_eval, BVHTREE_FROM_LOOPTRI, 4);
+  BVHTree *tree_mesh = BKE_bvhtree_from_mesh_get(
+      &data_mesh, ob.runtime.mesh_eval, BVHTREE_FROM_LOOPTRI, 4);
+  EXPECT_EQ(tree, tree_mesh);
+  EXPECT_TRUE(ob.runtime.bvh_persistent == NULL);
+
+  free_bvhtree_from_mesh(&data);
+  free_bvhtree_from_mesh(&data_mesh);
+}
+
+TEST_F(BVHPersistentTest, NoUsersLeft)
+{
+  BVHTreeFromMesh data;
+  BKE_bvhtree_from_object_mesh_get(&data, &ob, ob.runtime.mesh_eval, BVHTREE_FROM_VERTS, 4);
+  free_bvhtree_from_mesh(&data);
+
+  /* Trees used for the previous evaluated mesh are kept for the next one. */
+  object_mesh_eval_set(mesh_deformed(1, 0.1f));
+  EXPECT_TRUE(ob.runtime.bvh_persistent != NULL);
+
+  /* Nothing asked for them since, like after removing the Shrinkwrap modifiers targeting the
+   * object: they are freed. */
+  object_mesh_eval_set(mesh_deformed(2, 0.1f));
+  EXPECT_TRUE(ob.runtime.bvh_persistent == NULL);
+}
@@ -0,0 +1,188 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BKE_mesh_test_util.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_ID.h"
+
+#include "BKE_customdata.h"
+#include "BKE_library.h"
+}
+
+#define TOTELEM 64
+#define GRID_SIZE 4
+
+/* Layers copied with CD_SHARE use the data of their source until they are written to,
+ * the data is freed along with its last user. */
+class CustomDataShareTest : public testing::Test {
+ protected:
+  CustomData source;
+  unsigned int blocks_in_use;
+
+  virtual void SetUp()
+  {
+    BLI_threadapi_init();
+
+    /* Created on first use and kept until exit, not to be counted. */
+    BLI_task_scheduler_get();
+    blocks_in_use = MEM_get_memory_blocks_in_use();
+
+    CustomData_reset(&source);
+    float *values = (float *)CustomData_add_layer(
+        &source, CD_PROP_FLT, CD_CALLOC, NULL, TOTELEM);
+    for (int i = 0; i < TOTELEM; i++) {
+      values[i] = (float)i;
+    }
+  }
+
+  virtual void TearDown()
+  {
+    /* Shared data must neither leak nor be freed twice. */
+    EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use);
+
+    BLI_threadapi_exit();
+  }
+
+  static float *layer_values(CustomData *data)
+  {
+    return (float *)CustomData_get_layer(data, CD_PROP_FLT);
+  }
+
+  static void expect_source_values(const float *values)
+  {
+    for (int i = 0; i < TOTELEM; i++) {
+      EXPECT_EQ(values[i], (float)i);
+    }
+  }
+};
+
+TEST_F(CustomDataShareTest, CopyShares)
+{
+  CustomData copy;
+  CustomData_copy(&source, &copy, CD_MASK_PROP_FLT, CD_SHARE, TOTELEM);
+  EXPECT_EQ(layer_values(&copy), layer_values(&source));
+
+  /* Writers get their own copy, other users keep seeing the data unchanged. */
+  CustomData_unshare_layers(&copy, CD_MASK_PROP_FLT);
+  float *values = layer_values(&copy);
+  EXPECT_NE(values, layer_values(&source));
+  values[0] = -1.0f;
+  expect_source_values(layer_values(&source));
+
+  CustomData_free(&copy, TOTELEM);
+  CustomData_free(&source, TOTELEM);
+}
+
+TEST_F(CustomDataShareTest, LastUserFrees)
+{
+  CustomData copy_a, copy_b;
+  CustomData_copy(&source, &copy_a, CD_MASK_PROP_FLT, CD_SHARE, TOTELEM);
+  CustomData_copy(&copy_a, &copy_b, CD_MASK_PROP_FLT, CD_SHARE, TOTELEM);
+  const float *values = layer_values(&source);
+
+  /* Source goes away first, copies keep the data alive. */
+  CustomData_free(&source, TOTELEM);
+  EXPECT_EQ(layer_values(&copy_a), values);
+  expect_source_values(layer_values(&copy_b));
+
+  CustomData_unshare_layers(&copy_a, CD_MASK_PROP_FLT);
+  EXPECT_NE(layer_values(&copy_a), values);
+  CustomData_free(&copy_a, TOTELEM);
+
+  /* Only user left, un-sharing does not copy. */
+  CustomData_unshare_layers(&copy_b, CD_MASK_PROP_FLT);
+  EXPECT_EQ(layer_values(&copy_b), values);
+  expect_source_values(layer_values(&copy_b));
+  CustomData_free(&copy_b, TOTELEM);
+}
+
+TEST_F(CustomDataShareTest, DuplicateReferencedUnshares)
+{
+  CustomData copy;
+  CustomData_copy(&source, &copy, CD_MASK_PROP_FLT, CD_SHARE, TOTELEM);
+
+  CustomData_duplicate_referenced_layer(&copy, CD_PROP_FLT, TOTELEM);
+  EXPECT_NE(layer_values(&copy), layer_values(&source));
+  expect_source_values(layer_values(&copy));
+
+  CustomData_free(&source, TOTELEM);
+  CustomData_free(&copy, TOTELEM);
+}
+
+TEST_F(CustomDataShareTest, ReferenceOfSharedShares)
+{
+  CustomData copy, reference;
+  CustomData_copy(&source, &copy, CD_MASK_PROP_FLT, CD_SHARE, TOTELEM);
+
+  /* A reference to shared data would not notice the data being freed or written to. */
+  CustomData_copy(&copy, &reference, CD_MASK_PROP_FLT, CD_REFERENCE, TOTELEM);
+  EXPECT_EQ(layer_values(&reference), layer_values(&source));
+  EXPECT_FALSE(reference.layers[0].flag & CD_FLAG_NOFREE);
+
+  CustomData_free(&source, TOTELEM);
+  CustomData_free(&copy, TOTELEM);
+  expect_source_values(layer_values(&reference));
+  CustomData_free(&reference, TOTELEM);
+}
+
+TEST_F(CustomDataShareTest, NoFreeSourceDuplicated)
+{
+  /* Data owned by someone else can't be shared, it may be freed any time. */
+  CustomData reference, copy;
+  CustomData_copy(&source, &reference, CD_MASK_PROP_FLT, CD_REFERENCE, TOTELEM);
+  CustomData_copy(&reference, &copy, CD_MASK_PROP_FLT, CD_SHARE, TOTELEM);
+  EXPECT_NE(layer_values(&copy), layer_values(&source));
+  expect_source_values(layer_values(&copy));
+
+  CustomData_free(&reference, TOTELEM);
+  CustomData_free(&source, TOTELEM);
+  CustomData_free(&copy, TOTELEM);
+}
+
+/* Meshes copied like copy-on-write meshes of the depsgraph share their layers. */
+TEST_F(CustomDataShareTest, MeshCopyOnWrite)
+{
+  CustomData_free(&source, TOTELEM);
+
+  /* Outdated normals, so that calculating them changes the data. */
+  Mesh *mesh = mesh_test_grid_create(GRID_SIZE);
+  for (int i = 0; i < mesh->totvert; i++) {
+    memset(mesh->mvert[i].no, 0, sizeof(mesh->mvert[i].no));
+  }
+  MVert *mvert_orig = (MVert *)MEM_dupallocN(mesh->mvert);
+
+  Mesh *mesh_cow;
+  BKE_id_copy_ex(
+      NULL, &mesh->id, (ID **)&mesh_cow, LIB_ID_COPY_LOCALIZE | LIB_ID_COPY_CD_SHARE);
+  EXPECT_EQ(mesh_cow->mvert, mesh->mvert);
+  EXPECT_EQ(mesh_cow->mpoly, mesh->mpoly);
+
+  /* Evaluation writes normals in place, the original mesh must not see them. */
+  BKE_mesh_calc_normals(mesh_cow);
+  EXPECT_NE(mesh_cow->mvert, mesh->mvert);
+  EXPECT_NE(mesh_cow->mvert[0].no[2], 0);
+  EXPECT_EQ(mesh_cow->mpoly, mesh->mpoly);
+  EXPECT_EQ(memcmp(mesh->mvert, mvert_orig, sizeof(MVert) * mesh->totvert), 0);
+
+  /* Same for writers of the original mesh, like sculpt mode. */
+  CustomData_MeshMasks mask = {0};
+  mask.pmask = CD_MASK_MPOLY;
+  const MPoly *mpoly_cow = mesh_cow->mpoly;
+  BKE_mesh_unshare_layers(mesh, &mask);
+  EXPECT_NE(mesh->mpoly, mpoly_cow);
+  EXPECT_EQ(CustomData_get_layer(&mesh->pdata, CD_MPOLY), mesh->mpoly);
+  EXPECT_EQ(memcmp(mesh->mpoly, mpoly_cow, sizeof(MPoly) * mesh->totpoly), 0);
+
+  BKE_id_free(NULL, mesh);
+  EXPECT_EQ(mesh_cow->mpoly, mpoly_cow);
+  BKE_id_free(NULL, mesh_cow);
+  MEM_freeN(mvert_orig);
+}
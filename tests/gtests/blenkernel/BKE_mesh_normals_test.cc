@@ -0,0 +1,248 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BKE_mesh_test_util.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_customdata.h"
+#include "BKE_library.h"
+#include "BKE_mesh_mapping.h"
+#include "BKE_mesh_runtime.h"
+}
+
+#define GRID_SIZE 8
+#define NORMAL_EPS 1e-5f
+
+class MeshNormalsTest : public testing::Test {
+ protected:
+  Mesh *mesh;
+
+  virtual void SetUp()
+  {
+    BLI_threadapi_init();
+
+    mesh = mesh_test_grid_create(GRID_SIZE);
+    /* Sharp edge and flat face, to have fans which are not split by the fold only. */
+    mesh->medge[1].flag |= ME_SHARP;
+    mesh->mpoly[GRID_SIZE + 1].flag &= ~ME_SMOOTH;
+  }
+
+  virtual void TearDown()
+  {
+    BKE_id_free(NULL, mesh);
+
+    BLI_threadapi_exit();
+  }
+
+  /* Split normals computed from scratch, without any cached data of the mesh. */
+  float (*loop_normals_reference(Mesh *me, const float split_angle))[3]
+  {
+    float(*poly_nors)[3] = (float(*)[3])MEM_malloc_arrayN(
+        me->totpoly, sizeof(*poly_nors), __func__);
+    float(*loop_nors)[3] = (float(*)[3])MEM_malloc_arrayN(
+        me->totloop, sizeof(*loop_nors), __func__);
+
+    BKE_mesh_calc_normals_poly(me->mvert,
+                               NULL,
+                               me->totvert,
+                               me->mloop,
+                               me->mpoly,
+                               me->totloop,
+                               me->totpoly,
+                               poly_nors,
+                               true);
+    BKE_mesh_normals_loop_split(me->mvert,
+                                me->totvert,
+                                me->medge,
+                                me->totedge,
+                                me->mloop,
+                                loop_nors,
+                                me->totloop,
+                                me->mpoly,
+                                (const float(*)[3])poly_nors,
+                                me->totpoly,
+                                true,
+                                split_angle,
+                                NULL,
+                                NULL,
+                                NULL);
+
+    MEM_freeN(poly_nors);
+    return loop_nors;
+  }
+
+  /* Vertex normals computed from scratch, accumulating loop normals sequentially. */
+  float (*vert_normals_reference(Mesh *me))[3]
+  {
+    float(*vert_nors)[3] = (float(*)[3])MEM_malloc_arrayN(
+        me->totvert, sizeof(*vert_nors), __func__);
+    float(*poly_nors)[3] = (float(*)[3])MEM_malloc_arrayN(
+        me->totpoly, sizeof(*poly_nors), __func__);
+
+    BKE_mesh_calc_normals_poly(me->mvert,
+                               vert_nors,
+                               me->totvert,
+                               me->mloop,
+                               me->mpoly,
+                               me->totloop,
+                               me->totpoly,
+                               poly_nors,
+                               false);
+
+    MEM_freeN(poly_nors);
+    return vert_nors;
+  }
+
+  /* Share the fans of the mesh with a deformed copy of it,
+   * split normals of the copy must not depend on the fans being reused. */
+  void expect_shared_fans_match(const float split_angle)
+  {
+    mesh->flag |= ME_AUTOSMOOTH;
+    mesh->smoothresh = split_angle;
+
+    Mesh *mesh_deformed = BKE_mesh_copy_for_eval(mesh, true);
+    mesh_test_verts_jitter(mesh_deformed, 0, 0.25f);
+    BKE_mesh_calc_normals(mesh_deformed);
+
+    BKE_mesh_runtime_loop_fans_share(mesh, mesh_deformed);
+    ASSERT_TRUE(mesh->runtime.loop_fans != NULL);
+    EXPECT_EQ(mesh->runtime.loop_fans, mesh_deformed->runtime.loop_fans);
+    EXPECT_EQ(mesh->runtime.loop_fans->users, 2);
+
+    BKE_mesh_calc_normals_split(mesh_deformed);
+    const float(*loop_nors)[3] = (const float(*)[3])CustomData_get_layer(&mesh_deformed->ldata,
+                                                                         CD_NORMAL);
+    ASSERT_TRUE(loop_nors != NULL);
+
+    float(*loop_nors_ref)[3] = loop_normals_reference(mesh_deformed, split_angle);
+    for (int i = 0; i < mesh_deformed->totloop; i++) {
+      EXPECT_V3_NEAR(loop_nors[i], loop_nors_ref[i], NORMAL_EPS);
+    }
+    MEM_freeN(loop_nors_ref);
+
+    BKE_id_free(NULL, mesh_deformed);
+    EXPECT_EQ(mesh->runtime.loop_fans->users, 1);
+  }
+};
+
+TEST_F(MeshNormalsTest, LoopFansShared)
+{
+  expect_shared_fans_match((float)M_PI);
+}
+
+TEST_F(MeshNormalsTest, LoopFansSharedSplitAngle)
+{
+  /* The fold of the grid is sharper than this, the cached fans do not account for it. */
+  expect_shared_fans_match(DEG2RADF(30.0f));
+}
+
+TEST_F(MeshNormalsTest, LoopFansTopologyChanged)
+{
+  mesh->flag |= ME_AUTOSMOOTH;
+  mesh->smoothresh = (float)M_PI;
+
+  /* Without shared topology arrays there is nothing to share. */
+  Mesh *mesh_copy = BKE_mesh_copy_for_eval(mesh, false);
+  BKE_mesh_runtime_loop_fans_share(mesh, mesh_copy);
+  EXPECT_TRUE(mesh_copy->runtime.loop_fans == NULL);
+  BKE_id_free(NULL, mesh_copy);
+
+  /* Fans are only used for the topology arrays they were built from. */
+  MLoopFans *loop_fans = BKE_mesh_loop_fans_create(
+      mesh->medge, mesh->totedge, mesh->mloop, mesh->totloop, mesh->mpoly, mesh->totpoly);
+  EXPECT_TRUE(BKE_mesh_loop_fans_matches(loop_fans,
+                                         mesh->medge,
+                                         mesh->totedge,
+                                         mesh->mloop,
+                                         mesh->totloop,
+                                         mesh->mpoly,
+                                         mesh->totpoly));
+  EXPECT_FALSE(BKE_mesh_loop_fans_matches(loop_fans,
+                                          mesh->medge,
+                                          mesh->totedge,
+                                          mesh->mloop,
+                                          mesh->totloop,
+                                          mesh->mpoly,
+                                          mesh->totpoly - 1));
+
+  BKE_mesh_loop_fans_free(loop_fans);
+}
+
+TEST_F(MeshNormalsTest, VertLoopMapShared)
+{
+  Mesh *mesh_deformed = BKE_mesh_copy_for_eval(mesh, true);
+  mesh_test_verts_jitter(mesh_deformed, 1, 0.25f);
+  float(*vert_nors_ref)[3] = vert_normals_reference(mesh_deformed);
+
+  /* Coordinates changed, so did vertex normals. */
+  EXPECT_TRUE(BKE_mesh_runtime_vert_normals_get(mesh_deformed) == NULL);
+
+  BKE_mesh_runtime_vert_loop_map_share(mesh, mesh_deformed);
+  ASSERT_TRUE(mesh->runtime.vert_loop_map != NULL);
+  EXPECT_EQ(mesh->runtime.vert_loop_map, mesh_deformed->runtime.vert_loop_map);
+  EXPECT_EQ(mesh->runtime.vert_loop_map->users, 2);
+
+  /* Gathers vertex normals in parallel from the shared map, keeping float normals. */
+  BKE_mesh_ensure_normals_for_display(mesh_deformed);
+  const float(*vert_nors)[3] = BKE_mesh_runtime_vert_normals_get(mesh_deformed);
+  ASSERT_TRUE(vert_nors != NULL);
+
+  for (int i = 0; i < mesh_deformed->totvert; i++) {
+    EXPECT_V3_NEAR(vert_nors[i], vert_nors_ref[i], NORMAL_EPS);
+
+    short no_ref[3];
+    normal_float_to_short_v3(no_ref, vert_nors_ref[i]);
+    EXPECT_EQ(mesh_deformed->mvert[i].no[0], no_ref[0]);
+    EXPECT_EQ(mesh_deformed->mvert[i].no[1], no_ref[1]);
+    EXPECT_EQ(mesh_deformed->mvert[i].no[2], no_ref[2]);
+  }
+
+  /* Same again once float normals exist, from BKE_mesh_calc_normals(). */
+  mesh_test_verts_jitter(mesh_deformed, 2, 0.25f);
+  MEM_freeN(vert_nors_ref);
+  vert_nors_ref = vert_normals_reference(mesh_deformed);
+  BKE_mesh_calc_normals(mesh_deformed);
+  vert_nors = BKE_mesh_runtime_vert_normals_get(mesh_deformed);
+  ASSERT_TRUE(vert_nors != NULL);
+  for (int i = 0; i < mesh_deformed->totvert; i++) {
+    EXPECT_V3_NEAR(vert_nors[i], vert_nors_ref[i], NORMAL_EPS);
+  }
+  MEM_freeN(vert_nors_ref);
+
+  BKE_id_free(NULL, mesh_deformed);
+  EXPECT_EQ(mesh->runtime.vert_loop_map->users, 1);
+}
+
+TEST_F(MeshNormalsTest, VertLoopMapTopologyChanged)
+{
+  Mesh *mesh_copy = BKE_mesh_copy_for_eval(mesh, false);
+  BKE_mesh_runtime_vert_loop_map_share(mesh, mesh_copy);
+  EXPECT_TRUE(mesh_copy->runtime.vert_loop_map == NULL);
+  BKE_id_free(NULL, mesh_copy);
+
+  MVertLoopMap *vert_loop_map = BKE_mesh_vert_loop_map_cache_create(
+      mesh->mloop, mesh->totloop, mesh->mpoly, mesh->totpoly, mesh->totvert);
+  EXPECT_TRUE(BKE_mesh_vert_loop_map_cache_matches(
+      vert_loop_map, mesh->mloop, mesh->totloop, mesh->mpoly, mesh->totpoly, mesh->totvert));
+  EXPECT_FALSE(BKE_mesh_vert_loop_map_cache_matches(
+      vert_loop_map, mesh->mloop, mesh->totloop, mesh->mpoly, mesh->totpoly, mesh->totvert + 1));
+
+  /* Every loop of the grid is mapped to its vertex. */
+  int totloop = 0;
+  for (int v = 0; v < mesh->totvert; v++) {
+    const MeshElemMap *map = &vert_loop_map->map[v];
+    for (int j = 0; j < map->count; j++) {
+      EXPECT_EQ(mesh->mloop[map->indices[j]].v, (unsigned int)v);
+    }
+    totloop += map->count;
+  }
+  EXPECT_EQ(totloop, mesh->totloop);
+
+  BKE_mesh_vert_loop_map_cache_free(vert_loop_map);
+}
@@ -0,0 +1,68 @@
+/* Apache License, Version 2.0 */
+
+#ifndef __BLENDER_TESTING_BKE_MESH_TEST_UTIL_H__
+#define __BLENDER_TESTING_BKE_MESH_TEST_UTIL_H__
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math.h"
+#include "BLI_rand.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_mesh.h"
+}
+
+/* Grid of size x size smooth quads, folded by 90 degrees along its middle column of vertices. */
+static Mesh *mesh_test_grid_create(const int size)
+{
+  const int side = size + 1;
+  Mesh *mesh = BKE_mesh_new_nomain(side * side, 0, 0, size * size * 4, size * size);
+
+  for (int y = 0; y < side; y++) {
+    for (int x = 0; x < side; x++) {
+      MVert *mv = &mesh->mvert[y * side + x];
+      mv->co[0] = (float)x;
+      mv->co[1] = (float)y;
+      mv->co[2] = -fabsf((float)x - (float)(size / 2));
+    }
+  }
+
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int poly_index = y * size + x;
+      MPoly *mp = &mesh->mpoly[poly_index];
+      MLoop *ml = &mesh->mloop[poly_index * 4];
+      mp->loopstart = poly_index * 4;
+      mp->totloop = 4;
+      mp->flag = ME_SMOOTH;
+      ml[0].v = (unsigned int)(y * side + x);
+      ml[1].v = (unsigned int)(y * side + x + 1);
+      ml[2].v = (unsigned int)((y + 1) * side + x + 1);
+      ml[3].v = (unsigned int)((y + 1) * side + x);
+    }
+  }
+
+  BKE_mesh_calc_edges(mesh, false, false);
+  BKE_mesh_calc_normals(mesh);
+  return mesh;
+}
+
+/* Move all vertices of the mesh randomly, by less than scale along each axis. */
+static void mesh_test_verts_jitter(Mesh *mesh, const unsigned int seed, const float scale)
+{
+  float(*cos)[3] = BKE_mesh_vert_coords_alloc(mesh, NULL);
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < mesh->totvert; i++) {
+    for (int c = 0; c < 3; c++) {
+      cos[i][c] += (BLI_rng_get_float(rng) * 2.0f - 1.0f) * scale;
+    }
+  }
+  BLI_rng_free(rng);
+  BKE_mesh_vert_coords_apply(mesh, cos);
+  MEM_freeN(cos);
+}
+
+#endif /* __BLENDER_TESTING_BKE_MESH_TEST_UTIL_H__ */
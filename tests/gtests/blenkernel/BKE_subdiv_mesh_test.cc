@@ -0,0 +1,223 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BKE_mesh_test_util.h"
+
+extern "C" {
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_ID.h"
+
+#include "BKE_library.h"
+#include "BKE_subdiv.h"
+#include "BKE_subdiv_mesh.h"
+}
+
+#define GRID_SIZE 4
+#define SUBDIV_LEVEL 2
+#define COORD_EPS 1e-4f
+/* Normals are stored as shorts. */
+#define NORMAL_SHORT_EPS 64
+
+/* Subdividing deformed copies of a copy-on-write mesh re-uses the subdivided topology,
+ * only vertices are evaluated again. */
+class SubdivMeshCacheTest : public testing::Test {
+ protected:
+  Mesh *base_mesh;
+  Subdiv *subdiv;
+  SubdivToMeshSettings mesh_settings;
+  struct SubdivMeshCache *cache;
+
+  virtual void SetUp()
+  {
+    BLI_threadapi_init();
+
+    /* Copies get a copy stamp, which is how changes of the base mesh are detected. */
+    Mesh *mesh = mesh_test_grid_create(GRID_SIZE);
+    base_mesh = BKE_mesh_copy_for_eval(mesh, false);
+    base_mesh->id.tag |= LIB_TAG_COPIED_ON_WRITE;
+    BKE_id_free(NULL, mesh);
+
+    SubdivSettings settings;
+    settings.is_simple = false;
+    settings.is_adaptive = true;
+    settings.level = SUBDIV_LEVEL;
+    settings.use_creases = false;
+    settings.vtx_boundary_interpolation = SUBDIV_VTX_BOUNDARY_EDGE_ONLY;
+    settings.fvar_linear_interpolation = SUBDIV_FVAR_LINEAR_INTERPOLATION_BOUNDARIES;
+    subdiv = BKE_subdiv_new_from_mesh(&settings, base_mesh);
+
+    mesh_settings.resolution = (1 << SUBDIV_LEVEL) + 1;
+    mesh_settings.use_optimal_display = false;
+
+    cache = NULL;
+  }
+
+  virtual void TearDown()
+  {
+    if (cache != NULL) {
+      BKE_subdiv_mesh_cache_free(cache);
+    }
+    if (subdiv != NULL) {
+      BKE_subdiv_free(subdiv);
+    }
+    BKE_id_free(NULL, base_mesh);
+
+    BLI_threadapi_exit();
+  }
+
+  /* Same as a deform-only modifier: vertices change, everything else is referenced. */
+  Mesh *coarse_mesh_deformed(const unsigned int seed)
+  {
+    Mesh *coarse_mesh = BKE_mesh_copy_for_eval(base_mesh, true);
+    mesh_test_verts_jitter(coarse_mesh, seed, 0.25f);
+    return coarse_mesh;
+  }
+
+  void expect_mesh_vertices_match(const Mesh *result, const Mesh *result_ref)
+  {
+    ASSERT_EQ(result->totvert, result_ref->totvert);
+    for (int i = 0; i < result->totvert; i++) {
+      EXPECT_V3_NEAR(result->mvert[i].co, result_ref->mvert[i].co, COORD_EPS);
+      for (int c = 0; c < 3; c++) {
+        EXPECT_NEAR(result->mvert[i].no[c], result_ref->mvert[i].no[c], NORMAL_SHORT_EPS);
+      }
+    }
+  }
+
+  void expect_cached_matches_uncached(const bool use_limit_stencils)
+  {
+    ASSERT_TRUE(subdiv != NULL);
+
+    /* Nothing is kept for a single subdivision. */
+    Mesh *coarse_mesh = coarse_mesh_deformed(0);
+    Mesh *result_first = BKE_subdiv_to_mesh_cached(
+        subdiv, &mesh_settings, coarse_mesh, base_mesh, use_limit_stencils, &cache);
+    ASSERT_TRUE(result_first != NULL);
+    ASSERT_TRUE(cache != NULL);
+
+    /* Only vertices changed, the result is kept from now on. */
+    Mesh *coarse_mesh_kept = coarse_mesh_deformed(1);
+    Mesh *result_kept = BKE_subdiv_to_mesh_cached(
+        subdiv, &mesh_settings, coarse_mesh_kept, base_mesh, use_limit_stencils, &cache);
+    ASSERT_TRUE(result_kept != NULL);
+    const struct SubdivMeshCache *cache_kept = cache;
+
+    for (unsigned int seed = 2; seed < 4; seed++) {
+      Mesh *coarse_mesh_next = coarse_mesh_deformed(seed);
+      Mesh *result = BKE_subdiv_to_mesh_cached(
+          subdiv, &mesh_settings, coarse_mesh_next, base_mesh, use_limit_stencils, &cache);
+      ASSERT_TRUE(result != NULL);
+
+      /* Topology of the kept result is shared, not subdivided again. */
+      EXPECT_EQ(cache, cache_kept);
+      EXPECT_EQ(result->totedge, result_first->totedge);
+      EXPECT_EQ(result->totloop, result_first->totloop);
+      EXPECT_EQ(result->totpoly, result_first->totpoly);
+      EXPECT_EQ(result->medge, result_kept->medge);
+      EXPECT_EQ(result->mloop, result_kept->mloop);
+      EXPECT_EQ(result->mpoly, result_kept->mpoly);
+      EXPECT_NE(result->medge, result_first->medge);
+      EXPECT_NE(result->mvert, result_kept->mvert);
+
+      Mesh *result_ref = BKE_subdiv_to_mesh(subdiv, &mesh_settings, coarse_mesh_next);
+      ASSERT_TRUE(result_ref != NULL);
+      expect_mesh_vertices_match(result, result_ref);
+
+      BKE_id_free(NULL, result_ref);
+      BKE_id_free(NULL, result);
+      BKE_id_free(NULL, coarse_mesh_next);
+    }
+
+    BKE_id_free(NULL, result_kept);
+    BKE_id_free(NULL, coarse_mesh_kept);
+    BKE_id_free(NULL, result_first);
+    BKE_id_free(NULL, coarse_mesh);
+  }
+};
+
+TEST_F(SubdivMeshCacheTest, DeformedCoarseMesh)
+{
+  expect_cached_matches_uncached(false);
+}
+
+TEST_F(SubdivMeshCacheTest, DeformedCoarseMeshLimitStencils)
+{
+  expect_cached_matches_uncached(true);
+}
+
+TEST_F(SubdivMeshCacheTest, SettingsChanged)
+{
+  ASSERT_TRUE(subdiv != NULL);
+
+  Mesh *coarse_mesh = coarse_mesh_deformed(0);
+  Mesh *result_first = BKE_subdiv_to_mesh_cached(
+      subdiv, &mesh_settings, coarse_mesh, base_mesh, false, &cache);
+  ASSERT_TRUE(cache != NULL);
+
+  /* Another resolution gives another topology, the cache is re-created for it. */
+  mesh_settings.resolution = (1 << (SUBDIV_LEVEL + 1)) + 1;
+  Mesh *result = BKE_subdiv_to_mesh_cached(
+      subdiv, &mesh_settings, coarse_mesh, base_mesh, false, &cache);
+  ASSERT_TRUE(result != NULL);
+  ASSERT_TRUE(cache != NULL);
+  EXPECT_GT(result->totpoly, result_first->totpoly);
+
+  Mesh *result_ref = BKE_subdiv_to_mesh(subdiv, &mesh_settings, coarse_mesh);
+  expect_mesh_vertices_match(result, result_ref);
+
+  BKE_id_free(NULL, result_ref);
+  BKE_id_free(NULL, result);
+  BKE_id_free(NULL, result_first);
+  BKE_id_free(NULL, coarse_mesh);
+}
+
+TEST_F(SubdivMeshCacheTest, BaseMeshNotCopiedOnWrite)
+{
+  ASSERT_TRUE(subdiv != NULL);
+
+  /* Changes of the base mesh could not be detected, nothing is cached. */
+  base_mesh->id.tag &= ~LIB_TAG_COPIED_ON_WRITE;
+  Mesh *coarse_mesh = coarse_mesh_deformed(0);
+  Mesh *result = BKE_subdiv_to_mesh_cached(
+      subdiv, &mesh_settings, coarse_mesh, base_mesh, false, &cache);
+  ASSERT_TRUE(result != NULL);
+  EXPECT_TRUE(cache == NULL);
+
+  BKE_id_free(NULL, result);
+  BKE_id_free(NULL, coarse_mesh);
+}
+
+TEST_F(SubdivMeshCacheTest, TopologyChanged)
+{
+  ASSERT_TRUE(subdiv != NULL);
+
+  Mesh *coarse_mesh = coarse_mesh_deformed(0);
+  Mesh *result_first = BKE_subdiv_to_mesh_cached(
+      subdiv, &mesh_settings, coarse_mesh, base_mesh, false, &cache);
+  Mesh *coarse_mesh_kept = coarse_mesh_deformed(1);
+  Mesh *result_kept = BKE_subdiv_to_mesh_cached(
+      subdiv, &mesh_settings, coarse_mesh_kept, base_mesh, false, &cache);
+  ASSERT_TRUE(cache != NULL);
+
+  /* Custom data which is not the one of the base mesh could be anything, the kept result is
+   * freed and nothing is remembered. */
+  Mesh *coarse_mesh_copy = BKE_mesh_copy_for_eval(base_mesh, false);
+  Mesh *result = BKE_subdiv_to_mesh_cached(
+      subdiv, &mesh_settings, coarse_mesh_copy, base_mesh, false, &cache);
+  ASSERT_TRUE(result != NULL);
+  EXPECT_TRUE(cache == NULL);
+
+  Mesh *result_ref = BKE_subdiv_to_mesh(subdiv, &mesh_settings, coarse_mesh_copy);
+  expect_mesh_vertices_match(result, result_ref);
+
+  BKE_id_free(NULL, result_ref);
+  BKE_id_free(NULL, result);
+  BKE_id_free(NULL, coarse_mesh_copy);
+  BKE_id_free(NULL, result_kept);
+  BKE_id_free(NULL, coarse_mesh_kept);
+  BKE_id_free(NULL, result_first);
+  BKE_id_free(NULL, coarse_mesh);
+}
@@ -0,0 +1,142 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_constraint_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_collection.h"
+#include "BKE_constraint.h"
+#include "BKE_main.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_debug.h"
+
+#include "IMB_imbuf.h"
+}
+
+#include "intern/depsgraph.h"
+#include "intern/node/deg_node_id.h"
+
+/* Relations of objects tagged with DEG_graph_id_relations_tag_update() are re-built on their
+ * own, the graph must end up with the relations of a full rebuild. */
+class DepsgraphPartialBuildTest : public testing::Test {
+ protected:
+  Main *bmain;
+  Scene *scene;
+  ViewLayer *view_layer;
+  Depsgraph *depsgraph;
+  Object *ob_a, *ob_b, *ob_c;
+
+  virtual void SetUp()
+  {
+    BLI_threadapi_init();
+    IMB_init();
+    DEG_register_node_types();
+
+    bmain = BKE_main_new();
+    scene = BKE_scene_add(bmain, "Scene");
+    view_layer = (ViewLayer *)scene->view_layers.first;
+    ob_a = object_add("A");
+    ob_b = object_add("B");
+    ob_c = object_add("C");
+
+    depsgraph = NULL;
+  }
+
+  virtual void TearDown()
+  {
+    if (depsgraph != NULL) {
+      DEG_graph_free(depsgraph);
+    }
+    BKE_main_free(bmain);
+
+    DEG_free_node_types();
+    IMB_exit();
+    BLI_threadapi_exit();
+  }
+
+  Object *object_add(const char *name)
+  {
+    Object *ob = BKE_object_add_only_object(bmain, OB_EMPTY, name);
+    BKE_collection_object_add(bmain, scene->master_collection, ob);
+    return ob;
+  }
+
+  bConstraint *constraint_add(Object *ob, Object *target)
+  {
+    bConstraint *con = BKE_constraint_add_for_object(ob, NULL, CONSTRAINT_TYPE_LOCLIKE);
+    ((bLocateLikeConstraint *)con->data)->tar = target;
+    return con;
+  }
+
+  void graph_build()
+  {
+    depsgraph = DEG_graph_new(scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(depsgraph, bmain, scene, view_layer);
+  }
+
+  DEG::IDNode *id_node_find(ID *id)
+  {
+    return reinterpret_cast<DEG::Depsgraph *>(depsgraph)->find_id_node(id);
+  }
+
+  void expect_partial_update_matches_full_build(Object *ob)
+  {
+    /* Nodes of the scene are kept, unless the update fell back to a full rebuild. */
+    const DEG::IDNode *id_node_scene = id_node_find(&scene->id);
+    DEG_graph_id_relations_tag_update(depsgraph, &ob->id);
+    DEG_graph_relations_update(depsgraph, bmain, scene, view_layer);
+    EXPECT_EQ(id_node_find(&scene->id), id_node_scene);
+    EXPECT_TRUE(DEG_debug_consistency_check(depsgraph));
+    EXPECT_TRUE(DEG_debug_graph_relations_partial_validate(depsgraph, bmain, scene, view_layer));
+  }
+};
+
+TEST_F(DepsgraphPartialBuildTest, ConstraintAdded)
+{
+  constraint_add(ob_c, ob_b);
+  graph_build();
+
+  constraint_add(ob_b, ob_a);
+  expect_partial_update_matches_full_build(ob_b);
+}
+
+TEST_F(DepsgraphPartialBuildTest, ConstraintRemoved)
+{
+  /* Relations from and to the re-built object are kept. */
+  bConstraint *con = constraint_add(ob_b, ob_a);
+  constraint_add(ob_c, ob_b);
+  graph_build();
+
+  BKE_constraint_remove(&ob_b->constraints, con);
+  expect_partial_update_matches_full_build(ob_b);
+}
+
+TEST_F(DepsgraphPartialBuildTest, ConstraintTargetChanged)
+{
+  bConstraint *con = constraint_add(ob_b, ob_a);
+  constraint_add(ob_a, ob_c);
+  graph_build();
+
+  ((bLocateLikeConstraint *)con->data)->tar = ob_c;
+  expect_partial_update_matches_full_build(ob_b);
+}
+
+TEST_F(DepsgraphPartialBuildTest, SeveralObjectsTagged)
+{
+  graph_build();
+
+  constraint_add(ob_a, ob_b);
+  constraint_add(ob_b, ob_c);
+  DEG_graph_id_relations_tag_update(depsgraph, &ob_a->id);
+  expect_partial_update_matches_full_build(ob_b);
+}
@@ -0,0 +1,166 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_utildefines.h"
+
+#include "IK_solver.h"
+}
+
+#define ITERATIONS 500
+#define POS_EPS 1e-3f
+#define STRETCH_EPS 1e-2f
+
+/* Joint positions of a solved chain of two segments. */
+struct TwoBonePose {
+  float joint[3];
+  float end[3];
+};
+
+/* Chains of two segments are solved directly when enabled, the pose must be the one the
+ * iterative solver finds wherever the solution is unique. */
+class IKTwoBoneTest : public testing::Test {
+ protected:
+  float upper_start[3];
+  float upper_basis[3][3];
+  float lower_basis[3][3];
+  float upper_length;
+  float lower_length;
+  bool use_limits;
+
+  virtual void SetUp()
+  {
+    /* Slightly bent chain, like an arm in rest pose. */
+    zero_v3(upper_start);
+    axis_angle_to_mat3_single(upper_basis, 'X', 0.2f);
+    axis_angle_to_mat3_single(lower_basis, 'X', 0.3f);
+    upper_length = 1.0f;
+    lower_length = 0.8f;
+    use_limits = false;
+  }
+
+  TwoBonePose solve(const float goal[3],
+                    const float *polegoal,
+                    const bool use_analytic,
+                    const bool set_analytic = true)
+  {
+    float start_zero[3] = {0.0f, 0.0f, 0.0f};
+    float rest[3][3];
+    unit_m3(rest);
+
+    IK_Segment *upper = IK_CreateSegment(IK_XDOF | IK_YDOF | IK_ZDOF);
+    IK_Segment *lower = IK_CreateSegment(IK_XDOF | IK_YDOF | IK_ZDOF);
+    IK_SetParent(lower, upper);
+    IK_SetTransform(upper, upper_start, rest, upper_basis, upper_length);
+    IK_SetTransform(lower, start_zero, rest, lower_basis, lower_length);
+    if (use_limits) {
+      IK_SetLimit(lower, IK_X, -2.0f, 2.0f);
+    }
+
+    IK_Solver *solver = IK_CreateSolver(upper);
+    if (set_analytic) {
+      IK_SolverSetTwoBoneAnalytic(solver, use_analytic);
+    }
+    IK_SolverAddGoal(solver, lower, (float *)goal, 1.0f);
+    if (polegoal != NULL) {
+      IK_SolverSetPoleVectorConstraint(
+          solver, lower, (float *)goal, (float *)polegoal, 0.0f, false);
+    }
+    IK_Solve(solver, 0.0f, ITERATIONS);
+
+    float upper_change[3][3], lower_change[3][3];
+    IK_GetBasisChange(upper, upper_change);
+    IK_GetBasisChange(lower, lower_change);
+    IK_FreeSolver(solver);
+    IK_FreeSegment(lower);
+    IK_FreeSegment(upper);
+
+    /* Segments point along their Y axis, children start at the end of their parent. */
+    float upper_mat[3][3], lower_mat[3][3], tmp[3][3], vec[3];
+    TwoBonePose pose;
+    mul_m3_m3m3(upper_mat, upper_basis, upper_change);
+    copy_v3_fl3(vec, 0.0f, upper_length, 0.0f);
+    mul_m3_v3(upper_mat, vec);
+    add_v3_v3v3(pose.joint, upper_start, vec);
+
+    mul_m3_m3m3(tmp, lower_basis, lower_change);
+    mul_m3_m3m3(lower_mat, upper_mat, tmp);
+    copy_v3_fl3(vec, 0.0f, lower_length, 0.0f);
+    mul_m3_v3(lower_mat, vec);
+    add_v3_v3v3(pose.end, pose.joint, vec);
+
+    return pose;
+  }
+
+  void expect_bone_lengths(const TwoBonePose &pose)
+  {
+    EXPECT_NEAR(len_v3v3(upper_start, pose.joint), upper_length, POS_EPS);
+    EXPECT_NEAR(len_v3v3(pose.joint, pose.end), lower_length, POS_EPS);
+  }
+};
+
+TEST_F(IKTwoBoneTest, DisabledByDefault)
+{
+  const float goal[3] = {0.5f, 0.8f, 0.6f};
+  TwoBonePose pose_default = solve(goal, NULL, false, false);
+  TwoBonePose pose_jacobian = solve(goal, NULL, false);
+  EXPECT_EQ_ARRAY(pose_default.joint, pose_jacobian.joint, 3);
+  EXPECT_EQ_ARRAY(pose_default.end, pose_jacobian.end, 3);
+}
+
+TEST_F(IKTwoBoneTest, ReachableGoal)
+{
+  const float goal[3] = {0.5f, 0.8f, 0.6f};
+  TwoBonePose pose = solve(goal, NULL, true);
+  TwoBonePose pose_jacobian = solve(goal, NULL, false);
+
+  /* Without a pole the bend plane is free, only the end effector has to match. */
+  EXPECT_V3_NEAR(pose.end, goal, POS_EPS);
+  EXPECT_V3_NEAR(pose.end, pose_jacobian.end, POS_EPS);
+  expect_bone_lengths(pose);
+}
+
+TEST_F(IKTwoBoneTest, ReachableGoalPole)
+{
+  const float goal[3] = {0.5f, 0.8f, 0.6f};
+  const float polegoal[3] = {-1.0f, 1.0f, 2.0f};
+  TwoBonePose pose = solve(goal, polegoal, true);
+  TwoBonePose pose_jacobian = solve(goal, polegoal, false);
+
+  /* The pole fixes the bend plane, so the whole pose is unique. */
+  EXPECT_V3_NEAR(pose.end, goal, POS_EPS);
+  EXPECT_V3_NEAR(pose.end, pose_jacobian.end, POS_EPS);
+  EXPECT_V3_NEAR(pose.joint, pose_jacobian.joint, POS_EPS);
+  expect_bone_lengths(pose);
+}
+
+TEST_F(IKTwoBoneTest, UnreachableGoal)
+{
+  const float goal[3] = {2.0f, 1.0f, -1.0f};
+  TwoBonePose pose = solve(goal, NULL, true);
+  TwoBonePose pose_jacobian = solve(goal, NULL, false);
+
+  /* Stretched towards the goal. The damped iterative solver only approaches the singular
+   * stretched pose, it can't straighten the chain exactly. */
+  float dir[3], joint[3], end[3];
+  normalize_v3_v3(dir, goal);
+  mul_v3_v3fl(joint, dir, upper_length);
+  mul_v3_v3fl(end, dir, upper_length + lower_length);
+  EXPECT_V3_NEAR(pose.joint, joint, POS_EPS);
+  EXPECT_V3_NEAR(pose.end, end, POS_EPS);
+  EXPECT_V3_NEAR(pose.end, pose_jacobian.end, POS_EPS);
+  EXPECT_V3_NEAR(pose.joint, pose_jacobian.joint, STRETCH_EPS);
+}
+
+TEST_F(IKTwoBoneTest, LimitsIterate)
+{
+  /* Chains the closed form does not apply to are solved like before. */
+  use_limits = true;
+  const float goal[3] = {0.5f, 0.8f, 0.6f};
+  TwoBonePose pose = solve(goal, NULL, true);
+  TwoBonePose pose_jacobian = solve(goal, NULL, false);
+  EXPECT_EQ_ARRAY(pose.joint, pose_jacobian.joint, 3);
+  EXPECT_EQ_ARRAY(pose.end, pose_jacobian.end, 3);
+}